@@ -16,6 +16,7 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifndef _WIN32
@@ -32,7 +33,10 @@
 #include "command.h"
 
 #include "general.h"
+#include "movie.h"
+#include "performance.h"
 #include "verbosity.h"
+#include "record/record_driver.h"
 
 #define DEFAULT_NETWORK_CMD_PORT 55355
 #define STDIN_BUF_SIZE 4096
@@ -250,8 +254,46 @@ static bool cmd_set_shader(const char *arg)
    return video_driver_set_shader(type, arg);
 }
 
+static bool cmd_save_replay(const char *arg)
+{
+   char msg[256];
+
+   if (!recording_dump_replay(arg))
+      return false;
+
+   snprintf(msg, sizeof(msg), "Saving replay: \"%s\"", arg);
+   runloop_msg_queue_push(msg, 1, 120, true);
+
+   return true;
+}
+
+static bool cmd_seek_movie(const char *arg)
+{
+   char msg[256];
+   unsigned frame = strtoul(arg, NULL, 0);
+
+   if (!bsv_movie_ctl(BSV_MOVIE_CTL_SEEK, &frame))
+      return false;
+
+   snprintf(msg, sizeof(msg), "Movie frame: %u", frame);
+   runloop_msg_queue_push(msg, 1, 120, true);
+
+   return true;
+}
+
+static bool cmd_perf_dump(const char *arg)
+{
+   (void)arg;
+   rarch_perf_dump();
+   return true;
+}
+
+/* Actions without an argument description take none. */
 static const struct cmd_action_map action_map[] = {
-   { "SET_SHADER", cmd_set_shader, "<shader path>" },
+   { "SET_SHADER",  cmd_set_shader,  "<shader path>" },
+   { "SAVE_REPLAY", cmd_save_replay, "<video path>" },
+   { "SEEK_MOVIE",  cmd_seek_movie,  "<frame>" },
+   { "PERF_DUMP",   cmd_perf_dump,   NULL },
 };
 
 static bool command_get_arg(const char *tok,
@@ -279,11 +321,19 @@ static bool command_get_arg(const char *tok,
       if (str == tok)
       {
          const char *argument = str + strlen(action_map[i].str);
-         if (*argument != ' ')
+
+         if (!action_map[i].arg_desc)
+         {
+            if (*argument != '\0')
+               return false;
+         }
+         else if (*argument != ' ')
             return false;
+         else
+            argument++;
 
          if (arg)
-            *arg = argument + 1;
+            *arg = argument;
 
          if (index)
             *index = i;
@@ -606,7 +656,8 @@ static bool verify_command(const char *cmd)
       RARCH_ERR("\t\t%s\n", map[i].str);
 
    for (i = 0; i < sizeof(action_map) / sizeof(action_map[0]); i++)
-      RARCH_ERR("\t\t%s %s\n", action_map[i].str, action_map[i].arg_desc);
+      RARCH_ERR("\t\t%s %s\n", action_map[i].str,
+            action_map[i].arg_desc ? action_map[i].arg_desc : "");
 
    return false;
 }
@@ -34,6 +34,7 @@
 #include "msg_hash.h"
 #include "retroarch.h"
 #include "rewind.h"
+#include "runahead.h"
 #include "system.h"
 #include "dir_list_special.h"
 
@@ -47,6 +48,7 @@
 #include "runloop.h"
 #include "configuration.h"
 #include "input/input_remapping.h"
+#include "gfx/video_shader_watch.h"
 
 #ifdef HAVE_MENU
 #include "menu/menu_driver.h"
@@ -392,6 +394,7 @@ static void event_deinit_core(bool reinit)
    event_deinit_core_interfaces();
    core.retro_unload_game();
    core.retro_deinit();
+   runahead_deinit();
 
    if (reinit)
       event_command(EVENT_CMD_DRIVERS_DEINIT);
@@ -1393,6 +1396,9 @@ bool event_command(enum event_command cmd)
          if (!runloop_ctl(RUNLOOP_CTL_SHADER_DIR_INIT, NULL))
             return false;
          break;
+      case EVENT_CMD_SHADER_WATCH_TOGGLE:
+         video_shader_watch_update();
+         break;
       case EVENT_CMD_SAVEFILES:
          if (!global->savefiles || !global->sram.use)
             return false;
@@ -141,6 +141,8 @@ enum event_command
    EVENT_CMD_SHADER_DIR_INIT,
    /* Deinitializes shader directory. */
    EVENT_CMD_SHADER_DIR_DEINIT,
+   /* Starts or stops watching the shader files in use. */
+   EVENT_CMD_SHADER_WATCH_TOGGLE,
    /* Initializes controllers. */
    EVENT_CMD_CONTROLLERS_INIT,
    EVENT_CMD_SAVEFILES,
@@ -427,6 +427,13 @@ static const unsigned hard_sync_frames = 0;
  */
 static const unsigned frame_delay = 0;
 
+/* Measures when frames are presented and starts the core as
+ * late as it can while still making the next deadline.
+ * Replaces frame_delay and sleeps precisely under the frame limiter.
+ * With VSync, it needs hard_sync to see when frames are shown.
+ */
+static const bool frame_pacing = false;
+
 /* Inserts a black frame inbetween frames.
  * Useful for 120 Hz monitors who want to play 60 Hz material with eliminated
  * ghosting. video_refresh_rate should still be configured as if it
@@ -477,6 +484,10 @@ static const bool shader_enable = true;
 static const bool shader_enable = false;
 #endif
 
+/* Reloads the shader in use when its preset, pass sources
+ * or LUTs change on disk. Only supported on Linux. */
+static const bool shader_watch_files = false;
+
 /* Only scale in integer steps.
  * The base size depends on system-reported geometry and aspect ratio.
  * If video_force_aspect is not set, X/Y will be integer scaled independently.
@@ -577,6 +588,11 @@ static const uint32_t message_color = 0xffff00;
  * rather than raw game output. */
 static const bool post_filter_record = false;
 
+/* Hashes each software frame and treats one identical to the
+ * previous as a dupe, skipping CPU filtering, texture upload
+ * and re-encoding when recording. */
+static const bool frame_dupe_detect = false;
+
 /* Screenshots post-shaded GPU output if available. */
 static const bool gpu_screenshot = true;
 
@@ -667,6 +683,12 @@ static const unsigned rewind_buffer_size = 20 << 20; /* 20MiB */
 /* How many frames to rewind at a time. */
 static const unsigned rewind_granularity = 1;
 
+/* Runs the core this many frames ahead every frame, and
+ * rolls it back with an in-memory savestate. Hides that many
+ * frames of a game's own input lag. Needs a core with
+ * deterministic savestates. 0 disables it. */
+static const unsigned run_ahead_frames = 0;
+
 /* Pause gameplay when gameplay loses focus. */
 static const bool pause_nonactive = true;
 
@@ -32,7 +32,9 @@
 #include "defaults.h"
 #include "general.h"
 #include "retroarch.h"
+#include "runahead.h"
 #include "system.h"
+#include "msg_hash.h"
 #include "verbosity.h"
 
 #ifdef HAVE_CONFIG_H
@@ -502,6 +504,7 @@ static void config_set_defaults(void)
    settings->video.hard_sync             = hard_sync;
    settings->video.hard_sync_frames      = hard_sync_frames;
    settings->video.frame_delay           = frame_delay;
+   settings->video.frame_pacing          = frame_pacing;
    settings->video.black_frame_insertion = black_frame_insertion;
    settings->video.swap_interval         = swap_interval;
    settings->video.threaded              = video_threaded;
@@ -527,6 +530,7 @@ static void config_set_defaults(void)
    settings->video.aspect_ratio_auto           = aspect_ratio_auto; /* Let implementation decide if automatic, or 1:1 PAR. */
    settings->video.aspect_ratio_idx            = aspect_ratio_idx;
    settings->video.shader_enable               = shader_enable;
+   settings->video.shader_watch_files          = shader_watch_files;
    settings->video.allow_rotate                = allow_rotate;
 
    settings->video.font_enable                 = font_enable;
@@ -545,6 +549,7 @@ static void config_set_defaults(void)
       settings->video.refresh_rate             = g_defaults.settings.video_refresh_rate;
 
    settings->video.post_filter_record          = post_filter_record;
+   settings->video.frame_dupe_detect           = frame_dupe_detect;
    settings->video.gpu_record                  = gpu_record;
    settings->video.gpu_screenshot              = gpu_screenshot;
    settings->video.rotation                    = ORIENTATION_NORMAL;
@@ -572,6 +577,7 @@ static void config_set_defaults(void)
    settings->rewind_enable                     = rewind_enable;
    settings->rewind_buffer_size                = rewind_buffer_size;
    settings->rewind_granularity                = rewind_granularity;
+   settings->run_ahead_frames                  = run_ahead_frames;
    settings->slowmotion_ratio                  = slowmotion_ratio;
    settings->fastforward_ratio                 = fastforward_ratio;
    settings->pause_nonactive                   = pause_nonactive;
@@ -769,6 +775,7 @@ static void config_set_defaults(void)
    settings->menu_scroll_up_btn   = default_menu_btn_scroll_up;
 
    settings->user_language = 0;
+   msg_hash_set_language(settings->user_language);
 
    global->console.sound.system_bgm_enable = false;
 
@@ -1349,6 +1356,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT_BASE(conf, settings, video.frame_delay, "video_frame_delay");
    if (settings->video.frame_delay > 15)
       settings->video.frame_delay = 15;
+   CONFIG_GET_BOOL_BASE(conf, settings, video.frame_pacing, "video_frame_pacing");
 
    CONFIG_GET_BOOL_BASE(conf, settings, video.black_frame_insertion, "video_black_frame_insertion");
    CONFIG_GET_INT_BASE(conf, settings, video.swap_interval, "video_swap_interval");
@@ -1371,6 +1379,7 @@ static bool config_load_file(const char *path, bool set_defaults)
 
    config_get_path(conf, "video_shader", settings->video.shader_path, sizeof(settings->video.shader_path));
    CONFIG_GET_BOOL_BASE(conf, settings, video.shader_enable, "video_shader_enable");
+   CONFIG_GET_BOOL_BASE(conf, settings, video.shader_watch_files, "video_shader_watch_files");
 
    CONFIG_GET_BOOL_BASE(conf, settings, video.allow_rotate, "video_allow_rotate");
 
@@ -1407,6 +1416,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    }
 
    CONFIG_GET_BOOL_BASE(conf, settings, video.post_filter_record, "video_post_filter_record");
+   CONFIG_GET_BOOL_BASE(conf, settings, video.frame_dupe_detect, "video_frame_dupe_detect");
    CONFIG_GET_BOOL_BASE(conf, settings, video.gpu_record, "video_gpu_record");
    CONFIG_GET_BOOL_BASE(conf, settings, video.gpu_screenshot, "video_gpu_screenshot");
 
@@ -1660,6 +1670,9 @@ static bool config_load_file(const char *path, bool set_defaults)
    config_get_array(conf, "bundle_assets_dst_path_subdir", settings->bundle_assets_dst_path_subdir, sizeof(settings->bundle_assets_dst_path_subdir));
 
    CONFIG_GET_INT_BASE(conf, settings, rewind_granularity, "rewind_granularity");
+   CONFIG_GET_INT_BASE(conf, settings, run_ahead_frames, "run_ahead_frames");
+   if (settings->run_ahead_frames > RUNAHEAD_MAX_FRAMES)
+      settings->run_ahead_frames = RUNAHEAD_MAX_FRAMES;
    CONFIG_GET_FLOAT_BASE(conf, settings, slowmotion_ratio, "slowmotion_ratio");
    if (settings->slowmotion_ratio < 1.0f)
       settings->slowmotion_ratio = 1.0f;
@@ -1727,6 +1740,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    if (!global->has_set.username)
       config_get_path(conf, "netplay_nickname",  settings->username, sizeof(settings->username));
    CONFIG_GET_INT_BASE(conf, settings, user_language, "user_language");
+   msg_hash_set_language(settings->user_language);
 #ifdef HAVE_NETPLAY
    if (!global->has_set.netplay_mode)
       CONFIG_GET_BOOL_BASE(conf, global, netplay.is_spectate,
@@ -2565,9 +2579,12 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "audio_sync",    settings->audio.sync);
    config_set_int(conf,   "audio_block_frames", settings->audio.block_frames);
    config_set_int(conf,   "rewind_granularity", settings->rewind_granularity);
+   config_set_int(conf,   "run_ahead_frames", settings->run_ahead_frames);
    config_set_path(conf,  "video_shader", settings->video.shader_path);
    config_set_bool(conf,  "video_shader_enable",
          settings->video.shader_enable);
+   config_set_bool(conf,  "video_shader_watch_files",
+         settings->video.shader_watch_files);
    config_set_float(conf, "video_aspect_ratio", settings->video.aspect_ratio);
    config_set_bool(conf,  "video_aspect_ratio_auto", settings->video.aspect_ratio_auto);
    config_set_bool(conf,  "video_windowed_fullscreen",
@@ -2582,6 +2599,8 @@ bool config_save_file(const char *path)
 #endif
    config_set_bool(conf,  "video_smooth", settings->video.smooth);
    config_set_bool(conf,  "video_threaded", settings->video.threaded);
+   config_set_bool(conf,  "video_frame_dupe_detect",
+         settings->video.frame_dupe_detect);
    config_set_bool(conf,  "video_shared_context",
          settings->video.shared_context);
    config_set_bool(conf,  "video_force_srgb_disable",
@@ -2628,6 +2647,7 @@ bool config_save_file(const char *path)
    config_set_int(conf,   "video_hard_sync_frames",
          settings->video.hard_sync_frames);
    config_set_int(conf,   "video_frame_delay", settings->video.frame_delay);
+   config_set_bool(conf,  "video_frame_pacing", settings->video.frame_pacing);
    config_set_bool(conf,  "video_black_frame_insertion",
          settings->video.black_frame_insertion);
    config_set_bool(conf,  "video_disable_composition",
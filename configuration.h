@@ -59,6 +59,7 @@ typedef struct settings
       unsigned swap_interval;
       unsigned hard_sync_frames;
       unsigned frame_delay;
+      bool frame_pacing;
 #ifdef GEKKO
       unsigned viwidth;
       bool vfilter;
@@ -74,6 +75,7 @@ typedef struct settings
 
       char shader_path[PATH_MAX_LENGTH];
       bool shader_enable;
+      bool shader_watch_files;
 
       char softfilter_plugin[PATH_MAX_LENGTH];
       float refresh_rate;
@@ -94,6 +96,7 @@ typedef struct settings
       bool disable_composition;
 
       bool post_filter_record;
+      bool frame_dupe_detect;
       bool gpu_record;
       bool gpu_screenshot;
 
@@ -341,6 +344,7 @@ typedef struct settings
    bool rewind_enable;
    size_t rewind_buffer_size;
    unsigned rewind_granularity;
+   unsigned run_ahead_frames;
 
    float slowmotion_ratio;
    float fastforward_ratio;
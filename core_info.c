@@ -15,8 +15,13 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <ctype.h>
+#include <stddef.h>
+
 #include <file/file_path.h>
 #include <file/file_extract.h>
+#include <retro_file.h>
+#include <retro_stat.h>
 
 #include "core_info.h"
 #include "general.h"
@@ -59,48 +64,709 @@ static void core_info_list_resolve_all_extensions(
    }
 }
 
-static void core_info_list_resolve_all_firmware(
-      core_info_list_t *core_info_list)
+static void core_info_parse_firmware(core_info_t *info,
+      config_file_t *config)
 {
-   size_t i;
    unsigned c;
+   unsigned count = 0;
 
-   if (!core_info_list)
+   if (!config_get_uint(config, "firmware_count", &count) || !count)
       return;
 
-   for (i = 0; i < core_info_list->count; i++)
+   info->firmware = (core_info_firmware_t*)
+      calloc(count, sizeof(*info->firmware));
+
+   if (!info->firmware)
+      return;
+
+   info->firmware_count = count;
+
+   for (c = 0; c < count; c++)
    {
-      unsigned count        = 0;
-      core_info_t *info     = (core_info_t*)&core_info_list->list[i];
-      config_file_t *config = (config_file_t*)info->config_data;
+      char path_key[64] = {0};
+      char desc_key[64] = {0};
+      char opt_key[64]  = {0};
 
-      if (!info || !config)
-         continue;
+      snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
+      snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
+      snprintf(opt_key, sizeof(opt_key), "firmware%u_opt", c);
 
-      if (!config_get_uint(config, "firmware_count", &count))
-         continue;
+      config_get_string(config, path_key, &info->firmware[c].path);
+      config_get_string(config, desc_key, &info->firmware[c].desc);
+      config_get_bool(config, opt_key , &info->firmware[c].optional);
+   }
+}
 
-      info->firmware = (core_info_firmware_t*)
-         calloc(count, sizeof(*info->firmware));
+/* String members of core_info_t restored from the cache,
+ * in on-disk order. */
+static const size_t core_info_cache_fields[] = {
+   offsetof(core_info_t, display_name),
+   offsetof(core_info_t, core_name),
+   offsetof(core_info_t, systemname),
+   offsetof(core_info_t, system_manufacturer),
+   offsetof(core_info_t, supported_extensions),
+   offsetof(core_info_t, authors),
+   offsetof(core_info_t, permissions),
+   offsetof(core_info_t, licenses),
+   offsetof(core_info_t, categories),
+   offsetof(core_info_t, databases),
+   offsetof(core_info_t, notes),
+};
+
+#define CORE_INFO_FIELD(info, i) \
+   (*(char**)((uint8_t*)(info) + core_info_cache_fields[i]))
+
+#define CORE_INFO_NUM_FIELDS \
+   (sizeof(core_info_cache_fields) / sizeof(core_info_cache_fields[0]))
+
+static void core_info_split_lists(core_info_t *info)
+{
+   if (info->supported_extensions)
+      info->supported_extensions_list =
+         string_split(info->supported_extensions, "|");
+   if (info->authors)
+      info->authors_list     = string_split(info->authors, "|");
+   if (info->permissions)
+      info->permissions_list = string_split(info->permissions, "|");
+   if (info->licenses)
+      info->licenses_list    = string_split(info->licenses, "|");
+   if (info->categories)
+      info->categories_list  = string_split(info->categories, "|");
+   if (info->databases)
+      info->databases_list   = string_split(info->databases, "|");
+   if (info->notes)
+      info->note_list        = string_split(info->notes, "|");
+}
+
+static bool core_info_parse_file(core_info_t *info, const char *info_path)
+{
+   config_file_t *conf = config_file_new(info_path);
+
+   if (!conf)
+      return false;
+
+   config_get_string(conf, "display_name",
+         &info->display_name);
+   config_get_string(conf, "corename",
+         &info->core_name);
+   config_get_string(conf, "systemname",
+         &info->systemname);
+   config_get_string(conf, "manufacturer",
+         &info->system_manufacturer);
+   config_get_string(conf, "supported_extensions",
+         &info->supported_extensions);
+   config_get_string(conf, "authors",
+         &info->authors);
+   config_get_string(conf, "permissions",
+         &info->permissions);
+   config_get_string(conf, "license",
+         &info->licenses);
+   config_get_string(conf, "categories",
+         &info->categories);
+   config_get_string(conf, "database",
+         &info->databases);
+   config_get_string(conf, "notes",
+         &info->notes);
+   config_get_bool(conf, "supports_no_game",
+         &info->supports_no_game);
+
+   core_info_parse_firmware(info, conf);
+
+   config_file_free(conf);
+   return true;
+}
+
+/*
+ * Core info cache.
+ *
+ * All parsed .info records are stored in a single binary file so
+ * startup only has to stat() each .info file instead of opening and
+ * parsing it. An entry is reused when the modification time and size
+ * of its .info file are unchanged; anything else is reparsed and the
+ * cache is rewritten.
+ *
+ * Layout (native endianness, the magic doubles as a byte order mark):
+ *
+ *   u32 magic, u32 version, u32 num_entries
+ *   num_entries * {
+ *      str info_name, i64 mtime, i64 size,
+ *      str fields[CORE_INFO_NUM_FIELDS], u32 supports_no_game,
+ *      u32 firmware_count,
+ *      firmware_count * { str path, str desc, u32 optional }
+ *   }
+ *
+ * where str is a u32 length (UINT32_MAX for NULL) followed by the
+ * bytes without terminator.
+ */
+
+#define CORE_INFO_CACHE_MAGIC    0x43494152 /* "RAIC" */
+#define CORE_INFO_CACHE_VERSION  1
+#define CORE_INFO_CACHE_FILE     "core_info.cache"
+#define CORE_INFO_CACHE_NULL_STR 0xffffffffu
+
+typedef struct core_info_cache_entry
+{
+   char *info_name;
+   int64_t mtime;
+   int64_t size;
+   core_info_t info;
+} core_info_cache_entry_t;
+
+typedef struct core_info_cache
+{
+   core_info_cache_entry_t *entries;
+   size_t count;
+} core_info_cache_t;
+
+typedef struct core_info_cache_reader
+{
+   RFILE *file;
+   bool error;
+} core_info_cache_reader_t;
+
+static void core_info_free_fields(core_info_t *info)
+{
+   size_t i;
+
+   for (i = 0; i < CORE_INFO_NUM_FIELDS; i++)
+      free(CORE_INFO_FIELD(info, i));
+
+   string_list_free(info->supported_extensions_list);
+   string_list_free(info->authors_list);
+   string_list_free(info->note_list);
+   string_list_free(info->permissions_list);
+   string_list_free(info->licenses_list);
+   string_list_free(info->categories_list);
+   string_list_free(info->databases_list);
+
+   for (i = 0; i < info->firmware_count; i++)
+   {
+      free(info->firmware[i].path);
+      free(info->firmware[i].desc);
+   }
+   free(info->firmware);
+}
+
+static void core_info_cache_path(char *s, size_t len)
+{
+   settings_t *settings = config_get_ptr();
+   const char *dir      = settings->libretro_info_path;
+
+   if (*settings->cache_directory)
+      dir = settings->cache_directory;
+   else if (!*dir)
+      dir = settings->libretro_directory;
+
+   fill_pathname_join(s, dir, CORE_INFO_CACHE_FILE, len);
+}
+
+static uint32_t core_info_cache_read_u32(core_info_cache_reader_t *r)
+{
+   uint32_t val = 0;
+   if (!r->error && retro_fread(r->file, &val, sizeof(val)) != sizeof(val))
+      r->error = true;
+   return val;
+}
+
+static int64_t core_info_cache_read_i64(core_info_cache_reader_t *r)
+{
+   int64_t val = 0;
+   if (!r->error && retro_fread(r->file, &val, sizeof(val)) != sizeof(val))
+      r->error = true;
+   return val;
+}
+
+static char *core_info_cache_read_str(core_info_cache_reader_t *r)
+{
+   char *str    = NULL;
+   uint32_t len = core_info_cache_read_u32(r);
+
+   if (r->error || len == CORE_INFO_CACHE_NULL_STR)
+      return NULL;
+
+   /* Guard against truncated or corrupt files. */
+   if (len > PATH_MAX_LENGTH * 64)
+   {
+      r->error = true;
+      return NULL;
+   }
+
+   str = (char*)malloc(len + 1);
+   if (!str)
+   {
+      r->error = true;
+      return NULL;
+   }
+
+   if (retro_fread(r->file, str, len) != (ssize_t)len)
+   {
+      free(str);
+      r->error = true;
+      return NULL;
+   }
+
+   str[len] = '\0';
+   return str;
+}
+
+static void core_info_cache_read_entry(core_info_cache_reader_t *r,
+      core_info_cache_entry_t *entry)
+{
+   size_t i;
+   core_info_t *info = &entry->info;
 
+   entry->info_name = core_info_cache_read_str(r);
+   entry->mtime     = core_info_cache_read_i64(r);
+   entry->size      = core_info_cache_read_i64(r);
+
+   for (i = 0; i < CORE_INFO_NUM_FIELDS; i++)
+      CORE_INFO_FIELD(info, i) = core_info_cache_read_str(r);
+
+   info->supports_no_game = core_info_cache_read_u32(r);
+   info->firmware_count   = core_info_cache_read_u32(r);
+
+   if (r->error || !info->firmware_count)
+   {
+      info->firmware_count = 0;
+      return;
+   }
+
+   if (info->firmware_count > 1024)
+   {
+      info->firmware_count = 0;
+      r->error             = true;
+      return;
+   }
+
+   info->firmware = (core_info_firmware_t*)
+      calloc(info->firmware_count, sizeof(*info->firmware));
+
+   if (!info->firmware)
+   {
+      info->firmware_count = 0;
+      r->error             = true;
+      return;
+   }
+
+   for (i = 0; i < info->firmware_count; i++)
+   {
+      info->firmware[i].path     = core_info_cache_read_str(r);
+      info->firmware[i].desc     = core_info_cache_read_str(r);
+      info->firmware[i].optional = core_info_cache_read_u32(r);
+   }
+}
+
+static void core_info_cache_free(core_info_cache_t *cache)
+{
+   size_t i;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < cache->count; i++)
+   {
+      free(cache->entries[i].info_name);
+      core_info_free_fields(&cache->entries[i].info);
+   }
+
+   free(cache->entries);
+   free(cache);
+}
+
+static int core_info_cache_entry_cmp(const void *a_, const void *b_)
+{
+   const core_info_cache_entry_t *a = (const core_info_cache_entry_t*)a_;
+   const core_info_cache_entry_t *b = (const core_info_cache_entry_t*)b_;
+
+   return strcmp(a->info_name, b->info_name);
+}
+
+static core_info_cache_t *core_info_cache_load(void)
+{
+   size_t i;
+   uint32_t count;
+   core_info_cache_reader_t r;
+   char path[PATH_MAX_LENGTH] = {0};
+   core_info_cache_t *cache   = NULL;
+
+   core_info_cache_path(path, sizeof(path));
+
+   /* The whole cache is mapped once; every read below is a
+    * plain copy out of the mapping. */
+   r.file  = retro_fopen(path, RFILE_MODE_READ | RFILE_HINT_MMAP, -1);
+   r.error = false;
+
+   if (!r.file)
+      return NULL;
+
+   if (core_info_cache_read_u32(&r) != CORE_INFO_CACHE_MAGIC
+         || core_info_cache_read_u32(&r) != CORE_INFO_CACHE_VERSION)
+      goto error;
+
+   count = core_info_cache_read_u32(&r);
+   if (r.error || count > 65536)
+      goto error;
+
+   cache = (core_info_cache_t*)calloc(1, sizeof(*cache));
+   if (!cache)
+      goto error;
+
+   if (count)
+   {
+      cache->entries = (core_info_cache_entry_t*)
+         calloc(count, sizeof(*cache->entries));
+      if (!cache->entries)
+         goto error;
+   }
+
+   for (i = 0; i < count; i++)
+   {
+      core_info_cache_read_entry(&r, &cache->entries[i]);
+      cache->count++;
+
+      if (r.error || !cache->entries[i].info_name)
+         goto error;
+   }
+
+   retro_fclose(r.file);
+
+   qsort(cache->entries, cache->count, sizeof(*cache->entries),
+         core_info_cache_entry_cmp);
+
+   return cache;
+
+error:
+   RARCH_WARN("Ignoring invalid core info cache: %s.\n", path);
+   retro_fclose(r.file);
+   core_info_cache_free(cache);
+   return NULL;
+}
+
+static core_info_cache_entry_t *core_info_cache_find(
+      core_info_cache_t *cache, const char *info_name)
+{
+   core_info_cache_entry_t key;
+
+   if (!cache || !cache->count)
+      return NULL;
+
+   key.info_name = (char*)info_name;
+
+   return (core_info_cache_entry_t*)bsearch(&key, cache->entries,
+         cache->count, sizeof(*cache->entries),
+         core_info_cache_entry_cmp);
+}
+
+static char *core_info_strdup(const char *s)
+{
+   return s ? strdup(s) : NULL;
+}
+
+/* Copies a cached record into a list entry. Several cores may share
+ * one .info file, so the cache keeps ownership of its strings. */
+static bool core_info_cache_restore(core_info_t *info,
+      const core_info_cache_entry_t *entry)
+{
+   size_t i;
+   const core_info_t *src = &entry->info;
+
+   for (i = 0; i < CORE_INFO_NUM_FIELDS; i++)
+      CORE_INFO_FIELD(info, i) = core_info_strdup(
+            CORE_INFO_FIELD(src, i));
+
+   info->supports_no_game = src->supports_no_game;
+
+   if (src->firmware_count)
+   {
+      info->firmware = (core_info_firmware_t*)
+         calloc(src->firmware_count, sizeof(*info->firmware));
       if (!info->firmware)
+         return false;
+
+      info->firmware_count = src->firmware_count;
+
+      for (i = 0; i < src->firmware_count; i++)
+      {
+         info->firmware[i].path     = core_info_strdup(src->firmware[i].path);
+         info->firmware[i].desc     = core_info_strdup(src->firmware[i].desc);
+         info->firmware[i].optional = src->firmware[i].optional;
+      }
+   }
+
+   return true;
+}
+
+static bool core_info_cache_write_u32(RFILE *file, uint32_t val)
+{
+   return retro_fwrite(file, &val, sizeof(val)) == sizeof(val);
+}
+
+static bool core_info_cache_write_i64(RFILE *file, int64_t val)
+{
+   return retro_fwrite(file, &val, sizeof(val)) == sizeof(val);
+}
+
+static bool core_info_cache_write_str(RFILE *file, const char *s)
+{
+   uint32_t len;
+
+   if (!s)
+      return core_info_cache_write_u32(file, CORE_INFO_CACHE_NULL_STR);
+
+   len = strlen(s);
+   if (!core_info_cache_write_u32(file, len))
+      return false;
+   return retro_fwrite(file, s, len) == (ssize_t)len;
+}
+
+static bool core_info_cache_write_entry(RFILE *file,
+      const core_info_cache_entry_t *entry)
+{
+   size_t i;
+   bool ret                = true;
+   const core_info_t *info = &entry->info;
+
+   ret = ret && core_info_cache_write_str(file, entry->info_name);
+   ret = ret && core_info_cache_write_i64(file, entry->mtime);
+   ret = ret && core_info_cache_write_i64(file, entry->size);
+
+   for (i = 0; i < CORE_INFO_NUM_FIELDS; i++)
+      ret = ret && core_info_cache_write_str(file, CORE_INFO_FIELD(info, i));
+
+   ret = ret && core_info_cache_write_u32(file, info->supports_no_game);
+   ret = ret && core_info_cache_write_u32(file, info->firmware_count);
+
+   for (i = 0; i < info->firmware_count; i++)
+   {
+      ret = ret && core_info_cache_write_str(file, info->firmware[i].path);
+      ret = ret && core_info_cache_write_str(file, info->firmware[i].desc);
+      ret = ret && core_info_cache_write_u32(file, info->firmware[i].optional);
+   }
+
+   return ret;
+}
+
+/* @entries only borrows the strings of the list it was built from. */
+static void core_info_cache_save(const core_info_cache_entry_t *entries,
+      size_t count)
+{
+   size_t i;
+   bool ret                   = true;
+   RFILE *file                = NULL;
+   char path[PATH_MAX_LENGTH] = {0};
+
+   core_info_cache_path(path, sizeof(path));
+
+   file = retro_fopen(path, RFILE_MODE_WRITE, -1);
+   if (!file)
+      return;
+
+   ret = ret && core_info_cache_write_u32(file, CORE_INFO_CACHE_MAGIC);
+   ret = ret && core_info_cache_write_u32(file, CORE_INFO_CACHE_VERSION);
+   ret = ret && core_info_cache_write_u32(file, count);
+
+   for (i = 0; i < count && ret; i++)
+      ret = core_info_cache_write_entry(file, &entries[i]);
+
+   retro_fclose(file);
+
+   if (ret)
+      RARCH_LOG("Wrote core info cache: %s.\n", path);
+   else
+   {
+      RARCH_WARN("Failed to write core info cache: %s.\n", path);
+      remove(path);
+   }
+}
+
+/*
+ * Extension index.
+ *
+ * Open-addressed hash table from a lowercase extension (without
+ * leading dot) to the indices of the cores listing it in
+ * supported_extensions. Indices refer to core_info_list_t::list and
+ * the table is rebuilt whenever that array is reordered.
+ */
+
+typedef struct core_info_ext_bucket
+{
+   char *ext;
+   uint32_t hash;
+   size_t *cores;
+   size_t num_cores;
+} core_info_ext_bucket_t;
+
+struct core_info_ext_index
+{
+   core_info_ext_bucket_t *buckets;
+   size_t size;
+   /* Current list position of each core, by core id. */
+   size_t *pos;
+};
+
+static uint32_t core_info_ext_hash(const char *ext)
+{
+   uint32_t hash = 5381;
+
+   if (*ext == '.')
+      ext++;
+
+   for (; *ext; ext++)
+      hash = ((hash << 5) + hash) + (uint32_t)tolower((unsigned char)*ext);
+
+   return hash;
+}
+
+static core_info_ext_bucket_t *core_info_ext_index_bucket(
+      struct core_info_ext_index *index, const char *ext)
+{
+   uint32_t hash = core_info_ext_hash(ext);
+   size_t i      = hash & (index->size - 1);
+
+   if (*ext == '.')
+      ext++;
+
+   for (;;)
+   {
+      core_info_ext_bucket_t *bucket = &index->buckets[i];
+
+      if (!bucket->ext)
+      {
+         bucket->hash = hash;
+         return bucket;
+      }
+
+      if (bucket->hash == hash && !strcasecmp(bucket->ext, ext))
+         return bucket;
+
+      i = (i + 1) & (index->size - 1);
+   }
+}
+
+static void core_info_ext_index_free(struct core_info_ext_index *index)
+{
+   size_t i;
+
+   if (!index)
+      return;
+
+   for (i = 0; i < index->size; i++)
+   {
+      free(index->buckets[i].ext);
+      free(index->buckets[i].cores);
+   }
+
+   free(index->buckets);
+   free(index->pos);
+   free(index);
+}
+
+static void core_info_list_build_ext_index(core_info_list_t *core_info_list)
+{
+   size_t i, j, num_ext = 0, size = 16;
+   struct core_info_ext_index *index = NULL;
+
+   core_info_ext_index_free(core_info_list->ext_index);
+   core_info_list->ext_index = NULL;
+
+   for (i = 0; i < core_info_list->count; i++)
+      if (core_info_list->list[i].supported_extensions_list)
+         num_ext += core_info_list->list[i].supported_extensions_list->size;
+
+   /* Keep the load factor at or below 50%. */
+   while (size < num_ext * 2)
+      size <<= 1;
+
+   index = (struct core_info_ext_index*)calloc(1, sizeof(*index));
+   if (!index)
+      return;
+
+   index->size    = size;
+   index->buckets = (core_info_ext_bucket_t*)
+      calloc(size, sizeof(*index->buckets));
+   index->pos     = (size_t*)
+      calloc(core_info_list->count + 1, sizeof(*index->pos));
+
+   if (!index->buckets || !index->pos)
+   {
+      free(index->buckets);
+      free(index->pos);
+      free(index);
+      return;
+   }
+
+   /* Buckets refer to cores by id, so sorting the list only
+    * needs the position table refreshed, not a rebuild. */
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      core_info_list->list[i].id = i;
+      index->pos[i]              = i;
+   }
+
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      const struct string_list *exts =
+         core_info_list->list[i].supported_extensions_list;
+
+      if (!exts)
          continue;
 
-      for (c = 0; c < count; c++)
+      for (j = 0; j < exts->size; j++)
       {
-         char path_key[64] = {0};
-         char desc_key[64] = {0};
-         char opt_key[64]  = {0};
+         size_t *cores                  = NULL;
+         const char *ext                = exts->elems[j].data;
+         core_info_ext_bucket_t *bucket = NULL;
+
+         if (!ext || !*ext)
+            continue;
 
-         snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
-         snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
-         snprintf(opt_key, sizeof(opt_key), "firmware%u_opt", c);
+         bucket = core_info_ext_index_bucket(index, ext);
+
+         if (!bucket->ext)
+            bucket->ext = strdup(*ext == '.' ? ext + 1 : ext);
+
+         /* Extensions listed twice by the same core. */
+         if (bucket->num_cores && bucket->cores[bucket->num_cores - 1] == i)
+            continue;
+
+         cores = (size_t*)realloc(bucket->cores,
+               (bucket->num_cores + 1) * sizeof(*bucket->cores));
+         if (!cores)
+            continue;
 
-         config_get_string(config, path_key, &info->firmware[c].path);
-         config_get_string(config, desc_key, &info->firmware[c].desc);
-         config_get_bool(config, opt_key , &info->firmware[c].optional);
+         bucket->cores = cores;
+         bucket->cores[bucket->num_cores++] = i;
       }
    }
+
+   core_info_list->ext_index = index;
+}
+
+static void core_info_list_mark_supported_ext(
+      core_info_list_t *core_info_list, const char *ext)
+{
+   size_t i;
+   core_info_ext_bucket_t *bucket = NULL;
+
+   if (!ext || !*ext || !core_info_list->ext_index)
+      return;
+
+   bucket = core_info_ext_index_bucket(core_info_list->ext_index, ext);
+
+   for (i = 0; i < bucket->num_cores; i++)
+      core_info_list->list[core_info_list->ext_index->pos[
+         bucket->cores[i]]].supports_content = true;
+}
+
+static void core_info_list_update_ext_index(core_info_list_t *core_info_list)
+{
+   size_t i;
+
+   if (!core_info_list->ext_index)
+      return;
+
+   for (i = 0; i < core_info_list->count; i++)
+      core_info_list->ext_index->pos[core_info_list->list[i].id] = i;
 }
 
 void core_info_get_name(const char *path, char *s, size_t len)
@@ -161,7 +827,8 @@ void core_info_get_name(const char *path, char *s, size_t len)
       {
          config_get_string(conf, "corename",
                &core_info[i].core_name);
-         core_info[i].config_data = (void*)conf;
+         core_info[i].has_info = true;
+         config_file_free(conf);
       }
 
       strlcpy(s, core_info[i].core_name, len);
@@ -177,10 +844,14 @@ error:
 core_info_list_t *core_info_list_new(void)
 {
    size_t i;
-   core_info_t *core_info = NULL;
-   core_info_list_t *core_info_list = NULL;
-   settings_t *settings = config_get_ptr();
-   struct string_list *contents = dir_list_new_special(NULL, DIR_LIST_CORES, NULL);
+   bool cache_dirty                  = false;
+   core_info_t *core_info            = NULL;
+   core_info_cache_t *cache          = NULL;
+   core_info_cache_entry_t *records  = NULL;
+   size_t num_records                = 0;
+   core_info_list_t *core_info_list  = NULL;
+   settings_t *settings              = config_get_ptr();
+   struct string_list *contents      = dir_list_new_special(NULL, DIR_LIST_CORES, NULL);
 
    if (!contents)
       return NULL;
@@ -196,9 +867,18 @@ core_info_list_t *core_info_list_new(void)
    core_info_list->list = core_info;
    core_info_list->count = contents->size;
 
+   records = (core_info_cache_entry_t*)
+      calloc(contents->size, sizeof(*records));
+   if (!records)
+      goto error;
+
+   cache = core_info_cache_load();
+
    for (i = 0; i < contents->size; i++)
    {
-      config_file_t *conf                  = NULL;
+      int32_t size                         = 0;
+      int64_t mtime                        = 0;
+      core_info_cache_entry_t *entry       = NULL;
       char info_path_base[PATH_MAX_LENGTH] = {0};
       char info_path[PATH_MAX_LENGTH]      = {0};
       core_info[i].path = strdup(contents->elems[i].data);
@@ -222,74 +902,47 @@ core_info_list_t *core_info_list_new(void)
             settings->libretro_info_path : settings->libretro_directory,
             info_path_base, sizeof(info_path));
 
-      conf = config_file_new(info_path);
-
-      if (conf)
+      if (path_stat(info_path, &size, &mtime))
       {
-         unsigned count = 0;
-         config_get_string(conf, "display_name",
-               &core_info[i].display_name);
-         config_get_string(conf, "corename",
-               &core_info[i].core_name);
-         config_get_string(conf, "systemname",
-               &core_info[i].systemname);
-         config_get_string(conf, "manufacturer",
-               &core_info[i].system_manufacturer);
-         config_get_uint(conf, "firmware_count", &count);
-         core_info[i].firmware_count = count;
-         if (config_get_string(conf, "supported_extensions",
-                  &core_info[i].supported_extensions) &&
-               core_info[i].supported_extensions)
-            core_info[i].supported_extensions_list =
-               string_split(core_info[i].supported_extensions, "|");
-
-         if (config_get_string(conf, "authors",
-                  &core_info[i].authors) &&
-               core_info[i].authors)
-            core_info[i].authors_list =
-               string_split(core_info[i].authors, "|");
-
-         if (config_get_string(conf, "permissions",
-                  &core_info[i].permissions) &&
-               core_info[i].permissions)
-            core_info[i].permissions_list =
-               string_split(core_info[i].permissions, "|");
-
-         if (config_get_string(conf, "license",
-                  &core_info[i].licenses) &&
-               core_info[i].licenses)
-            core_info[i].licenses_list =
-               string_split(core_info[i].licenses, "|");
-
-         if (config_get_string(conf, "categories",
-                  &core_info[i].categories) &&
-               core_info[i].categories)
-            core_info[i].categories_list =
-               string_split(core_info[i].categories, "|");
-
-         if (config_get_string(conf, "database",
-                  &core_info[i].databases) &&
-               core_info[i].databases)
-            core_info[i].databases_list =
-               string_split(core_info[i].databases, "|");
-
-         if (config_get_string(conf, "notes",
-                  &core_info[i].notes) &&
-               core_info[i].notes)
-            core_info[i].note_list = string_split(core_info[i].notes, "|");
-
-         config_get_bool(conf, "supports_no_game",
-               &core_info[i].supports_no_game);
-
-         core_info[i].config_data = conf;
+         entry = core_info_cache_find(cache, info_path_base);
+
+         if (entry && entry->mtime == mtime && entry->size == size)
+            core_info[i].has_info = core_info_cache_restore(
+                  &core_info[i], entry);
+         else
+         {
+            core_info[i].has_info = core_info_parse_file(
+                  &core_info[i], info_path);
+            cache_dirty           = true;
+         }
+
+         if (core_info[i].has_info)
+         {
+            records[num_records].info_name = strdup(info_path_base);
+            records[num_records].mtime     = mtime;
+            records[num_records].size      = size;
+            records[num_records].info      = core_info[i];
+            num_records++;
+         }
       }
 
+      core_info_split_lists(&core_info[i]);
+
       if (!core_info[i].display_name)
          core_info[i].display_name = strdup(path_basename(core_info[i].path));
    }
 
+   /* Also rewrite the cache when .info files went away. */
+   if (cache_dirty || !cache || cache->count != num_records)
+      core_info_cache_save(records, num_records);
+
+   for (i = 0; i < num_records; i++)
+      free(records[i].info_name);
+   free(records);
+   core_info_cache_free(cache);
+
    core_info_list_resolve_all_extensions(core_info_list);
-   core_info_list_resolve_all_firmware(core_info_list);
+   core_info_list_build_ext_index(core_info_list);
 
    dir_list_free(contents);
    return core_info_list;
@@ -303,7 +956,7 @@ error:
 
 void core_info_list_free(core_info_list_t *core_info_list)
 {
-   size_t i, j;
+   size_t i;
 
    if (!core_info_list)
       return;
@@ -316,35 +969,10 @@ void core_info_list_free(core_info_list_t *core_info_list)
          continue;
 
       free(info->path);
-      free(info->core_name);
-      free(info->systemname);
-      free(info->system_manufacturer);
-      free(info->display_name);
-      free(info->supported_extensions);
-      free(info->authors);
-      free(info->permissions);
-      free(info->licenses);
-      free(info->categories);
-      free(info->databases);
-      free(info->notes);
-      if (info->supported_extensions_list)
-         string_list_free(info->supported_extensions_list);
-      string_list_free(info->authors_list);
-      string_list_free(info->note_list);
-      string_list_free(info->permissions_list);
-      string_list_free(info->licenses_list);
-      string_list_free(info->categories_list);
-      string_list_free(info->databases_list);
-      config_file_free((config_file_t*)info->config_data);
-
-      for (j = 0; j < info->firmware_count; j++)
-      {
-         free(info->firmware[j].path);
-         free(info->firmware[j].desc);
-      }
-      free(info->firmware);
+      core_info_free_fields(info);
    }
 
+   core_info_ext_index_free(core_info_list->ext_index);
    free(core_info_list->all_ext);
    free(core_info_list->list);
    free(core_info_list);
@@ -358,10 +986,7 @@ size_t core_info_list_num_info_files(core_info_list_t *core_info_list)
       return 0;
 
    for (i = 0; i < core_info_list->count; i++)
-   {
-      config_file_t *conf = (config_file_t*)core_info_list->list[i].config_data;
-      num += !!conf;
-   }
+      num += core_info_list->list[i].has_info;
 
    return num;
 }
@@ -481,21 +1106,13 @@ const char *core_info_list_get_all_extensions(void)
    return list->all_ext;
 }
 
-/* qsort_r() is not in standard C, sadly. */
-static const char *core_info_tmp_path;
-static const struct string_list *core_info_tmp_list;
-
 static int core_info_qsort_cmp(const void *a_, const void *b_)
 {
    const core_info_t *a = (const core_info_t*)a_;
    const core_info_t *b = (const core_info_t*)b_;
-   int support_a        = core_info_does_support_any_file(a, core_info_tmp_list) ||
-      core_info_does_support_file(a, core_info_tmp_path);
-   int support_b        = core_info_does_support_any_file(b, core_info_tmp_list) ||
-      core_info_does_support_file(b, core_info_tmp_path);
 
-   if (support_a != support_b)
-      return support_b - support_a;
+   if (a->supports_content != b->supports_content)
+      return b->supports_content - a->supports_content;
    return strcasecmp(a->display_name, b->display_name);
 }
 
@@ -510,12 +1127,23 @@ void core_info_list_get_supported_cores(core_info_list_t *core_info_list,
 
    (void)list;
 
-   core_info_tmp_path = path;
+   for (i = 0; i < core_info_list->count; i++)
+      core_info_list->list[i].supports_content = false;
+
+   core_info_list_mark_supported_ext(core_info_list,
+         path_get_extension(path));
 
 #ifdef HAVE_ZLIB
    if (!strcasecmp(path_get_extension(path), "zip"))
       list = zlib_get_file_list(path, NULL);
-   core_info_tmp_list = list;
+
+   if (list)
+   {
+      for (i = 0; i < list->size; i++)
+         core_info_list_mark_supported_ext(core_info_list,
+               path_get_extension(list->elems[i].data));
+      string_list_free(list);
+   }
 #endif
 
    /* Let supported core come first in list so we can return 
@@ -523,29 +1151,15 @@ void core_info_list_get_supported_cores(core_info_list_t *core_info_list,
    qsort(core_info_list->list, core_info_list->count,
          sizeof(core_info_t), core_info_qsort_cmp);
 
+   /* Sorting moved the cores, track their new positions. */
+   core_info_list_update_ext_index(core_info_list);
+
    for (i = 0; i < core_info_list->count; i++, supported++)
    {
-      const core_info_t *core = &core_info_list->list[i];
-
-      if (!core)
-         continue;
-
-      if (core_info_does_support_file(core, path))
-         continue;
-
-#ifdef HAVE_ZLIB
-      if (core_info_does_support_any_file(core, list))
-         continue;
-#endif
-
-      break;
+      if (!core_info_list->list[i].supports_content)
+         break;
    }
 
-#ifdef HAVE_ZLIB
-   if (list)
-      string_list_free(list);
-#endif
-
    *infos = core_info_list->list;
    *num_infos = supported;
 }
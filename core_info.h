@@ -20,6 +20,8 @@
 
 #include <stddef.h>
 
+#include <boolean.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -37,7 +39,13 @@ typedef struct
 typedef struct
 {
    char *path;
-   void *config_data;
+   /* Set when a .info file was found for this core,
+    * either parsed directly or restored from the cache. */
+   bool has_info;
+   /* Scratch flag used to sort supported cores first. */
+   bool supports_content;
+   /* Position at list creation, stays valid across sorts. */
+   size_t id;
    char *display_name;
    char *core_name;
    char *system_manufacturer;
@@ -63,11 +71,15 @@ typedef struct
    void *userdata;
 } core_info_t;
 
+struct core_info_ext_index;
+
 typedef struct
 {
    core_info_t *list;
    size_t count;
    char *all_ext;
+   /* Maps a content extension to the cores supporting it. */
+   struct core_info_ext_index *ext_index;
 } core_info_list_t;
 
 core_info_list_t *core_info_list_new(void);
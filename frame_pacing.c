@@ -0,0 +1,251 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <retro_miscellaneous.h>
+
+#include "frame_pacing.h"
+#include "performance.h"
+#include "verbosity.h"
+
+/* Recent core + submit times the start-late delay is sized from.
+ * The worst of them is used, so one slow frame holds it back. */
+#define FRAME_PACING_WORK_SAMPLES 32
+
+/* Headroom kept between the predicted end of a frame and its
+ * deadline, in microseconds. */
+#define FRAME_PACING_MARGIN       1000
+
+/* Spin at least this long at the end of a wait, and at most
+ * FRAME_PACING_SPIN_MAX however badly sleeps overshoot. */
+#define FRAME_PACING_SPIN_MIN     200
+#define FRAME_PACING_SPIN_MAX     4000
+
+/* Longer gaps between presents are pauses or loading,
+ * not frames. */
+#define FRAME_PACING_MAX_INTERVAL 250000
+
+static struct
+{
+   retro_time_t period;
+   /* Measured period, follows the display's actual rate. */
+   retro_time_t estimate;
+   /* Extra headroom after a missed deadline, decays back to 0. */
+   retro_time_t backoff;
+   /* How late retro_sleep() tends to wake up. */
+   retro_time_t oversleep;
+
+   retro_time_t last_present;
+   retro_time_t run_start;
+   retro_time_t submit;
+   retro_time_t deadline;
+
+   retro_time_t work[FRAME_PACING_WORK_SAMPLES];
+   unsigned work_index;
+
+   /* Welford's running mean and variance of present intervals. */
+   uint64_t samples;
+   double mean;
+   double m2;
+
+   uint64_t missed;
+   uint64_t delayed;
+   double delay_total;
+} frame_pacing;
+
+void frame_pacing_reset(void)
+{
+   memset(&frame_pacing, 0, sizeof(frame_pacing));
+}
+
+void frame_pacing_set_period(retro_time_t period)
+{
+   if (period == frame_pacing.period)
+      return;
+
+   frame_pacing.period   = period;
+   frame_pacing.estimate = period;
+   frame_pacing.backoff  = 0;
+   frame_pacing.deadline = 0;
+}
+
+void frame_pacing_wait_until(retro_time_t target)
+{
+   retro_time_t now  = retro_get_time_usec();
+   retro_time_t spin = FRAME_PACING_SPIN_MIN + 2 * frame_pacing.oversleep;
+
+   if (spin > FRAME_PACING_SPIN_MAX)
+      spin = FRAME_PACING_SPIN_MAX;
+
+   while (target - now > spin + 1000)
+   {
+      unsigned msec       = (unsigned)((target - now - spin) / 1000);
+      retro_time_t before = now;
+      retro_time_t late;
+
+      retro_sleep(msec);
+      now  = retro_get_time_usec();
+      late = (now - before) - (retro_time_t)msec * 1000;
+
+      if (late < 0)
+         late = 0;
+      frame_pacing.oversleep += (late - frame_pacing.oversleep) / 8;
+   }
+
+   while (now < target)
+      now = retro_get_time_usec();
+}
+
+static retro_time_t frame_pacing_work(void)
+{
+   unsigned i;
+   retro_time_t work = 0;
+
+   for (i = 0; i < FRAME_PACING_WORK_SAMPLES; i++)
+      work = max(work, frame_pacing.work[i]);
+
+   return work;
+}
+
+void frame_pacing_run_late(retro_time_t deadline)
+{
+   retro_time_t now = retro_get_time_usec();
+   retro_time_t wake;
+
+   frame_pacing.run_start = now;
+   frame_pacing.deadline  = 0;
+
+   if (!frame_pacing.estimate)
+      return;
+
+   if (!deadline)
+   {
+      if (!frame_pacing.last_present)
+         return;
+
+      /* Presents that already slipped move the deadline along. */
+      deadline = frame_pacing.last_present + frame_pacing.estimate;
+      if (deadline <= now)
+         deadline += ((now - deadline) / frame_pacing.estimate + 1)
+            * frame_pacing.estimate;
+   }
+
+   frame_pacing.deadline = deadline;
+
+   wake = deadline - frame_pacing_work()
+      - FRAME_PACING_MARGIN - frame_pacing.backoff;
+
+   /* Never hold the core back for a whole frame. */
+   if (wake - now >= frame_pacing.estimate)
+      wake = now + frame_pacing.estimate - FRAME_PACING_MARGIN;
+
+   if (wake <= now)
+      return;
+
+   frame_pacing_wait_until(wake);
+
+   frame_pacing.run_start    = retro_get_time_usec();
+   frame_pacing.delay_total += frame_pacing.run_start - now;
+   frame_pacing.delayed++;
+}
+
+void frame_pacing_submit(void)
+{
+   frame_pacing.submit = retro_get_time_usec();
+}
+
+void frame_pacing_present(void)
+{
+   retro_time_t now = retro_get_time_usec();
+
+   if (frame_pacing.run_start && frame_pacing.submit)
+   {
+      frame_pacing.work[frame_pacing.work_index] =
+         frame_pacing.submit - frame_pacing.run_start;
+      frame_pacing.work_index = (frame_pacing.work_index + 1)
+         % FRAME_PACING_WORK_SAMPLES;
+   }
+
+   if (frame_pacing.last_present)
+   {
+      retro_time_t interval = now - frame_pacing.last_present;
+
+      if (interval < FRAME_PACING_MAX_INTERVAL)
+      {
+         double delta = interval - frame_pacing.mean;
+
+         frame_pacing.samples++;
+         frame_pacing.mean += delta / frame_pacing.samples;
+         frame_pacing.m2   += delta * (interval - frame_pacing.mean);
+
+         /* Only intervals close to the nominal period refine
+          * the estimate, a missed vblank is not a new rate. */
+         if (frame_pacing.period
+               && interval > frame_pacing.period * 3 / 4
+               && interval < frame_pacing.period * 5 / 4)
+            frame_pacing.estimate += (interval - frame_pacing.estimate) / 16;
+      }
+   }
+
+   if (frame_pacing.deadline)
+   {
+      if (now > frame_pacing.deadline + frame_pacing.estimate / 2)
+      {
+         frame_pacing.missed++;
+         frame_pacing.backoff = min(frame_pacing.backoff
+               + frame_pacing.estimate / 8, frame_pacing.estimate / 2);
+      }
+      else
+         frame_pacing.backoff -= frame_pacing.backoff / 64;
+   }
+
+   frame_pacing.last_present = now;
+   frame_pacing.run_start    = 0;
+   frame_pacing.submit       = 0;
+   frame_pacing.deadline     = 0;
+}
+
+bool frame_pacing_get_stats(struct frame_pacing_stats *stats)
+{
+   if (!stats || frame_pacing.samples < 2)
+      return false;
+
+   stats->samples = frame_pacing.samples;
+   stats->mean    = frame_pacing.mean;
+   stats->stddev  = sqrt(frame_pacing.m2 / (frame_pacing.samples - 1));
+   stats->missed  = frame_pacing.missed;
+   stats->delay   = frame_pacing.delayed
+      ? frame_pacing.delay_total / frame_pacing.delayed : 0.0;
+
+   return true;
+}
+
+void frame_pacing_log(void)
+{
+   struct frame_pacing_stats stats;
+
+   if (!frame_pacing_get_stats(&stats))
+      return;
+
+   RARCH_LOG("Frame pacing: %.3f ms mean, %.3f ms stddev between presents"
+         " over %llu frames, %llu missed deadlines, core started %.3f ms late on average.\n",
+         stats.mean / 1000.0, stats.stddev / 1000.0,
+         (unsigned long long)stats.samples,
+         (unsigned long long)stats.missed,
+         stats.delay / 1000.0);
+}
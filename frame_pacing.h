@@ -0,0 +1,90 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_FRAME_PACING_H
+#define __RARCH_FRAME_PACING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <boolean.h>
+
+#include "libretro.h"
+
+/* Present-to-present timing, over every frame since
+ * the last frame_pacing_reset(). */
+struct frame_pacing_stats
+{
+   uint64_t samples;
+   /* Interval between presents, in microseconds. */
+   double mean;
+   double stddev;
+   /* Presents that landed at least half a period late. */
+   uint64_t missed;
+   /* Average time the core start was pushed back, in microseconds. */
+   double delay;
+};
+
+void frame_pacing_reset(void);
+
+/**
+ * frame_pacing_set_period:
+ * @period              : nominal time between presents in
+ *                        microseconds, or 0 when nothing paces
+ *                        presents (no vsync and no frame limit).
+ *
+ * Sets the period deadlines are predicted from.
+ **/
+void frame_pacing_set_period(retro_time_t period);
+
+/**
+ * frame_pacing_wait_until:
+ * @target              : time to wait for, as retro_get_time_usec().
+ *
+ * Sleeps until shortly before @target, then spins the rest
+ * of the way. The spin is sized from how late sleeps have
+ * been waking up.
+ **/
+void frame_pacing_wait_until(retro_time_t target);
+
+/**
+ * frame_pacing_run_late:
+ * @deadline            : time the next frame should be presented,
+ *                        or 0 to predict it from past presents.
+ *
+ * Called right before running the core. Waits until the core
+ * has just enough time left to finish its frame by the
+ * deadline, so its input is polled as late as possible.
+ **/
+void frame_pacing_run_late(retro_time_t deadline);
+
+/* Called by the video driver wrapper around handing a frame
+ * to the driver. With vsync, the driver returns on present. */
+void frame_pacing_submit(void);
+
+void frame_pacing_present(void);
+
+bool frame_pacing_get_stats(struct frame_pacing_stats *stats);
+
+void frame_pacing_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
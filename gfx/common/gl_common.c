@@ -14,6 +14,10 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <compat/strl.h>
+#include <file/file_extract.h>
+#include <retro_file.h>
+
 #include "gl_common.h"
 
 void gl_ff_vertex(const void *data)
@@ -48,6 +52,138 @@ void gl_ff_matrix(const void *data)
 #endif
 }
 
+/* LUT textures outlive the shader that loaded them, so that
+ * reloading a preset does not decode and upload its images
+ * again. An entry is reused while the file keeps the same
+ * size and CRC32; modification times are too coarse to catch
+ * an image saved twice in a second. Entries are only dropped
+ * for room once no shader uses them. */
+#define GL_LUT_CACHE_SIZE (GFX_MAX_TEXTURES * 2)
+
+struct gl_lut_cache_entry
+{
+   char path[PATH_MAX_LENGTH];
+   uint32_t crc;
+   ssize_t size;
+   enum texture_filter_type filter_type;
+   enum gfx_wrap_type wrap;
+
+   GLuint texture;
+   unsigned refs;
+   uint64_t last_use;
+};
+
+static struct gl_lut_cache_entry gl_lut_cache[GL_LUT_CACHE_SIZE];
+static uint64_t gl_lut_cache_uses;
+
+static GLuint gl_lut_cache_find(const char *path, uint32_t crc,
+      ssize_t size, enum texture_filter_type filter_type,
+      enum gfx_wrap_type wrap)
+{
+   unsigned i;
+
+   for (i = 0; i < GL_LUT_CACHE_SIZE; i++)
+   {
+      struct gl_lut_cache_entry *entry = &gl_lut_cache[i];
+
+      if (!entry->texture
+            || entry->crc         != crc
+            || entry->size        != size
+            || entry->filter_type != filter_type
+            || entry->wrap        != wrap
+            || strcmp(entry->path, path))
+         continue;
+
+      entry->refs++;
+      entry->last_use = ++gl_lut_cache_uses;
+      return entry->texture;
+   }
+
+   return 0;
+}
+
+/* Returns false when every entry is in use, the texture is
+ * then owned by the caller alone. */
+static bool gl_lut_cache_add(const char *path, uint32_t crc,
+      ssize_t size, enum texture_filter_type filter_type,
+      enum gfx_wrap_type wrap, GLuint texture)
+{
+   unsigned i;
+   struct gl_lut_cache_entry *entry = NULL;
+
+   for (i = 0; i < GL_LUT_CACHE_SIZE; i++)
+   {
+      struct gl_lut_cache_entry *cur = &gl_lut_cache[i];
+
+      if (!cur->texture)
+      {
+         entry = cur;
+         break;
+      }
+
+      if (!cur->refs && (!entry || cur->last_use < entry->last_use))
+         entry = cur;
+   }
+
+   if (!entry)
+      return false;
+
+   if (entry->texture)
+      glDeleteTextures(1, &entry->texture);
+
+   strlcpy(entry->path, path, sizeof(entry->path));
+   entry->crc         = crc;
+   entry->size        = size;
+   entry->filter_type = filter_type;
+   entry->wrap        = wrap;
+   entry->texture     = texture;
+   entry->refs        = 1;
+   entry->last_use    = ++gl_lut_cache_uses;
+   return true;
+}
+
+static void gl_lut_cache_release(GLuint texture)
+{
+   unsigned i;
+
+   for (i = 0; i < GL_LUT_CACHE_SIZE; i++)
+   {
+      if (gl_lut_cache[i].texture != texture)
+         continue;
+
+      if (gl_lut_cache[i].refs)
+         gl_lut_cache[i].refs--;
+      return;
+   }
+
+   glDeleteTextures(1, &texture);
+}
+
+void gl_lut_cache_free(void)
+{
+   unsigned i;
+
+   for (i = 0; i < GL_LUT_CACHE_SIZE; i++)
+   {
+      if (gl_lut_cache[i].texture)
+         glDeleteTextures(1, &gl_lut_cache[i].texture);
+   }
+
+   memset(gl_lut_cache, 0, sizeof(gl_lut_cache));
+}
+
+void gl_release_luts(GLuint *textures_lut)
+{
+   unsigned i;
+
+   for (i = 0; i < GFX_MAX_TEXTURES; i++)
+   {
+      if (textures_lut[i])
+         gl_lut_cache_release(textures_lut[i]);
+      textures_lut[i] = 0;
+   }
+}
+
 bool gl_load_luts(const struct video_shader *shader,
       GLuint *textures_lut)
 {
@@ -57,22 +193,20 @@ bool gl_load_luts(const struct video_shader *shader,
    if (!shader->luts)
       return true;
 
-   glGenTextures(num_luts, textures_lut);
-
    for (i = 0; i < num_luts; i++)
    {
       struct texture_image img = {0};
       enum texture_filter_type filter_type = TEXTURE_FILTER_LINEAR;
+      const char *path = shader->lut[i].path;
+      void *buf        = NULL;
+      ssize_t size     = 0;
+      uint32_t crc     = 0;
 
-      RARCH_LOG("Loading texture image from: \"%s\" ...\n",
-            shader->lut[i].path);
-
-      if (!texture_image_load(&img, shader->lut[i].path))
-      {
-         RARCH_ERR("Failed to load texture image from: \"%s\"\n",
-               shader->lut[i].path);
-         return false;
-      }
+      /* Hashing the file is far cheaper than decoding and
+       * uploading it again. */
+      if (retro_read_file(path, &buf, &size) > 0)
+         crc = zlib_crc32_calculate((const uint8_t*)buf, size);
+      free(buf);
 
       if (shader->lut[i].filter == RARCH_FILTER_NEAREST)
          filter_type = TEXTURE_FILTER_NEAREST;
@@ -85,12 +219,34 @@ bool gl_load_luts(const struct video_shader *shader,
             filter_type = TEXTURE_FILTER_MIPMAP_LINEAR;
       }
 
+      textures_lut[i] = gl_lut_cache_find(path, crc, size,
+            filter_type, shader->lut[i].wrap);
+
+      if (textures_lut[i])
+      {
+         RARCH_LOG("Reusing texture image: \"%s\".\n", path);
+         continue;
+      }
+
+      RARCH_LOG("Loading texture image from: \"%s\" ...\n", path);
+
+      if (!texture_image_load(&img, path))
+      {
+         RARCH_ERR("Failed to load texture image from: \"%s\"\n", path);
+         gl_release_luts(textures_lut);
+         return false;
+      }
+
+      glGenTextures(1, &textures_lut[i]);
       gl_load_texture_data(textures_lut[i],
             shader->lut[i].wrap,
             filter_type, 4,
             img.width, img.height,
             img.pixels, sizeof(uint32_t));
       texture_image_free(&img);
+
+      gl_lut_cache_add(path, crc, size, filter_type,
+            shader->lut[i].wrap, textures_lut[i]);
    }
 
    glBindTexture(GL_TEXTURE_2D, 0);
@@ -42,6 +42,12 @@
 #endif
 #endif
 
+#if !defined(HAVE_OPENGLES) && !defined(HAVE_PSGL)
+#ifdef GL_PIXEL_UNPACK_BUFFER
+#define HAVE_GL_ASYNC_UPLOAD
+#endif
+#endif
+
 #if defined(HAVE_PSGL)
 #define RARCH_GL_FRAMEBUFFER GL_FRAMEBUFFER_OES
 #define RARCH_GL_FRAMEBUFFER_COMPLETE GL_FRAMEBUFFER_COMPLETE_OES
@@ -274,6 +280,13 @@ typedef struct gl
 #endif
    void *readback_buffer_screenshot;
 
+#ifdef HAVE_GL_ASYNC_UPLOAD
+   /* PBO core frames are streamed through. */
+   GLuint pbo_upload;
+   size_t pbo_upload_size;
+   bool pbo_upload_enable;
+#endif
+
 #if defined(HAVE_MENU)
    GLuint menu_texture;
    bool menu_texture_enable;
@@ -320,6 +333,14 @@ static INLINE bool gl_check_error(void)
 bool gl_load_luts(const struct video_shader *generic_shader,
       GLuint *lut_textures);
 
+/* Hands back the GFX_MAX_TEXTURES textures gl_load_luts() gave
+ * out and zeroes them. They stay cached for the next preset. */
+void gl_release_luts(GLuint *lut_textures);
+
+/* Deletes every cached LUT texture. Call before the GL context
+ * goes away. */
+void gl_lut_cache_free(void);
+
 static INLINE unsigned gl_wrap_type_to_enum(enum gfx_wrap_type type)
 {
    switch (type)
@@ -45,6 +45,9 @@ static XIC g_x11_xic;
 static bool g_x11_true_full;
 
 unsigned g_x11_screen;
+/* Size of g_x11_win as of the last ConfigureNotify. */
+unsigned g_x11_width;
+unsigned g_x11_height;
 
 #define XA_INIT(x) XA##x = XInternAtom(dpy, #x, False)
 #define _NET_WM_STATE_ADD 1
@@ -411,6 +414,14 @@ bool x11_alive(void *data)
                g_x11_quit = true;
             break;
 
+         case ConfigureNotify:
+            if (event.xconfigure.window == g_x11_win)
+            {
+               g_x11_width  = event.xconfigure.width;
+               g_x11_height = event.xconfigure.height;
+            }
+            break;
+
          case MapNotify:
             if (event.xmap.window == g_x11_win)
                g_x11_has_focus = true;
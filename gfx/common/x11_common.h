@@ -39,6 +39,8 @@ extern Window   g_x11_win;
 extern Display *g_x11_dpy;
 extern Colormap g_x11_cmap;
 extern unsigned g_x11_screen;
+extern unsigned g_x11_width;
+extern unsigned g_x11_height;
 
 void x11_save_last_used_monitor(Window win);
 void x11_show_mouse(Display *dpy, Window win, bool state);
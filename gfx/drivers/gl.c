@@ -434,7 +434,7 @@ static void gl_compute_fbo_geometry(gl_t *gl, unsigned width, unsigned height,
    }
 }
 
-static void gl_create_fbo_texture(gl_t *gl, unsigned i, GLuint texture)
+static void gl_set_fbo_texture_sampling(gl_t *gl, unsigned i, GLuint texture)
 {
    settings_t *settings = config_get_ptr();
 
@@ -442,7 +442,6 @@ static void gl_create_fbo_texture(gl_t *gl, unsigned i, GLuint texture)
    GLenum min_filter, mag_filter, wrap_enum;
    bool mipmapped = false;
    bool smooth = false;
-   bool fp_fbo, srgb_fbo;
 
    GLuint base_filt     = settings->video.smooth ? GL_LINEAR : GL_NEAREST;
    GLuint base_mip_filt = settings->video.smooth ? 
@@ -469,6 +468,14 @@ static void gl_create_fbo_texture(gl_t *gl, unsigned i, GLuint texture)
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_enum);
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_enum);
+}
+
+static void gl_create_fbo_texture(gl_t *gl, unsigned i, GLuint texture)
+{
+   settings_t *settings = config_get_ptr();
+   bool fp_fbo, srgb_fbo;
+
+   gl_set_fbo_texture_sampling(gl, i, texture);
 
    fp_fbo   = gl->fbo_scale[i].fp_fbo;
    srgb_fbo = gl->fbo_scale[i].srgb_fbo;
@@ -540,10 +547,17 @@ static void gl_create_fbo_texture(gl_t *gl, unsigned i, GLuint texture)
 static void gl_create_fbo_textures(gl_t *gl)
 {
    int i;
-   glGenTextures(gl->fbo_pass, gl->fbo_texture);
 
    for (i = 0; i < gl->fbo_pass; i++)
    {
+      /* Kept from the last shader, only its sampling may differ. */
+      if (gl->fbo_texture[i])
+      {
+         gl_set_fbo_texture_sampling(gl, i, gl->fbo_texture[i]);
+         continue;
+      }
+
+      glGenTextures(1, &gl->fbo_texture[i]);
       gl_create_fbo_texture(gl, i, gl->fbo_texture[i]);
    }
 
@@ -565,10 +579,13 @@ static bool gl_create_fbo_targets(gl_t *gl)
       return false;
 
    glBindTexture(GL_TEXTURE_2D, 0);
-   glGenFramebuffers(gl->fbo_pass, gl->fbo);
 
    for (i = 0; i < gl->fbo_pass; i++)
    {
+      if (gl->fbo[i])
+         continue;
+
+      glGenFramebuffers(1, &gl->fbo[i]);
       glBindFramebuffer(RARCH_GL_FRAMEBUFFER, gl->fbo[i]);
       glFramebufferTexture2D(RARCH_GL_FRAMEBUFFER,
             RARCH_GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gl->fbo_texture[i], 0);
@@ -598,8 +615,10 @@ static bool gl_create_fbo_targets(gl_t *gl)
 
 error:
    glDeleteFramebuffers(gl->fbo_pass, gl->fbo);
+   memset(gl->fbo, 0, sizeof(gl->fbo));
    if (gl->fbo_feedback)
       glDeleteFramebuffers(1, &gl->fbo_feedback);
+   gl->fbo_feedback = 0;
    RARCH_ERR("Failed to set up frame buffer objects. Multi-pass shading will not work.\n");
    return false;
 }
@@ -627,16 +646,17 @@ static void gl_deinit_fbo(gl_t *gl)
    gl->fbo_feedback = 0;
 }
 
-/* Set up render to texture. */
+/* Lays out the FBO chain of the current shader, without
+ * creating anything. Returns false if it needs no FBOs. */
 
-static void gl_init_fbo(gl_t *gl, unsigned fbo_width, unsigned fbo_height)
+static bool gl_init_fbo_geometry(gl_t *gl, unsigned fbo_width, unsigned fbo_height)
 {
    int i;
    unsigned width, height;
    struct gfx_fbo_scale scale, scale_last;
 
    if (!gl || video_shader_driver_num_shaders() == 0)
-      return;
+      return false;
 
    video_driver_get_size(&width, &height);
 
@@ -645,12 +665,12 @@ static void gl_init_fbo(gl_t *gl, unsigned fbo_width, unsigned fbo_height)
 
    /* we always want FBO to be at least initialized on startup for consoles */
    if (video_shader_driver_num_shaders() == 1 && !scale.valid)
-      return;
+      return false;
 
    if (!gl_check_fbo_proc(gl))
    {
       RARCH_ERR("Failed to locate FBO functions. Won't be able to use render-to-texture.\n");
-      return;
+      return false;
    }
 
    gl->fbo_pass = video_shader_driver_num_shaders() - 1;
@@ -686,8 +706,6 @@ static void gl_init_fbo(gl_t *gl, unsigned fbo_width, unsigned fbo_height)
    {
       gl->fbo_rect[i].width  = next_pow2(gl->fbo_rect[i].img_width);
       gl->fbo_rect[i].height = next_pow2(gl->fbo_rect[i].img_height);
-      RARCH_LOG("[GL]: Creating FBO %d @ %ux%u\n", i,
-            gl->fbo_rect[i].width, gl->fbo_rect[i].height);
    }
 
    gl->fbo_feedback_enable = video_shader_driver_get_feedback_pass(&gl->fbo_feedback_pass);
@@ -704,10 +722,31 @@ static void gl_init_fbo(gl_t *gl, unsigned fbo_width, unsigned fbo_height)
       gl->fbo_feedback_enable = false;
    }
 
+   return true;
+}
+
+/* Creates the FBOs laid out by gl_init_fbo_geometry(),
+ * except for passes that already have one. */
+
+static void gl_init_fbo_targets(gl_t *gl)
+{
+   int i;
+
+   for (i = 0; i < gl->fbo_pass; i++)
+   {
+      if (!gl->fbo_texture[i])
+         RARCH_LOG("[GL]: Creating FBO %d @ %ux%u\n", i,
+               gl->fbo_rect[i].width, gl->fbo_rect[i].height);
+   }
+
    gl_create_fbo_textures(gl);
    if (!gl_create_fbo_targets(gl))
    {
       glDeleteTextures(gl->fbo_pass, gl->fbo_texture);
+      memset(gl->fbo_texture, 0, sizeof(gl->fbo_texture));
+      if (gl->fbo_feedback_texture)
+         glDeleteTextures(1, &gl->fbo_feedback_texture);
+      gl->fbo_feedback_texture = 0;
       RARCH_ERR("Failed to create FBO targets. Will continue without FBO.\n");
       return;
    }
@@ -715,6 +754,82 @@ static void gl_init_fbo(gl_t *gl, unsigned fbo_width, unsigned fbo_height)
    gl->fbo_inited = true;
 }
 
+/* Set up render to texture. */
+
+static void gl_init_fbo(gl_t *gl, unsigned fbo_width, unsigned fbo_height)
+{
+   if (gl_init_fbo_geometry(gl, fbo_width, fbo_height))
+      gl_init_fbo_targets(gl);
+}
+
+/* Moves to the FBO chain of a new shader. Passes whose
+ * texture keeps its size and format keep their texture and
+ * framebuffer, everything else is created again. */
+
+static void gl_reinit_fbo(gl_t *gl, unsigned fbo_width, unsigned fbo_height)
+{
+   int i;
+   unsigned kept = 0;
+   int old_pass  = gl->fbo_inited ? gl->fbo_pass : 0;
+   GLuint old_fbo[GFX_MAX_SHADERS];
+   GLuint old_texture[GFX_MAX_SHADERS];
+   struct gfx_fbo_rect old_rect[GFX_MAX_SHADERS];
+   struct gfx_fbo_scale old_scale[GFX_MAX_SHADERS];
+
+   memcpy(old_fbo,     gl->fbo,         sizeof(old_fbo));
+   memcpy(old_texture, gl->fbo_texture, sizeof(old_texture));
+   memcpy(old_rect,    gl->fbo_rect,    sizeof(old_rect));
+   memcpy(old_scale,   gl->fbo_scale,   sizeof(old_scale));
+
+   /* Feedback is cleared when created, it is never kept. */
+   if (gl->fbo_feedback)
+      glDeleteFramebuffers(1, &gl->fbo_feedback);
+   if (gl->fbo_feedback_texture)
+      glDeleteTextures(1, &gl->fbo_feedback_texture);
+
+   memset(gl->fbo_texture, 0, sizeof(gl->fbo_texture));
+   memset(gl->fbo, 0, sizeof(gl->fbo));
+   gl->fbo_inited           = false;
+   gl->fbo_pass             = 0;
+   gl->fbo_feedback_enable  = false;
+   gl->fbo_feedback_pass    = -1;
+   gl->fbo_feedback_texture = 0;
+   gl->fbo_feedback         = 0;
+
+   if (gl_init_fbo_geometry(gl, fbo_width, fbo_height))
+   {
+      for (i = 0; i < old_pass && i < gl->fbo_pass; i++)
+      {
+         if (old_rect[i].width     != gl->fbo_rect[i].width
+               || old_rect[i].height   != gl->fbo_rect[i].height
+               || old_scale[i].fp_fbo  != gl->fbo_scale[i].fp_fbo
+               || old_scale[i].srgb_fbo != gl->fbo_scale[i].srgb_fbo)
+            continue;
+
+         gl->fbo[i]         = old_fbo[i];
+         gl->fbo_texture[i] = old_texture[i];
+         old_fbo[i]         = 0;
+         old_texture[i]     = 0;
+         kept++;
+      }
+   }
+
+   for (i = 0; i < old_pass; i++)
+   {
+      if (old_fbo[i])
+         glDeleteFramebuffers(1, &old_fbo[i]);
+      if (old_texture[i])
+         glDeleteTextures(1, &old_texture[i]);
+   }
+
+   if (gl->fbo_pass)
+   {
+      if (kept)
+         RARCH_LOG("[GL]: Keeping %u of %d FBOs.\n", kept, gl->fbo_pass);
+      gl_init_fbo_targets(gl);
+   }
+}
+
 static void gl_deinit_hw_render(gl_t *gl)
 {
    if (!gl)
@@ -1398,6 +1513,62 @@ static void gl_init_textures(gl_t *gl, const video_info_t *video)
    glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
 }
 
+#ifdef HAVE_GL_ASYNC_UPLOAD
+/* Streams the frame through the upload PBO. Mapping it with
+ * GL_MAP_INVALIDATE_BUFFER_BIT orphans last frame's storage,
+ * so the driver never has to wait for the GPU to finish reading
+ * it; storage is only allocated when the frame grows. RGB565
+ * goes up as packed 5:6:5 and the driver expands it, rather
+ * than the CPU scaler. */
+static bool gl_copy_frame_pbo(gl_t *gl, const void *frame,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   GLenum type   = gl->texture_type;
+   GLenum fmt    = gl->texture_fmt;
+   /* The last line ends at the frame width, not the pitch. */
+   size_t size   = (height - 1) * pitch + width * gl->base_size;
+   void *mapped  = NULL;
+
+   if (!height)
+      return true;
+
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl->pbo_upload);
+
+   if (gl->pbo_upload_size < size)
+   {
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+      gl->pbo_upload_size = size;
+   }
+
+   mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+   if (!mapped)
+   {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      return false;
+   }
+
+   memcpy(mapped, frame, size);
+   glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+   if (gl->base_size == 2 && !gl->have_es2_compat)
+   {
+      type = GL_RGB;
+      fmt  = GL_UNSIGNED_SHORT_5_6_5;
+   }
+
+   glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(pitch));
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / gl->base_size);
+   glTexSubImage2D(GL_TEXTURE_2D,
+         0, 0, 0, width, height, type, fmt, NULL);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+   return true;
+}
+#endif
+
 static INLINE void gl_copy_frame(gl_t *gl, const void *frame,
       unsigned width, unsigned height, unsigned pitch)
 {
@@ -1493,6 +1664,14 @@ static INLINE void gl_copy_frame(gl_t *gl, const void *frame,
       glUnmapBuffer(GL_TEXTURE_REFERENCE_BUFFER_SCE);
    }
 #else
+#ifdef HAVE_GL_ASYNC_UPLOAD
+   if (gl->pbo_upload_enable && gl_copy_frame_pbo(gl, frame,
+            width, height, pitch))
+   {
+      retro_perf_stop(&copy_frame);
+      return;
+   }
+#endif
    {
       const GLvoid *data_buf = frame;
       glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(pitch));
@@ -1950,6 +2129,7 @@ static void gl_free(void *data)
    if (font_driver_has_render_msg())
       font_driver_free(NULL);
    gl_shader_deinit(gl);
+   gl_lut_cache_free();
 
 #ifndef NO_GL_FF_VERTEX
    gl_disable_client_arrays(gl);
@@ -1981,6 +2161,11 @@ static void gl_free(void *data)
    }
 #endif
 
+#ifdef HAVE_GL_ASYNC_UPLOAD
+   if (gl->pbo_upload_enable)
+      glDeleteBuffers(1, &gl->pbo_upload);
+#endif
+
 #ifdef HAVE_FBO
    gl_deinit_fbo(gl);
    gl_deinit_hw_render(gl);
@@ -2279,6 +2464,23 @@ static void gl_init_pbo_readback(gl_t *gl)
 }
 #endif
 
+#ifdef HAVE_GL_ASYNC_UPLOAD
+static void gl_init_pbo_upload(gl_t *gl)
+{
+   /* Hardware rendered frames never get copied. */
+   gl->pbo_upload_enable = !gl->hw_render_use
+      && glMapBufferRange && glUnmapBuffer;
+
+   if (!gl->pbo_upload_enable)
+      return;
+
+   RARCH_LOG("[GL]: Async PBO upload enabled.\n");
+
+   glGenBuffers(1, &gl->pbo_upload);
+   gl->pbo_upload_size = 0;
+}
+#endif
+
 static const gfx_ctx_driver_t *gl_get_context(gl_t *gl)
 {
    const struct retro_hw_render_callback *cb = 
@@ -2665,6 +2867,10 @@ static void *gl_init(const video_info_t *video, const input_driver_t **input, vo
    gl_init_pbo_readback(gl);
 #endif
 
+#ifdef HAVE_GL_ASYNC_UPLOAD
+   gl_init_pbo_upload(gl);
+#endif
+
    if (!gl_check_error())
       goto error;
 
@@ -2781,8 +2987,6 @@ static bool gl_set_shader(void *data,
    if (type == RARCH_SHADER_NONE)
       return false;
 
-   gl_shader_deinit(gl);
-
    switch (type)
    {
 #ifdef HAVE_GLSL
@@ -2809,15 +3013,14 @@ static bool gl_set_shader(void *data,
    }
 
 #ifdef HAVE_FBO
-   gl_deinit_fbo(gl);
    glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
 #endif
 
+   /* The shader in use is replaced only once the new one is
+    * built, and is kept if that fails. */
    if (!video_shader_driver_init(shader, gl, path))
    {
-      video_shader_driver_init(shader, gl, NULL);
-
-      RARCH_WARN("[GL]: Failed to set multipass shader. Falling back to stock.\n");
+      RARCH_WARN("[GL]: Failed to set multipass shader. Keeping the current one.\n");
 
       context_bind_hw_render(gl, true);
       return false;
@@ -2854,7 +3057,7 @@ static bool gl_set_shader(void *data,
    }
 
 #ifdef HAVE_FBO
-   gl_init_fbo(gl, gl->tex_w, gl->tex_h);
+   gl_reinit_fbo(gl, gl->tex_w, gl->tex_h);
 #endif
 
    /* Apparently need to set viewport for passes when we aren't using FBOs. */
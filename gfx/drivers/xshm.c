@@ -18,57 +18,1082 @@
 #include <signal.h>
 #include <math.h>
 
-/*#include <sys/ipc.h>*/
+#include <sys/ipc.h>
 #include <sys/shm.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/extensions/XShm.h>
 
 #include <retro_inline.h>
+#include <gfx/scaler/scaler.h>
 
 #include "../../driver.h"
 #include "../../general.h"
+#include "../../performance.h"
+#include "../../verbosity.h"
 #include "../font_driver.h"
 #include "../common/x11_common.h"
 
+/* Plain CPU rendering into MIT-SHM images. The core frame is
+ * scaled straight into the viewport of an image the size of
+ * the window. There are two images: while the X server reads
+ * one, the next frame is drawn into the other. */
+
+#define XSHM_IMAGES 2
+
+struct xshm_image
+{
+   XShmSegmentInfo shminfo;
+   XImage *image;
+   /* Request that put this image on screen. Until the server
+    * has processed it, the image can't be drawn into. */
+   unsigned long serial;
+   bool pending;
+   bool dirty;
+};
+
 typedef struct xshm
 {
-	Display* display;
-	int screen;
-	
-	Window parentwindow;
-	Window wndw;
-	
-	unsigned int width;
-	unsigned int height;
-	unsigned int pitch;
-#if 0
-	videoformat bpp;
-#endif
-	
-	XShmSegmentInfo shmInfo;
-	XImage* image;
-	GC gc;
+   GC gc;
+   Visual *visual;
+   int depth;
+
+   struct xshm_image images[XSHM_IMAGES];
+   unsigned index;
+   unsigned width;
+   unsigned height;
+
+   bool keep_aspect;
+   bool smooth;
+   bool rgb32;
+   unsigned rotation;
+   struct video_viewport vp;
+
+   struct scaler_ctx scaler;
+   /* Scaled frame, before rotation. */
+   uint32_t *rotate_buf;
+   size_t rotate_buf_size;
+
+   /* Last core frame, packed, so duped frames can be drawn
+    * again under a new message or the menu. */
+   uint8_t *last_frame;
+   size_t last_frame_size;
+   unsigned last_width;
+   unsigned last_height;
+   unsigned last_pitch;
+
+   struct
+   {
+      struct scaler_ctx scaler;
+      /* Menu texture as handed over, RGBA4444 or ARGB8888. */
+      uint8_t *frame;
+      size_t frame_size;
+      /* Scaled to the area it covers. */
+      uint32_t *scaled;
+      size_t scaled_size;
+      unsigned width;
+      unsigned height;
+      bool rgb32;
+      float alpha;
+      bool active;
+      bool full_screen;
+   } menu;
+
+   void *font;
+   const font_renderer_driver_t *font_driver;
+   uint32_t font_color;
 } xshm_t;
 
+static void xshm_free_image(struct xshm_image *img)
+{
+   if (!img->image)
+      return;
+
+   XShmDetach(g_x11_dpy, &img->shminfo);
+   XDestroyImage(img->image);
+   shmdt(img->shminfo.shmaddr);
+   shmctl(img->shminfo.shmid, IPC_RMID, NULL);
+
+   memset(img, 0, sizeof(*img));
+}
+
+static bool xshm_create_image(xshm_t *xshm, struct xshm_image *img,
+      unsigned width, unsigned height)
+{
+   memset(img, 0, sizeof(*img));
+
+   img->image = XShmCreateImage(g_x11_dpy, xshm->visual, xshm->depth,
+         ZPixmap, NULL, &img->shminfo, width, height);
+
+   if (!img->image)
+   {
+      RARCH_ERR("XShm: XShmCreateImage failed.\n");
+      return false;
+   }
+
+   if (img->image->bits_per_pixel != 32)
+   {
+      RARCH_ERR("XShm: Images with %d bits per pixel are not supported.\n",
+            img->image->bits_per_pixel);
+      XDestroyImage(img->image);
+      img->image = NULL;
+      return false;
+   }
+
+   img->shminfo.shmid = shmget(IPC_PRIVATE,
+         img->image->bytes_per_line * img->image->height, IPC_CREAT | 0600);
+   if (img->shminfo.shmid < 0)
+   {
+      RARCH_ERR("XShm: Failed to init SHM.\n");
+      XDestroyImage(img->image);
+      img->image = NULL;
+      return false;
+   }
+
+   img->shminfo.shmaddr  = img->image->data =
+      (char*)shmat(img->shminfo.shmid, NULL, 0);
+   img->shminfo.readOnly = False;
+
+   if (!XShmAttach(g_x11_dpy, &img->shminfo))
+   {
+      RARCH_ERR("XShm: XShmAttach failed.\n");
+      shmdt(img->shminfo.shmaddr);
+      shmctl(img->shminfo.shmid, IPC_RMID, NULL);
+      XDestroyImage(img->image);
+      img->image = NULL;
+      return false;
+   }
+
+   img->dirty = true;
+   return true;
+}
+
+static bool xshm_resize(xshm_t *xshm, unsigned width, unsigned height)
+{
+   unsigned i;
+
+   if (width == xshm->width && height == xshm->height)
+      return true;
+
+   /* The server must be done with the old images. */
+   XSync(g_x11_dpy, False);
+
+   for (i = 0; i < XSHM_IMAGES; i++)
+      xshm_free_image(&xshm->images[i]);
+
+   xshm->width  = 0;
+   xshm->height = 0;
+
+   for (i = 0; i < XSHM_IMAGES; i++)
+      if (!xshm_create_image(xshm, &xshm->images[i], width, height))
+         return false;
+
+   XSync(g_x11_dpy, False);
+
+   xshm->width  = width;
+   xshm->height = height;
+   xshm->index  = 0;
+   return true;
+}
+
+/* Waits until the server no longer reads from @img. Usually it
+ * finished long ago: the ShmCompletion event it sent has
+ * already been read by the event loop, bumping the last known
+ * request, and this costs nothing. */
+static void xshm_wait_image(struct xshm_image *img)
+{
+   if (!img->pending)
+      return;
+
+   if ((long)(LastKnownRequestProcessed(g_x11_dpy) - img->serial) < 0)
+      XSync(g_x11_dpy, False);
+
+   img->pending = false;
+}
+
+static void calc_out_rect(bool keep_aspect, struct video_viewport *vp,
+      unsigned vp_width, unsigned vp_height)
+{
+   settings_t *settings = config_get_ptr();
+
+   vp->full_width  = vp_width;
+   vp->full_height = vp_height;
+
+   if (settings->video.scale_integer)
+      video_viewport_get_scaled_integer(vp, vp_width, vp_height,
+            video_driver_get_aspect_ratio(), keep_aspect);
+   else if (!keep_aspect)
+   {
+      vp->x      = 0;
+      vp->y      = 0;
+      vp->width  = vp_width;
+      vp->height = vp_height;
+   }
+   else
+   {
+      float desired_aspect = video_driver_get_aspect_ratio();
+      float device_aspect  = (float)vp_width / vp_height;
+
+      /* If the aspect ratios of screen and desired aspect ratio
+       * are sufficiently equal (floating point stuff),
+       * assume they are actually equal.
+       */
+      if (fabs(device_aspect - desired_aspect) < 0.0001)
+      {
+         vp->x      = 0;
+         vp->y      = 0;
+         vp->width  = vp_width;
+         vp->height = vp_height;
+      }
+      else if (device_aspect > desired_aspect)
+      {
+         float delta = (desired_aspect / device_aspect - 1.0) / 2.0 + 0.5;
+         vp->x       = vp_width * (0.5 - delta);
+         vp->y       = 0;
+         vp->width   = 2.0 * vp_width * delta;
+         vp->height  = vp_height;
+      }
+      else
+      {
+         float delta = (device_aspect / desired_aspect - 1.0) / 2.0 + 0.5;
+         vp->x       = 0;
+         vp->y       = vp_height * (0.5 - delta);
+         vp->width   = vp_width;
+         vp->height  = 2.0 * vp_height * delta;
+      }
+   }
+
+   /* Integer scaling can overflow a small window. */
+   if (vp->width > vp_width)
+      vp->width = vp_width;
+   if (vp->height > vp_height)
+      vp->height = vp_height;
+   if (vp->x < 0 || vp->x + vp->width > vp_width)
+      vp->x = 0;
+   if (vp->y < 0 || vp->y + vp->height > vp_height)
+      vp->y = 0;
+}
+
+static void xshm_init_font(xshm_t *xshm)
+{
+   int r, g, b;
+   settings_t *settings = config_get_ptr();
+
+   if (!settings->video.font_enable)
+      return;
+
+   if (!font_renderer_create_default((const void**)&xshm->font_driver,
+            &xshm->font, *settings->video.font_path
+            ? settings->video.font_path : NULL, settings->video.font_size))
+   {
+      RARCH_LOG("Could not initialize fonts.\n");
+      return;
+   }
+
+   r = settings->video.msg_color_r * 255;
+   r = (r < 0 ? 0 : (r > 255 ? 255 : r));
+   g = settings->video.msg_color_g * 255;
+   g = (g < 0 ? 0 : (g > 255 ? 255 : g));
+   b = settings->video.msg_color_b * 255;
+   b = (b < 0 ? 0 : (b > 255 ? 255 : b));
+
+   xshm->font_color = (r << 16) | (g << 8) | b;
+}
+
+static void xshm_set_nonblock_state(void *data, bool state)
+{
+   /* There is no vsync to turn off, XShmPutImage never blocks. */
+   (void)data;
+   (void)state;
+}
+
+/* Also tears down a partially initialized driver, for
+ * xshm_init() failing halfway. */
+static void xshm_free(void *data)
+{
+   unsigned i;
+   xshm_t *xshm = (xshm_t*)data;
+
+   if (!xshm)
+      return;
+
+   if (g_x11_dpy)
+   {
+      x11_input_ctx_destroy();
+
+      XSync(g_x11_dpy, False);
+      for (i = 0; i < XSHM_IMAGES; i++)
+         xshm_free_image(&xshm->images[i]);
+
+      if (xshm->gc)
+         XFreeGC(g_x11_dpy, xshm->gc);
+
+      x11_window_destroy(true);
+      x11_colormap_destroy();
+
+      XCloseDisplay(g_x11_dpy);
+      g_x11_dpy = NULL;
+   }
+
+   scaler_ctx_gen_reset(&xshm->scaler);
+   scaler_ctx_gen_reset(&xshm->menu.scaler);
+   free(xshm->rotate_buf);
+   free(xshm->last_frame);
+   free(xshm->menu.frame);
+   free(xshm->menu.scaled);
+
+   if (xshm->font)
+      xshm->font_driver->free(xshm->font);
+
+   free(xshm);
+}
+
+static void *xshm_init(const video_info_t *video,
+      const input_driver_t **input, void **input_data)
+{
+   XWindowAttributes target;
+   char buf[128]                          = {0};
+   XSetWindowAttributes attributes        = {0};
+   unsigned width                         = 0;
+   unsigned height                        = 0;
+   void *xinput                           = NULL;
+   const struct retro_game_geometry *geom = NULL;
+   struct retro_system_av_info *av_info   = NULL;
+   xshm_t *xshm                           = (xshm_t*)calloc(1, sizeof(*xshm));
+
+   if (!xshm)
+      return NULL;
+
+   XInitThreads();
+
+   g_x11_dpy = XOpenDisplay(NULL);
+   if (!g_x11_dpy)
+   {
+      RARCH_ERR("XShm: Failed to connect to the X server.\n");
+      goto error;
+   }
+
+   av_info = video_viewport_get_system_av_info();
+   if (av_info)
+      geom = &av_info->geometry;
+
+   if (!XShmQueryExtension(g_x11_dpy))
+   {
+      RARCH_ERR("XShm: XShm extension not found.\n");
+      goto error;
+   }
+
+   g_x11_screen  = DefaultScreen(g_x11_dpy);
+   xshm->visual  = DefaultVisual(g_x11_dpy, g_x11_screen);
+   xshm->depth   = DefaultDepth(g_x11_dpy, g_x11_screen);
+
+   /* Everything is drawn as XRGB8888. */
+   if ((xshm->depth != 24 && xshm->depth != 32)
+         || xshm->visual->red_mask   != 0xff0000
+         || xshm->visual->green_mask != 0x00ff00
+         || xshm->visual->blue_mask  != 0x0000ff)
+   {
+      RARCH_ERR("XShm: Only 24-bit and 32-bit XRGB8888 visuals are supported.\n");
+      goto error;
+   }
+
+   xshm->keep_aspect = video->force_aspect;
+   xshm->smooth      = video->smooth;
+   xshm->rgb32       = video->rgb32;
+
+   /* Scaling to the window is the bulk of the work here, but the
+    * core and a recording scaler want cores too, take half. */
+   xshm->scaler.threads = retro_get_cpu_cores() / 2;
+
+   g_x11_cmap = XCreateColormap(g_x11_dpy,
+         DefaultRootWindow(g_x11_dpy), xshm->visual, AllocNone);
+
+   attributes.colormap     = g_x11_cmap;
+   attributes.border_pixel = 0;
+   attributes.event_mask   = StructureNotifyMask | KeyPressMask |
+      KeyReleaseMask | ButtonReleaseMask | ButtonPressMask | DestroyNotify | ClientMessage;
+
+   width     = video->fullscreen ? ((video->width  == 0) ? geom->base_width  : video->width)  : video->width;
+   height    = video->fullscreen ? ((video->height == 0) ? geom->base_height : video->height) : video->height;
+   g_x11_win = XCreateWindow(g_x11_dpy, DefaultRootWindow(g_x11_dpy),
+         0, 0, width, height,
+         0, xshm->depth, InputOutput, xshm->visual,
+         CWColormap | CWBorderPixel | CWEventMask, &attributes);
+
+   XSetWindowBackground(g_x11_dpy, g_x11_win, 0);
+   XMapWindow(g_x11_dpy, g_x11_win);
+
+   if (video_monitor_get_fps(buf, sizeof(buf), NULL, 0))
+      XStoreName(g_x11_dpy, g_x11_win, buf);
+
+   x11_set_window_attr(g_x11_dpy, g_x11_win);
+
+   if (video->fullscreen)
+   {
+      x11_windowed_fullscreen(g_x11_dpy, g_x11_win);
+      x11_show_mouse(g_x11_dpy, g_x11_win, false);
+   }
+
+   xshm->gc = XCreateGC(g_x11_dpy, g_x11_win, 0, 0);
+
+   /* From here on, x11_alive() tracks the size. */
+   XGetWindowAttributes(g_x11_dpy, g_x11_win, &target);
+   g_x11_width  = target.width;
+   g_x11_height = target.height;
+
+   if (!xshm_resize(xshm, target.width, target.height))
+      goto error;
+
+   calc_out_rect(xshm->keep_aspect, &xshm->vp, target.width, target.height);
+
+   x11_install_quit_atom();
+   x11_install_sighandlers();
+
+   if (!x11_input_ctx_new(true))
+      goto error;
+
+   xshm_init_font(xshm);
+
+   /* Last, nothing may fail once the input driver exists. */
+   if (input && input_data)
+   {
+      xinput = input_x.init();
+      if (xinput)
+      {
+         *input      = &input_x;
+         *input_data = xinput;
+      }
+      else
+         *input = NULL;
+   }
+
+   return xshm;
+
+error:
+   xshm_free(xshm);
+   return NULL;
+}
+
+static bool xshm_update_scaler(struct scaler_ctx *scaler,
+      enum scaler_pix_fmt in_fmt, enum scaler_type type,
+      unsigned width, unsigned height, unsigned pitch,
+      unsigned out_width, unsigned out_height, unsigned out_stride)
+{
+   scaler->in_stride  = pitch;
+   scaler->out_stride = out_stride;
+
+   if (scaler->in_width == width && scaler->in_height == height
+         && scaler->out_width == out_width
+         && scaler->out_height == out_height
+         && scaler->in_fmt == in_fmt && scaler->scaler_type == type)
+      return true;
+
+   scaler->in_width    = width;
+   scaler->in_height   = height;
+   scaler->out_width   = out_width;
+   scaler->out_height  = out_height;
+   scaler->in_fmt      = in_fmt;
+   scaler->out_fmt     = SCALER_FMT_ARGB8888;
+   scaler->scaler_type = type;
+   scaler->in_stride   = pitch;
+   scaler->out_stride  = out_stride;
+
+   return scaler_ctx_gen_filter(scaler);
+}
+
+/* Copies @src, @width x @height, into @dst rotated
+ * counter-clockwise by 90 degrees times @rotation. */
+static void xshm_rotate(uint32_t *dst, unsigned dst_stride,
+      const uint32_t *src, unsigned width, unsigned height,
+      unsigned rotation)
+{
+   unsigned x, y;
+
+   for (y = 0; y < height; y++)
+   {
+      const uint32_t *in = src + y * width;
+
+      for (x = 0; x < width; x++)
+      {
+         unsigned out_x, out_y;
+
+         switch (rotation)
+         {
+            case 1:
+               out_x = y;
+               out_y = width - 1 - x;
+               break;
+            case 2:
+               out_x = width - 1 - x;
+               out_y = height - 1 - y;
+               break;
+            default:
+               out_x = height - 1 - y;
+               out_y = x;
+               break;
+         }
+
+         dst[out_y * dst_stride + out_x] = in[x];
+      }
+   }
+}
+
+static void xshm_render_frame(xshm_t *xshm, struct xshm_image *img,
+      const void *frame, unsigned width, unsigned height, unsigned pitch)
+{
+   enum scaler_pix_fmt in_fmt = xshm->rgb32
+      ? SCALER_FMT_ARGB8888 : SCALER_FMT_RGB565;
+   enum scaler_type type = xshm->smooth
+      ? SCALER_TYPE_BILINEAR : SCALER_TYPE_POINT;
+   unsigned stride     = img->image->bytes_per_line;
+   uint32_t *out       = (uint32_t*)(img->image->data
+         + xshm->vp.y * stride) + xshm->vp.x;
+   unsigned out_width  = xshm->vp.width;
+   unsigned out_height = xshm->vp.height;
+   bool rotated        = xshm->rotation & 1;
+
+   if (!xshm->rotation)
+   {
+      if (xshm_update_scaler(&xshm->scaler, in_fmt, type,
+               width, height, pitch, out_width, out_height, stride))
+         scaler_ctx_scale(&xshm->scaler, out, frame);
+      return;
+   }
+
+   /* Scale into a side buffer with the rotated
+    * viewport's dimensions, then rotate into place. */
+   if (rotated)
+   {
+      out_width  = xshm->vp.height;
+      out_height = xshm->vp.width;
+   }
+
+   if (xshm->rotate_buf_size < out_width * out_height)
+   {
+      uint32_t *buf = (uint32_t*)realloc(xshm->rotate_buf,
+            out_width * out_height * sizeof(uint32_t));
+      if (!buf)
+         return;
+
+      xshm->rotate_buf      = buf;
+      xshm->rotate_buf_size = out_width * out_height;
+   }
+
+   if (!xshm_update_scaler(&xshm->scaler, in_fmt, type,
+            width, height, pitch,
+            out_width, out_height, out_width * sizeof(uint32_t)))
+      return;
+
+   scaler_ctx_scale(&xshm->scaler, xshm->rotate_buf, frame);
+   xshm_rotate(out, stride / sizeof(uint32_t), xshm->rotate_buf,
+         out_width, out_height, xshm->rotation);
+}
+
+/* Keeps a packed copy of @frame for redrawing dupes. */
+static void xshm_save_frame(xshm_t *xshm, const void *frame,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   unsigned y;
+   unsigned line = width * (xshm->rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
+   size_t size   = (size_t)line * height;
+
+   if (xshm->last_frame_size < size)
+   {
+      uint8_t *buf = (uint8_t*)realloc(xshm->last_frame, size);
+      if (!buf)
+      {
+         xshm->last_width = 0;
+         return;
+      }
+
+      xshm->last_frame      = buf;
+      xshm->last_frame_size = size;
+   }
+
+   for (y = 0; y < height; y++)
+      memcpy(xshm->last_frame + y * line,
+            (const uint8_t*)frame + y * pitch, line);
+
+   xshm->last_width  = width;
+   xshm->last_height = height;
+   xshm->last_pitch  = line;
+}
+
+/* Blends the menu texture over the viewport,
+ * or over the whole window when it is full screen. */
+static void xshm_render_menu(xshm_t *xshm, struct xshm_image *img)
+{
+   unsigned x, y, alpha;
+   const uint32_t *src = NULL;
+   uint32_t *out       = NULL;
+   int out_x           = 0;
+   int out_y           = 0;
+   unsigned out_width  = xshm->width;
+   unsigned out_height = xshm->height;
+   unsigned stride     = img->image->bytes_per_line / sizeof(uint32_t);
+   unsigned bpp        = xshm->menu.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
+   float menu_alpha    = xshm->menu.alpha;
+
+   if (!xshm->menu.frame)
+      return;
+
+   if (!xshm->menu.full_screen)
+   {
+      out_x      = xshm->vp.x;
+      out_y      = xshm->vp.y;
+      out_width  = xshm->vp.width;
+      out_height = xshm->vp.height;
+   }
+
+   if (!out_width || !out_height)
+      return;
+
+   if (xshm->menu.scaled_size < out_width * out_height)
+   {
+      uint32_t *buf = (uint32_t*)realloc(xshm->menu.scaled,
+            out_width * out_height * sizeof(uint32_t));
+      if (!buf)
+         return;
+
+      xshm->menu.scaled      = buf;
+      xshm->menu.scaled_size = out_width * out_height;
+   }
+
+   if (!xshm_update_scaler(&xshm->menu.scaler,
+            xshm->menu.rgb32 ? SCALER_FMT_ARGB8888 : SCALER_FMT_RGBA4444,
+            SCALER_TYPE_POINT, xshm->menu.width, xshm->menu.height,
+            xshm->menu.width * bpp,
+            out_width, out_height, out_width * sizeof(uint32_t)))
+      return;
+
+   scaler_ctx_scale(&xshm->menu.scaler, xshm->menu.scaled, xshm->menu.frame);
+
+   menu_alpha = menu_alpha < 0.0f ? 0.0f : (menu_alpha > 1.0f ? 1.0f : menu_alpha);
+   alpha      = menu_alpha * 256;
+   src        = xshm->menu.scaled;
+   out        = (uint32_t*)img->image->data + out_y * stride + out_x;
+
+   for (y = 0; y < out_height; y++, src += out_width, out += stride)
+   {
+      for (x = 0; x < out_width; x++)
+      {
+         uint32_t color = src[x];
+         uint32_t pixel = out[x];
+         unsigned a     = ((color >> 24) * alpha) >> 8;
+         unsigned r, g, b;
+
+         if (!a)
+            continue;
+
+         r = (((color >> 16) & 0xff) * a + ((pixel >> 16) & 0xff) * (256 - a)) >> 8;
+         g = (((color >>  8) & 0xff) * a + ((pixel >>  8) & 0xff) * (256 - a)) >> 8;
+         b = (((color >>  0) & 0xff) * a + ((pixel >>  0) & 0xff) * (256 - a)) >> 8;
+
+         out[x] = (r << 16) | (g << 8) | b;
+      }
+   }
+}
+
+static void xshm_render_msg(xshm_t *xshm, struct xshm_image *img,
+      const char *msg)
+{
+   int x, y, msg_base_x, msg_base_y;
+   unsigned width                 = xshm->width;
+   unsigned height                = xshm->height;
+   unsigned stride                = img->image->bytes_per_line / sizeof(uint32_t);
+   settings_t *settings           = config_get_ptr();
+   const struct font_atlas *atlas = NULL;
+   unsigned font_r                = (xshm->font_color >> 16) & 0xff;
+   unsigned font_g                = (xshm->font_color >>  8) & 0xff;
+   unsigned font_b                = (xshm->font_color >>  0) & 0xff;
+
+   if (!xshm->font)
+      return;
+
+   atlas      = xshm->font_driver->get_atlas(xshm->font);
+
+   msg_base_x = xshm->vp.x + settings->video.msg_pos_x * xshm->vp.width;
+   msg_base_y = xshm->vp.y + xshm->vp.height * (1.0f - settings->video.msg_pos_y);
+
+   for (; *msg; msg++)
+   {
+      int base_x, base_y, glyph_width, glyph_height, max_width, max_height;
+      const uint8_t *src             = NULL;
+      uint32_t *out                  = NULL;
+      const struct font_glyph *glyph = xshm->font_driver->get_glyph(
+            xshm->font, (uint8_t)*msg);
+
+      if (!glyph)
+         continue;
+
+      base_x       = msg_base_x + glyph->draw_offset_x;
+      base_y       = msg_base_y + glyph->draw_offset_y;
+      glyph_width  = glyph->width;
+      glyph_height = glyph->height;
+
+      src          = atlas->buffer + glyph->atlas_offset_x +
+                     glyph->atlas_offset_y * atlas->width;
+
+      if (base_x < 0)
+      {
+         src          -= base_x;
+         glyph_width  += base_x;
+         base_x        = 0;
+      }
+
+      if (base_y < 0)
+      {
+         src          -= base_y * (int)atlas->width;
+         glyph_height += base_y;
+         base_y        = 0;
+      }
+
+      max_width  = width - base_x;
+      max_height = height - base_y;
+
+      if (max_width <= 0 || max_height <= 0)
+         continue;
+
+      if (glyph_width > max_width)
+         glyph_width  = max_width;
+      if (glyph_height > max_height)
+         glyph_height = max_height;
+
+      out = (uint32_t*)img->image->data + base_y * stride + base_x;
+
+      for (y = 0; y < glyph_height; y++, src += atlas->width, out += stride)
+      {
+         for (x = 0; x < glyph_width; x++)
+         {
+            unsigned alpha = src[x];
+            uint32_t pixel = out[x];
+            unsigned r     = (pixel >> 16) & 0xff;
+            unsigned g     = (pixel >>  8) & 0xff;
+            unsigned b     = (pixel >>  0) & 0xff;
+
+            if (!alpha)
+               continue;
+
+            r = (font_r * alpha + r * (256 - alpha)) >> 8;
+            g = (font_g * alpha + g * (256 - alpha)) >> 8;
+            b = (font_b * alpha + b * (256 - alpha)) >> 8;
+
+            out[x] = (r << 16) | (g << 8) | b;
+         }
+      }
+
+      msg_base_x += glyph->advance_x;
+      msg_base_y += glyph->advance_y;
+   }
+}
+
+static bool xshm_frame(void *data, const void *frame, unsigned width,
+      unsigned height, uint64_t frame_count,
+      unsigned pitch, const char *msg)
+{
+   struct video_viewport vp;
+   struct xshm_image *img = NULL;
+   xshm_t *xshm           = (xshm_t*)data;
+   bool overlay           = msg || xshm->menu.active;
+   static struct retro_perf_counter xshm_frame_perf = {0};
+
+   rarch_perf_init(&xshm_frame_perf, "xshm_frame");
+   retro_perf_start(&xshm_frame_perf);
+
+   if (!xshm_resize(xshm, g_x11_width, g_x11_height))
+   {
+      retro_perf_stop(&xshm_frame_perf);
+      return false;
+   }
+
+   vp = xshm->vp;
+   calc_out_rect(xshm->keep_aspect, &xshm->vp, g_x11_width, g_x11_height);
+
+   /* Borders need clearing in both images once it moves. */
+   if (vp.x != xshm->vp.x || vp.y != xshm->vp.y
+         || vp.width != xshm->vp.width || vp.height != xshm->vp.height)
+   {
+      unsigned i;
+      for (i = 0; i < XSHM_IMAGES; i++)
+         xshm->images[i].dirty = true;
+   }
+
+   img = &xshm->images[xshm->index];
+
+   /* A dupe leaves the screen as it is, unless something has
+    * to be drawn over it or taken off it. The image on screen
+    * is dirty when it has a message or the menu on it. */
+   if (!frame && !overlay && !img->dirty
+         && !xshm->images[(xshm->index + XSHM_IMAGES - 1) % XSHM_IMAGES].dirty)
+   {
+      retro_perf_stop(&xshm_frame_perf);
+      return true;
+   }
+
+   if (frame)
+      xshm_save_frame(xshm, frame, width, height, pitch);
+   else if (xshm->last_width)
+   {
+      frame  = xshm->last_frame;
+      width  = xshm->last_width;
+      height = xshm->last_height;
+      pitch  = xshm->last_pitch;
+   }
+
+   xshm_wait_image(img);
+
+   if (img->dirty || overlay || !frame)
+   {
+      memset(img->image->data, 0,
+            img->image->bytes_per_line * img->image->height);
+      img->dirty = overlay;
+   }
+
+   if (frame)
+      xshm_render_frame(xshm, img, frame, width, height, pitch);
+
+   if (xshm->menu.active)
+      xshm_render_menu(xshm, img);
+
+   if (msg)
+      xshm_render_msg(xshm, img, msg);
+
+   img->serial  = NextRequest(g_x11_dpy);
+   img->pending = true;
+   XShmPutImage(g_x11_dpy, g_x11_win, xshm->gc, img->image,
+         0, 0, 0, 0, xshm->width, xshm->height, True);
+   XFlush(g_x11_dpy);
+
+   xshm->index = (xshm->index + 1) % XSHM_IMAGES;
+
+   x11_update_window_title(NULL);
+
+   retro_perf_stop(&xshm_frame_perf);
+   return true;
+}
+
+static bool xshm_suppress_screensaver(void *data, bool enable)
+{
+   if (video_driver_display_type_get() != RARCH_DISPLAY_X11)
+      return false;
+
+   x11_suspend_screensaver(video_driver_window_get());
+   return true;
+}
+
+static bool xshm_has_windowed(void *data)
+{
+   (void)data;
+   return true;
+}
+
+static bool xshm_set_shader(void *data,
+      enum rarch_shader_type type, const char *path)
+{
+   (void)data;
+   (void)type;
+   (void)path;
+
+   return false;
+}
+
+static void xshm_set_rotation(void *data, unsigned rotation)
+{
+   unsigned i;
+   xshm_t *xshm = (xshm_t*)data;
+
+   if (!xshm)
+      return;
+
+   xshm->rotation = rotation & 3;
+
+   for (i = 0; i < XSHM_IMAGES; i++)
+      xshm->images[i].dirty = true;
+}
+
+static void xshm_viewport_info(void *data, struct video_viewport *vp)
+{
+   xshm_t *xshm = (xshm_t*)data;
+   *vp = xshm->vp;
+}
+
+/* BGR24, bottom-up, like the GL driver reads it. */
+static bool xshm_read_viewport(void *data, uint8_t *buffer)
+{
+   unsigned x, y, stride;
+   const struct xshm_image *img = NULL;
+   xshm_t *xshm                 = (xshm_t*)data;
+
+   if (!xshm)
+      return false;
+
+   /* Last image put on screen. */
+   img = &xshm->images[(xshm->index + XSHM_IMAGES - 1) % XSHM_IMAGES];
+   if (!img->image)
+      return false;
+
+   stride = img->image->bytes_per_line;
+
+   for (y = 0; y < xshm->vp.height; y++)
+   {
+      const uint32_t *in = (const uint32_t*)(img->image->data
+            + (xshm->vp.y + xshm->vp.height - 1 - y) * stride) + xshm->vp.x;
+
+      for (x = 0; x < xshm->vp.width; x++, buffer += 3)
+      {
+         buffer[0] = (in[x] >>  0) & 0xff;
+         buffer[1] = (in[x] >>  8) & 0xff;
+         buffer[2] = (in[x] >> 16) & 0xff;
+      }
+   }
+
+   return true;
+}
+
+static void xshm_set_filtering(void *data, unsigned index, bool smooth)
+{
+   xshm_t *xshm = (xshm_t*)data;
+
+   if (xshm)
+      xshm->smooth = smooth;
+}
+
+static void xshm_apply_state_changes(void *data)
+{
+   unsigned i;
+   xshm_t *xshm = (xshm_t*)data;
+
+   if (!xshm)
+      return;
+
+   for (i = 0; i < XSHM_IMAGES; i++)
+      xshm->images[i].dirty = true;
+}
+
+#ifdef HAVE_MENU
+static void xshm_set_texture_frame(void *data, const void *frame, bool rgb32,
+      unsigned width, unsigned height, float alpha)
+{
+   xshm_t *xshm = (xshm_t*)data;
+   size_t size  = (size_t)width * height
+      * (rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
+
+   if (!xshm || !frame)
+      return;
+
+   if (xshm->menu.frame_size < size)
+   {
+      uint8_t *buf = (uint8_t*)realloc(xshm->menu.frame, size);
+      if (!buf)
+         return;
+
+      xshm->menu.frame      = buf;
+      xshm->menu.frame_size = size;
+   }
+
+   memcpy(xshm->menu.frame, frame, size);
+
+   xshm->menu.width  = width;
+   xshm->menu.height = height;
+   xshm->menu.rgb32  = rgb32;
+   xshm->menu.alpha  = alpha;
+}
+#endif
+
+static void xshm_set_texture_enable(void *data, bool state, bool full_screen)
+{
+   xshm_t *xshm = (xshm_t*)data;
+
+   if (!xshm)
+      return;
+
+   xshm->menu.active      = state;
+   xshm->menu.full_screen = full_screen;
+}
+
+static void xshm_set_aspect_ratio(void *data, unsigned aspect_ratio_idx)
+{
+   xshm_t *xshm                     = (xshm_t*)data;
+   enum rarch_display_ctl_state cmd = RARCH_DISPLAY_CTL_NONE;
+
+   switch (aspect_ratio_idx)
+   {
+      case ASPECT_RATIO_SQUARE:
+         cmd = RARCH_DISPLAY_CTL_SET_VIEWPORT_SQUARE_PIXEL;
+         break;
+
+      case ASPECT_RATIO_CORE:
+         cmd = RARCH_DISPLAY_CTL_SET_VIEWPORT_CORE;
+         break;
+
+      case ASPECT_RATIO_CONFIG:
+         cmd = RARCH_DISPLAY_CTL_SET_VIEWPORT_CONFIG;
+         break;
+
+      default:
+         break;
+   }
+
+   if (cmd != RARCH_DISPLAY_CTL_NONE)
+      video_driver_ctl(cmd, NULL);
+
+   video_driver_set_aspect_ratio_value(aspectratio_lut[aspect_ratio_idx].value);
+
+   if (!xshm)
+      return;
+
+   xshm->keep_aspect = true;
+   xshm_apply_state_changes(xshm);
+}
+
+static const video_poke_interface_t xshm_poke_interface = {
+   NULL, /* load_texture */
+   NULL, /* unload_texture */
+   NULL, /* set_video_mode */
+   xshm_set_filtering,
+   NULL, /* get_video_output_size */
+   NULL, /* get_video_output_prev */
+   NULL, /* get_video_output_next */
+   NULL, /* get_current_framebuffer */
+   NULL, /* get_proc_address */
+   xshm_set_aspect_ratio,
+   xshm_apply_state_changes,
+#ifdef HAVE_MENU
+   xshm_set_texture_frame,
+#endif
+   xshm_set_texture_enable,
+   NULL, /* set_osd_msg */
+   NULL, /* show_mouse */
+   NULL, /* grab_mouse_toggle */
+   NULL, /* get_current_shader */
+   NULL, /* get_current_software_framebuffer */
+};
+
+static void xshm_get_poke_interface(void *data,
+      const video_poke_interface_t **iface)
+{
+   (void)data;
+   *iface = &xshm_poke_interface;
+}
+
 video_driver_t video_xshm = {
-   NULL,/*xshm_init,*/
-   NULL,/*xshm_frame,*/
-   NULL,/*xshm_set_nonblock_state,*/
-   NULL,/*xshm_alive,*/
-   NULL,/*xshm_focus,*/
-   NULL,/*xshm_suppress_screensaver,*/
-   NULL,/*xshm_has_windowed,*/
-   NULL,/*xshm_set_shader,*/
-   NULL,/*xshm_free,*/
+   xshm_init,
+   xshm_frame,
+   xshm_set_nonblock_state,
+   x11_alive,
+   x11_has_focus_internal,
+   xshm_suppress_screensaver,
+   xshm_has_windowed,
+   xshm_set_shader,
+   xshm_free,
    "xshm",
    NULL, /* set_viewport */
-   NULL,/*xshm_set_rotation,*/
-   NULL,/*xshm_viewport_info,*/
-   NULL,/*xshm_read_viewport,*/
+   xshm_set_rotation,
+   xshm_viewport_info,
+   xshm_read_viewport,
    NULL, /* read_frame_raw */
 #ifdef HAVE_OVERLAY
    NULL, /* overlay_interface */
 #endif
-   NULL/*xshm_get_poke_interface*/
+   xshm_get_poke_interface
 };
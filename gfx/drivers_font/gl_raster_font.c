@@ -14,9 +14,12 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <encodings/utf.h>
+
 #include "../common/gl_common.h"
 #include "../font_driver.h"
 #include "../video_shader_driver.h"
+#include "../../performance.h"
 
 /* TODO: Move viewport side effects to the caller: it's a source of bugs. */
 
@@ -40,6 +43,7 @@ typedef struct
    gl_t *gl;
    GLuint tex;
    unsigned tex_width, tex_height;
+   unsigned atlas_version;
 
    const font_renderer_driver_t *font_driver;
    void *font_data;
@@ -165,6 +169,8 @@ static void *gl_raster_font_init_font(void *data,
    if (!gl_raster_font_upload_atlas(font, atlas, font->tex_width, font->tex_height))
       goto error;
 
+   font->atlas_version = atlas->version;
+
    glBindTexture(GL_TEXTURE_2D, font->gl->texture[font->gl->tex_index]);
 
    return font;
@@ -189,45 +195,82 @@ static void gl_raster_font_free_font(void *data)
    free(font);
 }
 
+static const struct font_glyph *gl_raster_font_lookup(
+      gl_raster_t *font, uint32_t code)
+{
+   const struct font_glyph *glyph =
+      font->font_driver->get_glyph(font->font_data, code);
+
+   if (!glyph) /* Do something smarter here ... */
+      glyph = font->font_driver->get_glyph(font->font_data, '?');
+   return glyph;
+}
+
 static int gl_get_message_width(void *data, const char *msg, unsigned msg_len_full, float scale)
 {
-   gl_raster_t *font = (gl_raster_t*)data;
-      
-   unsigned i;
-   unsigned msg_len        = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+   gl_raster_t *font       = (gl_raster_t*)data;
+   const char *msg_end     = msg + msg_len_full;
    int      delta_x        = 0;
 
    if (!font)
       return 0;
 
-   while (msg_len_full)
+   while (msg < msg_end)
    {
-      for (i = 0; i < msg_len; i++)
-      {
-         const struct font_glyph *glyph = 
-            font->font_driver->get_glyph(font->font_data, (uint8_t)msg[i]);
-         if (!glyph) /* Do something smarter here ... */
-            glyph = font->font_driver->get_glyph(font->font_data, '?');
-         if (!glyph)
-            continue;
+      const struct font_glyph *glyph = NULL;
+      uint32_t code                  = utf8_walk(&msg);
 
-         delta_x += glyph->advance_x;
-      }
+      if (!code)
+         break;
 
-      msg_len_full -= msg_len;
-      msg          += msg_len;
-      msg_len       = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+      glyph = gl_raster_font_lookup(font, code);
+      if (!glyph)
+         continue;
+
+      delta_x += glyph->advance_x;
    }
 
    return delta_x * scale;
 }
 
-static void gl_raster_font_draw_vertices(gl_t *gl, const gfx_coords_t *coords)
+/* Glyphs rendered on demand only land in the texture once the
+ * text using them is drawn, so blocks see them as well. */
+static void gl_raster_font_update_atlas(gl_raster_t *font)
+{
+   static struct retro_perf_counter font_atlas_upload = {0};
+   const struct font_atlas *atlas =
+      font->font_driver->get_atlas(font->font_data);
+
+   if (!atlas || atlas->version == font->atlas_version)
+      return;
+
+   rarch_perf_init(&font_atlas_upload, "font_atlas_upload");
+   retro_perf_start(&font_atlas_upload);
+
+   gl_raster_font_upload_atlas(font, atlas, font->tex_width, font->tex_height);
+   font->atlas_version = atlas->version;
+
+   retro_perf_stop(&font_atlas_upload);
+}
+
+static void gl_raster_font_draw_vertices(gl_raster_t *font,
+      const gfx_coords_t *coords)
 {
+   static struct retro_perf_counter font_draw = {0};
+   gl_t *gl = font->gl;
+
+   gl_raster_font_update_atlas(font);
+
    video_shader_driver_set_coords(NULL, coords);
    video_shader_driver_set_mvp(gl, &gl->mvp_no_rot);
 
+   rarch_perf_init(&font_draw, "font_draw");
+   retro_perf_start(&font_draw);
    glDrawArrays(GL_TRIANGLES, 0, coords->vertices);
+   retro_perf_stop(&font_draw);
+
+   if (font->font_driver->glyphs_drawn)
+      font->font_driver->glyphs_drawn(font->font_data);
 }
 
 static void gl_raster_font_render_line(
@@ -237,19 +280,18 @@ static void gl_raster_font_render_line(
 {
    int x, y, delta_x, delta_y;
    float inv_tex_size_x, inv_tex_size_y, inv_win_width, inv_win_height;
-   unsigned i, msg_len;
+   unsigned i;
    struct gfx_coords coords;
    GLfloat font_tex_coords[2 * 6 * MAX_MSG_LEN_CHUNK];
    GLfloat font_vertex[2 * 6 * MAX_MSG_LEN_CHUNK]; 
    GLfloat font_color[4 * 6 * MAX_MSG_LEN_CHUNK];
    GLfloat font_lut_tex_coord[2 * 6 * MAX_MSG_LEN_CHUNK];
+   const char *msg_end = msg + msg_len_full;
    gl_t *gl       = font ? font->gl : NULL;
 
    if (!gl)
       return;
 
-   msg_len        = min(msg_len_full, MAX_MSG_LEN_CHUNK);
-
    x              = roundf(pos_x * gl->vp.width);
    y              = roundf(pos_y * gl->vp.height);
    delta_x        = 0;
@@ -270,16 +312,21 @@ static void gl_raster_font_render_line(
    inv_win_width  = 1.0f / font->gl->vp.width;
    inv_win_height = 1.0f / font->gl->vp.height;
 
-   while (msg_len_full)
+   while (msg < msg_end)
    {
-      for (i = 0; i < msg_len; i++)
+      for (i = 0; i < MAX_MSG_LEN_CHUNK && msg < msg_end; )
       {
          int off_x, off_y, tex_x, tex_y, width, height;
-         const struct font_glyph *glyph =
-            font->font_driver->get_glyph(font->font_data, (uint8_t)msg[i]);
+         const struct font_glyph *glyph = NULL;
+         uint32_t code                  = utf8_walk(&msg);
 
-         if (!glyph) /* Do something smarter here ... */
-            glyph = font->font_driver->get_glyph(font->font_data, '?');
+         if (!code)
+         {
+            msg = msg_end;
+            break;
+         }
+
+         glyph = gl_raster_font_lookup(font, code);
          if (!glyph)
             continue;
 
@@ -300,22 +347,22 @@ static void gl_raster_font_render_line(
 
          delta_x += glyph->advance_x;
          delta_y -= glyph->advance_y;
+         i++;
       }
 
+      if (!i)
+         continue;
+
       coords.tex_coord     = font_tex_coords;
       coords.vertex        = font_vertex;
       coords.color         = font_color;
-      coords.vertices      = 6 * msg_len;
+      coords.vertices      = 6 * i;
       coords.lut_tex_coord = font_lut_tex_coord;
 
       if (font->block)
          gfx_coord_array_add(&font->block->carr, &coords, coords.vertices);
       else
-         gl_raster_font_draw_vertices(gl, &coords);
-
-      msg_len_full -= msg_len;
-      msg          += msg_len;
-      msg_len       = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+         gl_raster_font_draw_vertices(font, &coords);
    }
 }
 
@@ -489,7 +536,7 @@ static void gl_raster_font_flush_block(void *data)
       return;
 
    gl_raster_font_setup_viewport(font, block->fullscreen);
-   gl_raster_font_draw_vertices(font->gl, (gfx_coords_t*)&block->carr.coords);
+   gl_raster_font_draw_vertices(font, (gfx_coords_t*)&block->carr.coords);
    gl_raster_font_restore_viewport(font->gl);
 }
 
@@ -148,5 +148,6 @@ font_renderer_driver_t bitmap_font_renderer = {
    font_renderer_bmp_get_default_font,
    "bitmap",
    font_renderer_bmp_get_line_height,
+   NULL, /* glyphs_drawn */
 };
 
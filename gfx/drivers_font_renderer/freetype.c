@@ -27,9 +27,25 @@
 #include "../font_driver.h"
 #include "../../general.h"
 
-#define FT_ATLAS_ROWS 16
-#define FT_ATLAS_COLS 16
-#define FT_ATLAS_SIZE (FT_ATLAS_ROWS * FT_ATLAS_COLS)
+/* Glyphs live in fixed-size cells of a single atlas. ASCII is
+ * rendered up front and pinned; everything else (CJK menus,
+ * accented OSD text) is rendered on first use and evicted
+ * least-recently-used once the atlas is full. Glyphs looked
+ * up since the font driver last drew are never evicted, queued
+ * vertices still point at their cells. */
+#define FT_ATLAS_MAX_CELLS  32
+#define FT_ATLAS_MAX_SIZE   2048
+#define FT_ATLAS_PINNED     128
+#define FT_HASH_SIZE        256
+
+typedef struct ft_font_glyph_slot
+{
+   struct font_glyph glyph;
+   uint32_t code;
+   unsigned last_used;
+   int next;      /* Next slot in the same hash bucket, or -1. */
+   bool used;
+} ft_font_glyph_slot_t;
 
 typedef struct freetype_renderer
 {
@@ -37,7 +53,19 @@ typedef struct freetype_renderer
    FT_Face face;
 
    struct font_atlas atlas;
-   struct font_glyph glyphs[FT_ATLAS_SIZE];
+
+   unsigned cell_width;
+   unsigned cell_height;
+   unsigned cols;
+   unsigned num_slots;
+   unsigned tick;
+   /* Tick of the last glyphs_drawn() call. */
+   unsigned drawn_tick;
+   /* False for font drivers that never call glyphs_drawn(). */
+   bool tracks_draws;
+
+   ft_font_glyph_slot_t *slots;
+   int buckets[FT_HASH_SIZE];
 } ft_font_renderer_t;
 
 static const struct font_atlas *font_renderer_ft_get_atlas(void *data)
@@ -48,13 +76,135 @@ static const struct font_atlas *font_renderer_ft_get_atlas(void *data)
    return &handle->atlas;
 }
 
+static void font_renderer_ft_unlink(ft_font_renderer_t *handle, int idx)
+{
+   int *link = &handle->buckets[handle->slots[idx].code % FT_HASH_SIZE];
+
+   for (; *link >= 0; link = &handle->slots[*link].next)
+   {
+      if (*link == idx)
+      {
+         *link = handle->slots[idx].next;
+         break;
+      }
+   }
+
+   handle->slots[idx].used = false;
+}
+
+/* Returns a free slot, or the least recently used one
+ * that is not waiting to be drawn. */
+static int font_renderer_ft_alloc_slot(ft_font_renderer_t *handle)
+{
+   unsigned i;
+   int lru = -1;
+
+   for (i = FT_ATLAS_PINNED; i < handle->num_slots; i++)
+   {
+      if (!handle->slots[i].used)
+         return i;
+
+      if (handle->tracks_draws
+            && handle->slots[i].last_used > handle->drawn_tick)
+         continue;
+
+      if (lru < 0 || handle->slots[i].last_used
+            < handle->slots[lru].last_used)
+         lru = i;
+   }
+
+   if (lru >= 0)
+      font_renderer_ft_unlink(handle, lru);
+
+   return lru;
+}
+
+static bool font_renderer_ft_render_glyph(ft_font_renderer_t *handle,
+      uint32_t code, int idx)
+{
+   unsigned r, width, height;
+   uint8_t *dst               = NULL;
+   FT_GlyphSlot slot          = NULL;
+   struct font_glyph *glyph   = &handle->slots[idx].glyph;
+   unsigned offset_x          = (idx % handle->cols) * handle->cell_width;
+   unsigned offset_y          = (idx / handle->cols) * handle->cell_height;
+
+   if (FT_Load_Char(handle->face, code, FT_LOAD_RENDER))
+      return false;
+
+   FT_Render_Glyph(handle->face->glyph, FT_RENDER_MODE_NORMAL);
+   slot = handle->face->glyph;
+
+   /* Oversized glyphs are clipped to the cell. */
+   width  = min((unsigned)slot->bitmap.width, handle->cell_width);
+   height = min((unsigned)slot->bitmap.rows, handle->cell_height);
+
+   glyph->width          = width;
+   glyph->height         = height;
+   glyph->atlas_offset_x = offset_x;
+   glyph->atlas_offset_y = offset_y;
+   glyph->advance_x      = slot->advance.x >> 6;
+   glyph->advance_y      = slot->advance.y >> 6;
+   glyph->draw_offset_x  = slot->bitmap_left;
+   glyph->draw_offset_y  = -slot->bitmap_top;
+
+   dst = handle->atlas.buffer + offset_x + offset_y * handle->atlas.width;
+
+   for (r = 0; r < handle->cell_height; r++, dst += handle->atlas.width)
+   {
+      if (r < height)
+      {
+         memcpy(dst, slot->bitmap.buffer + r * slot->bitmap.pitch, width);
+         memset(dst + width, 0, handle->cell_width - width);
+      }
+      else
+         memset(dst, 0, handle->cell_width);
+   }
+
+   handle->atlas.version++;
+   return true;
+}
+
 static const struct font_glyph *font_renderer_ft_get_glyph(
       void *data, uint32_t code)
 {
+   int idx;
    ft_font_renderer_t *handle = (ft_font_renderer_t*)data;
+
    if (!handle)
       return NULL;
-   return code < FT_ATLAS_SIZE ? &handle->glyphs[code] : NULL;
+
+   if (code < FT_ATLAS_PINNED)
+      return &handle->slots[code].glyph;
+
+   for (idx = handle->buckets[code % FT_HASH_SIZE]; idx >= 0;
+         idx = handle->slots[idx].next)
+   {
+      if (handle->slots[idx].code == code)
+      {
+         handle->slots[idx].last_used = ++handle->tick;
+         return &handle->slots[idx].glyph;
+      }
+   }
+
+   /* Let the caller substitute a replacement glyph. */
+   if (!FT_Get_Char_Index(handle->face, code))
+      return NULL;
+
+   idx = font_renderer_ft_alloc_slot(handle);
+   if (idx < 0)
+      return NULL;
+
+   if (!font_renderer_ft_render_glyph(handle, code, idx))
+      return NULL;
+
+   handle->slots[idx].code      = code;
+   handle->slots[idx].last_used = ++handle->tick;
+   handle->slots[idx].used      = true;
+   handle->slots[idx].next      = handle->buckets[code % FT_HASH_SIZE];
+   handle->buckets[code % FT_HASH_SIZE] = idx;
+
+   return &handle->slots[idx].glyph;
 }
 
 static void font_renderer_ft_free(void *data)
@@ -64,6 +214,7 @@ static void font_renderer_ft_free(void *data)
       return;
 
    free(handle->atlas.buffer);
+   free(handle->slots);
 
    if (handle->face)
       FT_Done_Face(handle->face);
@@ -72,94 +223,67 @@ static void font_renderer_ft_free(void *data)
    free(handle);
 }
 
-static bool font_renderer_create_atlas(ft_font_renderer_t *handle)
+static bool font_renderer_create_atlas(ft_font_renderer_t *handle,
+      float font_size)
 {
-   unsigned i;
-   bool ret = true;
-
-   uint8_t *buffer[FT_ATLAS_SIZE] = {NULL};
-   unsigned pitches[FT_ATLAS_SIZE] = {0};
-
-   unsigned max_width = 0;
+   unsigned i, rows;
+   unsigned max_width  = 0;
    unsigned max_height = 0;
 
-   for (i = 0; i < FT_ATLAS_SIZE; i++)
+   /* Size cells for the larger of ASCII and a full-width glyph. */
+   for (i = 0; i < FT_ATLAS_PINNED; i++)
    {
       FT_GlyphSlot slot;
-      struct font_glyph *glyph = &handle->glyphs[i];
-
-      if (!glyph)
-         continue;
 
       if (FT_Load_Char(handle->face, i, FT_LOAD_RENDER))
-      {
-         ret = false;
-         goto end;
-      }
-
-      FT_Render_Glyph(handle->face->glyph, FT_RENDER_MODE_NORMAL);
-      slot = handle->face->glyph;
-
-      /* Some glyphs can be blank. */
-      buffer[i] = (uint8_t*)calloc(slot->bitmap.rows * slot->bitmap.pitch, 1);
+         return false;
 
-      glyph->width = slot->bitmap.width;
-      glyph->height = slot->bitmap.rows;
-      pitches[i] = slot->bitmap.pitch;
-
-      glyph->advance_x = slot->advance.x >> 6;
-      glyph->advance_y = slot->advance.y >> 6;
-      glyph->draw_offset_x = slot->bitmap_left;
-      glyph->draw_offset_y = -slot->bitmap_top;
-
-      if (buffer[i])
-         memcpy(buffer[i], slot->bitmap.buffer,
-               slot->bitmap.rows * pitches[i]);
-      max_width = max(max_width, (unsigned)slot->bitmap.width);
+      slot       = handle->face->glyph;
+      max_width  = max(max_width, (unsigned)slot->bitmap.width);
       max_height = max(max_height, (unsigned)slot->bitmap.rows);
    }
 
-   handle->atlas.width = max_width * FT_ATLAS_COLS;
-   handle->atlas.height = max_height * FT_ATLAS_ROWS;
+   handle->cell_width  = max(max_width,  (unsigned)font_size) + 1;
+   handle->cell_height = max(max_height, (unsigned)font_size) + 1;
 
-   handle->atlas.buffer = (uint8_t*)
-      calloc(handle->atlas.width * handle->atlas.height, 1);
+   handle->cols = min(FT_ATLAS_MAX_CELLS,
+         FT_ATLAS_MAX_SIZE / handle->cell_width);
+   rows         = min(FT_ATLAS_MAX_CELLS,
+         FT_ATLAS_MAX_SIZE / handle->cell_height);
 
-   if (!handle->atlas.buffer)
+   /* Huge font sizes: shrink the cells instead of the atlas
+    * growing past the limit, glyphs get clipped to them. */
+   if (handle->cols * rows <= FT_ATLAS_PINNED)
    {
-      ret = false;
-      goto end;
+      handle->cols        = 16;
+      rows                = 16;
+      handle->cell_width  = min(handle->cell_width,  FT_ATLAS_MAX_SIZE / 16);
+      handle->cell_height = min(handle->cell_height, FT_ATLAS_MAX_SIZE / 16);
    }
 
-   /* Blit our texture atlas. */
-   for (i = 0; i < FT_ATLAS_SIZE; i++)
-   {
-      uint8_t *dst      = NULL;
-      unsigned offset_x = (i % FT_ATLAS_COLS) * max_width;
-      unsigned offset_y = (i / FT_ATLAS_COLS) * max_height;
-
-      handle->glyphs[i].atlas_offset_x = offset_x;
-      handle->glyphs[i].atlas_offset_y = offset_y;
+   handle->num_slots    = handle->cols * rows;
+   handle->atlas.width  = handle->cell_width  * handle->cols;
+   handle->atlas.height = handle->cell_height * rows;
+   handle->atlas.buffer = (uint8_t*)
+      calloc(handle->atlas.width * handle->atlas.height, 1);
+   handle->slots        = (ft_font_glyph_slot_t*)
+      calloc(handle->num_slots, sizeof(*handle->slots));
 
-      dst = (uint8_t*)handle->atlas.buffer;
-      dst += offset_x + offset_y * handle->atlas.width;
+   if (!handle->atlas.buffer || !handle->slots)
+      return false;
 
-      if (buffer[i])
-      {
-         unsigned r, c;
-         const uint8_t *src = (const uint8_t*)buffer[i];
+   for (i = 0; i < FT_HASH_SIZE; i++)
+      handle->buckets[i] = -1;
 
-         for (r = 0; r < handle->glyphs[i].height;
-               r++, dst += handle->atlas.width, src += pitches[i])
-            for (c = 0; c < handle->glyphs[i].width; c++)
-               dst[c] = src[c];
-      }
+   for (i = 0; i < FT_ATLAS_PINNED; i++)
+   {
+      if (!font_renderer_ft_render_glyph(handle, i, i))
+         return false;
+      handle->slots[i].code = i;
+      handle->slots[i].used = true;
    }
 
-end:
-   for (i = 0; i < FT_ATLAS_SIZE; i++)
-      free(buffer[i]);
-   return ret;
+   return true;
 }
 
 static void *font_renderer_ft_init(const char *font_path, float font_size)
@@ -184,7 +308,7 @@ static void *font_renderer_ft_init(const char *font_path, float font_size)
    if (err)
       goto error;
 
-   if (!font_renderer_create_atlas(handle))
+   if (!font_renderer_create_atlas(handle, font_size))
       goto error;
 
    return handle;
@@ -240,6 +364,16 @@ static int font_renderer_ft_get_line_height(void* data)
     return handle->face->size->metrics.height/64;
 }
 
+static void font_renderer_ft_glyphs_drawn(void *data)
+{
+   ft_font_renderer_t *handle = (ft_font_renderer_t*)data;
+   if (!handle)
+      return;
+
+   handle->drawn_tick   = handle->tick;
+   handle->tracks_draws = true;
+}
+
 font_renderer_driver_t freetype_font_renderer = {
    font_renderer_ft_init,
    font_renderer_ft_get_atlas,
@@ -248,4 +382,5 @@ font_renderer_driver_t freetype_font_renderer = {
    font_renderer_ft_get_default_font,
    "freetype",
    font_renderer_ft_get_line_height,
+   font_renderer_ft_glyphs_drawn,
 };
@@ -226,4 +226,5 @@ font_renderer_driver_t stb_font_renderer = {
    font_renderer_stb_get_default_font,
    "stb",
    font_renderer_stb_get_line_height,
+   NULL, /* glyphs_drawn */
 };
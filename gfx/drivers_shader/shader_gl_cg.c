@@ -402,11 +402,7 @@ static void gl_cg_destroy_resources(void *data)
 
    gl_cg_deinit_progs(data);
 
-   if (cg_data->shader && cg_data->shader->luts)
-   {
-      glDeleteTextures(cg_data->shader->luts, cg_data->lut_textures);
-      memset(cg_data->lut_textures, 0, sizeof(cg_data->lut_textures));
-   }
+   gl_release_luts(cg_data->lut_textures);
 
    if (cg_data->state_tracker)
    {
@@ -18,10 +18,14 @@
 
 #include <compat/strl.h>
 #include <compat/posix_string.h>
+#include <file/dir_list.h>
 #include <file/file_path.h>
+#include <retro_file.h>
+#include <retro_stat.h>
 
 #include "../../general.h"
 #include "shader_glsl.h"
+#include "shader_glsl_uniforms.h"
 #include "../video_state_tracker.h"
 #include "../../dynamic.h"
 #include "../../file_ops.h"
@@ -89,6 +93,13 @@ struct shader_uniforms
    int frame_direction;
 
    int lut_texture[GFX_MAX_TEXTURES];
+
+   /* #pragma parameters and state tracker variables, resolved
+    * at link time. What was last uploaded to them lives in the
+    * chain's uniform cache, shared by passes with one program. */
+   int parameters[GFX_MAX_PARAMETERS];
+   int variables[GFX_MAX_VARIABLES];
+   float *values;
    
    struct shader_uniforms_frame orig;
    struct shader_uniforms_frame feedback;
@@ -220,12 +231,327 @@ typedef struct glsl_shader_data
    GLuint gl_teximage[GFX_MAX_TEXTURES];
    GLint gl_attribs[PREV_TEXTURES + 2 + 4 + GFX_MAX_SHADERS];
    state_tracker_t *gl_state_tracker;
+   struct glsl_uniform_cache uniform_cache;
+
+   /* Every program this chain linked or took over, by what was
+    * compiled into it, so that the next chain can take over
+    * the ones it shares. */
+   struct glsl_program_source
+   {
+      GLuint prog;
+      uint64_t key;
+   } sources[GFX_MAX_SHADERS];
+   unsigned num_sources;
 } glsl_shader_data_t;
 
+/* The chain currently in use. A new one is built while it is
+ * still alive, see video_shader_driver_init(). */
+static glsl_shader_data_t *glsl_current;
+
 static bool glsl_core;
 static unsigned glsl_major;
 static unsigned glsl_minor;
 
+/* FNV-1a, with a separator so that
+ * ("ab", "c") and ("a", "bc") differ. */
+static uint64_t gl_glsl_cache_hash(uint64_t hash, const char *str)
+{
+   if (str)
+   {
+      for (; *str; str++)
+      {
+         hash ^= (uint8_t)*str;
+         hash *= 0x100000001b3ULL;
+      }
+   }
+
+   hash ^= 0xff;
+   hash *= 0x100000001b3ULL;
+   return hash;
+}
+
+/* Identifies a program by everything that is compiled into it. */
+static uint64_t gl_glsl_program_key(glsl_shader_data_t *glsl,
+      const char *vertex, const char *fragment)
+{
+   char version[64] = {0};
+   uint64_t key     = 0xcbf29ce484222325ULL;
+
+   snprintf(version, sizeof(version), "%d %u.%u",
+         glsl_core, glsl_major, glsl_minor);
+
+   key = gl_glsl_cache_hash(key, version);
+   key = gl_glsl_cache_hash(key, glsl->glsl_alias_define);
+   key = gl_glsl_cache_hash(key, vertex);
+   key = gl_glsl_cache_hash(key, fragment);
+   return key;
+}
+
+/* Linked programs are cached on disk where the driver can hand
+ * out program binaries. The key hashes everything that went into
+ * a program, driver vendor, renderer and version included, so
+ * a driver update simply misses the cache. Binaries of other
+ * drivers are dropped when a shader is loaded, as are the
+ * oldest ones once the cache outgrows GLSL_CACHE_MAX_SIZE. */
+#if defined(GL_PROGRAM_BINARY_LENGTH)
+#define HAVE_GLSL_PROGRAM_BINARY
+#elif defined(GL_PROGRAM_BINARY_LENGTH_OES)
+#define HAVE_GLSL_PROGRAM_BINARY
+#define glGetProgramBinary        glGetProgramBinaryOES
+#define glProgramBinary           glProgramBinaryOES
+#define GL_PROGRAM_BINARY_LENGTH  GL_PROGRAM_BINARY_LENGTH_OES
+#define GL_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+#endif
+
+#ifdef HAVE_GLSL_PROGRAM_BINARY
+#define GLSL_CACHE_MAGIC   0x42534c47 /* "GLSB" */
+#define GLSL_CACHE_VERSION 2
+#define GLSL_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+struct glsl_cache_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t format;
+   uint32_t size;
+   uint64_t key;
+   uint64_t driver;
+};
+
+struct glsl_cache_file
+{
+   const char *path;
+   int64_t mtime;
+   int32_t size;
+};
+
+static bool glsl_cache_enable;
+static uint64_t glsl_cache_driver;
+
+static uint64_t gl_glsl_cache_key(uint64_t program_key)
+{
+   /* Binaries only load on the driver that made them. */
+   return (glsl_cache_driver ^ program_key) * 0x100000001b3ULL;
+}
+
+static bool gl_glsl_cache_dir(char *s, size_t len, bool create)
+{
+   char base[PATH_MAX_LENGTH] = {0};
+   settings_t *settings       = config_get_ptr();
+   global_t   *global         = global_get_ptr();
+
+   if (*settings->cache_directory)
+      strlcpy(base, settings->cache_directory, sizeof(base));
+   else if (*global->path.config)
+      fill_pathname_basedir(base, global->path.config, sizeof(base));
+
+   if (!*base)
+      return false;
+
+   fill_pathname_join(s, base, "shaders", len);
+   if (create && !path_is_directory(s) && !path_mkdir(s))
+      return false;
+
+   return true;
+}
+
+static bool gl_glsl_cache_path(char *s, size_t len, uint64_t key,
+      bool create)
+{
+   char dir[PATH_MAX_LENGTH]  = {0};
+   char name[64]              = {0};
+
+   if (!gl_glsl_cache_dir(dir, sizeof(dir), create))
+      return false;
+
+   snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+   fill_pathname_join(s, dir, name, len);
+   return true;
+}
+
+/* Oldest first. */
+static int gl_glsl_cache_file_compare(const void *a, const void *b)
+{
+   const struct glsl_cache_file *left  = (const struct glsl_cache_file*)a;
+   const struct glsl_cache_file *right = (const struct glsl_cache_file*)b;
+
+   if (left->mtime != right->mtime)
+      return left->mtime < right->mtime ? -1 : 1;
+   return 0;
+}
+
+static bool gl_glsl_cache_file_valid(const char *path)
+{
+   struct glsl_cache_header header;
+   bool valid   = false;
+   RFILE *file  = retro_fopen(path, RFILE_MODE_READ, -1);
+
+   if (!file)
+      return false;
+
+   if (retro_fread(file, &header, sizeof(header)) == sizeof(header))
+      valid = header.magic   == GLSL_CACHE_MAGIC
+         &&   header.version == GLSL_CACHE_VERSION
+         &&   header.driver  == glsl_cache_driver;
+
+   retro_fclose(file);
+   return valid;
+}
+
+static void gl_glsl_cache_prune(void)
+{
+   unsigned i;
+   char dir[PATH_MAX_LENGTH]      = {0};
+   unsigned count                 = 0;
+   unsigned removed               = 0;
+   int64_t total                  = 0;
+   struct string_list *list       = NULL;
+   struct glsl_cache_file *files  = NULL;
+
+   if (!gl_glsl_cache_dir(dir, sizeof(dir), false)
+         || !path_is_directory(dir))
+      return;
+
+   list = dir_list_new(dir, "bin", false, false);
+   if (!list)
+      return;
+
+   files = (struct glsl_cache_file*)calloc(list->size + 1, sizeof(*files));
+   if (!files)
+      goto end;
+
+   for (i = 0; i < list->size; i++)
+   {
+      struct glsl_cache_file *file = &files[count];
+
+      file->path = list->elems[i].data;
+
+      if (!gl_glsl_cache_file_valid(file->path)
+            || !path_stat(file->path, &file->size, &file->mtime))
+      {
+         remove(file->path);
+         removed++;
+         continue;
+      }
+
+      total += file->size;
+      count++;
+   }
+
+   qsort(files, count, sizeof(*files), gl_glsl_cache_file_compare);
+
+   for (i = 0; i < count && total > GLSL_CACHE_MAX_SIZE; i++)
+   {
+      remove(files[i].path);
+      total -= files[i].size;
+      removed++;
+   }
+
+   if (removed)
+      RARCH_LOG("[GLSL]: Pruned %u cached programs.\n", removed);
+
+end:
+   free(files);
+   dir_list_free(list);
+}
+
+static void gl_glsl_cache_init(void)
+{
+   GLint formats = 0;
+
+   glsl_cache_enable = false;
+
+#ifndef HAVE_OPENGLES3
+   if (!glGetProgramBinary || !glProgramBinary)
+      return;
+#endif
+
+   glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+   if (formats <= 0)
+      return;
+
+   glsl_cache_driver = gl_glsl_cache_hash(0xcbf29ce484222325ULL,
+         (const char*)glGetString(GL_VENDOR));
+   glsl_cache_driver = gl_glsl_cache_hash(glsl_cache_driver,
+         (const char*)glGetString(GL_RENDERER));
+   glsl_cache_driver = gl_glsl_cache_hash(glsl_cache_driver,
+         (const char*)glGetString(GL_VERSION));
+   glsl_cache_enable = true;
+
+   gl_glsl_cache_prune();
+}
+
+static bool gl_glsl_cache_load(GLuint prog, uint64_t key, unsigned i)
+{
+   char path[PATH_MAX_LENGTH] = {0};
+   GLint status               = GL_FALSE;
+   void *buf                  = NULL;
+   ssize_t len                = 0;
+   const struct glsl_cache_header *header = NULL;
+
+   if (!gl_glsl_cache_path(path, sizeof(path), key, false)
+         || !path_file_exists(path)
+         || !read_file(path, &buf, &len))
+   {
+      RARCH_LOG("[GLSL]: Program cache miss for program #%u.\n", i);
+      return false;
+   }
+
+   header = (const struct glsl_cache_header*)buf;
+
+   if (len >= (ssize_t)sizeof(*header)
+         && header->magic   == GLSL_CACHE_MAGIC
+         && header->version == GLSL_CACHE_VERSION
+         && header->key     == key
+         && header->size    == len - sizeof(*header))
+   {
+      glProgramBinary(prog, header->format, header + 1, header->size);
+      glGetProgramiv(prog, GL_LINK_STATUS, &status);
+   }
+
+   free(buf);
+
+   if (status != GL_TRUE)
+   {
+      RARCH_LOG("[GLSL]: Cached program #%u was rejected, recompiling.\n", i);
+      return false;
+   }
+
+   RARCH_LOG("[GLSL]: Program cache hit for program #%u.\n", i);
+   return true;
+}
+
+static void gl_glsl_cache_save(GLuint prog, uint64_t key, unsigned i)
+{
+   char path[PATH_MAX_LENGTH]       = {0};
+   GLint size                       = 0;
+   GLenum format                    = 0;
+   struct glsl_cache_header *header = NULL;
+
+   glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+   if (size <= 0 || !gl_glsl_cache_path(path, sizeof(path), key, true))
+      return;
+
+   header = (struct glsl_cache_header*)malloc(sizeof(*header) + size);
+   if (!header)
+      return;
+
+   glGetProgramBinary(prog, size, &size, &format, header + 1);
+
+   header->magic   = GLSL_CACHE_MAGIC;
+   header->version = GLSL_CACHE_VERSION;
+   header->format  = format;
+   header->size    = size;
+   header->key     = key;
+   header->driver  = glsl_cache_driver;
+
+   if (!retro_write_file(path, header, sizeof(*header) + size))
+      RARCH_WARN("[GLSL]: Failed to cache program #%u.\n", i);
+
+   free(header);
+}
+#endif
+
 static GLint get_uniform(glsl_shader_data_t *glsl,
       GLuint prog, const char *base)
 {
@@ -379,14 +705,119 @@ static bool link_program(GLuint prog)
    return true;
 }
 
+static void gl_glsl_add_source(glsl_shader_data_t *glsl,
+      GLuint prog, uint64_t key)
+{
+   if (glsl->num_sources >= GFX_MAX_SHADERS)
+      return;
+
+   glsl->sources[glsl->num_sources].prog = prog;
+   glsl->sources[glsl->num_sources].key  = key;
+   glsl->num_sources++;
+}
+
+static bool gl_glsl_has_source(const glsl_shader_data_t *glsl,
+      GLuint prog)
+{
+   unsigned i;
+
+   for (i = 0; i < glsl->num_sources; i++)
+   {
+      if (glsl->sources[i].prog == prog)
+         return true;
+   }
+
+   return false;
+}
+
+/* Shares a program the current chain linked from the same
+ * sources, instead of compiling it again. The current chain
+ * gives it up once this one is built, see
+ * gl_glsl_take_programs(). */
+static GLuint gl_glsl_share_program(glsl_shader_data_t *glsl,
+      uint64_t key, unsigned i)
+{
+   unsigned j;
+   const glsl_shader_data_t *old = glsl_current;
+
+   if (!old || old == glsl)
+      return 0;
+
+   for (j = 0; j < old->num_sources; j++)
+   {
+      GLuint prog = old->sources[j].prog;
+
+      if (!prog || old->sources[j].key != key
+            || gl_glsl_has_source(glsl, prog))
+         continue;
+
+      gl_glsl_add_source(glsl, prog, key);
+      RARCH_LOG("[GLSL]: Program #%u is unchanged, reusing it.\n", i);
+      return prog;
+   }
+
+   return 0;
+}
+
+static void gl_glsl_take_programs(glsl_shader_data_t *glsl,
+      glsl_shader_data_t *old)
+{
+   unsigned i, j;
+
+   if (!old || old == glsl)
+      return;
+
+   for (i = 0; i < glsl->num_sources; i++)
+   {
+      GLuint prog = glsl->sources[i].prog;
+
+      for (j = 0; j < old->num_sources; j++)
+      {
+         if (old->sources[j].prog == prog)
+            old->sources[j].prog = 0;
+      }
+
+      for (j = 0; j < GFX_MAX_SHADERS; j++)
+      {
+         if (old->gl_program[j] == prog)
+            old->gl_program[j] = 0;
+      }
+   }
+}
+
 static GLuint compile_program(glsl_shader_data_t *glsl,
       const char *vertex,
       const char *fragment, unsigned i)
 {
-   GLuint vert = 0, frag = 0, prog = glCreateProgram();
+   GLuint vert = 0, frag = 0, prog = 0;
+   uint64_t key = 0;
+
+   if (vertex || fragment)
+   {
+      key  = gl_glsl_program_key(glsl, vertex, fragment);
+      prog = gl_glsl_share_program(glsl, key, i);
+      if (prog)
+         return prog;
+   }
+
+   prog = glCreateProgram();
    if (!prog)
       return 0;
 
+#ifdef HAVE_GLSL_PROGRAM_BINARY
+   if (glsl_cache_enable && (vertex || fragment))
+   {
+      if (gl_glsl_cache_load(prog, gl_glsl_cache_key(key), i))
+      {
+         glUseProgram(prog);
+         glUniform1i(get_uniform(glsl, prog, "Texture"), 0);
+         glUseProgram(0);
+         gl_glsl_add_source(glsl, prog, key);
+         return prog;
+      }
+   }
+#endif
+
    if (vertex)
    {
       RARCH_LOG("Found GLSL vertex shader.\n");
@@ -418,6 +849,11 @@ static GLuint compile_program(glsl_shader_data_t *glsl,
 
    if (vertex || fragment)
    {
+#if defined(HAVE_GLSL_PROGRAM_BINARY) && defined(GL_PROGRAM_BINARY_RETRIEVABLE_HINT) && !defined(HAVE_OPENGLES)
+      if (glsl_cache_enable && glProgramParameteri)
+         glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+
       RARCH_LOG("Linking GLSL program.\n");
       if (!link_program(prog))
       {
@@ -433,9 +869,15 @@ static GLuint compile_program(glsl_shader_data_t *glsl,
       if (frag)
          glDeleteShader(frag);
 
+#ifdef HAVE_GLSL_PROGRAM_BINARY
+      if (glsl_cache_enable)
+         gl_glsl_cache_save(prog, gl_glsl_cache_key(key), i);
+#endif
+
       glUseProgram(prog);
       glUniform1i(get_uniform(glsl, prog, "Texture"), 0);
       glUseProgram(0);
+      gl_glsl_add_source(glsl, prog, key);
    }
 
    return prog;
@@ -590,6 +1032,7 @@ static void find_uniforms(glsl_shader_data_t *glsl,
       struct shader_uniforms *uni)
 {
    unsigned i;
+   bool fresh          = false;
    char frame_base[64] = {0};
 
    glUseProgram(prog);
@@ -610,6 +1053,29 @@ static void find_uniforms(glsl_shader_data_t *glsl,
    for (i = 0; i < glsl->shader->luts; i++)
       uni->lut_texture[i] = glGetUniformLocation(prog, glsl->shader->lut[i].id);
 
+   /* Passes that run the same program get the same entry,
+    * zeroed once. A program taken over from the last chain
+    * still holds the values it was given there. */
+   uni->values = glsl_uniform_cache_get(&glsl->uniform_cache, prog, &fresh);
+
+   for (i = 0; i < glsl->shader->num_parameters; i++)
+   {
+      uni->parameters[i] = glGetUniformLocation(prog,
+            glsl->shader->parameters[i].id);
+
+      if (fresh && uni->parameters[i] >= 0)
+         glUniform1f(uni->parameters[i], 0.0f);
+   }
+
+   for (i = 0; i < glsl->shader->variables; i++)
+   {
+      uni->variables[i] = glGetUniformLocation(prog,
+            glsl->shader->variable[i].id);
+
+      if (fresh && uni->variables[i] >= 0)
+         glUniform1f(uni->variables[i], 0.0f);
+   }
+
    clear_uniforms_frame(&uni->orig);
    find_uniforms_frame(glsl, prog, &uni->orig, "Orig");
    clear_uniforms_frame(&uni->feedback);
@@ -677,15 +1143,20 @@ static void gl_glsl_destroy_resources(glsl_shader_data_t *glsl)
          continue;
       if (!glIsProgram(glsl->gl_program[i]))
          continue;
+      /* Shared with the chain in use, this one failed to build. */
+      if (glsl_current && glsl_current != glsl
+            && gl_glsl_has_source(glsl_current, glsl->gl_program[i]))
+         continue;
 
       glDeleteProgram(glsl->gl_program[i]);
    }
 
-   if (glsl->shader && glsl->shader->luts)
-      glDeleteTextures(glsl->shader->luts, glsl->gl_teximage);
+   gl_release_luts(glsl->gl_teximage);
 
    memset(glsl->gl_program, 0, sizeof(glsl->gl_program));
    memset(glsl->gl_uniforms, 0, sizeof(glsl->gl_uniforms));
+   memset(glsl->sources, 0, sizeof(glsl->sources));
+   glsl->num_sources = 0;
    glsl->glsl_active_index = 0;
 
    gl_glsl_deinit_shader(glsl);
@@ -716,6 +1187,9 @@ static void gl_glsl_deinit(void *data)
    if (!glsl)
       return;
 
+   if (glsl == glsl_current)
+      glsl_current = NULL;
+
    gl_glsl_destroy_resources(glsl);
 
    free(glsl);
@@ -755,6 +1229,10 @@ static void *gl_glsl_init(void *data, const char *path)
    }
 #endif
 
+#ifdef HAVE_GLSL_PROGRAM_BINARY
+   gl_glsl_cache_init();
+#endif
+
    glsl->shader = (struct video_shader*)calloc(1, sizeof(*glsl->shader));
    if (!glsl->shader)
       goto error;
@@ -923,6 +1401,9 @@ static void *gl_glsl_init(void *data, const char *path)
       glGenBuffers(1, &glsl->glsl_vbo[i].vbo_secondary);
    }
 
+   gl_glsl_take_programs(glsl, glsl_current);
+   glsl_current = glsl;
+
    return glsl;
 
 error:
@@ -948,7 +1429,7 @@ static void gl_glsl_set_params(void *data, void *shader_data,
    struct glsl_attrib attribs[32];
    float input_size[2], output_size[2], texture_size[2];
    unsigned i, texunit = 1;
-   const struct shader_uniforms *uni = NULL;
+   struct shader_uniforms *uni = NULL;
    size_t size = 0, attribs_size = 0;
    const struct gfx_tex_info *info = (const struct gfx_tex_info*)_info;
    const struct gfx_tex_info *prev_info = (const struct gfx_tex_info*)_prev_info;
@@ -960,7 +1441,7 @@ static void gl_glsl_set_params(void *data, void *shader_data,
    if (!glsl)
       return;
 
-   uni = (const struct shader_uniforms*)&glsl->gl_uniforms[glsl->glsl_active_index];
+   uni = &glsl->gl_uniforms[glsl->glsl_active_index];
 
    (void)data;
 
@@ -1140,13 +1621,16 @@ static void gl_glsl_set_params(void *data, void *shader_data,
 
    glActiveTexture(GL_TEXTURE0);
 
-   /* #pragma parameters. */
+   /* #pragma parameters. Only upload what changed. */
    for (i = 0; i < glsl->shader->num_parameters; i++)
    {
-      int location = glGetUniformLocation(
-            glsl->gl_program[glsl->glsl_active_index],
-            glsl->shader->parameters[i].id);
-      glUniform1f(location, glsl->shader->parameters[i].current);
+      float value = glsl->shader->parameters[i].current;
+
+      if (uni->parameters[i] < 0
+            || !glsl_uniform_cache_set(uni->values, i, value))
+         continue;
+
+      glUniform1f(uni->parameters[i], value);
    }
 
    /* Set state parameters. */
@@ -1159,12 +1643,16 @@ static void gl_glsl_set_params(void *data, void *shader_data,
          cnt = state_tracker_get_uniform(glsl->gl_state_tracker, state_info,
                GFX_MAX_VARIABLES, frame_count);
 
+      /* Same order as shader->variable, which
+       * the locations were looked up from. */
       for (i = 0; i < cnt; i++)
       {
-         int location = glGetUniformLocation(
-               glsl->gl_program[glsl->glsl_active_index],
-               state_info[i].id);
-         glUniform1f(location, state_info[i].value);
+         if (uni->variables[i] < 0
+               || !glsl_uniform_cache_set(uni->values,
+                  GLSL_UNIFORM_VARIABLE(i), state_info[i].value))
+            continue;
+
+         glUniform1f(uni->variables[i], state_info[i].value);
       }
    }
 }
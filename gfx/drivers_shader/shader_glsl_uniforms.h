@@ -0,0 +1,109 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SHADER_GLSL_UNIFORMS_H
+#define __SHADER_GLSL_UNIFORMS_H
+
+#include <string.h>
+
+#include <boolean.h>
+#include <retro_inline.h>
+
+#include "../video_shader_parse.h"
+
+/* #pragma parameters come first, state tracker variables
+ * after them. */
+#define GLSL_UNIFORM_VARIABLE(i) (GFX_MAX_PARAMETERS + (i))
+#define GLSL_UNIFORM_VALUES      (GFX_MAX_PARAMETERS + GFX_MAX_VARIABLES)
+
+/* What was last uploaded to the float uniforms of a program.
+ * The cache belongs to the program rather than to a pass,
+ * since several passes can run the same program. */
+struct glsl_uniform_values
+{
+   unsigned prog;
+   float values[GLSL_UNIFORM_VALUES];
+};
+
+struct glsl_uniform_cache
+{
+   struct glsl_uniform_values programs[GFX_MAX_SHADERS];
+   unsigned num_programs;
+};
+
+/**
+ * glsl_uniform_cache_get:
+ * @cache              : uniform cache of a shader chain.
+ * @prog               : program object.
+ * @fresh              : set if the entry was just added.
+ *
+ * Looks up the values cached for @prog, adding an entry with
+ * every value at zero if it has none yet. The caller has to
+ * upload those zeros when @fresh is set, so the entry holds
+ * whether the program was just linked or taken over with
+ * other values.
+ *
+ * Returns: the values, or NULL if the cache is full, in which
+ * case every upload goes through.
+ **/
+static INLINE float *glsl_uniform_cache_get(
+      struct glsl_uniform_cache *cache, unsigned prog, bool *fresh)
+{
+   unsigned i;
+   struct glsl_uniform_values *entry = NULL;
+
+   *fresh = false;
+
+   for (i = 0; i < cache->num_programs; i++)
+   {
+      if (cache->programs[i].prog == prog)
+         return cache->programs[i].values;
+   }
+
+   if (cache->num_programs >= GFX_MAX_SHADERS)
+      return NULL;
+
+   entry       = &cache->programs[cache->num_programs++];
+   entry->prog = prog;
+   memset(entry->values, 0, sizeof(entry->values));
+   *fresh      = true;
+
+   return entry->values;
+}
+
+/**
+ * glsl_uniform_cache_set:
+ * @values             : values from glsl_uniform_cache_get(), or NULL.
+ * @index              : uniform, see GLSL_UNIFORM_VARIABLE().
+ * @value              : value about to be uploaded.
+ *
+ * Returns: true (1) if @value differs from what the program
+ * holds and has to be uploaded, otherwise false (0).
+ **/
+static INLINE bool glsl_uniform_cache_set(float *values,
+      unsigned index, float value)
+{
+   if (!values)
+      return true;
+
+   if (values[index] == value)
+      return false;
+
+   values[index] = value;
+   return true;
+}
+
+#endif
@@ -0,0 +1,175 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Drives the uniform cache the way shader_glsl.c does, against a
+ * fake GL that counts glUniform1f() calls and remembers what each
+ * program holds. Checks that every pass draws with the values it
+ * asked for, and that nothing unchanged is uploaded again. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "shader_glsl_uniforms.h"
+
+#define TEST_PROGRAMS   4
+#define TEST_PARAMETERS 3
+
+static unsigned uploads;
+static float gl_state[TEST_PROGRAMS][GLSL_UNIFORM_VALUES];
+
+static void fake_uniform1f(unsigned prog, unsigned index, float value)
+{
+   gl_state[prog][index] = value;
+   uploads++;
+}
+
+/* Same steps as find_uniforms(). */
+static float *test_link(struct glsl_uniform_cache *cache, unsigned prog)
+{
+   unsigned i;
+   bool fresh     = false;
+   float *values  = glsl_uniform_cache_get(cache, prog, &fresh);
+
+   if (fresh)
+      for (i = 0; i < TEST_PARAMETERS; i++)
+         fake_uniform1f(prog, i, 0.0f);
+
+   return values;
+}
+
+/* Same steps as gl_glsl_set_params(), then checks what the pass
+ * would draw with. */
+static int test_draw(unsigned prog, float *values, const float *params)
+{
+   unsigned i;
+
+   for (i = 0; i < TEST_PARAMETERS; i++)
+      if (glsl_uniform_cache_set(values, i, params[i]))
+         fake_uniform1f(prog, i, params[i]);
+
+   for (i = 0; i < TEST_PARAMETERS; i++)
+   {
+      if (gl_state[prog][i] != params[i])
+      {
+         printf("ERROR: program %u draws with %f for parameter %u, "
+               "expected %f\n", prog, gl_state[prog][i], i, params[i]);
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+static int test_expect(const char *what, unsigned expected)
+{
+   if (uploads == expected)
+      return 0;
+
+   printf("ERROR: %s uploaded %u uniforms, expected %u\n",
+         what, uploads, expected);
+   return 1;
+}
+
+/* Runs a chain of three passes where the first and last share a
+ * program, plus a copy of the first as the final pass, like
+ * gl_uniforms[passes + 1]. */
+static int test_chain(bool taken_over)
+{
+   unsigned i, frame;
+   float *values[4];
+   int failed                       = 0;
+   static const unsigned passes[4]  = { 1, 2, 1, 1 };
+   float params[TEST_PARAMETERS]    = { 0.5f, 0.0f, 1.0f };
+   struct glsl_uniform_cache cache;
+
+   memset(&cache, 0, sizeof(cache));
+   memset(gl_state, 0, sizeof(gl_state));
+
+   /* A program taken over from the last chain holds whatever
+    * that chain uploaded. */
+   if (taken_over)
+      for (i = 0; i < TEST_PARAMETERS; i++)
+         gl_state[1][i] = 0.75f;
+
+   uploads = 0;
+   for (i = 0; i < 3; i++)
+      values[i] = test_link(&cache, passes[i]);
+   values[3] = values[0];
+   failed |= test_expect("linking two programs", 2 * TEST_PARAMETERS);
+
+   /* Parameters 0 and 2 differ from zero, once per program. */
+   uploads = 0;
+   for (i = 0; i < 4; i++)
+      failed |= test_draw(passes[i], values[i], params);
+   failed |= test_expect("the first frame", 4);
+
+   uploads = 0;
+   for (frame = 0; frame < 10; frame++)
+      for (i = 0; i < 4; i++)
+         failed |= test_draw(passes[i], values[i], params);
+   failed |= test_expect("unchanged frames", 0);
+
+   params[1] = 0.25f;
+   uploads   = 0;
+   for (i = 0; i < 4; i++)
+      failed |= test_draw(passes[i], values[i], params);
+   failed |= test_expect("changing one parameter", 2);
+
+   return failed;
+}
+
+/* With every entry taken, uploads must still go through. */
+static int test_full(void)
+{
+   unsigned i;
+   float *values                 = NULL;
+   bool fresh                    = false;
+   int failed                    = 0;
+   float params[TEST_PARAMETERS] = { 0.5f, 0.5f, 0.5f };
+   struct glsl_uniform_cache cache;
+
+   memset(&cache, 0, sizeof(cache));
+   memset(gl_state, 0, sizeof(gl_state));
+
+   for (i = 0; i < GFX_MAX_SHADERS; i++)
+      glsl_uniform_cache_get(&cache, 100 + i, &fresh);
+
+   values = glsl_uniform_cache_get(&cache, 3, &fresh);
+   if (values || fresh)
+   {
+      puts("ERROR: full cache handed out an entry");
+      failed = 1;
+   }
+
+   uploads = 0;
+   for (i = 0; i < 2; i++)
+      failed |= test_draw(3, values, params);
+   failed |= test_expect("a full cache", 2 * TEST_PARAMETERS);
+
+   return failed;
+}
+
+int main(void)
+{
+   int failed = 0;
+
+   failed |= test_chain(false);
+   failed |= test_chain(true);
+   failed |= test_full();
+
+   puts(failed ? "FAILED" : "ok");
+   return failed;
+}
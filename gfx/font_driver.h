@@ -72,6 +72,9 @@ struct font_atlas
    uint8_t *buffer; /* Alpha channel. */
    unsigned width;
    unsigned height;
+   /* Bumped by renderers that rasterize glyphs on demand. Font
+    * drivers re-upload the atlas when it differs from their copy. */
+   unsigned version;
 };
 
 struct font_params
@@ -111,7 +114,8 @@ typedef struct font_renderer_driver
 
    const struct font_atlas *(*get_atlas)(void *data);
 
-   /* Returns NULL if no glyph for this code is found. */
+   /* Returns NULL if no glyph for this code is found.
+    * May add the glyph to the atlas and bump its version. */
    const struct font_glyph *(*get_glyph)(void *data, uint32_t code);
 
    void (*free)(void *data);
@@ -121,6 +125,10 @@ typedef struct font_renderer_driver
    const char *ident;
    
    int (*get_line_height)(void* data);
+
+   /* Optional. Tells renderers that evict glyphs that everything
+    * looked up so far has been drawn, so their cells may be reused. */
+   void (*glyphs_drawn)(void *data);
 } font_renderer_driver_t;
 
 /* font_path can be NULL for default font. */
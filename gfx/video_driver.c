@@ -25,8 +25,10 @@
 #include "video_thread_wrapper.h"
 #include "../frontend/frontend_driver.h"
 #include "video_context_driver.h"
+#include "video_shader_watch.h"
 #include "../record/record_driver.h"
 #include "../config.def.h"
+#include "../frame_pacing.h"
 #include "../general.h"
 #include "../performance.h"
 #include "../string_list_special.h"
@@ -34,6 +36,7 @@
 #include "../system.h"
 
 #ifdef HAVE_MENU
+#include "../menu/menu_driver.h"
 #include "../menu/menu_hash.h"
 #include "../menu/menu_setting.h"
 #endif
@@ -72,6 +75,17 @@ typedef struct video_driver_state
       unsigned out_bpp;
       bool out_rgb32;
    } filter;
+
+   /* Content hash of the last frame handed to the driver,
+    * see video_driver_frame_is_dupe(). */
+   struct
+   {
+      bool valid;
+      uint64_t hash;
+      unsigned width;
+      unsigned height;
+      uint64_t count;
+   } frame_dupe;
 } video_driver_state_t;
 
 typedef struct video_pixel_scaler
@@ -287,16 +301,31 @@ static bool find_video_driver(void)
 void *video_driver_get_ptr(bool force_nonthreaded_data)
 {
 #ifdef HAVE_THREADS
-   settings_t *settings = config_get_ptr();
-
-   if (settings->video.threaded
-         && !video_driver_state.hw_render_callback.context_type && !force_nonthreaded_data)
+   if (video_driver_is_threaded() && !force_nonthreaded_data)
       return rarch_threaded_video_get_ptr(NULL);
 #endif
 
    return video_driver_data;
 }
 
+/**
+ * video_driver_is_threaded:
+ *
+ * Returns: true (1) if the video driver runs behind the
+ * threaded wrapper. Hardware rendered cores never do.
+ **/
+bool video_driver_is_threaded(void)
+{
+#ifdef HAVE_THREADS
+   settings_t *settings = config_get_ptr();
+
+   return settings->video.threaded
+      && !video_driver_state.hw_render_callback.context_type;
+#else
+   return false;
+#endif
+}
+
 const char *video_driver_get_ident(void)
 {
    return (current_video) ? current_video->ident : NULL;
@@ -336,12 +365,26 @@ retro_proc_address_t video_driver_get_proc_address(const char *sym)
    return NULL;
 }
 
+static void video_driver_frame_dupe_reset(void)
+{
+   video_driver_state.frame_dupe.valid = false;
+}
+
 bool video_driver_set_shader(enum rarch_shader_type type,
       const char *path)
 {
+   bool ret = false;
+
+   /* The driver may recreate the textures holding the last frame. */
+   video_driver_frame_dupe_reset();
+
    if (current_video->set_shader)
-      return current_video->set_shader(video_driver_data, type, path);
-   return false;
+      ret = current_video->set_shader(video_driver_data, type, path);
+
+   /* Watched even if it failed, saving a fix reloads it. */
+   video_shader_watch_set(path);
+
+   return ret;
 }
 
 static void deinit_video_filter(void)
@@ -489,6 +532,18 @@ static void video_monitor_compute_fps_statistics(void)
    }
 }
 
+static void video_driver_log_frame_dupe_statistics(void)
+{
+   settings_t *settings = config_get_ptr();
+
+   if (!settings->video.frame_dupe_detect || !video_driver_frame_count)
+      return;
+
+   RARCH_LOG("Skipped %llu duplicate frames out of %llu.\n",
+         (unsigned long long)video_driver_state.frame_dupe.count,
+         (unsigned long long)video_driver_frame_count);
+}
+
 static void deinit_pixel_converter(void)
 {
    if (!video_driver_scaler_ptr)
@@ -545,7 +600,10 @@ static bool uninit_video_input(void)
    deinit_video_filter();
 
    event_command(EVENT_CMD_SHADER_DIR_DEINIT);
+   video_shader_watch_deinit();
    video_monitor_compute_fps_statistics();
+   video_driver_log_frame_dupe_statistics();
+   frame_pacing_log();
 
    return true;
 }
@@ -604,6 +662,20 @@ error:
    return false;
 }
 
+/* Lets the pixel converters use the SIMD paths this CPU has. */
+static void init_video_pixconv_simd(void)
+{
+   unsigned simd = 0;
+   uint64_t cpu  = retro_get_cpu_features();
+
+   if (cpu & RETRO_SIMD_AVX2)
+      simd |= CONV_SIMD_AVX2;
+   if (cpu & RETRO_SIMD_NEON)
+      simd |= CONV_SIMD_NEON;
+
+   scaler_init_simd(simd);
+}
+
 static bool init_video(void)
 {
    unsigned max_dim, scale, width, height;
@@ -619,7 +691,12 @@ static bool init_video(void)
 
    runloop_ctl(RUNLOOP_CTL_SYSTEM_INFO_GET, &system);
 
+   init_video_pixconv_simd();
    init_video_filter(video_driver_state.pix_fmt);
+
+   video_driver_frame_dupe_reset();
+   video_driver_state.frame_dupe.count = 0;
+   frame_pacing_reset();
    event_command(EVENT_CMD_SHADER_DIR_INIT);
 
    if (av_info)
@@ -711,7 +788,7 @@ static bool init_video(void)
    video_driver_ctl(RARCH_DISPLAY_CTL_FIND_DRIVER, NULL);
 
 #ifdef HAVE_THREADS
-   if (settings->video.threaded && !video_driver_state.hw_render_callback.context_type)
+   if (video_driver_is_threaded())
    {
       /* Can't do hardware rendering with threaded driver currently. */
       RARCH_LOG("Starting threaded video driver ...\n");
@@ -739,6 +816,10 @@ static bool init_video(void)
    if (current_video->poke_interface)
       current_video->poke_interface(video_driver_data, &video_driver_poke);
 
+   video_shader_watch_set((settings->video.shader_enable
+            && *settings->video.shader_path) ?
+         settings->video.shader_path : NULL);
+
    if (current_video->viewport_info && (!custom_vp->width ||
             !custom_vp->height))
    {
@@ -1055,9 +1136,38 @@ bool video_monitor_get_fps(char *buf, size_t size,
       }
 
       if (buf_fps)
+      {
+         struct retro_perf_stats stats;
+         struct frame_pacing_stats pacing;
+         settings_t *settings = config_get_ptr();
+
          snprintf(buf_fps, size_fps, "FPS: %6.1f || Frames: " U64_SIGN,
                last_fps, (unsigned long long)video_driver_frame_count);
 
+         if (settings->video.frame_dupe_detect)
+         {
+            size_t len = strlen(buf_fps);
+            snprintf(buf_fps + len, size_fps - len, " || Dupes: " U64_SIGN,
+                  (unsigned long long)video_driver_state.frame_dupe.count);
+         }
+
+         if (frame_pacing_get_stats(&pacing))
+         {
+            size_t len = strlen(buf_fps);
+            snprintf(buf_fps + len, size_fps - len, " || Jitter: %.2f ms",
+                  pacing.stddev / 1000.0);
+         }
+
+         /* Spikes don't show in the average. */
+         if (rarch_perf_get_frame_stats(&stats))
+         {
+            size_t len = strlen(buf_fps);
+            snprintf(buf_fps + len, size_fps - len,
+                  " || p50/p99/max: %.1f/%.1f/%.1f ms",
+                  stats.p50 / 1000.0, stats.p99 / 1000.0, stats.max / 1000.0);
+         }
+      }
+
       return ret;
    }
 
@@ -1092,7 +1202,7 @@ void video_driver_unset_callback(void)
 
 static bool video_driver_frame_filter(const void *data,
       unsigned width, unsigned height,
-      size_t pitch,
+      size_t pitch, bool dupe,
       unsigned *output_width, unsigned *output_height,
       unsigned *output_pitch)
 {
@@ -1109,6 +1219,15 @@ static bool video_driver_frame_filter(const void *data,
 
    *output_pitch = (*output_width) * video_driver_state.filter.out_bpp;
 
+   /* The filter buffer still holds the output for this input. */
+   if (dupe)
+   {
+      if (settings->video.post_filter_record)
+         recording_dump_frame(NULL,
+               *output_width, *output_height, *output_pitch);
+      return true;
+   }
+
    retro_perf_start(&softfilter_process);
    rarch_softfilter_process(video_driver_state.filter.filter,
          video_driver_state.filter.buffer, *output_pitch,
@@ -1862,6 +1981,110 @@ static bool video_pixel_frame_scale(const void *data,
    return true;
 }
 
+/**
+ * video_frame_hash:
+ * @data                 : pointer to data of the video frame.
+ * @row_size             : bytes of pixel data per row.
+ * @height               : height of the video frame.
+ * @pitch                : pitch of the video frame.
+ *
+ * Hashes every visible byte of a frame, ignoring the padding
+ * between rows. Four independent lanes keep the multiplies
+ * from serializing.
+ *
+ * Returns: 64-bit content hash.
+ **/
+static uint64_t video_frame_hash(const void *data,
+      size_t row_size, unsigned height, size_t pitch)
+{
+   unsigned h;
+   const uint64_t prime = 0x100000001b3ULL;
+   uint64_t lane[4]     = {
+      0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL,
+      0x9e3779b97f4a7c15ULL, 0x7f4a7c159e3779b9ULL
+   };
+   const uint8_t *row   = (const uint8_t*)data;
+
+   for (h = 0; h < height; h++, row += pitch)
+   {
+      size_t i = 0;
+
+      for (; i + 32 <= row_size; i += 32)
+      {
+         uint64_t w[4];
+         memcpy(w, row + i, sizeof(w));
+
+         lane[0] = (lane[0] ^ w[0]) * prime;
+         lane[1] = (lane[1] ^ w[1]) * prime;
+         lane[2] = (lane[2] ^ w[2]) * prime;
+         lane[3] = (lane[3] ^ w[3]) * prime;
+      }
+
+      for (; i < row_size; i++)
+         lane[i & 3] = (lane[i & 3] ^ row[i]) * prime;
+   }
+
+   return (lane[0] ^ (lane[1] >> 17) ^ (lane[1] << 47))
+      + (lane[2] ^ (lane[3] >> 29) ^ (lane[3] << 35));
+}
+
+/**
+ * video_driver_frame_is_dupe:
+ * @data                 : pointer to data of the video frame.
+ * @width                : width of the video frame.
+ * @height               : height of the video frame.
+ * @pitch                : pitch of the video frame.
+ *
+ * Checks whether a software frame has the same contents as
+ * the previous one, for cores that resend an unchanged buffer
+ * instead of passing NULL. A dupe can skip filtering, texture
+ * upload and recording the same way a NULL frame does.
+ *
+ * Returns: true if the frame is identical to the last one.
+ **/
+static bool video_driver_frame_is_dupe(const void *data,
+      unsigned width, unsigned height, size_t pitch)
+{
+   static struct retro_perf_counter video_frame_dupe = {0};
+   uint64_t hash;
+   unsigned bpp;
+   bool dupe;
+   settings_t *settings = config_get_ptr();
+
+   if (!settings->video.frame_dupe_detect)
+      return false;
+
+   if (!data || data == RETRO_HW_FRAME_BUFFER_VALID)
+   {
+      video_driver_frame_dupe_reset();
+      return false;
+   }
+
+   rarch_perf_init(&video_frame_dupe, "video_frame_dupe");
+   retro_perf_start(&video_frame_dupe);
+
+   bpp  = (video_driver_get_pixel_format() == RETRO_PIXEL_FORMAT_XRGB8888)
+      ? sizeof(uint32_t) : sizeof(uint16_t);
+   hash = video_frame_hash(data, width * bpp, height, pitch);
+
+   dupe = video_driver_state.frame_dupe.valid
+      && video_driver_state.frame_dupe.hash   == hash
+      && video_driver_state.frame_dupe.width  == width
+      && video_driver_state.frame_dupe.height == height;
+
+   video_driver_state.frame_dupe.valid  = true;
+   video_driver_state.frame_dupe.hash   = hash;
+   video_driver_state.frame_dupe.width  = width;
+   video_driver_state.frame_dupe.height = height;
+
+   if (dupe)
+      video_driver_state.frame_dupe.count++;
+
+   retro_perf_stop(&video_frame_dupe);
+
+   return dupe;
+}
+
 /**
  * video_driver_frame:
  * @data                 : pointer to data of the video frame.
@@ -1875,17 +2098,24 @@ void video_driver_frame(const void *data, unsigned width,
       unsigned height, size_t pitch)
 {
    static char video_driver_msg[256];
+   static bool video_driver_osd_last;
+   bool osd               = false;
    unsigned output_width  = 0;
    unsigned output_height = 0;
    unsigned  output_pitch = 0;
    const char *msg        = runloop_msg_queue_pull();
    settings_t *settings   = config_get_ptr();
+   bool dupe              = false;
 
    if (!video_driver_ctl(RARCH_DISPLAY_CTL_IS_ACTIVE, NULL))
       return;
 
+   dupe = video_driver_frame_is_dupe(data, width, height, pitch);
+
+   /* A converter only exists for 0RGB1555, and on a dupe its
+    * output buffer already holds this frame. */
    if (video_driver_scaler_ptr &&
-         video_pixel_frame_scale(data, width, height, pitch))
+         (dupe || video_pixel_frame_scale(data, width, height, pitch)))
    {
       data                = video_driver_scaler_ptr->scaler_out;
       pitch               = video_driver_scaler_ptr->scaler->out_stride;
@@ -1905,9 +2135,9 @@ void video_driver_frame(const void *data, unsigned width,
           || video_driver_ctl(RARCH_DISPLAY_CTL_HAS_GPU_RECORD, NULL)
          )
       )
-      recording_dump_frame(data, width, height, pitch);
+      recording_dump_frame(dupe ? NULL : data, width, height, pitch);
 
-   if (video_driver_frame_filter(data, width, height, pitch,
+   if (video_driver_frame_filter(data, width, height, pitch, dupe,
             &output_width, &output_height, &output_pitch))
    {
       data   = video_driver_state.filter.buffer;
@@ -1920,11 +2150,32 @@ void video_driver_frame(const void *data, unsigned width,
    if (msg)
       strlcpy(video_driver_msg, msg, sizeof(video_driver_msg));
 
+   /* Drivers keep showing their last texture for NULL frames,
+    * but several return right away without drawing messages
+    * or the menu. So dupes only go out as NULL while there is
+    * nothing to draw over them, or to take off them. The
+    * threaded wrapper drops frames while its thread is busy,
+    * so the last frame it was handed may never have been
+    * shown. */
+   osd = *video_driver_msg != '\0';
+#ifdef HAVE_MENU
+   osd = osd || menu_driver_ctl(RARCH_MENU_CTL_IS_ALIVE, NULL);
+#endif
+
+   if (dupe && !osd && !video_driver_osd_last && !video_driver_is_threaded())
+      data = NULL;
+
+   video_driver_osd_last = osd;
+
+   frame_pacing_submit();
+
    if (!current_video || !current_video->frame(
             video_driver_data, data, width, height, video_driver_frame_count,
             pitch, video_driver_msg))
       video_driver_ctl(RARCH_DISPLAY_CTL_UNSET_ACTIVE, NULL);
 
+   frame_pacing_present();
+
    video_driver_frame_count++;
 }
 
@@ -1962,22 +2213,11 @@ bool video_driver_texture_load(void *data,
       enum texture_filter_type  filter_type,
       unsigned *id)
 {
-#ifdef HAVE_THREADS
-   settings_t *settings = config_get_ptr();
-   const struct retro_hw_render_callback *hw_render =
-      (const struct retro_hw_render_callback*)video_driver_callback();
-#endif
-
    if (!id || !video_driver_poke || !video_driver_poke->load_texture)
       return false;
 
    *id = video_driver_poke->load_texture(video_driver_data, data,
-#ifdef HAVE_THREADS
-         settings->video.threaded && !hw_render->context_type,
-#else
-         false,
-#endif
-         filter_type);
+         video_driver_is_threaded(), filter_type);
 
    return true;
 }
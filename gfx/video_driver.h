@@ -362,6 +362,14 @@ const char* config_get_video_driver_options(void);
  **/
 void *video_driver_get_ptr(bool force_nonthreaded_data);
 
+/**
+ * video_driver_is_threaded:
+ *
+ * Returns: true (1) if the video driver runs behind the
+ * threaded wrapper. Hardware rendered cores never do.
+ **/
+bool video_driver_is_threaded(void);
+
 /**
  * video_driver_get_current_framebuffer:
  *
@@ -101,10 +101,14 @@ void video_shader_driver_scale(unsigned idx, struct gfx_fbo_scale *scale)
 bool video_shader_driver_init(const shader_backend_t *shader, void *data, const char *path)
 {
    void *tmp = NULL;
+   const shader_backend_t *old_shader = current_shader;
+   void *old_data                     = shader_data;
 
    if (!shader || !shader->init)
       return false;
 
+   /* The current chain stays alive until the new one is built,
+    * so the backend can carry over what did not change. */
    tmp = shader->init(data, path);
 
    if (!tmp)
@@ -113,6 +117,9 @@ bool video_shader_driver_init(const shader_backend_t *shader, void *data, const
    shader_data    = tmp;
    current_shader = shader;
 
+   if (old_data && old_shader && old_shader->deinit)
+      old_shader->deinit(old_data);
+
    return true;
 }
 
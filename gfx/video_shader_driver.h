@@ -115,6 +115,18 @@ bool video_shader_driver_init_first(void);
 
 struct video_shader *video_shader_driver_get_current_shader(void);
 
+/**
+ * video_shader_driver_init:
+ * @shader                  : Shader backend to use.
+ * @data                    : Video driver handle.
+ * @path                    : Shader or preset path, NULL for stock.
+ *
+ * Builds a new shader chain. The current one, if any, is only
+ * freed once the new one is built, and is left in place if
+ * that fails.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
 bool video_shader_driver_init(const shader_backend_t *shader, void *data, const char *path);
 
 void video_shader_driver_deinit(void);
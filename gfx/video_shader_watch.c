@@ -0,0 +1,242 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <limits.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#include <compat/strl.h>
+#include <file/config_file.h>
+#include <file/file_path.h>
+#include <string/string_list.h>
+
+#include "video_shader_watch.h"
+#include "video_driver.h"
+#include "video_shader_driver.h"
+#include "../configuration.h"
+#include "../msg_hash.h"
+#include "../performance.h"
+#include "../runloop.h"
+#include "../verbosity.h"
+
+/* Editors save in more than one step, so a reload waits until
+ * the files have been left alone this long, in microseconds. */
+#define SHADER_WATCH_SETTLE 100000
+
+static struct
+{
+   char path[PATH_MAX_LENGTH];
+   int fd;
+   /* Base names of the watched files. attr.i is the watch on
+    * their directory, editors often save by renaming over the
+    * file, which a watch on the file itself would not see. */
+   struct string_list *files;
+   bool pending;
+   retro_time_t changed;
+} shader_watch = { "", -1, NULL, false, 0 };
+
+#ifdef __linux__
+static void video_shader_watch_add(const char *path)
+{
+   int wd;
+   union string_list_elem_attr attr;
+   char dir[PATH_MAX_LENGTH] = {0};
+
+   if (!path || !*path)
+      return;
+
+   fill_pathname_basedir(dir, path, sizeof(dir));
+   if (!*dir)
+      strlcpy(dir, ".", sizeof(dir));
+
+   wd = inotify_add_watch(shader_watch.fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+   if (wd < 0)
+   {
+      RARCH_WARN("[Shader]: Cannot watch \"%s\".\n", dir);
+      return;
+   }
+
+   attr.i = wd;
+   string_list_append(shader_watch.files, path_basename(path), attr);
+}
+
+static void video_shader_watch_add_preset(const char *path)
+{
+#ifdef HAVE_SHADER_MANAGER
+   unsigned i;
+   struct video_shader *shader = NULL;
+   config_file_t *conf         = NULL;
+   const char *ext             = path_get_extension(path);
+
+   if (strcmp(ext, "glslp") && strcmp(ext, "cgp"))
+      return;
+
+   conf = config_file_new(path);
+   if (!conf)
+      return;
+
+   shader = (struct video_shader*)calloc(1, sizeof(*shader));
+
+   if (shader && video_shader_read_conf_cgp(conf, shader))
+   {
+      video_shader_resolve_relative(shader, path);
+
+      for (i = 0; i < shader->passes; i++)
+         video_shader_watch_add(shader->pass[i].source.path);
+      for (i = 0; i < shader->luts; i++)
+         video_shader_watch_add(shader->lut[i].path);
+      video_shader_watch_add(shader->script_path);
+   }
+
+   free(shader);
+   config_file_free(conf);
+#endif
+}
+
+static bool video_shader_watch_is_watched(int wd, const char *name)
+{
+   unsigned i;
+
+   for (i = 0; i < shader_watch.files->size; i++)
+   {
+      if (shader_watch.files->elems[i].attr.i == wd
+            && !strcmp(shader_watch.files->elems[i].data, name))
+         return true;
+   }
+
+   return false;
+}
+#endif
+
+void video_shader_watch_deinit(void)
+{
+#ifdef __linux__
+   /* Closing drops every watch with it. */
+   if (shader_watch.fd >= 0)
+      close(shader_watch.fd);
+#endif
+   if (shader_watch.files)
+      string_list_free(shader_watch.files);
+
+   shader_watch.fd      = -1;
+   shader_watch.files   = NULL;
+   shader_watch.pending = false;
+}
+
+void video_shader_watch_update(void)
+{
+   settings_t *settings = config_get_ptr();
+
+   video_shader_watch_deinit();
+
+   if (!settings->video.shader_watch_files || !*shader_watch.path)
+      return;
+
+#ifdef __linux__
+   shader_watch.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+   if (shader_watch.fd < 0)
+   {
+      RARCH_WARN("[Shader]: Cannot watch shader files.\n");
+      return;
+   }
+
+   shader_watch.files = string_list_new();
+   if (!shader_watch.files)
+   {
+      video_shader_watch_deinit();
+      return;
+   }
+
+   video_shader_watch_add(shader_watch.path);
+   video_shader_watch_add_preset(shader_watch.path);
+
+   RARCH_LOG("[Shader]: Watching %u files of \"%s\".\n",
+         (unsigned)shader_watch.files->size, shader_watch.path);
+#else
+   RARCH_WARN("[Shader]: Watching shader files is not supported on this platform.\n");
+#endif
+}
+
+void video_shader_watch_set(const char *path)
+{
+   if (path && path != shader_watch.path)
+      strlcpy(shader_watch.path, path, sizeof(shader_watch.path));
+   else if (!path)
+      *shader_watch.path = '\0';
+
+   video_shader_watch_update();
+}
+
+void video_shader_watch_check(void)
+{
+#ifdef __linux__
+   char path[PATH_MAX_LENGTH];
+   enum rarch_shader_type type;
+   ssize_t len;
+   union
+   {
+      struct inotify_event event;
+      char buf[sizeof(struct inotify_event) + NAME_MAX + 1];
+   } events;
+
+   if (shader_watch.fd < 0)
+      return;
+
+   while ((len = read(shader_watch.fd, &events, sizeof(events))) > 0)
+   {
+      ssize_t i;
+
+      for (i = 0; i + (ssize_t)sizeof(struct inotify_event) <= len; )
+      {
+         const struct inotify_event *event =
+            (const struct inotify_event*)&events.buf[i];
+
+         if (event->len && video_shader_watch_is_watched(event->wd, event->name))
+         {
+            shader_watch.pending = true;
+            shader_watch.changed = retro_get_time_usec();
+         }
+
+         i += sizeof(struct inotify_event) + event->len;
+      }
+   }
+
+   if (!shader_watch.pending
+         || retro_get_time_usec() - shader_watch.changed < SHADER_WATCH_SETTLE)
+      return;
+
+   shader_watch.pending = false;
+
+   /* Reloading watches the new set of files, which replaces
+    * shader_watch.path with itself. */
+   strlcpy(path, shader_watch.path, sizeof(path));
+   type = video_shader_parse_type(path, RARCH_SHADER_NONE);
+
+   RARCH_LOG("[Shader]: \"%s\" changed, reloading.\n", path);
+
+   if (video_driver_set_shader(type, path))
+      runloop_msg_queue_push(
+            msg_hash_to_str(MSG_SHADER_RELOADED), 1, 120, true);
+   else
+      runloop_msg_queue_push(
+            msg_hash_to_str(MSG_SHADER_FAILED_TO_RELOAD), 1, 180, true);
+#endif
+}
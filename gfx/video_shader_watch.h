@@ -0,0 +1,54 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEO_SHADER_WATCH_H__
+#define VIDEO_SHADER_WATCH_H__
+
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * video_shader_watch_set:
+ * @path                    : Shader or preset now in use, or NULL.
+ *
+ * Remembers the shader in use and, if video_shader_watch_files
+ * is enabled, watches it along with the pass sources and LUTs
+ * of a preset.
+ **/
+void video_shader_watch_set(const char *path);
+
+/* Starts or stops watching after video_shader_watch_files
+ * changed. */
+void video_shader_watch_update(void);
+
+void video_shader_watch_deinit(void);
+
+/**
+ * video_shader_watch_check:
+ *
+ * Reloads the shader once its files have been changed and
+ * left alone for a moment. Call once per frame.
+ **/
+void video_shader_watch_check(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
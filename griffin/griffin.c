@@ -540,6 +540,7 @@ DRIVERS
 ============================================================ */
 #include "../gfx/video_driver.c"
 #include "../gfx/video_common.c"
+#include "../gfx/video_shader_watch.c"
 #include "../input/input_driver.c"
 #include "../audio/audio_driver.c"
 #include "../camera/camera_driver.c"
@@ -700,6 +701,8 @@ RETROARCH
 #include "../libretro_version_1.c"
 #include "../retroarch.c"
 #include "../runloop.c"
+#include "../frame_pacing.c"
+#include "../runahead.c"
 #include "../tasks/tasks.c"
 
 #include "../msg_hash.c"
@@ -806,6 +809,7 @@ MENU
 #include "../menu/menu_display.c"
 #include "../menu/menu_displaylist.c"
 #include "../menu/menu_animation.c"
+#include "../menu/menu_thumbnail.c"
 
 #include "../menu/intl/menu_hash_de.c"
 #include "../menu/intl/menu_hash_es.c"
@@ -0,0 +1,94 @@
+/* Generated by msg_hash_lut.py, do not edit. */
+
+#define MSG_HASH_LUT_BITS 9
+#define MSG_HASH_LUT_MULT 0xc0ed8c81U
+
+static const uint32_t msg_hash_lut_keys[] = {
+   MSG_APPENDED_DISK,
+   MSG_APPLYING_SHADER,
+   MSG_AUDIO_MUTED,
+   MSG_AUDIO_UNMUTED,
+   MSG_AUTOSAVE_FAILED,
+   MSG_BLOCKING_SRAM_OVERWRITE,
+   MSG_BYTES,
+   MSG_CONFIG_DIRECTORY_NOT_SET,
+   MSG_CORE_DOES_NOT_SUPPORT_SAVESTATES,
+   MSG_COULD_NOT_PROCESS_ZIP_FILE,
+   MSG_COULD_NOT_READ_CONTENT_FILE,
+   MSG_CUSTOM_TIMING_GIVEN,
+   MSG_DETECTED_VIEWPORT_OF,
+   MSG_DOWNLOADING,
+   MSG_EXTRACTING,
+   MSG_FAILED_TO,
+   MSG_FAILED_TO_APPLY_SHADER,
+   MSG_FAILED_TO_LOAD_CONTENT,
+   MSG_FAILED_TO_LOAD_MOVIE_FILE,
+   MSG_FAILED_TO_LOAD_OVERLAY,
+   MSG_FAILED_TO_LOAD_STATE,
+   MSG_FAILED_TO_REMOVE_DISK_FROM_TRAY,
+   MSG_FAILED_TO_REMOVE_TEMPORARY_FILE,
+   MSG_FAILED_TO_SAVE_SRAM,
+   MSG_FAILED_TO_SAVE_STATE_TO,
+   MSG_FAILED_TO_START_MOVIE_RECORD,
+   MSG_FAILED_TO_START_RECORDING,
+   MSG_FAILED_TO_TAKE_SCREENSHOT,
+   MSG_FAILED_TO_UNMUTE_AUDIO,
+   MSG_FOUND_SHADER,
+   MSG_GOT_INVALID_DISK_INDEX,
+   MSG_GRAB_MOUSE_STATE,
+   MSG_HW_RENDERED_MUST_USE_POSTSHADED_RECORDING,
+   MSG_LIBRETRO_ABI_BREAK,
+   MSG_LOADED_STATE_FROM_SLOT,
+   MSG_LOADING_CONTENT_FILE,
+   MSG_LOADING_STATE,
+   MSG_MOVIE_PLAYBACK_ENDED,
+   MSG_MOVIE_RECORD_STOPPED,
+   MSG_NETPLAY_FAILED,
+   MSG_NETPLAY_FAILED_MOVIE_PLAYBACK_HAS_STARTED,
+   MSG_PAUSED,
+   MSG_PROGRAM,
+   MSG_RECEIVED,
+   MSG_RECORDING_TERMINATED_DUE_TO_RESIZE,
+   MSG_RECORDING_TO,
+   MSG_REDIRECTING_CHEATFILE_TO,
+   MSG_REDIRECTING_SAVEFILE_TO,
+   MSG_REDIRECTING_SAVESTATE_TO,
+   MSG_REMOVED_DISK_FROM_TRAY,
+   MSG_REMOVING_TEMPORARY_CONTENT_FILE,
+   MSG_RESET,
+   MSG_RESTARTING_RECORDING_DUE_TO_DRIVER_REINIT,
+   MSG_REWINDING,
+   MSG_REWIND_INIT,
+   MSG_REWIND_INIT_FAILED,
+   MSG_REWIND_INIT_FAILED_NO_SAVESTATES,
+   MSG_REWIND_INIT_FAILED_THREADED_AUDIO,
+   MSG_REWIND_REACHED_END,
+   MSG_RUNAHEAD_FAILED_TO_LOAD_STATE,
+   MSG_SAVED_STATE_TO_SLOT,
+   MSG_SAVED_SUCCESSFULLY_TO,
+   MSG_SAVING_RAM_TYPE,
+   MSG_SAVING_STATE,
+   MSG_SCANNING,
+   MSG_SCANNING_OF_DIRECTORY_FINISHED,
+   MSG_SENDING_COMMAND,
+   MSG_SHADER,
+   MSG_SHADER_FAILED_TO_RELOAD,
+   MSG_SHADER_RELOADED,
+   MSG_SKIPPING_SRAM_LOAD,
+   MSG_SLOW_MOTION,
+   MSG_SLOW_MOTION_REWIND,
+   MSG_SRAM_WILL_NOT_BE_SAVED,
+   MSG_STARTING_MOVIE_PLAYBACK,
+   MSG_STARTING_MOVIE_RECORD_TO,
+   MSG_STATE_SIZE,
+   MSG_STATE_SLOT,
+   MSG_TAKING_SCREENSHOT,
+   MSG_TASK_FAILED,
+   MSG_TO,
+   MSG_UNKNOWN,
+   MSG_UNPAUSED,
+   MSG_UNRECOGNIZED_COMMAND,
+   MSG_USING_LIBRETRO_DUMMY_CORE_RECORDING_SKIPPED,
+   MSG_VIEWPORT_SIZE_CALCULATION_FAILED,
+   MSG_VIRTUAL_DISK_TRAY,
+};
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+
+# RetroArch - A frontend for libretro.
+# Copyright (C) 2011-2016 - Daniel De Matteis
+#
+#
+# RetroArch is free software: you can redistribute it and/or modify it under the terms
+# of the GNU General Public License as published by the Free Software Found-
+# ation, either version 3 of the License, or (at your option) any later version.
+#
+# RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+# without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+# PURPOSE.  See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with RetroArch.
+# If not, see <http://www.gnu.org/licenses/>.
+
+# Regenerates msg_hash_lut.h, the list of translated messages and the
+# perfect hash msg_hash.c uses to look them up. Run it whenever a
+# message is added to one of the msg_hash_*.c files.
+
+# Usage: ./msg_hash_lut.py ../msg_hash.h msg_hash_*.c > msg_hash_lut.h
+
+import re
+import sys
+
+def find_defines(path):
+   defines = {}
+   with open(path) as f:
+      for line in f:
+         m = re.match(r'^#define\s+(MSG_\w+)\s+(0x[0-9a-fA-F]+)U?', line)
+         if m:
+            defines[m.group(1)] = int(m.group(2), 16)
+   return defines
+
+def find_cases(path):
+   with open(path, encoding='utf-8', errors='replace') as f:
+      return re.findall(r'case\s+(MSG_\w+)\s*:', f.read())
+
+def find_perfect_hash(values):
+   # Smallest table, then first multiplier, so that
+   # (hash * mult) >> (32 - bits) has no collisions.
+   bits = max(1, (len(values) - 1).bit_length())
+   while bits <= 16:
+      for mult in range(1, 1 << 20, 2):
+         mult  = (mult * 0x9e3779b1) & 0xffffffff
+         slots = set(((v * mult) & 0xffffffff) >> (32 - bits) for v in values)
+         if len(slots) == len(values):
+            return bits, mult
+      bits += 1
+   sys.exit('No perfect hash found.')
+
+if __name__ == '__main__':
+   if len(sys.argv) < 3:
+      sys.exit('Usage: %s msg_hash.h msg_hash_*.c' % sys.argv[0])
+
+   defines = find_defines(sys.argv[1])
+   names   = {}
+
+   for path in sys.argv[2:]:
+      for name in find_cases(path):
+         if name not in defines:
+            sys.exit('%s: %s is not defined.' % (path, name))
+         names.setdefault(defines[name], name)
+
+   keys       = sorted(names.items(), key = lambda k: k[1])
+   bits, mult = find_perfect_hash([k[0] for k in keys])
+
+   print('/* Generated by msg_hash_lut.py, do not edit. */')
+   print('')
+   print('#define MSG_HASH_LUT_BITS %u' % bits)
+   print('#define MSG_HASH_LUT_MULT 0x%08xU' % mult)
+   print('')
+   print('static const uint32_t msg_hash_lut_keys[] = {')
+   for value, name in keys:
+      print('   %s,' % name)
+   print('};')
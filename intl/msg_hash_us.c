@@ -164,6 +164,10 @@ const char *msg_hash_to_str_us(uint32_t hash)
          return "Shader";
       case MSG_APPLYING_SHADER:
          return "Applying shader";
+      case MSG_SHADER_RELOADED:
+         return "Shader reloaded";
+      case MSG_SHADER_FAILED_TO_RELOAD:
+         return "Shader failed to reload, keeping the current one";
       case MSG_FAILED_TO_APPLY_SHADER:
          return "Failed to apply shader.";
       case MSG_STARTING_MOVIE_RECORD_TO:
@@ -182,6 +186,8 @@ const char *msg_hash_to_str_us(uint32_t hash)
          return "Rewinding.";
       case MSG_REWIND_REACHED_END:
          return "Reached end of rewind buffer.";
+      case MSG_RUNAHEAD_FAILED_TO_LOAD_STATE:
+         return "Run-ahead failed to load the core's state, disabling it";
       case MSG_TASK_FAILED:
          return "Failed";
       case MSG_DOWNLOADING:
@@ -133,3 +133,47 @@ bool utf16_conv_utf8(uint8_t *out, size_t *out_chars,
    *out_chars = out_pos;
    return false;
 }
+
+/**
+ * utf8_walk:
+ * @string              : pointer to the string to decode.
+ *
+ * Decodes the code point at *@string and advances *@string
+ * past it. Bytes that do not start a valid sequence are
+ * returned as-is, so Latin-1 text still renders.
+ *
+ * Returns: the decoded code point, 0 at the end of the string.
+ */
+uint32_t utf8_walk(const char **string)
+{
+   unsigned i, extra;
+   uint32_t c;
+   const uint8_t *str = (const uint8_t*)*string;
+   uint8_t first      = *str;
+   unsigned ones      = leading_ones(first);
+
+   if (!first)
+      return 0;
+
+   if (ones < 2 || ones > 4)
+   {
+      *string += 1;
+      return first;
+   }
+
+   extra = ones - 1;
+   c     = first & ((1 << (7 - ones)) - 1);
+
+   for (i = 1; i <= extra; i++)
+   {
+      if ((str[i] & 0xc0) != 0x80)
+      {
+         *string += 1;
+         return first;
+      }
+      c = (c << 6) | (str[i] & 0x3f);
+   }
+
+   *string += 1 + extra;
+   return c;
+}
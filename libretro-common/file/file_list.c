@@ -43,6 +43,8 @@ void file_list_push(file_list_t *list,
          return;
    }
 
+   list->sorted_on_alt                  = false;
+
    list->list[list->size].label         = NULL;
    list->list[list->size].path          = NULL;
    list->list[list->size].alt           = NULL;
@@ -156,7 +158,8 @@ void file_list_clear(file_list_t *list)
       list->list[i].alt = NULL;
    }
 
-   list->size = 0;
+   list->size          = 0;
+   list->sorted_on_alt = false;
 }
 
 void file_list_copy(const file_list_t *src, file_list_t *dst)
@@ -183,14 +186,16 @@ void file_list_copy(const file_list_t *src, file_list_t *dst)
       free(dst->list);
    }
 
-   dst->size     = 0;
-   dst->capacity = 0;
-   dst->list     = (struct item_file*)malloc(src->size * sizeof(struct item_file));
+   dst->size          = 0;
+   dst->capacity      = 0;
+   dst->sorted_on_alt = false;
+   dst->list          = (struct item_file*)malloc(src->size * sizeof(struct item_file));
 
    if (!dst->list)
       return;
 
    dst->size = dst->capacity = src->size;
+   dst->sorted_on_alt        = src->sorted_on_alt;
 
    memcpy(dst->list, src->list, dst->size * sizeof(struct item_file));
 
@@ -244,6 +249,8 @@ void file_list_set_alt_at_offset(file_list_t *list, size_t idx,
 
    if (alt)
       list->list[idx].alt   = strdup(alt);
+
+   list->sorted_on_alt      = false;
 }
 
 void file_list_get_alt_at_offset(const file_list_t *list, size_t idx,
@@ -257,6 +264,12 @@ void file_list_get_alt_at_offset(const file_list_t *list, size_t idx,
          list->list[idx].alt : list->list[idx].path;
 }
 
+struct file_list_sort_key
+{
+   const char *str;
+   size_t idx;
+};
+
 static int file_list_alt_cmp(const void *a_, const void *b_)
 {
    const struct item_file *a = (const struct item_file*)a_;
@@ -266,6 +279,13 @@ static int file_list_alt_cmp(const void *a_, const void *b_)
    return strcasecmp(cmp_a, cmp_b);
 }
 
+static int file_list_key_cmp(const void *a_, const void *b_)
+{
+   const struct file_list_sort_key *a = (const struct file_list_sort_key*)a_;
+   const struct file_list_sort_key *b = (const struct file_list_sort_key*)b_;
+   return strcasecmp(a->str, b->str);
+}
+
 static int file_list_type_cmp(const void *a_, const void *b_)
 {
    const struct item_file *a = (const struct item_file*)a_;
@@ -278,14 +298,74 @@ static int file_list_type_cmp(const void *a_, const void *b_)
    return 1;
 }
 
+/* Reorders the list so that item i becomes the item at
+ * keys[i].idx, following each permutation cycle so every
+ * item is moved exactly once. Clobbers the keys. */
+static void file_list_permute(file_list_t *list,
+      struct file_list_sort_key *keys)
+{
+   size_t i;
+
+   for (i = 0; i < list->size; i++)
+   {
+      size_t j;
+      struct item_file tmp;
+
+      if (keys[i].idx == i)
+         continue;
+
+      tmp = list->list[i];
+      j   = i;
+
+      while (keys[j].idx != i)
+      {
+         size_t k      = keys[j].idx;
+         list->list[j] = list->list[k];
+         keys[j].idx   = j;
+         j             = k;
+      }
+
+      list->list[j] = tmp;
+      keys[j].idx   = j;
+   }
+}
+
 void file_list_sort_on_alt(file_list_t *list)
 {
-   qsort(list->list, list->size, sizeof(list->list[0]), file_list_alt_cmp);
+   size_t i;
+   struct file_list_sort_key *keys = NULL;
+
+   if (!list)
+      return;
+
+   /* Sort small keys rather than moving whole items
+    * around on every swap. */
+   keys = (struct file_list_sort_key*)malloc(list->size * sizeof(*keys));
+
+   if (!keys)
+   {
+      qsort(list->list, list->size, sizeof(list->list[0]), file_list_alt_cmp);
+      list->sorted_on_alt = true;
+      return;
+   }
+
+   for (i = 0; i < list->size; i++)
+   {
+      keys[i].str = list->list[i].alt ? list->list[i].alt : list->list[i].path;
+      keys[i].idx = i;
+   }
+
+   qsort(keys, list->size, sizeof(*keys), file_list_key_cmp);
+   file_list_permute(list, keys);
+
+   free(keys);
+   list->sorted_on_alt = true;
 }
 
 void file_list_sort_on_type(file_list_t *list)
 {
    qsort(list->list, list->size, sizeof(list->list[0]), file_list_type_cmp);
+   list->sorted_on_alt = false;
 }
 
 void *file_list_get_userdata_at_offset(const file_list_t *list, size_t idx)
@@ -369,6 +449,40 @@ void file_list_get_last(const file_list_t *list,
       file_list_get_at_offset(list, list->size - 1, path, label, file_type, entry_idx);
 }
 
+/* Finds the first item starting with @needle in a list
+ * sorted on alt. */
+static bool file_list_search_sorted(const file_list_t *list,
+      const char *needle, size_t *idx)
+{
+   size_t lo  = 0;
+   size_t hi  = list->size;
+   size_t len = strlen(needle);
+   const char *alt;
+
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+
+      file_list_get_alt_at_offset(list, mid, &alt);
+
+      if (strncasecmp(alt, needle, len) < 0)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   if (lo >= list->size)
+      return false;
+
+   file_list_get_alt_at_offset(list, lo, &alt);
+
+   if (strncasecmp(alt, needle, len) != 0)
+      return false;
+
+   *idx = lo;
+   return true;
+}
+
 bool file_list_search(const file_list_t *list, const char *needle, size_t *idx)
 {
    size_t i;
@@ -378,6 +492,11 @@ bool file_list_search(const file_list_t *list, const char *needle, size_t *idx)
    if (!list)
       return false;
 
+   /* Prefix matches are preferred and form a contiguous
+    * range in a sorted list. */
+   if (list->sorted_on_alt && file_list_search_sorted(list, needle, idx))
+      return true;
+
    for (i = 0; i < list->size; i++)
    {
       const char *str;
@@ -79,7 +79,8 @@ enum stat_mode
    IS_VALID
 };
 
-static bool path_stat(const char *path, enum stat_mode mode, int32_t *size)
+static bool path_stat_internal(const char *path, enum stat_mode mode,
+      int32_t *size, int64_t *mtime)
 {
 #if defined(VITA) || defined(PSP)
    SceIoStat buf;
@@ -114,9 +115,20 @@ static bool path_stat(const char *path, enum stat_mode mode, int32_t *size)
 #if defined(_WIN32)
    if (size)
       *size = file_info.nFileSizeLow;
+   if (mtime)
+      *mtime = ((int64_t)file_info.ftLastWriteTime.dwHighDateTime << 32)
+         | file_info.ftLastWriteTime.dwLowDateTime;
 #else
    if (size)
       *size = buf.st_size;
+#if defined(VITA) || defined(PSP)
+   /* SceIoStat carries a calendar date, not a timestamp. */
+   if (mtime)
+      *mtime = 0;
+#else
+   if (mtime)
+      *mtime = (int64_t)buf.st_mtime;
+#endif
 #endif
 
    switch (mode)
@@ -154,28 +166,63 @@ static bool path_stat(const char *path, enum stat_mode mode, int32_t *size)
  */
 bool path_is_directory(const char *path)
 {
-   return path_stat(path, IS_DIRECTORY, NULL);
+   return path_stat_internal(path, IS_DIRECTORY, NULL, NULL);
 }
 
 bool path_is_character_special(const char *path)
 {
-   return path_stat(path, IS_CHARACTER_SPECIAL, NULL);
+   return path_stat_internal(path, IS_CHARACTER_SPECIAL, NULL, NULL);
 }
 
 bool path_is_valid(const char *path)
 {
-   return path_stat(path, IS_VALID, NULL);
+   return path_stat_internal(path, IS_VALID, NULL, NULL);
 }
 
 int32_t path_get_size(const char *path)
 {
    int32_t filesize = 0;
-   if (path_stat(path, IS_VALID, &filesize))
+   if (path_stat_internal(path, IS_VALID, &filesize, NULL))
       return filesize;
 
    return -1;
 }
 
+/**
+ * path_get_mtime:
+ * @path               : path
+ *
+ * Gets the last modification time of a file. The unit is
+ * platform-specific and should only be compared for equality.
+ *
+ * Returns: modification time, or 0 if unavailable.
+ */
+int64_t path_get_mtime(const char *path)
+{
+   int64_t mtime = 0;
+   if (path_stat_internal(path, IS_VALID, NULL, &mtime))
+      return mtime;
+
+   return 0;
+}
+
+/**
+ * path_stat:
+ * @path               : path
+ * @size               : file size (may be NULL)
+ * @mtime              : modification time (may be NULL)
+ *
+ * Gets the size and modification time of a file with a single
+ * stat call. The mtime unit is platform-specific and should only
+ * be compared for equality.
+ *
+ * Returns: true (1) if path exists, otherwise false (0).
+ */
+bool path_stat(const char *path, int32_t *size, int64_t *mtime)
+{
+   return path_stat_internal(path, IS_VALID, size, mtime);
+}
+
 /**
  * path_mkdir_norecurse:
  * @dir                : directory
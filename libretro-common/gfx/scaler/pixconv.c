@@ -37,7 +37,25 @@
 #include <emmintrin.h>
 #endif
 
-void conv_rgb565_0rgb1555(void *output_, const void *input_,
+/* AVX2 versions are built regardless of the compiler flags and
+ * only picked by conv_init_simd() when the CPU has AVX2. */
+#if !defined(SCALER_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) \
+   && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define PIXCONV_HAVE_AVX2
+#define PIXCONV_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#if !defined(SCALER_NO_SIMD) && (defined(__ARM_NEON__) || defined(__aarch64__))
+#define PIXCONV_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+typedef void (*conv_func_t)(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride);
+
+static void conv_rgb565_0rgb1555_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -45,7 +63,7 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output = (uint16_t*)output_;
 
-#if defined(__SSE2_)
+#if defined(__SSE2__)
    int max_width = width - 7;
 
    const __m128i hi_mask   = _mm_set1_epi16(0x7fe0);
@@ -56,11 +74,11 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
       int w = 0;
-#if defined(__SSE2_)
+#if defined(__SSE2__)
       for (; w < max_width; w += 8)
       {
          const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i hi = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
+         __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 1), hi_mask);
          __m128i lo = _mm_and_si128(in, lo_mask);
          _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
       }
@@ -76,7 +94,7 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    }
 }
 
-void conv_0rgb1555_rgb565(void *output_, const void *input_,
+static void conv_0rgb1555_rgb565_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -120,7 +138,7 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
    }
 }
 
-void conv_0rgb1555_argb8888(void *output_, const void *input_,
+static void conv_0rgb1555_argb8888_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -187,7 +205,7 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
    }
 }
 
-void conv_rgb565_argb8888(void *output_, const void *input_,
+static void conv_rgb565_argb8888_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -255,7 +273,7 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
    }
 }
 
-void conv_argb8888_rgba4444(void *output_, const void *input_,
+static void conv_argb8888_rgba4444_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -264,26 +282,22 @@ void conv_argb8888_rgba4444(void *output_, const void *input_,
    uint16_t *output      = (uint16_t*)output_;
 
    for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+         h++, output += out_stride >> 1, input += in_stride >> 2)
    {
       for (w = 0; w < width; w++)
       {
          uint32_t col = input[w];
-         uint32_t r = (col >> 16) & 0xf;
-         uint32_t g = (col >>  8) & 0xf;
-         uint32_t b = (col) & 0xf;
-         uint32_t a = (col >>  24) & 0xf;
-         r = (r >> 4) | r;
-         g = (g >> 4) | g;
-         b = (b >> 4) | b;
-         a = (a >> 4) | a;
+         uint32_t r = (col >> 20) & 0xf;
+         uint32_t g = (col >> 12) & 0xf;
+         uint32_t b = (col >>  4) & 0xf;
+         uint32_t a = (col >> 28) & 0xf;
 
          output[w] = (r << 12) | (g << 8) | (b << 4) | a;
       }
    }
 }
 
-void conv_rgba4444_argb8888(void *output_, const void *input_,
+static void conv_rgba4444_argb8888_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -311,7 +325,7 @@ void conv_rgba4444_argb8888(void *output_, const void *input_,
    }
 }
 
-void conv_rgba4444_rgb565(void *output_, const void *input_,
+static void conv_rgba4444_rgb565_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -381,7 +395,7 @@ static INLINE void store_bgr24_sse2(void *output, __m128i a,
 }
 #endif
 
-void conv_0rgb1555_bgr24(void *output_, const void *input_,
+static void conv_0rgb1555_bgr24_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -467,7 +481,7 @@ void conv_0rgb1555_bgr24(void *output_, const void *input_,
    }
 }
 
-void conv_rgb565_bgr24(void *output_, const void *input_,
+static void conv_rgb565_bgr24_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -552,7 +566,7 @@ void conv_rgb565_bgr24(void *output_, const void *input_,
    }
 }
 
-void conv_bgr24_argb8888(void *output_, const void *input_,
+static void conv_bgr24_argb8888_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -574,7 +588,7 @@ void conv_bgr24_argb8888(void *output_, const void *input_,
    }
 }
 
-void conv_argb8888_0rgb1555(void *output_, const void *input_,
+static void conv_argb8888_0rgb1555_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -596,7 +610,7 @@ void conv_argb8888_0rgb1555(void *output_, const void *input_,
    }
 }
 
-void conv_argb8888_bgr24(void *output_, const void *input_,
+static void conv_argb8888_bgr24_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -634,7 +648,7 @@ void conv_argb8888_bgr24(void *output_, const void *input_,
    }
 }
 
-void conv_argb8888_abgr8888(void *output_, const void *input_,
+static void conv_argb8888_abgr8888_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -662,7 +676,7 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
 #define YUV_MAT_V_R (90)
 #define YUV_MAT_V_G (-46)
 
-void conv_yuyv_argb8888(void *output_, const void *input_,
+static void conv_yuyv_argb8888_generic(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -799,6 +813,1284 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
    }
 }
 
+#if defined(PIXCONV_HAVE_AVX2)
+/* 8 pixels in 32-bit lanes to ARGB8888. Same bit replication
+ * as the C versions, so the results are identical. */
+static INLINE PIXCONV_AVX2 __m256i rgb565_argb8888_avx2(__m256i x)
+{
+   __m256i r = _mm256_or_si256(
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0xf800)), 8),
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0xe000)), 3));
+   __m256i g = _mm256_or_si256(
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x07e0)), 5),
+         _mm256_srli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x0600)), 1));
+   __m256i b = _mm256_or_si256(
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x001f)), 3),
+         _mm256_srli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x001c)), 2));
+
+   return _mm256_or_si256(_mm256_set1_epi32((int)0xff000000u),
+         _mm256_or_si256(r, _mm256_or_si256(g, b)));
+}
+
+static INLINE PIXCONV_AVX2 __m256i rgb1555_argb8888_avx2(__m256i x)
+{
+   __m256i r = _mm256_or_si256(
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x7c00)), 9),
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x7000)), 4));
+   __m256i g = _mm256_or_si256(
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x03e0)), 6),
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x0380)), 1));
+   __m256i b = _mm256_or_si256(
+         _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x001f)), 3),
+         _mm256_srli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x001c)), 2));
+
+   return _mm256_or_si256(_mm256_set1_epi32((int)0xff000000u),
+         _mm256_or_si256(r, _mm256_or_si256(g, b)));
+}
+
+static INLINE PIXCONV_AVX2 __m256i rgba4444_argb8888_avx2(__m256i x)
+{
+   __m256i t = _mm256_or_si256(
+         _mm256_or_si256(
+            _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0xf000)), 4),
+            _mm256_and_si256(x, _mm256_set1_epi32(0x0f00))),
+         _mm256_or_si256(
+            _mm256_srli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x00f0)), 4),
+            _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x000f)), 24)));
+
+   return _mm256_or_si256(t, _mm256_slli_epi32(t, 4));
+}
+
+/* Packs two registers of 32-bit lanes holding 16-bit values
+ * back into 16 pixels in order. */
+static INLINE PIXCONV_AVX2 __m256i pack_16bit_avx2(__m256i lo, __m256i hi)
+{
+   return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xd8);
+}
+
+/* Drops the alpha byte of 16 ARGB8888 pixels
+ * and writes the remaining 48 bytes. */
+static INLINE PIXCONV_AVX2 void store_bgr24_avx2(uint8_t *out,
+      __m256i lo, __m256i hi)
+{
+   const __m256i pack = _mm256_setr_epi8(
+         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+   __m256i p0 = _mm256_shuffle_epi8(lo, pack);
+   __m256i p1 = _mm256_shuffle_epi8(hi, pack);
+   __m128i a  = _mm256_castsi256_si128(p0);
+   __m128i b  = _mm256_extracti128_si256(p0, 1);
+   __m128i c  = _mm256_castsi256_si128(p1);
+   __m128i d  = _mm256_extracti128_si256(p1, 1);
+
+   _mm_storeu_si128((__m128i*)(out +  0),
+         _mm_or_si128(a, _mm_slli_si128(b, 12)));
+   _mm_storeu_si128((__m128i*)(out + 16),
+         _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+   _mm_storeu_si128((__m128i*)(out + 32),
+         _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+}
+
+static PIXCONV_AVX2 void conv_rgb565_0rgb1555_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m256i hi_mask = _mm256_set1_epi16(0x7fe0);
+   const __m256i lo_mask = _mm256_set1_epi16(0x1f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 1), hi_mask);
+         __m256i lo = _mm256_and_si256(in, lo_mask);
+         _mm256_storeu_si256((__m256i*)(output + w), _mm256_or_si256(hi, lo));
+      }
+
+      if (w < width)
+         conv_rgb565_0rgb1555_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_0rgb1555_rgb565_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input   = (const uint16_t*)input_;
+   uint16_t *output        = (uint16_t*)output_;
+   const __m256i hi_mask   = _mm256_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m256i lo_mask   = _mm256_set1_epi16(0x1f);
+   const __m256i glow_mask = _mm256_set1_epi16(1 << 5);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i rg   = _mm256_and_si256(_mm256_slli_epi16(in, 1), hi_mask);
+         __m256i b    = _mm256_and_si256(in, lo_mask);
+         __m256i glow = _mm256_and_si256(_mm256_srli_epi16(in, 4), glow_mask);
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_or_si256(rg, _mm256_or_si256(b, glow)));
+      }
+
+      if (w < width)
+         conv_0rgb1555_rgb565_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_0rgb1555_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               rgb1555_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_castsi256_si128(in))));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               rgb1555_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_extracti128_si256(in, 1))));
+      }
+
+      if (w < width)
+         conv_0rgb1555_argb8888_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_rgb565_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               rgb565_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_castsi256_si128(in))));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               rgb565_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_extracti128_si256(in, 1))));
+      }
+
+      if (w < width)
+         conv_rgb565_argb8888_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_argb8888_rgba4444_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m256i mask_r  = _mm256_set1_epi32(0xf000);
+   const __m256i mask_g  = _mm256_set1_epi32(0x0f00);
+   const __m256i mask_b  = _mm256_set1_epi32(0x00f0);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         __m256i res[2];
+         unsigned i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m256i in = _mm256_loadu_si256(
+                  (const __m256i*)(input + w + i * 8));
+            __m256i r = _mm256_and_si256(_mm256_srli_epi32(in,  8), mask_r);
+            __m256i g = _mm256_and_si256(_mm256_srli_epi32(in,  4), mask_g);
+            __m256i b = _mm256_and_si256(in, mask_b);
+            __m256i a = _mm256_srli_epi32(in, 28);
+            res[i]    = _mm256_or_si256(_mm256_or_si256(r, g),
+                  _mm256_or_si256(b, a));
+         }
+
+         _mm256_storeu_si256((__m256i*)(output + w),
+               pack_16bit_avx2(res[0], res[1]));
+      }
+
+      if (w < width)
+         conv_argb8888_rgba4444_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_rgba4444_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               rgba4444_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_castsi256_si128(in))));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               rgba4444_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_extracti128_si256(in, 1))));
+      }
+
+      if (w < width)
+         conv_rgba4444_argb8888_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_rgba4444_rgb565_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m256i mask_r  = _mm256_set1_epi16((int16_t)0xf000);
+   const __m256i mask_g  = _mm256_set1_epi16(0x0780);
+   const __m256i mask_b  = _mm256_set1_epi16(0x001e);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i r = _mm256_and_si256(in, mask_r);
+         __m256i g = _mm256_and_si256(_mm256_srli_epi16(in, 1), mask_g);
+         __m256i b = _mm256_and_si256(_mm256_srli_epi16(in, 3), mask_b);
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_or_si256(r, _mm256_or_si256(g, b)));
+      }
+
+      if (w < width)
+         conv_rgba4444_rgb565_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_0rgb1555_bgr24_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         store_bgr24_avx2(output + w * 3,
+               rgb1555_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_castsi256_si128(in))),
+               rgb1555_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_extracti128_si256(in, 1))));
+      }
+
+      if (w < width)
+         conv_0rgb1555_bgr24_generic(output + w * 3, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_rgb565_bgr24_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         store_bgr24_avx2(output + w * 3,
+               rgb565_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_castsi256_si128(in))),
+               rgb565_argb8888_avx2(_mm256_cvtepu16_epi32(
+                     _mm256_extracti128_si256(in, 1))));
+      }
+
+      if (w < width)
+         conv_rgb565_bgr24_generic(output + w * 3, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_bgr24_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint8_t *input   = (const uint8_t*)input_;
+   uint32_t *output       = (uint32_t*)output_;
+   const __m256i alpha    = _mm256_set1_epi32((int)0xff000000u);
+   const __m256i unpack   = _mm256_setr_epi8(
+         0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+         0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride)
+   {
+      int w = 0;
+
+      /* 48 bytes in, regrouped so every 128-bit
+       * lane starts with four whole pixels. */
+      for (; w + 16 <= width; w += 16)
+      {
+         const uint8_t *in = input + w * 3;
+         __m128i i0 = _mm_loadu_si128((const __m128i*)(in +  0));
+         __m128i i1 = _mm_loadu_si128((const __m128i*)(in + 16));
+         __m128i i2 = _mm_loadu_si128((const __m128i*)(in + 32));
+         __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(i0),
+               _mm_alignr_epi8(i1, i0, 12), 1);
+         __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                  _mm_alignr_epi8(i2, i1, 8)), _mm_srli_si128(i2, 4), 1);
+
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               _mm256_or_si256(_mm256_shuffle_epi8(lo, unpack), alpha));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               _mm256_or_si256(_mm256_shuffle_epi8(hi, unpack), alpha));
+      }
+
+      if (w < width)
+         conv_bgr24_argb8888_generic(output + w, input + w * 3,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_argb8888_0rgb1555_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+   const __m256i mask_r  = _mm256_set1_epi32(0x7c00);
+   const __m256i mask_g  = _mm256_set1_epi32(0x03e0);
+   const __m256i mask_b  = _mm256_set1_epi32(0x001f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         __m256i res[2];
+         unsigned i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m256i in = _mm256_loadu_si256(
+                  (const __m256i*)(input + w + i * 8));
+            __m256i r = _mm256_and_si256(_mm256_srli_epi32(in, 9), mask_r);
+            __m256i g = _mm256_and_si256(_mm256_srli_epi32(in, 6), mask_g);
+            __m256i b = _mm256_and_si256(_mm256_srli_epi32(in, 3), mask_b);
+            res[i]    = _mm256_or_si256(r, _mm256_or_si256(g, b));
+         }
+
+         _mm256_storeu_si256((__m256i*)(output + w),
+               pack_16bit_avx2(res[0], res[1]));
+      }
+
+      if (w < width)
+         conv_argb8888_0rgb1555_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_argb8888_bgr24_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 2)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+         store_bgr24_avx2(output + w * 3,
+               _mm256_loadu_si256((const __m256i*)(input + w + 0)),
+               _mm256_loadu_si256((const __m256i*)(input + w + 8)));
+
+      if (w < width)
+         conv_argb8888_bgr24_generic(output + w * 3, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_argb8888_abgr8888_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+   const __m256i swap_rb = _mm256_setr_epi8(
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 2)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_shuffle_epi8(in, swap_rb));
+      }
+
+      if (w < width)
+         conv_argb8888_abgr8888_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static PIXCONV_AVX2 void conv_yuyv_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint8_t *input        = (const uint8_t*)input_;
+   uint32_t *output            = (uint32_t*)output_;
+   const __m256i mask_y        = _mm256_set1_epi16(0xffu);
+   const __m256i mask_u        = _mm256_set1_epi32(0xffu << 8);
+   const __m256i mask_v        = _mm256_set1_epi32((int)(0xffu << 24));
+   const __m256i chroma_offset = _mm256_set1_epi16(128);
+   const __m256i round_offset  = _mm256_set1_epi16(YUV_OFFSET);
+   const __m256i yuv_mul       = _mm256_set1_epi16(YUV_MAT_Y);
+   const __m256i u_g_mul       = _mm256_set1_epi16(YUV_MAT_U_G);
+   const __m256i u_b_mul       = _mm256_set1_epi16(YUV_MAT_U_B);
+   const __m256i v_r_mul       = _mm256_set1_epi16(YUV_MAT_V_R);
+   const __m256i v_g_mul       = _mm256_set1_epi16(YUV_MAT_V_G);
+   const __m256i a             = _mm256_set1_epi16(-1);
+
+   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
+   {
+      int w = 0;
+
+      /* Same math as the SSE2 path, 32 pixels at a time. The
+       * in-lane packs and unpacks leave pixels 0-15 in the
+       * first register pair and 16-31 in the second, with
+       * each 128-bit lane holding its own run of pixels. */
+      for (; w + 32 <= width; w += 32)
+      {
+         const uint8_t *src = input + w * 2;
+         uint32_t      *dst = output + w;
+         __m256i u, v, u0, u1, v0, v1, r0, g0, b0, r1, g1, b1;
+         __m256i res_lo_bg, res_hi_bg, res_lo_ra, res_hi_ra;
+         __m256i res0, res1, res2, res3;
+         __m256i yuv0 = _mm256_loadu_si256((const __m256i*)(src +  0));
+         __m256i yuv1 = _mm256_loadu_si256((const __m256i*)(src + 32));
+         __m256i _y0  = _mm256_mullo_epi16(
+               _mm256_and_si256(yuv0, mask_y), yuv_mul);
+         __m256i _y1  = _mm256_mullo_epi16(
+               _mm256_and_si256(yuv1, mask_y), yuv_mul);
+
+         u0 = _mm256_srli_si256(_mm256_and_si256(yuv0, mask_u), 1);
+         v0 = _mm256_srli_si256(_mm256_and_si256(yuv0, mask_v), 3);
+         u1 = _mm256_srli_si256(_mm256_and_si256(yuv1, mask_u), 1);
+         v1 = _mm256_srli_si256(_mm256_and_si256(yuv1, mask_v), 3);
+         u  = _mm256_sub_epi16(_mm256_packs_epi32(u0, u1), chroma_offset);
+         v  = _mm256_sub_epi16(_mm256_packs_epi32(v0, v1), chroma_offset);
+
+         u0 = _mm256_unpacklo_epi16(u, u);
+         u1 = _mm256_unpackhi_epi16(u, u);
+         v0 = _mm256_unpacklo_epi16(v, v);
+         v1 = _mm256_unpackhi_epi16(v, v);
+
+         r0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y0,
+                     _mm256_mullo_epi16(v0, v_r_mul)), round_offset), YUV_SHIFT);
+         g0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                     _mm256_adds_epi16(_y0, _mm256_mullo_epi16(v0, v_g_mul)),
+                     _mm256_mullo_epi16(u0, u_g_mul)), round_offset), YUV_SHIFT);
+         b0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y0,
+                     _mm256_mullo_epi16(u0, u_b_mul)), round_offset), YUV_SHIFT);
+
+         r1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y1,
+                     _mm256_mullo_epi16(v1, v_r_mul)), round_offset), YUV_SHIFT);
+         g1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                     _mm256_adds_epi16(_y1, _mm256_mullo_epi16(v1, v_g_mul)),
+                     _mm256_mullo_epi16(u1, u_g_mul)), round_offset), YUV_SHIFT);
+         b1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y1,
+                     _mm256_mullo_epi16(u1, u_b_mul)), round_offset), YUV_SHIFT);
+
+         r0 = _mm256_packus_epi16(r0, r1);
+         g0 = _mm256_packus_epi16(g0, g1);
+         b0 = _mm256_packus_epi16(b0, b1);
+
+         res_lo_bg = _mm256_unpacklo_epi8(b0, g0);
+         res_hi_bg = _mm256_unpackhi_epi8(b0, g0);
+         res_lo_ra = _mm256_unpacklo_epi8(r0, a);
+         res_hi_ra = _mm256_unpackhi_epi8(r0, a);
+         res0 = _mm256_unpacklo_epi16(res_lo_bg, res_lo_ra);
+         res1 = _mm256_unpackhi_epi16(res_lo_bg, res_lo_ra);
+         res2 = _mm256_unpacklo_epi16(res_hi_bg, res_hi_ra);
+         res3 = _mm256_unpackhi_epi16(res_hi_bg, res_hi_ra);
+
+         _mm256_storeu_si256((__m256i*)(dst +  0),
+               _mm256_permute2x128_si256(res0, res1, 0x20));
+         _mm256_storeu_si256((__m256i*)(dst +  8),
+               _mm256_permute2x128_si256(res0, res1, 0x31));
+         _mm256_storeu_si256((__m256i*)(dst + 16),
+               _mm256_permute2x128_si256(res2, res3, 0x20));
+         _mm256_storeu_si256((__m256i*)(dst + 24),
+               _mm256_permute2x128_si256(res2, res3, 0x31));
+      }
+
+      if (w < width)
+         conv_yuyv_argb8888_generic(output + w, input + w * 2,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+#endif
+
+#if defined(PIXCONV_HAVE_NEON)
+/* 8 pixels to B, G, R, A planes, ready for vst3/vst4. */
+static INLINE uint8x8x4_t rgb565_argb8888_neon(uint16x8_t x)
+{
+   uint8x8x4_t res;
+   uint8x8_t r = vand_u8(vshrn_n_u16(x, 8), vdup_n_u8(0xf8));
+   uint8x8_t g = vand_u8(vshrn_n_u16(x, 3), vdup_n_u8(0xfc));
+   uint8x8_t b = vshl_n_u8(vmovn_u16(x), 3);
+
+   res.val[0] = vorr_u8(b, vshr_n_u8(b, 5));
+   res.val[1] = vorr_u8(g, vshr_n_u8(g, 6));
+   res.val[2] = vorr_u8(r, vshr_n_u8(r, 5));
+   res.val[3] = vdup_n_u8(0xff);
+   return res;
+}
+
+static INLINE uint8x8x4_t rgb1555_argb8888_neon(uint16x8_t x)
+{
+   uint8x8x4_t res;
+   uint8x8_t r = vand_u8(vshrn_n_u16(x, 7), vdup_n_u8(0xf8));
+   uint8x8_t g = vand_u8(vshrn_n_u16(x, 2), vdup_n_u8(0xf8));
+   uint8x8_t b = vshl_n_u8(vmovn_u16(x), 3);
+
+   res.val[0] = vorr_u8(b, vshr_n_u8(b, 5));
+   res.val[1] = vorr_u8(g, vshr_n_u8(g, 5));
+   res.val[2] = vorr_u8(r, vshr_n_u8(r, 5));
+   res.val[3] = vdup_n_u8(0xff);
+   return res;
+}
+
+static INLINE uint8x8x4_t rgba4444_argb8888_neon(uint16x8_t x)
+{
+   uint8x8x4_t res;
+   uint8x8_t r = vand_u8(vshrn_n_u16(x, 8), vdup_n_u8(0xf0));
+   uint8x8_t g = vand_u8(vshrn_n_u16(x, 4), vdup_n_u8(0xf0));
+   uint8x8_t b = vand_u8(vmovn_u16(x), vdup_n_u8(0xf0));
+   uint8x8_t a = vshl_n_u8(vmovn_u16(x), 4);
+
+   res.val[0] = vorr_u8(b, vshr_n_u8(b, 4));
+   res.val[1] = vorr_u8(g, vshr_n_u8(g, 4));
+   res.val[2] = vorr_u8(r, vshr_n_u8(r, 4));
+   res.val[3] = vorr_u8(a, vshr_n_u8(a, 4));
+   return res;
+}
+
+static void conv_rgb565_0rgb1555_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input    = (const uint16_t*)input_;
+   uint16_t *output         = (uint16_t*)output_;
+   const uint16x8_t hi_mask = vdupq_n_u16(0x7fe0);
+   const uint16x8_t lo_mask = vdupq_n_u16(0x1f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in = vld1q_u16(input + w);
+         vst1q_u16(output + w, vorrq_u16(
+                  vandq_u16(vshrq_n_u16(in, 1), hi_mask),
+                  vandq_u16(in, lo_mask)));
+      }
+
+      if (w < width)
+         conv_rgb565_0rgb1555_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_0rgb1555_rgb565_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input      = (const uint16_t*)input_;
+   uint16_t *output           = (uint16_t*)output_;
+   const uint16x8_t hi_mask   = vdupq_n_u16((0x1f << 11) | (0x1f << 6));
+   const uint16x8_t lo_mask   = vdupq_n_u16(0x1f);
+   const uint16x8_t glow_mask = vdupq_n_u16(1 << 5);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in   = vld1q_u16(input + w);
+         uint16x8_t rg   = vandq_u16(vshlq_n_u16(in, 1), hi_mask);
+         uint16x8_t b    = vandq_u16(in, lo_mask);
+         uint16x8_t glow = vandq_u16(vshrq_n_u16(in, 4), glow_mask);
+         vst1q_u16(output + w, vorrq_u16(rg, vorrq_u16(b, glow)));
+      }
+
+      if (w < width)
+         conv_0rgb1555_rgb565_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_0rgb1555_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+         vst4_u8((uint8_t*)(output + w),
+               rgb1555_argb8888_neon(vld1q_u16(input + w)));
+
+      if (w < width)
+         conv_0rgb1555_argb8888_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_rgb565_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+         vst4_u8((uint8_t*)(output + w),
+               rgb565_argb8888_neon(vld1q_u16(input + w)));
+
+      if (w < width)
+         conv_rgb565_argb8888_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_argb8888_rgba4444_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint16x8_t r   = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[2], 4)), 12);
+         uint16x8_t g   = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[1], 4)), 8);
+         uint16x8_t b   = vmovl_u8(vand_u8(in.val[0], vdup_n_u8(0xf0)));
+         uint16x8_t a   = vmovl_u8(vshr_n_u8(in.val[3], 4));
+         vst1q_u16(output + w, vorrq_u16(vorrq_u16(r, g), vorrq_u16(b, a)));
+      }
+
+      if (w < width)
+         conv_argb8888_rgba4444_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_rgba4444_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+         vst4_u8((uint8_t*)(output + w),
+               rgba4444_argb8888_neon(vld1q_u16(input + w)));
+
+      if (w < width)
+         conv_rgba4444_argb8888_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_rgba4444_rgb565_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input   = (const uint16_t*)input_;
+   uint16_t *output        = (uint16_t*)output_;
+   const uint16x8_t mask_r = vdupq_n_u16(0xf000);
+   const uint16x8_t mask_g = vdupq_n_u16(0x0780);
+   const uint16x8_t mask_b = vdupq_n_u16(0x001e);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in = vld1q_u16(input + w);
+         uint16x8_t r  = vandq_u16(in, mask_r);
+         uint16x8_t g  = vandq_u16(vshrq_n_u16(in, 1), mask_g);
+         uint16x8_t b  = vandq_u16(vshrq_n_u16(in, 3), mask_b);
+         vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
+      }
+
+      if (w < width)
+         conv_rgba4444_rgb565_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_0rgb1555_bgr24_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t argb = rgb1555_argb8888_neon(vld1q_u16(input + w));
+         uint8x8x3_t bgr;
+
+         bgr.val[0] = argb.val[0];
+         bgr.val[1] = argb.val[1];
+         bgr.val[2] = argb.val[2];
+         vst3_u8(output + w * 3, bgr);
+      }
+
+      if (w < width)
+         conv_0rgb1555_bgr24_generic(output + w * 3, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_rgb565_bgr24_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t argb = rgb565_argb8888_neon(vld1q_u16(input + w));
+         uint8x8x3_t bgr;
+
+         bgr.val[0] = argb.val[0];
+         bgr.val[1] = argb.val[1];
+         bgr.val[2] = argb.val[2];
+         vst3_u8(output + w * 3, bgr);
+      }
+
+      if (w < width)
+         conv_rgb565_bgr24_generic(output + w * 3, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_bgr24_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         uint8x16x3_t bgr = vld3q_u8(input + w * 3);
+         uint8x16x4_t argb;
+
+         argb.val[0] = bgr.val[0];
+         argb.val[1] = bgr.val[1];
+         argb.val[2] = bgr.val[2];
+         argb.val[3] = vdupq_n_u8(0xff);
+         vst4q_u8((uint8_t*)(output + w), argb);
+      }
+
+      if (w < width)
+         conv_bgr24_argb8888_generic(output + w, input + w * 3,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_argb8888_0rgb1555_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      int w = 0;
+
+      for (; w + 8 <= width; w += 8)
+      {
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint16x8_t r   = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[2], 3)), 10);
+         uint16x8_t g   = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[1], 3)), 5);
+         uint16x8_t b   = vmovl_u8(vshr_n_u8(in.val[0], 3));
+         vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
+      }
+
+      if (w < width)
+         conv_argb8888_0rgb1555_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_argb8888_bgr24_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 2)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         uint8x16x4_t argb = vld4q_u8((const uint8_t*)(input + w));
+         uint8x16x3_t bgr;
+
+         bgr.val[0] = argb.val[0];
+         bgr.val[1] = argb.val[1];
+         bgr.val[2] = argb.val[2];
+         vst3q_u8(output + w * 3, bgr);
+      }
+
+      if (w < width)
+         conv_argb8888_bgr24_generic(output + w * 3, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_argb8888_abgr8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 2)
+   {
+      int w = 0;
+
+      for (; w + 16 <= width; w += 16)
+      {
+         uint8x16x4_t px = vld4q_u8((const uint8_t*)(input + w));
+         uint8x16_t tmp  = px.val[0];
+
+         px.val[0] = px.val[2];
+         px.val[2] = tmp;
+         vst4q_u8((uint8_t*)(output + w), px);
+      }
+
+      if (w < width)
+         conv_argb8888_abgr8888_generic(output + w, input + w,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+
+static void conv_yuyv_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h;
+   const uint8_t *input   = (const uint8_t*)input_;
+   uint32_t *output       = (uint32_t*)output_;
+   const int16x8_t offset = vdupq_n_s16(YUV_OFFSET);
+   const uint8x8_t chroma = vdup_n_u8(128);
+
+   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
+   {
+      int w = 0;
+
+      /* vld4 splits 16 pixels into even Y, U, odd Y and V.
+       * None of the sums can overflow 16 bits, and the
+       * saturating narrow matches clamp_8bit(). */
+      for (; w + 16 <= width; w += 16)
+      {
+         uint8x8x4_t yuv = vld4_u8(input + w * 2);
+         int16x8_t _y0   = vreinterpretq_s16_u16(vshll_n_u8(yuv.val[0], 6));
+         int16x8_t _y1   = vreinterpretq_s16_u16(vshll_n_u8(yuv.val[2], 6));
+         int16x8_t u     = vreinterpretq_s16_u16(vsubl_u8(yuv.val[1], chroma));
+         int16x8_t v     = vreinterpretq_s16_u16(vsubl_u8(yuv.val[3], chroma));
+         int16x8_t r     = vmlaq_n_s16(offset, v, YUV_MAT_V_R);
+         int16x8_t g     = vmlaq_n_s16(vmlaq_n_s16(offset, u, YUV_MAT_U_G),
+               v, YUV_MAT_V_G);
+         int16x8_t b     = vmlaq_n_s16(offset, u, YUV_MAT_U_B);
+         uint8x8x2_t r8  = vzip_u8(
+               vqshrun_n_s16(vaddq_s16(_y0, r), YUV_SHIFT),
+               vqshrun_n_s16(vaddq_s16(_y1, r), YUV_SHIFT));
+         uint8x8x2_t g8  = vzip_u8(
+               vqshrun_n_s16(vaddq_s16(_y0, g), YUV_SHIFT),
+               vqshrun_n_s16(vaddq_s16(_y1, g), YUV_SHIFT));
+         uint8x8x2_t b8  = vzip_u8(
+               vqshrun_n_s16(vaddq_s16(_y0, b), YUV_SHIFT),
+               vqshrun_n_s16(vaddq_s16(_y1, b), YUV_SHIFT));
+         uint8x8x4_t argb;
+
+         argb.val[3] = vdup_n_u8(0xff);
+
+         argb.val[0] = b8.val[0];
+         argb.val[1] = g8.val[0];
+         argb.val[2] = r8.val[0];
+         vst4_u8((uint8_t*)(output + w), argb);
+
+         argb.val[0] = b8.val[1];
+         argb.val[1] = g8.val[1];
+         argb.val[2] = r8.val[1];
+         vst4_u8((uint8_t*)(output + w + 8), argb);
+      }
+
+      if (w < width)
+         conv_yuyv_argb8888_generic(output + w, input + w * 2,
+               width - w, 1, out_stride, in_stride);
+   }
+}
+#endif
+
+struct pixconv_impl
+{
+   conv_func_t rgb565_0rgb1555;
+   conv_func_t _0rgb1555_rgb565;
+   conv_func_t _0rgb1555_argb8888;
+   conv_func_t rgb565_argb8888;
+   conv_func_t argb8888_rgba4444;
+   conv_func_t rgba4444_argb8888;
+   conv_func_t rgba4444_rgb565;
+   conv_func_t _0rgb1555_bgr24;
+   conv_func_t rgb565_bgr24;
+   conv_func_t bgr24_argb8888;
+   conv_func_t argb8888_0rgb1555;
+   conv_func_t argb8888_bgr24;
+   conv_func_t argb8888_abgr8888;
+   conv_func_t yuyv_argb8888;
+};
+
+static const struct pixconv_impl pixconv_generic = {
+   conv_rgb565_0rgb1555_generic,
+   conv_0rgb1555_rgb565_generic,
+   conv_0rgb1555_argb8888_generic,
+   conv_rgb565_argb8888_generic,
+   conv_argb8888_rgba4444_generic,
+   conv_rgba4444_argb8888_generic,
+   conv_rgba4444_rgb565_generic,
+   conv_0rgb1555_bgr24_generic,
+   conv_rgb565_bgr24_generic,
+   conv_bgr24_argb8888_generic,
+   conv_argb8888_0rgb1555_generic,
+   conv_argb8888_bgr24_generic,
+   conv_argb8888_abgr8888_generic,
+   conv_yuyv_argb8888_generic,
+};
+
+#if defined(PIXCONV_HAVE_AVX2)
+static const struct pixconv_impl pixconv_avx2 = {
+   conv_rgb565_0rgb1555_avx2,
+   conv_0rgb1555_rgb565_avx2,
+   conv_0rgb1555_argb8888_avx2,
+   conv_rgb565_argb8888_avx2,
+   conv_argb8888_rgba4444_avx2,
+   conv_rgba4444_argb8888_avx2,
+   conv_rgba4444_rgb565_avx2,
+   conv_0rgb1555_bgr24_avx2,
+   conv_rgb565_bgr24_avx2,
+   conv_bgr24_argb8888_avx2,
+   conv_argb8888_0rgb1555_avx2,
+   conv_argb8888_bgr24_avx2,
+   conv_argb8888_abgr8888_avx2,
+   conv_yuyv_argb8888_avx2,
+};
+#endif
+
+#if defined(PIXCONV_HAVE_NEON)
+static const struct pixconv_impl pixconv_neon = {
+   conv_rgb565_0rgb1555_neon,
+   conv_0rgb1555_rgb565_neon,
+   conv_0rgb1555_argb8888_neon,
+   conv_rgb565_argb8888_neon,
+   conv_argb8888_rgba4444_neon,
+   conv_rgba4444_argb8888_neon,
+   conv_rgba4444_rgb565_neon,
+   conv_0rgb1555_bgr24_neon,
+   conv_rgb565_bgr24_neon,
+   conv_bgr24_argb8888_neon,
+   conv_argb8888_0rgb1555_neon,
+   conv_argb8888_bgr24_neon,
+   conv_argb8888_abgr8888_neon,
+   conv_yuyv_argb8888_neon,
+};
+#endif
+
+static const struct pixconv_impl *pixconv = &pixconv_generic;
+
+/**
+ * conv_init_simd:
+ * @simd                : Bitmask of CONV_SIMD_* flags.
+ *
+ * Selects the converters used by the conv_* functions.
+ * Until this is called, the scalar (or SSE2, if compiled
+ * in) versions are used.
+ **/
+void conv_init_simd(unsigned simd)
+{
+   pixconv = &pixconv_generic;
+
+#if defined(PIXCONV_HAVE_AVX2)
+   if (simd & CONV_SIMD_AVX2)
+      pixconv = &pixconv_avx2;
+#endif
+#if defined(PIXCONV_HAVE_NEON)
+   if (simd & CONV_SIMD_NEON)
+      pixconv = &pixconv_neon;
+#endif
+}
+
+void conv_rgb565_0rgb1555(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->rgb565_0rgb1555(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_0rgb1555_rgb565(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->_0rgb1555_rgb565(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_0rgb1555_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->_0rgb1555_argb8888(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_rgb565_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->rgb565_argb8888(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_argb8888_rgba4444(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->argb8888_rgba4444(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_rgba4444_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->rgba4444_argb8888(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_rgba4444_rgb565(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->rgba4444_rgb565(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_0rgb1555_bgr24(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->_0rgb1555_bgr24(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_rgb565_bgr24(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->rgb565_bgr24(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_bgr24_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->bgr24_argb8888(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_argb8888_0rgb1555(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->argb8888_0rgb1555(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_argb8888_bgr24(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->argb8888_bgr24(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_argb8888_abgr8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->argb8888_abgr8888(output, input, width, height,
+         out_stride, in_stride);
+}
+
+void conv_yuyv_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   pixconv->yuyv_argb8888(output, input, width, height,
+         out_stride, in_stride);
+}
+
 void conv_copy(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -0,0 +1,192 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (pixconv_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Runs every converter through the SIMD path this machine has and
+ * through the generic one, and checks the outputs are bit-exact,
+ * including the row padding neither may touch. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gfx/scaler/pixconv.h>
+
+#define TEST_HEIGHT 3
+#define TEST_CANARY 0xa5
+
+typedef void (*conv_test_func_t)(void *, const void *,
+      int, int, int, int);
+
+struct conv_test
+{
+   const char *name;
+   conv_test_func_t func;
+   int in_bpp;
+   int out_bpp;
+   /* Converters that work on pixel pairs. */
+   int even_width;
+};
+
+static const struct conv_test conv_tests[] = {
+   { "rgb565_0rgb1555",   conv_rgb565_0rgb1555,   2, 2, 0 },
+   { "0rgb1555_rgb565",   conv_0rgb1555_rgb565,   2, 2, 0 },
+   { "0rgb1555_argb8888", conv_0rgb1555_argb8888, 2, 4, 0 },
+   { "rgb565_argb8888",   conv_rgb565_argb8888,   2, 4, 0 },
+   { "argb8888_rgba4444", conv_argb8888_rgba4444, 4, 2, 0 },
+   { "rgba4444_argb8888", conv_rgba4444_argb8888, 2, 4, 0 },
+   { "rgba4444_rgb565",   conv_rgba4444_rgb565,   2, 2, 0 },
+   { "0rgb1555_bgr24",    conv_0rgb1555_bgr24,    2, 3, 0 },
+   { "rgb565_bgr24",      conv_rgb565_bgr24,      2, 3, 0 },
+   { "bgr24_argb8888",    conv_bgr24_argb8888,    3, 4, 0 },
+   { "argb8888_0rgb1555", conv_argb8888_0rgb1555, 4, 2, 0 },
+   { "argb8888_bgr24",    conv_argb8888_bgr24,    4, 3, 0 },
+   { "argb8888_abgr8888", conv_argb8888_abgr8888, 4, 4, 0 },
+   { "yuyv_argb8888",     conv_yuyv_argb8888,     2, 4, 1 },
+};
+
+/* Extra bytes per row; a multiple of four keeps every format's
+ * stride whole while still misaligning the rows. */
+static const int test_pads[] = { 0, 4, 36 };
+
+static unsigned test_simd(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      return CONV_SIMD_AVX2;
+#endif
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+   return CONV_SIMD_NEON;
+#endif
+   return 0;
+}
+
+static int test_conv(const struct conv_test *test, unsigned simd,
+      int width, int pad)
+{
+   int i;
+   int ret          = 0;
+   int in_stride    = width * test->in_bpp + pad;
+   int out_stride   = width * test->out_bpp + pad;
+   size_t in_size   = (size_t)in_stride * TEST_HEIGHT;
+   size_t out_size  = (size_t)out_stride * TEST_HEIGHT;
+   uint8_t *input   = (uint8_t*)malloc(in_size);
+   uint8_t *ref     = (uint8_t*)malloc(out_size);
+   uint8_t *out     = (uint8_t*)malloc(out_size);
+
+   if (!input || !ref || !out)
+   {
+      puts("ERROR: out of memory");
+      ret = 1;
+      goto end;
+   }
+
+   for (i = 0; i < (int)in_size; i++)
+      input[i] = rand();
+
+   memset(ref, TEST_CANARY, out_size);
+   memset(out, TEST_CANARY, out_size);
+
+   conv_init_simd(0);
+   test->func(ref, input, width, TEST_HEIGHT, out_stride, in_stride);
+
+   conv_init_simd(simd);
+   test->func(out, input, width, TEST_HEIGHT, out_stride, in_stride);
+
+   for (i = 0; i < (int)out_size; i++)
+   {
+      int x      = i % out_stride;
+      int in_row = x < width * test->out_bpp;
+
+      if (!in_row && ref[i] != TEST_CANARY)
+      {
+         printf("ERROR: %s (generic) wrote past the row at width %d, "
+               "pad %d, byte %d\n", test->name, width, pad, x);
+         ret = 1;
+         break;
+      }
+
+      if (out[i] != ref[i])
+      {
+         printf("ERROR: %s differs at width %d, pad %d, "
+               "row %d, byte %d (%02x, expected %02x)\n",
+               test->name, width, pad, i / out_stride, x,
+               out[i], ref[i]);
+         ret = 1;
+         break;
+      }
+   }
+
+end:
+   free(input);
+   free(ref);
+   free(out);
+   return ret;
+}
+
+int main(void)
+{
+   unsigned i, j;
+   int width;
+   int failed    = 0;
+   unsigned simd = test_simd();
+
+   if (!simd)
+   {
+      puts("No SIMD converters for this CPU, nothing to compare.");
+      return 0;
+   }
+
+   srand(1);
+
+   for (i = 0; i < sizeof(conv_tests) / sizeof(conv_tests[0]); i++)
+   {
+      const struct conv_test *test = &conv_tests[i];
+      int test_failed              = 0;
+
+      /* Every tail length for the widest vector, then sizes
+       * that cross several vectors. */
+      for (width = 1; width <= 80 && !test_failed; width++)
+      {
+         if (test->even_width && (width & 1))
+            continue;
+
+         for (j = 0; j < sizeof(test_pads) / sizeof(test_pads[0]); j++)
+            test_failed |= test_conv(test, simd, width, test_pads[j]);
+      }
+
+      for (width = 253; width <= 259 && !test_failed; width++)
+      {
+         if (test->even_width && (width & 1))
+            continue;
+
+         for (j = 0; j < sizeof(test_pads) / sizeof(test_pads[0]); j++)
+            test_failed |= test_conv(test, simd, width, test_pads[j]);
+      }
+
+      printf("%-20s %s\n", test->name, test_failed ? "FAILED" : "ok");
+      failed |= test_failed;
+   }
+
+   return failed;
+}
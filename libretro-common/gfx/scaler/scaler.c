@@ -30,6 +30,65 @@
 #include <gfx/scaler/filter.h>
 #include <gfx/scaler/pixconv.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+/* Smaller frames are not worth waking up worker threads for. */
+#define SCALER_THREAD_MIN_PIXELS (256 * 256)
+#define SCALER_MAX_THREADS       16
+
+enum scaler_phase
+{
+   /* Straight pixel conversion, banded over output rows. */
+   SCALER_PHASE_DIRECT = 0,
+   /* Input conversion and horizontal pass, banded over input rows. */
+   SCALER_PHASE_HORIZ,
+   /* Vertical (or point) pass and output conversion,
+    * banded over output rows. */
+   SCALER_PHASE_VERT
+};
+
+struct scaler_job
+{
+   enum scaler_phase phase;
+   void *output;
+   const void *input;
+   void *output_frame;
+   const void *input_frame;
+   int output_stride;
+   int input_stride;
+};
+
+#ifdef HAVE_THREADS
+struct scaler_pool;
+
+struct scaler_worker
+{
+   struct scaler_pool *pool;
+   sthread_t *thread;
+   unsigned index;
+};
+
+struct scaler_pool
+{
+   struct scaler_ctx *ctx;
+   slock_t *lock;
+   scond_t *cond;
+   scond_t *done;
+
+   struct scaler_job job;
+   unsigned generation;
+   unsigned pending;
+   bool quit;
+
+   /* Bands per phase. The caller runs band 0. */
+   unsigned count;
+   unsigned num_workers;
+   struct scaler_worker workers[SCALER_MAX_THREADS - 1];
+};
+#endif
+
 /**
  * scaler_alloc:
  * @elem_size    : size of the elements to be used.
@@ -60,13 +119,33 @@ void scaler_free(void *ptr)
       free(ptr);
 }
 
+void *scaler_realloc(void *ptr, size_t *capacity,
+      size_t elem_size, size_t size)
+{
+   if (!ptr || *capacity < size)
+   {
+      scaler_free(ptr);
+      *capacity = 0;
+
+      ptr       = scaler_alloc(elem_size, size);
+      if (!ptr)
+         return NULL;
+
+      *capacity = size;
+      return ptr;
+   }
+
+   memset(ptr, 0, elem_size * size);
+   return ptr;
+}
+
 static bool allocate_frames(struct scaler_ctx *ctx)
 {
    ctx->scaled.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint64_t);
    ctx->scaled.width  = ctx->out_width;
    ctx->scaled.height = ctx->in_height;
    ctx->scaled.frame  = (uint64_t*)
-      scaler_alloc(sizeof(uint64_t),
+      scaler_realloc(ctx->scaled.frame, &ctx->scaled.size, sizeof(uint64_t),
             (ctx->scaled.stride * ctx->scaled.height) >> 3);
    if (!ctx->scaled.frame)
       return false;
@@ -75,7 +154,7 @@ static bool allocate_frames(struct scaler_ctx *ctx)
    {
       ctx->input.stride = ((ctx->in_width + 7) & ~7) * sizeof(uint32_t);
       ctx->input.frame = (uint32_t*)
-         scaler_alloc(sizeof(uint32_t),
+         scaler_realloc(ctx->input.frame, &ctx->input.size, sizeof(uint32_t),
                (ctx->input.stride * ctx->in_height) >> 2);
       if (!ctx->input.frame)
          return false;
@@ -85,7 +164,7 @@ static bool allocate_frames(struct scaler_ctx *ctx)
    {
       ctx->output.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint32_t);
       ctx->output.frame  = (uint32_t*)
-         scaler_alloc(sizeof(uint32_t),
+         scaler_realloc(ctx->output.frame, &ctx->output.size, sizeof(uint32_t),
                (ctx->output.stride * ctx->out_height) >> 2);
       if (!ctx->output.frame)
          return false;
@@ -262,9 +341,21 @@ static bool set_pix_conv(struct scaler_ctx *ctx)
    return true;
 }
 
+void scaler_init_simd(unsigned simd)
+{
+   conv_init_simd(simd);
+   scaler_argb8888_init_simd(simd);
+}
+
 bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 {
-   scaler_ctx_gen_reset(ctx);
+   /* Buffers are kept, but nothing bound for the
+    * previous formats may leak into this setup. */
+   ctx->scaler_horiz   = NULL;
+   ctx->scaler_vert    = NULL;
+   ctx->in_pixconv     = NULL;
+   ctx->out_pixconv    = NULL;
+   ctx->direct_pixconv = NULL;
 
    if (ctx->in_width == ctx->out_width && ctx->in_height == ctx->out_height)
       ctx->unscaled = true; /* Only pixel format conversion ... */
@@ -297,8 +388,17 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
    return true;
 }
 
+#ifdef HAVE_THREADS
+static void scaler_pool_free(struct scaler_pool *pool);
+#endif
+
 void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 {
+#ifdef HAVE_THREADS
+   scaler_pool_free((struct scaler_pool*)ctx->pool);
+#endif
+   ctx->pool = NULL;
+
    scaler_free(ctx->horiz.filter);
    scaler_free(ctx->horiz.filter_pos);
    scaler_free(ctx->vert.filter);
@@ -314,6 +414,235 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
    memset(&ctx->output, 0, sizeof(ctx->output));
 }
 
+/**
+ * scaler_ctx_run_band:
+ * @ctx          : pointer to scaler context object.
+ * @job          : phase to run.
+ * @index        : band to process.
+ * @count        : number of bands the phase is split into.
+ *
+ * Runs one horizontal band of a scaling phase. Bands of the
+ * same phase never touch the same rows, so they can run
+ * concurrently.
+ **/
+static void scaler_ctx_run_band(const struct scaler_ctx *ctx,
+      const struct scaler_job *job, unsigned index, unsigned count)
+{
+   int rows  = (job->phase == SCALER_PHASE_HORIZ) ?
+      ctx->in_height : ctx->out_height;
+   int first = (int)(((int64_t)rows * index) / count);
+   int last  = (int)(((int64_t)rows * (index + 1)) / count);
+
+   if (first >= last)
+      return;
+
+   switch (job->phase)
+   {
+      case SCALER_PHASE_DIRECT:
+         ctx->direct_pixconv(
+               (uint8_t*)job->output + first * ctx->out_stride,
+               (const uint8_t*)job->input + first * ctx->in_stride,
+               ctx->out_width, last - first,
+               ctx->out_stride, ctx->in_stride);
+         break;
+
+      case SCALER_PHASE_HORIZ:
+         if (ctx->in_fmt != SCALER_FMT_ARGB8888)
+            ctx->in_pixconv(
+                  (uint8_t*)ctx->input.frame + first * ctx->input.stride,
+                  (const uint8_t*)job->input + first * ctx->in_stride,
+                  ctx->in_width, last - first,
+                  ctx->input.stride, ctx->in_stride);
+
+         if (!ctx->scaler_special && ctx->scaler_horiz)
+            ctx->scaler_horiz(ctx, job->input_frame,
+                  job->input_stride, first, last);
+         break;
+
+      case SCALER_PHASE_VERT:
+         if (ctx->scaler_special)
+         {
+            /* Take some special, and (hopefully) more optimized path. */
+            ctx->scaler_special(ctx, job->output_frame, job->input_frame,
+                  ctx->out_width, ctx->out_height,
+                  ctx->in_width, ctx->in_height,
+                  job->output_stride, job->input_stride,
+                  first, last);
+         }
+         else if (ctx->scaler_vert)
+            ctx->scaler_vert(ctx, job->output_frame,
+                  job->output_stride, first, last);
+
+         if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+            ctx->out_pixconv(
+                  (uint8_t*)job->output + first * ctx->out_stride,
+                  (const uint8_t*)ctx->output.frame + first * ctx->output.stride,
+                  ctx->out_width, last - first,
+                  ctx->out_stride, ctx->output.stride);
+         break;
+   }
+}
+
+#ifdef HAVE_THREADS
+static void scaler_worker_thread(void *data)
+{
+   struct scaler_worker *worker = (struct scaler_worker*)data;
+   struct scaler_pool     *pool = worker->pool;
+   unsigned generation          = 0;
+
+   slock_lock(pool->lock);
+
+   for (;;)
+   {
+      while (!pool->quit && pool->generation == generation)
+         scond_wait(pool->cond, pool->lock);
+
+      if (pool->quit)
+         break;
+
+      generation = pool->generation;
+      slock_unlock(pool->lock);
+
+      scaler_ctx_run_band(pool->ctx, &pool->job,
+            worker->index, pool->count);
+
+      slock_lock(pool->lock);
+      if (--pool->pending == 0)
+         scond_signal(pool->done);
+   }
+
+   slock_unlock(pool->lock);
+}
+
+static void scaler_pool_free(struct scaler_pool *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   if (pool->lock)
+   {
+      slock_lock(pool->lock);
+      pool->quit = true;
+      if (pool->cond)
+         scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+   }
+
+   for (i = 0; i < pool->num_workers; i++)
+      sthread_join(pool->workers[i].thread);
+
+   if (pool->done)
+      scond_free(pool->done);
+   if (pool->cond)
+      scond_free(pool->cond);
+   if (pool->lock)
+      slock_free(pool->lock);
+
+   free(pool);
+}
+
+static struct scaler_pool *scaler_pool_new(struct scaler_ctx *ctx,
+      unsigned count)
+{
+   unsigned i;
+   struct scaler_pool *pool = (struct scaler_pool*)
+      calloc(1, sizeof(*pool));
+
+   if (!pool)
+      return NULL;
+
+   pool->ctx   = ctx;
+   pool->count = count;
+   pool->lock  = slock_new();
+   pool->cond  = scond_new();
+   pool->done  = scond_new();
+
+   if (!pool->lock || !pool->cond || !pool->done)
+      goto error;
+
+   for (i = 0; i < count - 1; i++)
+   {
+      struct scaler_worker *worker = &pool->workers[i];
+
+      worker->pool   = pool;
+      worker->index  = i + 1;
+      worker->thread = sthread_create(scaler_worker_thread, worker);
+      if (!worker->thread)
+         goto error;
+
+      pool->num_workers++;
+   }
+
+   return pool;
+
+error:
+   scaler_pool_free(pool);
+   return NULL;
+}
+
+static void scaler_pool_run(struct scaler_pool *pool,
+      const struct scaler_job *job)
+{
+   slock_lock(pool->lock);
+   pool->job     = *job;
+   pool->pending = pool->num_workers;
+   pool->generation++;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+
+   scaler_ctx_run_band(pool->ctx, job, 0, pool->count);
+
+   slock_lock(pool->lock);
+   while (pool->pending)
+      scond_wait(pool->done, pool->lock);
+   slock_unlock(pool->lock);
+}
+
+static struct scaler_pool *scaler_ctx_get_pool(struct scaler_ctx *ctx)
+{
+   struct scaler_pool *pool = (struct scaler_pool*)ctx->pool;
+   unsigned count           = ctx->threads;
+
+   if (count > SCALER_MAX_THREADS)
+      count = SCALER_MAX_THREADS;
+
+   if (count < 2 ||
+         ctx->out_width * ctx->out_height < SCALER_THREAD_MIN_PIXELS)
+      return NULL;
+
+   if (pool && pool->count == count && pool->ctx == ctx)
+      return pool;
+
+   scaler_pool_free(pool);
+   pool     = scaler_pool_new(ctx, count);
+   ctx->pool = pool;
+
+   /* Failing to spawn workers just means scaling on this thread. */
+   if (!pool)
+      ctx->threads = 1;
+
+   return pool;
+}
+#endif
+
+static void scaler_ctx_run(struct scaler_ctx *ctx,
+      const struct scaler_job *job)
+{
+#ifdef HAVE_THREADS
+   struct scaler_pool *pool = scaler_ctx_get_pool(ctx);
+
+   if (pool)
+   {
+      scaler_pool_run(pool, job);
+      return;
+   }
+#endif
+
+   scaler_ctx_run_band(ctx, job, 0, 1);
+}
+
 /**
  * scaler_ctx_scale:
  * @ctx          : pointer to scaler context object.
@@ -325,55 +654,40 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 void scaler_ctx_scale(struct scaler_ctx *ctx,
       void *output, const void *input)
 {
-   const void *input_frame = input;
-   void *output_frame      = output;
-   int input_stride        = ctx->in_stride;
-   int output_stride       = ctx->out_stride;
+   struct scaler_job job;
+
+   job.output        = output;
+   job.input         = input;
+   job.output_frame  = output;
+   job.input_frame   = input;
+   job.output_stride = ctx->out_stride;
+   job.input_stride  = ctx->in_stride;
 
    if (ctx->unscaled)
    {
       /* Just perform straight pixel conversion. */
-      ctx->direct_pixconv(output, input,
-            ctx->out_width, ctx->out_height,
-            ctx->out_stride, ctx->in_stride);
+      job.phase = SCALER_PHASE_DIRECT;
+      scaler_ctx_run(ctx, &job);
       return;
    }
 
    if (ctx->in_fmt != SCALER_FMT_ARGB8888)
    {
-      ctx->in_pixconv(ctx->input.frame, input,
-            ctx->in_width, ctx->in_height,
-            ctx->input.stride, ctx->in_stride);
-
-      input_frame       = ctx->input.frame;
-      input_stride      = ctx->input.stride;
+      job.input_frame   = ctx->input.frame;
+      job.input_stride  = ctx->input.stride;
    }
 
    if (ctx->out_fmt != SCALER_FMT_ARGB8888)
    {
-      output_frame  = ctx->output.frame;
-      output_stride = ctx->output.stride;
+      job.output_frame  = ctx->output.frame;
+      job.output_stride = ctx->output.stride;
    }
 
-   if (ctx->scaler_special)
-   {
-      /* Take some special, and (hopefully) more optimized path. */
-      ctx->scaler_special(ctx, output_frame, input_frame,
-            ctx->out_width, ctx->out_height,
-            ctx->in_width, ctx->in_height,
-            output_stride, input_stride);
-   }
-   else
-   {
-      /* Take generic filter path. */
-      if (ctx->scaler_horiz)
-         ctx->scaler_horiz(ctx, input_frame, input_stride);
-      if (ctx->scaler_vert)
-         ctx->scaler_vert (ctx, output, output_stride);
-   }
+   /* The vertical pass reads rows from every horizontal band,
+    * so each phase has to complete before the next starts. */
+   job.phase = SCALER_PHASE_HORIZ;
+   scaler_ctx_run(ctx, &job);
 
-   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
-      ctx->out_pixconv(output, ctx->output.frame,
-            ctx->out_width, ctx->out_height,
-            ctx->out_stride, ctx->output.stride);
+   job.phase = SCALER_PHASE_VERT;
+   scaler_ctx_run(ctx, &job);
 }
@@ -0,0 +1,198 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (scaler_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Times scaler_ctx_scale() per frame for each scaler type, with the
+ * generic and the SIMD kernels, on one thread and on several.
+ *
+ * Usage: scaler_bench [frames] */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <gfx/scaler/scaler.h>
+#include <gfx/scaler/pixconv.h>
+
+struct bench_size
+{
+   int in_width;
+   int in_height;
+   int out_width;
+   int out_height;
+};
+
+static const struct bench_size bench_sizes[] = {
+   { 256, 224,  256,  224 },
+   { 320, 240, 1280,  960 },
+   { 320, 240, 1920, 1080 },
+   { 640, 480, 1920, 1080 },
+};
+
+static const struct
+{
+   enum scaler_type type;
+   const char *name;
+} bench_types[] = {
+   { SCALER_TYPE_POINT,    "point"    },
+   { SCALER_TYPE_BILINEAR, "bilinear" },
+   { SCALER_TYPE_SINC,     "sinc"     },
+};
+
+static const struct
+{
+   enum scaler_pix_fmt fmt;
+   int bpp;
+   const char *name;
+} bench_fmts[] = {
+   { SCALER_FMT_ARGB8888, 4, "argb8888" },
+   { SCALER_FMT_RGB565,   2, "rgb565"   },
+};
+
+static const unsigned bench_threads[] = { 1, 2, 4 };
+
+static double bench_time(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static unsigned bench_simd(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      return CONV_SIMD_AVX2;
+#endif
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+   return CONV_SIMD_NEON;
+#endif
+   return 0;
+}
+
+/* Returns milliseconds per frame, or a negative value on failure. */
+static double bench_run(const struct bench_size *size,
+      enum scaler_type type, enum scaler_pix_fmt fmt, int bpp,
+      unsigned threads, unsigned frames)
+{
+   unsigned i;
+   double start;
+   double ms           = -1.0;
+   struct scaler_ctx ctx;
+   uint8_t *input      = (uint8_t*)malloc(
+         (size_t)size->in_width * size->in_height * bpp);
+   uint32_t *output    = (uint32_t*)malloc(
+         (size_t)size->out_width * size->out_height * sizeof(uint32_t));
+
+   memset(&ctx, 0, sizeof(ctx));
+
+   if (!input || !output)
+      goto end;
+
+   for (i = 0; i < (unsigned)(size->in_width * size->in_height * bpp); i++)
+      input[i] = rand();
+
+   ctx.in_width    = size->in_width;
+   ctx.in_height   = size->in_height;
+   ctx.in_stride   = size->in_width * bpp;
+   ctx.in_fmt      = fmt;
+   ctx.out_width   = size->out_width;
+   ctx.out_height  = size->out_height;
+   ctx.out_stride  = size->out_width * sizeof(uint32_t);
+   ctx.out_fmt     = SCALER_FMT_ARGB8888;
+   ctx.scaler_type = type;
+   ctx.threads     = threads;
+
+   if (!scaler_ctx_gen_filter(&ctx))
+      goto end;
+
+   /* Warms the caches and spawns the workers. */
+   scaler_ctx_scale(&ctx, output, input);
+
+   start = bench_time();
+   for (i = 0; i < frames; i++)
+      scaler_ctx_scale(&ctx, output, input);
+   ms = (bench_time() - start) * 1000.0 / frames;
+
+end:
+   scaler_ctx_gen_reset(&ctx);
+   free(input);
+   free(output);
+   return ms;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned s, t, f, n, pass;
+   unsigned frames = argc > 1 ? strtoul(argv[1], NULL, 0) : 100;
+   unsigned simd   = bench_simd();
+
+   if (!frames)
+      frames = 1;
+
+   printf("%-20s %-9s %-9s %-8s", "size", "type", "format", "kernels");
+   for (n = 0; n < sizeof(bench_threads) / sizeof(bench_threads[0]); n++)
+      printf(" %6u thr", bench_threads[n]);
+   printf("\n");
+
+   for (s = 0; s < sizeof(bench_sizes) / sizeof(bench_sizes[0]); s++)
+   {
+      const struct bench_size *size = &bench_sizes[s];
+
+      for (t = 0; t < sizeof(bench_types) / sizeof(bench_types[0]); t++)
+      {
+         for (f = 0; f < sizeof(bench_fmts) / sizeof(bench_fmts[0]); f++)
+         {
+            for (pass = 0; pass < (simd ? 2 : 1); pass++)
+            {
+               char dims[32];
+
+               snprintf(dims, sizeof(dims), "%dx%d->%dx%d",
+                     size->in_width, size->in_height,
+                     size->out_width, size->out_height);
+
+               scaler_init_simd(pass ? simd : 0);
+
+               printf("%-20s %-9s %-9s %-8s", dims, bench_types[t].name,
+                     bench_fmts[f].name, pass ? "simd" : "generic");
+
+               for (n = 0; n < sizeof(bench_threads) / sizeof(bench_threads[0]); n++)
+               {
+                  double ms = bench_run(size, bench_types[t].type,
+                        bench_fmts[f].fmt, bench_fmts[f].bpp,
+                        bench_threads[n], frames);
+
+                  if (ms < 0.0)
+                     printf(" %10s", "failed");
+                  else
+                     printf(" %7.3f ms", ms);
+               }
+               printf("\n");
+            }
+         }
+      }
+   }
+
+   return 0;
+}
@@ -32,13 +32,20 @@
 
 static bool allocate_filters(struct scaler_ctx *ctx)
 {
-   ctx->horiz.filter     = (int16_t*)scaler_alloc(sizeof(int16_t), ctx->horiz.filter_stride * ctx->out_width);
-   ctx->horiz.filter_pos = (int*)scaler_alloc(sizeof(int), ctx->out_width);
-
-   ctx->vert.filter      = (int16_t*)scaler_alloc(sizeof(int16_t), ctx->vert.filter_stride * ctx->out_height);
-   ctx->vert.filter_pos  = (int*)scaler_alloc(sizeof(int), ctx->out_height);
-
-   return ctx->horiz.filter && ctx->vert.filter;
+   ctx->horiz.filter     = (int16_t*)scaler_realloc(ctx->horiz.filter,
+         &ctx->horiz.filter_size, sizeof(int16_t),
+         ctx->horiz.filter_stride * ctx->out_width);
+   ctx->horiz.filter_pos = (int*)scaler_realloc(ctx->horiz.filter_pos,
+         &ctx->horiz.filter_pos_size, sizeof(int), ctx->out_width);
+
+   ctx->vert.filter      = (int16_t*)scaler_realloc(ctx->vert.filter,
+         &ctx->vert.filter_size, sizeof(int16_t),
+         ctx->vert.filter_stride * ctx->out_height);
+   ctx->vert.filter_pos  = (int*)scaler_realloc(ctx->vert.filter_pos,
+         &ctx->vert.filter_pos_size, sizeof(int), ctx->out_height);
+
+   return ctx->horiz.filter && ctx->horiz.filter_pos
+      && ctx->vert.filter && ctx->vert.filter_pos;
 }
 
 static void gen_filter_point_sub(struct scaler_filter *filter,
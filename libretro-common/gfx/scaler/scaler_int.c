@@ -21,6 +21,7 @@
  */
 
 #include <gfx/scaler/scaler_int.h>
+#include <gfx/scaler/pixconv.h>
 
 #include <retro_inline.h>
 
@@ -35,6 +36,18 @@
 #endif
 #endif
 
+#if !defined(SCALER_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) \
+   && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define SCALER_HAVE_AVX2
+#define SCALER_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#if !defined(SCALER_NO_SIMD) && (defined(__ARM_NEON__) || defined(__aarch64__))
+#define SCALER_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
 /* ARGB8888 scaler is split in two:
  *
  * First, horizontal scaler is applied.
@@ -53,61 +66,76 @@
  * The C version of scalers perform the exact same operations as the SIMD code for testing purposes.
  */
 
+
+/* All kernels work on the rows [first, last) of their output,
+ * which lets scaler_ctx_scale() split a frame into bands. The
+ * vertical kernels walk a whole output row per filter tap, so
+ * the SIMD versions handle several adjacent pixels at once. */
+
+typedef void (*scaler_horiz_func_t)(const struct scaler_ctx*,
+      const void*, int, int, int);
+typedef void (*scaler_vert_func_t)(const struct scaler_ctx*,
+      void*, int, int, int);
+
 #if defined(__SSE2__)
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+static void scaler_argb8888_vert_generic(const struct scaler_ctx *ctx,
+      void *output_, int stride, int first, int last)
 {
    int h, w, y;
-   const uint64_t *input = ctx->scaled.frame;
-   uint32_t      *output = (uint32_t*)output_;
-
-   const int16_t *filter_vert = ctx->vert.filter;
+   const int scaled_stride    = ctx->scaled.stride >> 3;
+   uint32_t *output           = (uint32_t*)output_ + first * (stride >> 2);
+   const int16_t *filter_vert = ctx->vert.filter + first * ctx->vert.filter_stride;
 
-   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   for (h = first; h < last; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+      const uint64_t *input_base = ctx->scaled.frame + ctx->vert.filter_pos[h] * scaled_stride;
 
-      for (w = 0; w < ctx->out_width; w++)
+      for (w = 0; (w + 1) < ctx->out_width; w += 2)
       {
-         __m128i final;
          __m128i res = _mm_setzero_si128();
-
          const uint64_t *input_base_y = input_base + w;
 
-         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += scaled_stride)
          {
-            __m128i coeff = _mm_set_epi64x(filter_vert[y + 1] * 0x0001000100010001ll, filter_vert[y + 0] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
+            __m128i coeff = _mm_set1_epi16(filter_vert[y]);
+            __m128i col   = _mm_loadu_si128((const __m128i*)input_base_y);
 
             res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
          }
 
-         for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
+         res = _mm_srai_epi16(res, (7 - 2 - 2));
+         _mm_storel_epi64((__m128i*)(output + w), _mm_packus_epi16(res, res));
+      }
+
+      for (; w < ctx->out_width; w++)
+      {
+         __m128i res = _mm_setzero_si128();
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += scaled_stride)
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_vert[y] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
+            __m128i coeff = _mm_set1_epi16(filter_vert[y]);
+            __m128i col   = _mm_loadl_epi64((const __m128i*)input_base_y);
 
             res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
          }
 
-         res       = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
          res       = _mm_srai_epi16(res, (7 - 2 - 2));
-
-         final     = _mm_packus_epi16(res, res);
-
-         output[w] = _mm_cvtsi128_si32(final);
+         output[w] = _mm_cvtsi128_si32(_mm_packus_epi16(res, res));
       }
    }
 }
 #else
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+static void scaler_argb8888_vert_generic(const struct scaler_ctx *ctx,
+      void *output_, int stride, int first, int last)
 {
    int h, w, y;
    const uint64_t      *input = ctx->scaled.frame;
-   uint32_t           *output = (uint32_t*)output_;
+   uint32_t           *output = (uint32_t*)output_ + first * (stride >> 2);
 
-   const int16_t *filter_vert = ctx->vert.filter;
+   const int16_t *filter_vert = ctx->vert.filter + first * ctx->vert.filter_stride;
 
-   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   for (h = first; h < last; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
    {
       const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
 
@@ -148,13 +176,14 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 #endif
 
 #if defined(__SSE2__)
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+static void scaler_argb8888_horiz_generic(const struct scaler_ctx *ctx,
+      const void *input_, int stride, int first, int last)
 {
    int h, w, x;
-   const uint32_t *input = (const uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
+   const uint32_t *input = (const uint32_t*)input_ + first * (stride >> 2);
+   uint64_t *output      = ctx->scaled.frame + first * (ctx->scaled.stride >> 3);
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   for (h = first; h < last; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
    {
       const int16_t *filter_horiz = ctx->horiz.filter;
 
@@ -166,7 +195,9 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 
          for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
          {
-            __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
+            __m128i coeff = _mm_unpacklo_epi64(
+                  _mm_set1_epi16(filter_horiz[x + 0]),
+                  _mm_set1_epi16(filter_horiz[x + 1]));
 
             __m128i col = _mm_unpacklo_epi8(_mm_set_epi64x(0,
                      ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
@@ -177,7 +208,8 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 
          for (; x < ctx->horiz.filter_len; x++)
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
+            __m128i coeff = _mm_unpacklo_epi64(
+                  _mm_set1_epi16(filter_horiz[x]), _mm_setzero_si128());
             __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
 
             col = _mm_slli_epi16(col, 7);
@@ -207,13 +239,14 @@ static INLINE uint64_t build_argb64(uint16_t a, uint16_t r, uint16_t g, uint16_t
    return ((uint64_t)a << 48) | ((uint64_t)r << 32) | ((uint64_t)g << 16) | ((uint64_t)b << 0);
 }
 
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+static void scaler_argb8888_horiz_generic(const struct scaler_ctx *ctx,
+      const void *input_, int stride, int first, int last)
 {
    int h, w, x;
-   const uint32_t *input = (uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
+   const uint32_t *input = (const uint32_t*)input_ + first * (stride >> 2);
+   uint64_t *output      = ctx->scaled.frame + first * (ctx->scaled.stride >> 3);
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   for (h = first; h < last; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
    {
       const int16_t *filter_horiz = ctx->horiz.filter;
 
@@ -249,11 +282,294 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 }
 #endif
 
+#if defined(SCALER_HAVE_AVX2)
+/* Two output pixels per iteration, one per 128-bit lane.
+ * Each lane does what the SSE2 version does for one pixel. */
+static SCALER_AVX2 void scaler_argb8888_horiz_avx2(const struct scaler_ctx *ctx,
+      const void *input_, int stride, int first, int last)
+{
+   int h, w, x;
+   const __m256i expand  = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+   const uint32_t *input = (const uint32_t*)input_ + first * (stride >> 2);
+   uint64_t *output      = ctx->scaled.frame + first * (ctx->scaled.stride >> 3);
+   const int len         = ctx->horiz.filter_len;
+
+   for (h = first; h < last; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      for (w = 0; (w + 1) < ctx->scaled.width; w += 2,
+            filter_horiz += 2 * ctx->horiz.filter_stride)
+      {
+         __m256i res;
+         __m256i sum             = _mm256_setzero_si256();
+         const int16_t *filter_n = filter_horiz + ctx->horiz.filter_stride;
+         const uint32_t *base0   = input + ctx->horiz.filter_pos[w + 0];
+         const uint32_t *base1   = input + ctx->horiz.filter_pos[w + 1];
+
+         for (x = 0; (x + 1) < len; x += 2)
+         {
+            __m128i px    = _mm_unpacklo_epi64(
+                  _mm_loadl_epi64((const __m128i*)(base0 + x)),
+                  _mm_loadl_epi64((const __m128i*)(base1 + x)));
+            __m256i coeff = _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(
+                     _mm_unpacklo_epi16(_mm_set_epi16(0, 0, 0, 0,
+                           filter_n[x + 1], filter_n[x],
+                           filter_horiz[x + 1], filter_horiz[x]),
+                        _mm_set_epi16(0, 0, 0, 0,
+                           filter_n[x + 1], filter_n[x],
+                           filter_horiz[x + 1], filter_horiz[x]))), expand);
+            __m256i col   = _mm256_slli_epi16(_mm256_cvtepu8_epi16(px), 7);
+
+            sum = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), sum);
+         }
+
+         for (; x < len; x++)
+         {
+            __m128i px    = _mm_unpacklo_epi64(
+                  _mm_cvtsi32_si128(base0[x]), _mm_cvtsi32_si128(base1[x]));
+            __m256i coeff = _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(
+                     _mm_unpacklo_epi16(_mm_set_epi16(0, 0, 0, 0,
+                           0, filter_n[x], 0, filter_horiz[x]),
+                        _mm_set_epi16(0, 0, 0, 0,
+                           0, filter_n[x], 0, filter_horiz[x]))), expand);
+            __m256i col   = _mm256_slli_epi16(_mm256_cvtepu8_epi16(px), 7);
+
+            sum = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), sum);
+         }
+
+         res = _mm256_adds_epi16(_mm256_srli_si256(sum, 8), sum);
+         _mm_storeu_si128((__m128i*)(output + w), _mm256_castsi256_si128(
+                  _mm256_permute4x64_epi64(res, 0x08)));
+      }
+
+      for (; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
+      {
+         __m128i res = _mm_setzero_si128();
+         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+
+         for (x = 0; (x + 1) < len; x += 2)
+         {
+            __m128i coeff = _mm_unpacklo_epi64(
+                  _mm_set1_epi16(filter_horiz[x + 0]),
+                  _mm_set1_epi16(filter_horiz[x + 1]));
+            __m128i col   = _mm_slli_epi16(_mm_cvtepu8_epi16(
+                     _mm_loadl_epi64((const __m128i*)(input_base_x + x))), 7);
+
+            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+         }
+
+         for (; x < len; x++)
+         {
+            __m128i coeff = _mm_unpacklo_epi64(
+                  _mm_set1_epi16(filter_horiz[x]), _mm_setzero_si128());
+            __m128i col   = _mm_slli_epi16(_mm_cvtepu8_epi16(
+                     _mm_cvtsi32_si128(input_base_x[x])), 7);
+
+            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+         }
+
+         res = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+         _mm_storel_epi64((__m128i*)(output + w), res);
+      }
+   }
+}
+
+static SCALER_AVX2 void scaler_argb8888_vert_avx2(const struct scaler_ctx *ctx,
+      void *output_, int stride, int first, int last)
+{
+   int h, w, y;
+   const int scaled_stride    = ctx->scaled.stride >> 3;
+   uint32_t *output           = (uint32_t*)output_ + first * (stride >> 2);
+   const int16_t *filter_vert = ctx->vert.filter + first * ctx->vert.filter_stride;
+
+   for (h = first; h < last; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   {
+      const uint64_t *input_base = ctx->scaled.frame + ctx->vert.filter_pos[h] * scaled_stride;
+
+      for (w = 0; (w + 3) < ctx->out_width; w += 4)
+      {
+         __m256i res = _mm256_setzero_si256();
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += scaled_stride)
+         {
+            __m256i coeff = _mm256_set1_epi16(filter_vert[y]);
+            __m256i col   = _mm256_loadu_si256((const __m256i*)input_base_y);
+
+            res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         res = _mm256_srai_epi16(res, (7 - 2 - 2));
+         res = _mm256_permute4x64_epi64(_mm256_packus_epi16(res, res), 0x08);
+         _mm_storeu_si128((__m128i*)(output + w), _mm256_castsi256_si128(res));
+      }
+
+      for (; w < ctx->out_width; w++)
+      {
+         __m128i res = _mm_setzero_si128();
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += scaled_stride)
+         {
+            __m128i coeff = _mm_set1_epi16(filter_vert[y]);
+            __m128i col   = _mm_loadl_epi64((const __m128i*)input_base_y);
+
+            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+         }
+
+         res       = _mm_srai_epi16(res, (7 - 2 - 2));
+         output[w] = _mm_cvtsi128_si32(_mm_packus_epi16(res, res));
+      }
+   }
+}
+#endif
+
+#if defined(SCALER_HAVE_NEON)
+/* Same as _mm_mulhi_epi16(). */
+static INLINE int16x4_t mulhi_s16_neon(int16x4_t a, int16_t b)
+{
+   return vshrn_n_s32(vmull_n_s16(a, b), 16);
+}
+
+static void scaler_argb8888_horiz_neon(const struct scaler_ctx *ctx,
+      const void *input_, int stride, int first, int last)
+{
+   int h, w, x;
+   const uint32_t *input = (const uint32_t*)input_ + first * (stride >> 2);
+   uint64_t *output      = ctx->scaled.frame + first * (ctx->scaled.stride >> 3);
+
+   for (h = first; h < last; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
+      {
+         int16x4_t even = vdup_n_s16(0);
+         int16x4_t odd  = vdup_n_s16(0);
+         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+
+         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         {
+            int16x8_t col = vreinterpretq_s16_u16(vshll_n_u8(
+                     vld1_u8((const uint8_t*)(input_base_x + x)), 7));
+
+            even = vqadd_s16(mulhi_s16_neon(vget_low_s16(col),  filter_horiz[x + 0]), even);
+            odd  = vqadd_s16(mulhi_s16_neon(vget_high_s16(col), filter_horiz[x + 1]), odd);
+         }
+
+         for (; x < ctx->horiz.filter_len; x++)
+         {
+            int16x8_t col = vreinterpretq_s16_u16(vshll_n_u8(vreinterpret_u8_u32(
+                        vdup_n_u32(input_base_x[x])), 7));
+
+            even = vqadd_s16(mulhi_s16_neon(vget_low_s16(col), filter_horiz[x]), even);
+         }
+
+         vst1_s16((int16_t*)(output + w), vqadd_s16(odd, even));
+      }
+   }
+}
+
+static void scaler_argb8888_vert_neon(const struct scaler_ctx *ctx,
+      void *output_, int stride, int first, int last)
+{
+   int h, w, y;
+   const int scaled_stride    = ctx->scaled.stride >> 3;
+   uint32_t *output           = (uint32_t*)output_ + first * (stride >> 2);
+   const int16_t *filter_vert = ctx->vert.filter + first * ctx->vert.filter_stride;
+
+   for (h = first; h < last; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   {
+      const uint64_t *input_base = ctx->scaled.frame + ctx->vert.filter_pos[h] * scaled_stride;
+
+      for (w = 0; (w + 3) < ctx->out_width; w += 4)
+      {
+         int16x4_t res[4];
+         unsigned i;
+         const uint64_t *input_base_y = input_base + w;
+
+         for (i = 0; i < 4; i++)
+            res[i] = vdup_n_s16(0);
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += scaled_stride)
+         {
+            const int16_t *col = (const int16_t*)input_base_y;
+
+            for (i = 0; i < 4; i++)
+               res[i] = vqadd_s16(mulhi_s16_neon(vld1_s16(col + i * 4), filter_vert[y]), res[i]);
+         }
+
+         vst1q_u8((uint8_t*)(output + w), vcombine_u8(
+                  vqmovun_s16(vshrq_n_s16(vcombine_s16(res[0], res[1]), (7 - 2 - 2))),
+                  vqmovun_s16(vshrq_n_s16(vcombine_s16(res[2], res[3]), (7 - 2 - 2)))));
+      }
+
+      for (; w < ctx->out_width; w++)
+      {
+         int16x4_t res = vdup_n_s16(0);
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += scaled_stride)
+            res = vqadd_s16(mulhi_s16_neon(vld1_s16((const int16_t*)input_base_y), filter_vert[y]), res);
+
+         res       = vshr_n_s16(res, (7 - 2 - 2));
+         output[w] = vget_lane_u32(vreinterpret_u32_u8(
+                  vqmovun_s16(vcombine_s16(res, res))), 0);
+      }
+   }
+}
+#endif
+
+static scaler_horiz_func_t scaler_horiz_impl = scaler_argb8888_horiz_generic;
+static scaler_vert_func_t  scaler_vert_impl  = scaler_argb8888_vert_generic;
+
+/**
+ * scaler_argb8888_init_simd:
+ * @simd                : Bitmask of CONV_SIMD_* flags.
+ *
+ * Selects the kernels behind scaler_argb8888_horiz()
+ * and scaler_argb8888_vert().
+ **/
+void scaler_argb8888_init_simd(unsigned simd)
+{
+   scaler_horiz_impl = scaler_argb8888_horiz_generic;
+   scaler_vert_impl  = scaler_argb8888_vert_generic;
+
+#if defined(SCALER_HAVE_AVX2)
+   if (simd & CONV_SIMD_AVX2)
+   {
+      scaler_horiz_impl = scaler_argb8888_horiz_avx2;
+      scaler_vert_impl  = scaler_argb8888_vert_avx2;
+   }
+#endif
+#if defined(SCALER_HAVE_NEON)
+   if (simd & CONV_SIMD_NEON)
+   {
+      scaler_horiz_impl = scaler_argb8888_horiz_neon;
+      scaler_vert_impl  = scaler_argb8888_vert_neon;
+   }
+#endif
+}
+
+void scaler_argb8888_vert(const struct scaler_ctx *ctx,
+      void *output, int stride, int first, int last)
+{
+   scaler_vert_impl(ctx, output, stride, first, last);
+}
+
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
+      const void *input, int stride, int first, int last)
+{
+   scaler_horiz_impl(ctx, input, stride, first, last);
+}
+
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
       void *output_, const void *input_,
       int out_width, int out_height,
       int in_width, int in_height,
-      int out_stride, int in_stride)
+      int out_stride, int in_stride,
+      int first, int last)
 {
    int h, w;
    const uint32_t *input = NULL;
@@ -270,10 +586,11 @@ void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
    if (y_pos < 0)
       y_pos = 0;
 
-   input = (const uint32_t*)input_;
-   output = (uint32_t*)output_;
+   input  = (const uint32_t*)input_;
+   output = (uint32_t*)output_ + first * (out_stride >> 2);
+   y_pos += first * y_step;
 
-   for (h = 0; h < out_height; h++, y_pos += y_step, output += out_stride >> 2)
+   for (h = first; h < last; h++, y_pos += y_step, output += out_stride >> 2)
    {
       int x = x_pos;
       const uint32_t *inp = input + (y_pos >> 16) * (in_stride >> 2);
@@ -282,4 +599,3 @@ void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
          output[w] = inp[x >> 16];
    }
 }
-
@@ -34,4 +34,6 @@ size_t utf8_conv_utf32(uint32_t *out, size_t out_chars,
 bool utf16_conv_utf8(uint8_t *out, size_t *out_chars,
       const uint16_t *in, size_t in_size);
 
+uint32_t utf8_walk(const char **string);
+
 #endif
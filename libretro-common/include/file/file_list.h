@@ -50,6 +50,10 @@ typedef struct file_list
 
    size_t capacity;
    size_t size;
+
+   /* Set by file_list_sort_on_alt() and cleared by anything
+    * that may break the order. Lets searches bisect. */
+   bool sorted_on_alt;
 } file_list_t;
 
 
@@ -25,6 +25,12 @@
 
 #include <clamping.h>
 
+/* SIMD paths conv_init_simd() can select. */
+#define CONV_SIMD_AVX2 (1 << 0)
+#define CONV_SIMD_NEON (1 << 1)
+
+void conv_init_simd(unsigned simd);
+
 void conv_0rgb1555_argb8888(void *output, const void *input,
       int width, int height,
       int out_stride, int in_stride);
@@ -59,6 +59,10 @@ struct scaler_filter
    int filter_len;
    int filter_stride;
    int *filter_pos;
+
+   /* Allocated element counts, kept across scaler_ctx_gen_filter(). */
+   size_t filter_size;
+   size_t filter_pos_size;
 };
 
 struct scaler_ctx
@@ -75,12 +79,17 @@ struct scaler_ctx
    enum scaler_pix_fmt out_fmt;
    enum scaler_type scaler_type;
 
+   /* Number of threads scaler_ctx_scale() may split a frame
+    * across, including the caller. 0 or 1 keeps it on the
+    * calling thread. Only honored with HAVE_THREADS. */
+   unsigned threads;
+
    void (*scaler_horiz)(const struct scaler_ctx*,
-         const void*, int);
+         const void*, int, int, int);
    void (*scaler_vert)(const struct scaler_ctx*,
-         void*, int);
+         void*, int, int, int);
    void (*scaler_special)(const struct scaler_ctx*,
-         void*, const void*, int, int, int, int, int, int);
+         void*, const void*, int, int, int, int, int, int, int, int);
 
    void (*in_pixconv)(void*, const void*, int, int, int, int);
    void (*out_pixconv)(void*, const void*, int, int, int, int);
@@ -93,6 +102,7 @@ struct scaler_ctx
    {
       uint32_t *frame;
       int stride;
+      size_t size;
    } input;
 
    struct
@@ -101,17 +111,47 @@ struct scaler_ctx
       int width;
       int height;
       int stride;
+      size_t size;
    } scaled;
 
    struct
    {
       uint32_t *frame;
       int stride;
+      size_t size;
    } output;
+
+   /* Worker threads, created on first threaded scale. */
+   void *pool;
 };
 
+/**
+ * scaler_init_simd:
+ * @simd         : Bitmask of CONV_SIMD_* flags.
+ *
+ * Selects the SIMD pixel converters and resampling
+ * kernels used by every scaler context.
+ **/
+void scaler_init_simd(unsigned simd);
+
+/**
+ * scaler_ctx_gen_filter:
+ * @ctx          : pointer to scaler context object.
+ *
+ * (Re)generates the filters for the current dimensions and
+ * formats. Buffers from a previous call are reused when they
+ * are large enough.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
 bool scaler_ctx_gen_filter(struct scaler_ctx *ctx);
 
+/**
+ * scaler_ctx_gen_reset:
+ * @ctx          : pointer to scaler context object.
+ *
+ * Frees all buffers and worker threads owned by @ctx.
+ **/
 void scaler_ctx_gen_reset(struct scaler_ctx *ctx);
 
 /**
@@ -137,6 +177,22 @@ void scaler_ctx_scale(struct scaler_ctx *ctx,
  **/
 void *scaler_alloc(size_t elem_size, size_t size);
 
+/**
+ * scaler_realloc:
+ * @ptr          : pointer to a buffer from scaler_alloc(), or NULL.
+ * @capacity     : number of elements @ptr holds. Updated on return.
+ * @elem_size    : size of the elements to be used.
+ * @size         : number of elements needed.
+ *
+ * Grows a scaler buffer if it holds fewer than @size elements.
+ * The first @size elements are cleared either way.
+ *
+ * Returns: pointer to the buffer, or NULL on failure, in which
+ * case the old buffer has been freed.
+ **/
+void *scaler_realloc(void *ptr, size_t *capacity,
+      size_t elem_size, size_t size);
+
 /**
  * scaler_free:
  * @ptr          : pointer to scaler object.
@@ -44,6 +44,10 @@ bool path_is_valid(const char *path);
 
 int32_t path_get_size(const char *path);
 
+int64_t path_get_mtime(const char *path);
+
+bool path_stat(const char *path, int32_t *size, int64_t *mtime);
+
 /**
  * path_mkdir_norecurse:
  * @dir                : directory
@@ -37,6 +37,29 @@
 
 struct retro_callbacks retro_ctx;
 
+/* Video refresh callback the core was last handed. Code that
+ * swaps in its own for a while, like movie seeking, puts this
+ * one back after. */
+static retro_video_refresh_t retro_video_refresh_cb;
+
+/**
+ * retro_set_video_refresh:
+ * @cb             : video refresh callback.
+ *
+ * Hands @cb to the core and remembers it, see
+ * retro_get_video_refresh().
+ **/
+void retro_set_video_refresh(retro_video_refresh_t cb)
+{
+   retro_video_refresh_cb = cb;
+   core.retro_set_video_refresh(cb);
+}
+
+retro_video_refresh_t retro_get_video_refresh(void)
+{
+   return retro_video_refresh_cb;
+}
+
 /**
  * retro_set_default_callbacks:
  * @data           : pointer to retro_callbacks object
@@ -66,6 +89,8 @@ void retro_uninit_libretro_cbs(void)
    cbs->sample_batch_cb = NULL;
    cbs->state_cb        = NULL;
    cbs->poll_cb         = NULL;
+
+   retro_video_refresh_cb = NULL;
 }
 
 /**
@@ -85,7 +110,7 @@ void retro_init_libretro_cbs(void *data)
 
    (void)global;
 
-   core.retro_set_video_refresh(video_driver_frame);
+   retro_set_video_refresh(video_driver_frame);
    core.retro_set_audio_sample(audio_driver_sample);
    core.retro_set_audio_sample_batch(audio_driver_sample_batch);
    core.retro_set_input_state(input_state);
@@ -106,7 +131,7 @@ void retro_init_libretro_cbs(void *data)
    }
    else
    {
-      core.retro_set_video_refresh(video_frame_net);
+      retro_set_video_refresh(video_frame_net);
       core.retro_set_audio_sample(audio_sample_net);
       core.retro_set_audio_sample_batch(audio_sample_batch_net);
       core.retro_set_input_state(input_state_net);
@@ -52,6 +52,23 @@ void retro_init_libretro_cbs(void *data);
  **/
 void retro_set_default_callbacks(void *data);
 
+/**
+ * retro_set_video_refresh:
+ * @cb             : video refresh callback.
+ *
+ * Hands @cb to the core and remembers it, see
+ * retro_get_video_refresh().
+ **/
+void retro_set_video_refresh(retro_video_refresh_t cb);
+
+/**
+ * retro_get_video_refresh:
+ *
+ * Returns: the video refresh callback last set
+ * with retro_set_video_refresh().
+ **/
+retro_video_refresh_t retro_get_video_refresh(void);
+
 /**
  * retro_set_rewind_callbacks:
  *
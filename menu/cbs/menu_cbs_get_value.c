@@ -430,11 +430,28 @@ static void menu_action_setting_disp_set_label_perf_counters_common(
       unsigned offset, char *s, size_t len
       )
 {
+   struct retro_perf_stats stats;
+
    if (!counters[offset])
       return;
    if (!counters[offset]->call_cnt)
       return;
 
+   if (retro_perf_get_stats(counters[offset], &stats))
+   {
+      snprintf(s, len,
+#ifdef _WIN32
+            "%I64u/%I64u/%I64u ticks, %I64u runs.",
+#else
+            "%llu/%llu/%llu ticks, %llu runs.",
+#endif
+            (unsigned long long)stats.p50,
+            (unsigned long long)stats.p95,
+            (unsigned long long)stats.p99,
+            (unsigned long long)counters[offset]->call_cnt);
+      return;
+   }
+
    snprintf(s, len,
 #ifdef _WIN32
          "%I64u ticks, %I64u runs.",
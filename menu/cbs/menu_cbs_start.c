@@ -68,10 +68,7 @@ static int generic_action_start_performance_counters(struct retro_perf_counter *
       unsigned offset, unsigned type, const char *label)
 {
    if (counters[offset])
-   {
-      counters[offset]->total    = 0;
-      counters[offset]->call_cnt = 0;
-   }
+      retro_perf_reset(counters[offset]);
 
    return 0;
 }
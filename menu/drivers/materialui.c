@@ -35,6 +35,7 @@
 #include "../menu_navigation.h"
 #include "../menu_hash.h"
 #include "../menu_display.h"
+#include "../menu_thumbnail.h"
 
 #include "../../core_info.h"
 #include "../../configuration.h"
@@ -92,8 +93,12 @@ typedef struct mui_handle
       struct mui_texture_item bg;
       struct mui_texture_item list[MUI_TEXTURE_LAST];
       uintptr_t white;
+      uintptr_t boxart;
    } textures;
 
+   float boxart_width;
+   float boxart_height;
+
    struct
    {
       struct
@@ -198,6 +203,37 @@ static void mui_draw_icon(mui_handle_t *mui,
 }
 
 
+static void mui_draw_boxart(mui_handle_t *mui,
+      unsigned width, unsigned height, float *color)
+{
+   struct gfx_coords coords;
+   math_matrix_4x4 mymat;
+   unsigned header_height;
+   float x = width - mui->boxart_width - mui->margin;
+
+   menu_display_ctl(MENU_DISPLAY_CTL_HEADER_HEIGHT, &header_height);
+
+   menu_display_ctl(MENU_DISPLAY_CTL_BLEND_BEGIN, NULL);
+
+   menu_display_matrix_4x4_rotate_z(&mymat, 0, 1, 1, 1, true);
+
+   coords.vertices      = 4;
+   coords.vertex        = NULL;
+   coords.tex_coord     = NULL;
+   coords.lut_tex_coord = NULL;
+   coords.color         = (const float*)color;
+
+   menu_display_draw(
+         x,
+         height - header_height - mui->margin - mui->boxart_height,
+         mui->boxart_width,
+         mui->boxart_height,
+         &coords, &mymat, mui->textures.boxart,
+         MENU_DISPLAY_PRIM_TRIANGLESTRIP);
+
+   menu_display_ctl(MENU_DISPLAY_CTL_BLEND_END, NULL);
+}
+
 static void mui_draw_tab(mui_handle_t *mui,
       unsigned i,
       unsigned width, unsigned height,
@@ -573,13 +609,18 @@ static void mui_render_menu_list(mui_handle_t *mui,
 {
    unsigned header_height;
    uint64_t *frame_count;
-   size_t i                = 0;
-   size_t          end     = menu_entries_get_end();
+   size_t selection;
+   size_t i                   = 0;
+   size_t          end        = menu_entries_get_end();
+   file_list_t *selection_buf = menu_entries_get_selection_buf_ptr(0);
    video_driver_ctl(RARCH_DISPLAY_CTL_GET_FRAME_COUNT, &frame_count);
 
    if (!menu_display_ctl(MENU_DISPLAY_CTL_UPDATE_PENDING, NULL))
       return;
 
+   if (!menu_navigation_ctl(MENU_NAVIGATION_CTL_GET_SELECTION, &selection))
+      return;
+
    menu_display_ctl(MENU_DISPLAY_CTL_HEADER_HEIGHT, &header_height);
 
    mui->list_block.carr.coords.vertices = 0;
@@ -589,20 +630,20 @@ static void mui_render_menu_list(mui_handle_t *mui,
    for (; i < end; i++)
    {
       int y;
-      size_t selection;
       bool entry_selected;
       menu_entry_t entry;
 
-      if (!menu_navigation_ctl(MENU_NAVIGATION_CTL_GET_SELECTION, &selection))
-         continue;
-
       y = header_height - mui->scroll_y + (mui->line_height * i);
 
-      if ((y - (int)mui->line_height) > (int)height
-            || ((y + (int)mui->line_height) < 0))
+      /* Rows are laid out top to bottom, nothing
+       * further down can be visible. */
+      if ((y - (int)mui->line_height) > (int)height)
+         break;
+
+      if ((y + (int)mui->line_height) < 0)
          continue;
 
-      menu_entry_get(&entry, 0, i, NULL, true);
+      menu_entries_get_row(&entry, selection_buf, i);
 
       entry_selected = selection == i;
 
@@ -807,6 +848,9 @@ static void mui_frame(void *data)
    menu_display_ctl(MENU_DISPLAY_CTL_FONT_FLUSH_BLOCK, NULL);
    menu_animation_ctl(MENU_ANIMATION_CTL_SET_ACTIVE, NULL);
 
+   if (settings->menu.boxart_enable && mui->textures.boxart)
+      mui_draw_boxart(mui, width, height, &pure_white[0]);
+
    /* header */
    mui_render_quad(mui, 0, 0, width, header_height, width, height, &blue_bg[0]);
 
@@ -933,6 +977,7 @@ static void mui_layout(mui_handle_t *mui)
    mui->line_height     = scale_factor / 3;
    mui->margin          = scale_factor / 9;
    mui->icon_size       = scale_factor / 3;
+   mui->boxart_width    = width / 3;
 
    menu_display_ctl(MENU_DISPLAY_CTL_SET_HEADER_HEIGHT, &new_header_height);
    menu_display_ctl(MENU_DISPLAY_CTL_SET_FONT_SIZE,     &new_font_size);
@@ -1003,6 +1048,12 @@ static void mui_context_bg_destroy(mui_handle_t *mui)
    menu_display_texture_unload((uintptr_t*)&mui->textures.white);
 }
 
+static void mui_context_boxart_destroy(mui_handle_t *mui)
+{
+   menu_display_texture_unload(&mui->textures.boxart);
+   mui->textures.boxart = 0;
+}
+
 static void mui_context_destroy(void *data)
 {
    unsigned i;
@@ -1017,6 +1068,7 @@ static void mui_context_destroy(void *data)
    menu_display_free_main_font();
 
    mui_context_bg_destroy(mui);
+   mui_context_boxart_destroy(mui);
 }
 
 static bool mui_load_image(void *userdata, void *data, menu_image_type_t type)
@@ -1035,6 +1087,16 @@ static bool mui_load_image(void *userdata, void *data, menu_image_type_t type)
          mui_allocate_white_texture(mui);
          break;
       case MENU_IMAGE_BOXART:
+         {
+            struct texture_image *img = (struct texture_image*)data;
+
+            mui_context_boxart_destroy(mui);
+
+            mui->boxart_height   = mui->boxart_width
+               * (float)img->height / (float)img->width;
+            mui->textures.boxart = menu_display_texture_load(data,
+                  TEXTURE_FILTER_MIPMAP_LINEAR);
+         }
          break;
    }
 
@@ -1062,12 +1124,36 @@ static float mui_get_scroll(mui_handle_t *mui)
    return ((selection + 2 - half) * mui->line_height);
 }
 
+/* Shows the thumbnail of the selected playlist entry,
+ * hides it anywhere else. */
+static void mui_update_boxart(mui_handle_t *mui)
+{
+   size_t selection;
+   char system[PATH_MAX_LENGTH] = {0};
+   settings_t *settings         = config_get_ptr();
+
+   if (!settings->menu.boxart_enable)
+      return;
+   if (!menu_navigation_ctl(MENU_NAVIGATION_CTL_GET_SELECTION, &selection))
+      return;
+
+   if (!menu_thumbnail_get_system(system, sizeof(system))
+         || !menu_thumbnail_select(system, selection,
+            menu_entries_get_end()))
+      mui_context_boxart_destroy(mui);
+}
+
 static void mui_navigation_set(void *data, bool scroll)
 {
    mui_handle_t *mui    = (mui_handle_t*)data;
    float     scroll_pos = mui ? mui_get_scroll(mui) : 0.0f;
 
-   if (!mui || !scroll)
+   if (!mui)
+      return;
+
+   mui_update_boxart(mui);
+
+   if (!scroll)
       return;
 
    menu_animation_push(10, scroll_pos,
@@ -1088,6 +1174,10 @@ static void mui_navigation_clear(void *data, bool pending_push)
 
    menu_entries_ctl(MENU_ENTRIES_CTL_SET_START, &i);
    mui->scroll_y = 0;
+
+   /* Pushes are followed by populate_entries. */
+   if (!pending_push)
+      mui_update_boxart(mui);
 }
 
 static void mui_navigation_set_last(void *data)
@@ -1109,6 +1199,8 @@ static void mui_populate_entries(
       return;
 
    mui->scroll_y = mui_get_scroll(mui);
+
+   mui_update_boxart(mui);
 }
 
 static void mui_context_reset(void *data)
@@ -1131,6 +1223,8 @@ static void mui_context_reset(void *data)
 
    rarch_task_push_image_load(settings->menu.wallpaper, "cb_menu_wallpaper",
          menu_display_handle_wallpaper_upload, NULL);
+
+   mui_update_boxart(mui);
 }
 
 static int mui_environ(menu_environ_cb_t type, void *data, void *userdata)
@@ -25,6 +25,7 @@
 #include <string/string_list.h>
 #include <compat/posix_string.h>
 #include <file/file_path.h>
+#include <formats/image.h>
 #include <retro_inline.h>
 #include <string/stdstring.h>
 
@@ -37,6 +38,7 @@
 #include "../menu_display.h"
 #include "../menu_navigation.h"
 #include "../menu_hash.h"
+#include "../menu_thumbnail.h"
 
 #include "../../gfx/drivers_font_renderer/bitmap.h"
 
@@ -52,6 +54,11 @@ typedef struct
    unsigned last_width;
    unsigned last_height;
    float scroll_y;
+   /* Thumbnail of the selected playlist entry,
+    * already scaled and in framebuffer format. */
+   uint16_t *boxart;
+   unsigned boxart_width;
+   unsigned boxart_height;
 } rgui_t;
 
 #if defined(GEKKO)|| defined(PSP)
@@ -299,6 +306,119 @@ static void rgui_render_background(void)
          green_filler);
 }
 
+static uint16_t rgui_boxart_pixel(uint32_t col)
+{
+   unsigned a = ((col >> 24) & 0xff) >> 4;
+   unsigned r = ((col >> 16) & 0xff) >> 4;
+   unsigned g = ((col >> 8) & 0xff)  >> 4;
+   unsigned b =  (col & 0xff)        >> 4;
+#if defined(GEKKO) || defined(PSP)
+   return (a << 12) | (r << 8) | (g << 4) | b;
+#else
+   return (r << 12) | (g << 8) | (b << 4) | a;
+#endif
+}
+
+static void rgui_boxart_free(rgui_t *rgui)
+{
+   free(rgui->boxart);
+   rgui->boxart        = NULL;
+   rgui->boxart_width  = 0;
+   rgui->boxart_height = 0;
+}
+
+/* Scales @img down to fit the right third of the
+ * framebuffer, nearest neighbour is plenty at RGUI sizes. */
+static void rgui_boxart_load(rgui_t *rgui, const struct texture_image *img)
+{
+   unsigned x, y, fb_width, fb_height, max_width, max_height;
+   unsigned width, height;
+
+   rgui_boxart_free(rgui);
+
+   if (!img || !img->pixels || !img->width || !img->height)
+      return;
+
+   menu_display_ctl(MENU_DISPLAY_CTL_WIDTH,  &fb_width);
+   menu_display_ctl(MENU_DISPLAY_CTL_HEIGHT, &fb_height);
+
+   max_width  = fb_width / 3;
+   max_height = fb_height / 2;
+   width      = img->width;
+   height     = img->height;
+
+   if (width > max_width)
+   {
+      height = height * max_width / width;
+      width  = max_width;
+   }
+   if (height > max_height)
+   {
+      width  = width * max_height / height;
+      height = max_height;
+   }
+
+   if (!width || !height)
+      return;
+
+   rgui->boxart = (uint16_t*)malloc(width * height * sizeof(uint16_t));
+   if (!rgui->boxart)
+      return;
+
+   for (y = 0; y < height; y++)
+   {
+      const uint32_t *src = img->pixels + (y * img->height / height) * img->width;
+
+      for (x = 0; x < width; x++)
+         rgui->boxart[y * width + x] =
+            rgui_boxart_pixel(src[x * img->width / width]);
+   }
+
+   rgui->boxart_width  = width;
+   rgui->boxart_height = height;
+   rgui->force_redraw  = true;
+}
+
+static void rgui_render_boxart(rgui_t *rgui, uint16_t *fb_data,
+      size_t fb_pitch, unsigned fb_width, unsigned fb_height)
+{
+   unsigned y;
+   unsigned x_pos = fb_width - RGUI_TERM_START_X(fb_width) - rgui->boxart_width;
+   unsigned y_pos = RGUI_TERM_START_Y(fb_height);
+
+   if (rgui->boxart_width + RGUI_TERM_START_X(fb_width) > fb_width
+         || y_pos + rgui->boxart_height > fb_height)
+      return;
+
+   for (y = 0; y < rgui->boxart_height; y++)
+      memcpy(fb_data + (y_pos + y) * (fb_pitch >> 1) + x_pos,
+            rgui->boxart + y * rgui->boxart_width,
+            rgui->boxart_width * sizeof(uint16_t));
+}
+
+/* Requests the thumbnail of the selected playlist entry,
+ * hides it anywhere else. */
+static void rgui_update_boxart(rgui_t *rgui)
+{
+   size_t selection;
+   char system[PATH_MAX_LENGTH] = {0};
+   settings_t *settings         = config_get_ptr();
+
+   if (!settings->menu.boxart_enable)
+      return;
+   if (!menu_navigation_ctl(MENU_NAVIGATION_CTL_GET_SELECTION, &selection))
+      return;
+
+   if (!menu_thumbnail_get_system(system, sizeof(system))
+         || !menu_thumbnail_select(system, selection,
+            menu_entries_get_end()))
+   {
+      if (rgui->boxart)
+         rgui->force_redraw = true;
+      rgui_boxart_free(rgui);
+   }
+}
+
 static void rgui_set_message(void *data, const char *message)
 {
    rgui_t           *rgui = (rgui_t*)data;
@@ -622,6 +742,9 @@ static void rgui_render(void *data)
             entry_selected ? hover_color : normal_color);
    }
 
+   if (settings->menu.boxart_enable && rgui->boxart)
+      rgui_render_boxart(rgui, fb_data, fb_pitch, fb_width, fb_height);
+
    menu_input_ctl(MENU_INPUT_CTL_KEYBOARD_DISPLAY, &display_kb);
 
    if (display_kb)
@@ -715,6 +838,10 @@ static void rgui_free(void *data)
 {
    uint8_t *font_fb;
    bool fb_font_inited   = false;
+   rgui_t *rgui          = (rgui_t*)data;
+
+   if (rgui)
+      rgui_boxart_free(rgui);
 
    menu_display_ctl(MENU_DISPLAY_CTL_FONT_DATA_INIT, &fb_font_inited);
    menu_display_ctl(MENU_DISPLAY_CTL_FONT_FB, &font_fb);
@@ -756,6 +883,10 @@ static void rgui_navigation_clear(void *data, bool pending_push)
    start = 0;
    menu_entries_ctl(MENU_ENTRIES_CTL_SET_START, &start);
    rgui->scroll_y = 0;
+
+   /* Pushes are followed by populate_entries. */
+   if (!pending_push)
+      rgui_update_boxart(rgui);
 }
 
 static void rgui_navigation_set(void *data, bool scroll)
@@ -764,8 +895,14 @@ static void rgui_navigation_set(void *data, bool scroll)
    unsigned fb_width, fb_height;
    bool do_set_start              = false;
    size_t end                     = menu_entries_get_end();
+   rgui_t *rgui                   = (rgui_t*)data;
+
    if (!menu_navigation_ctl(MENU_NAVIGATION_CTL_GET_SELECTION, &selection))
       return;
+
+   if (rgui)
+      rgui_update_boxart(rgui);
+
    if (!scroll)
       return;
 
@@ -815,6 +952,25 @@ static void rgui_populate_entries(void *data,
    rgui_navigation_set(data, true);
 }
 
+static bool rgui_load_image(void *userdata, void *data, menu_image_type_t type)
+{
+   rgui_t *rgui = (rgui_t*)userdata;
+
+   if (!rgui)
+      return false;
+
+   switch (type)
+   {
+      case MENU_IMAGE_BOXART:
+         rgui_boxart_load(rgui, (const struct texture_image*)data);
+         break;
+      default:
+         break;
+   }
+
+   return true;
+}
+
 static int rgui_environ(menu_environ_cb_t type, void *data, void *userdata)
 {
    switch (type)
@@ -889,7 +1045,7 @@ menu_ctx_driver_t menu_ctx_rgui = {
    NULL,
    NULL,
    NULL,
-   NULL,
+   rgui_load_image,
    "rgui",
    rgui_environ,
    rgui_pointer_tap,
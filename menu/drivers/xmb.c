@@ -37,6 +37,7 @@
 #include "../menu_hash.h"
 #include "../menu_display.h"
 #include "../menu_navigation.h"
+#include "../menu_thumbnail.h"
 
 #include "../menu_cbs.h"
 
@@ -511,28 +512,23 @@ end:
 
 static void xmb_update_boxart_path(xmb_handle_t *xmb, unsigned i)
 {
-   menu_entry_t entry;
-   settings_t *settings       = config_get_ptr();
-
-   menu_entry_get(&entry, 0, i, NULL, true);
-
-   fill_pathname_join(xmb->boxart_file_path, settings->boxarts_directory,
-         xmb->title_name, sizeof(xmb->boxart_file_path));
-   fill_pathname_join(xmb->boxart_file_path, xmb->boxart_file_path,
-         "Named_Snaps", sizeof(xmb->boxart_file_path));
-   fill_pathname_join(xmb->boxart_file_path, xmb->boxart_file_path,
-         entry.path, sizeof(xmb->boxart_file_path));
+   menu_thumbnail_get_path(xmb->title_name, i, xmb->boxart_file_path,
+         sizeof(xmb->boxart_file_path));
+}
 
-   strlcat(xmb->boxart_file_path, ".png", sizeof(xmb->boxart_file_path));
+static void xmb_boxart_missing(xmb_handle_t *xmb)
+{
+   if (xmb->depth == 1)
+   {
+      menu_display_texture_unload(&xmb->boxart);
+      xmb->boxart = 0;
+   }
 }
 
 static void xmb_update_boxart_image(xmb_handle_t *xmb)
 {
-   if (path_file_exists(xmb->boxart_file_path))
-      rarch_task_push_image_load(xmb->boxart_file_path, "cb_menu_boxart",
-            menu_display_handle_boxart_upload, NULL);
-   else if (xmb->depth == 1)
-      xmb->boxart = 0;
+   if (!menu_thumbnail_request(xmb->boxart_file_path))
+      xmb_boxart_missing(xmb);
 }
 
 static void xmb_selection_pointer_changed(xmb_handle_t *xmb, bool allow_animations)
@@ -584,7 +580,8 @@ static void xmb_selection_pointer_changed(xmb_handle_t *xmb, bool allow_animatio
          if (settings->menu.boxart_enable && depth == 1)
          {
             xmb_update_boxart_path(xmb, i);
-            xmb_update_boxart_image(xmb);
+            if (!menu_thumbnail_select(xmb->title_name, selection, end))
+               xmb_boxart_missing(xmb);
          }
       }
 
@@ -1339,7 +1336,7 @@ static void xmb_draw_items(xmb_handle_t *xmb,
       if (icon_x < -half_size || icon_x > width)
          continue;
 
-      menu_entry_get(&entry, 0, i, list, true);
+      menu_entries_get_row(&entry, list, i);
 
       hash_label = menu_hash_calculate(entry.label);
       hash_value = menu_hash_calculate(entry.value);
@@ -2021,6 +2018,7 @@ static bool xmb_load_image(void *userdata, void *data, menu_image_type_t type)
       case MENU_IMAGE_BOXART:
          {
             struct texture_image *img = (struct texture_image*)data;
+            menu_display_texture_unload(&xmb->boxart);
             xmb->boxart_height = xmb->boxart_width * (float)img->height / (float)img->width;
             xmb->boxart = menu_display_texture_load(data,
                   TEXTURE_FILTER_MIPMAP_LINEAR);
@@ -2473,6 +2471,9 @@ static void xmb_context_destroy(void *data)
    xmb_context_destroy_horizontal_list(xmb);
    xmb_context_bg_destroy(xmb);
 
+   menu_display_texture_unload(&xmb->boxart);
+   xmb->boxart = 0;
+
    menu_display_free_main_font();
 }
 
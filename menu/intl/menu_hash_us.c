@@ -209,6 +209,10 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "record_config";
       case MENU_LABEL_VIDEO_POST_FILTER_RECORD:
          return "video_post_filter_record";
+      case MENU_LABEL_VIDEO_FRAME_DUPE_DETECT:
+         return "video_frame_dupe_detect";
+      case MENU_LABEL_VIDEO_SHADER_WATCH_FILES:
+         return "video_shader_watch_files";
       case MENU_LABEL_CORE_ASSETS_DIRECTORY:
          return "core_assets_directory";
       case MENU_LABEL_ASSETS_DIRECTORY:
@@ -415,6 +419,8 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "video_monitor_index";
       case MENU_LABEL_VIDEO_FRAME_DELAY:
          return "video_frame_delay";
+      case MENU_LABEL_VIDEO_FRAME_PACING:
+         return "video_frame_pacing";
       case MENU_LABEL_INPUT_DUTY_CYCLE:
          return "input_duty_cycle";
       case MENU_LABEL_INPUT_TURBO_PERIOD:
@@ -523,6 +529,8 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "load_open_zip";
       case MENU_LABEL_REWIND_GRANULARITY:
          return "rewind_granularity";
+      case MENU_LABEL_RUN_AHEAD_FRAMES:
+         return "run_ahead_frames";
       case MENU_LABEL_REMAP_FILE_LOAD:
          return "remap_file_load";
       case MENU_LABEL_CUSTOM_RATIO:
@@ -927,6 +935,10 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Record Config";
       case MENU_LABEL_VALUE_VIDEO_POST_FILTER_RECORD:
          return "Post filter record Enable";
+      case MENU_LABEL_VALUE_VIDEO_FRAME_DUPE_DETECT:
+         return "Frame Duplicate Detection";
+      case MENU_LABEL_VALUE_VIDEO_SHADER_WATCH_FILES:
+         return "Watch Shader Files";
       case MENU_LABEL_VALUE_CORE_ASSETS_DIRECTORY:
          return "Downloads Dir";
       case MENU_LABEL_VALUE_ASSETS_DIRECTORY:
@@ -1137,6 +1149,8 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Monitor Index";
       case MENU_LABEL_VALUE_VIDEO_FRAME_DELAY:
          return "Frame Delay";
+      case MENU_LABEL_VALUE_VIDEO_FRAME_PACING:
+         return "Frame Pacing";
       case MENU_LABEL_VALUE_INPUT_DUTY_CYCLE:
          return "Duty Cycle";
       case MENU_LABEL_VALUE_INPUT_TURBO_PERIOD:
@@ -1193,6 +1207,8 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Load Configuration";
       case MENU_LABEL_VALUE_REWIND_GRANULARITY:
          return "Rewind Granularity";
+      case MENU_LABEL_VALUE_RUN_AHEAD_FRAMES:
+         return "Run-Ahead Frames";
       case MENU_LABEL_VALUE_REMAP_FILE_LOAD:
          return "Load Remap File";
       case MENU_LABEL_VALUE_CUSTOM_RATIO:
@@ -1439,6 +1455,22 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Network Command interface support";
       case MENU_LABEL_VALUE_SYSTEM_INFO_COCOA_SUPPORT:
          return "Cocoa support";
+      case MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_INPUT_LAG:
+         return "Netplay input lag (frames)";
+      case MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_JITTER:
+         return "Netplay jitter (frames)";
+      case MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_LOST_FRAMES:
+         return "Netplay frames recovered from packet loss";
+      case MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_STALLS:
+         return "Netplay stalls";
+      case MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_RTT:
+         return "Netplay round trip (ms)";
+      case MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_RTT_JITTER:
+         return "Netplay round trip jitter (ms)";
+      case MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_REDUNDANCY:
+         return "Netplay frames per packet";
+      case MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_SPECTATORS:
+         return "Netplay spectators";
       case MENU_LABEL_VALUE_SYSTEM_INFO_RPNG_SUPPORT:
          return "PNG support (RPNG)";
       case MENU_LABEL_VALUE_SYSTEM_INFO_SDL_SUPPORT:
@@ -2367,6 +2399,23 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                "possible cost of latency and more video \n"
                "stuttering.");
          break;
+      case MENU_LABEL_VIDEO_FRAME_DUPE_DETECT:
+         snprintf(s, len,
+               "Detect frames identical to the previous one.\n"
+               " \n"
+               "Skips filtering, texture upload and \n"
+               "re-encoding while the core keeps \n"
+               "resending a static screen.");
+         break;
+      case MENU_LABEL_VIDEO_SHADER_WATCH_FILES:
+         snprintf(s, len,
+               "Reloads the shader in use whenever \n"
+               "its preset, pass sources or LUTs \n"
+               "are saved.\n"
+               " \n"
+               "Only the passes that changed are \n"
+               "recompiled.");
+         break;
       case MENU_LABEL_VIDEO_VSYNC:
          snprintf(s, len,
                "Video V-Sync.\n");
@@ -2388,6 +2437,17 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                "at a time, increasing the rewinding \n"
                "speed.");
          break;
+      case MENU_LABEL_RUN_AHEAD_FRAMES:
+         snprintf(s, len,
+               "Runs the core this many frames ahead \n"
+               "and rolls it back every frame.\n"
+               " \n"
+               "Hides that many frames of the game's \n"
+               "own input lag. Needs a core with \n"
+               "deterministic savestates.\n"
+               " \n"
+               "Maximum is 6.");
+         break;
       case MENU_LABEL_SCREENSHOT:
          snprintf(s, len,
                "Take screenshot.");
@@ -2402,6 +2462,16 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                " \n"
                "Maximum is 15.");
          break;
+      case MENU_LABEL_VIDEO_FRAME_PACING:
+         snprintf(s, len,
+               "Starts the core as late as it can\n"
+               "while still making the next frame.\n"
+               " \n"
+               "Measures when frames are presented\n"
+               "instead of using a fixed Frame Delay.\n"
+               " \n"
+               "With VSync, it needs Hard GPU Sync.");
+         break;
       case MENU_LABEL_VIDEO_HARD_SYNC_FRAMES:
          snprintf(s, len,
                "Sets how many frames CPU can \n"
@@ -150,6 +150,10 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "record_config";
       case MENU_LABEL_VIDEO_POST_FILTER_RECORD:
          return "video_post_filter_record";
+      case MENU_LABEL_VIDEO_FRAME_DUPE_DETECT:
+         return "video_frame_dupe_detect";
+      case MENU_LABEL_VIDEO_SHADER_WATCH_FILES:
+         return "video_shader_watch_files";
       case MENU_LABEL_CORE_ASSETS_DIRECTORY:
          return "core_assets_directory";
       case MENU_LABEL_ASSETS_DIRECTORY:
@@ -354,6 +358,8 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "video_monitor_index";
       case MENU_LABEL_VIDEO_FRAME_DELAY:
          return "video_frame_delay";
+      case MENU_LABEL_VIDEO_FRAME_PACING:
+         return "video_frame_pacing";
       case MENU_LABEL_INPUT_DUTY_CYCLE:
          return "input_duty_cycle";
       case MENU_LABEL_INPUT_TURBO_PERIOD:
@@ -462,6 +468,8 @@ static const char *menu_hash_to_str_us_label(uint32_t hash)
          return "load_open_zip";
       case MENU_LABEL_REWIND_GRANULARITY:
          return "rewind_granularity";
+      case MENU_LABEL_RUN_AHEAD_FRAMES:
+         return "run_ahead_frames";
       case MENU_LABEL_REMAP_FILE_LOAD:
          return "remap_file_load";
       case MENU_LABEL_REMAP_FILE_SAVE_AS:
@@ -824,6 +832,10 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Record Cönfig";
       case MENU_LABEL_VALUE_VIDEO_POST_FILTER_RECORD:
          return "Põst fíltêr rècord Enàble";
+      case MENU_LABEL_VALUE_VIDEO_FRAME_DUPE_DETECT:
+         return "Fràme Dúplicâte Detèctìon";
+      case MENU_LABEL_VALUE_VIDEO_SHADER_WATCH_FILES:
+         return "Wàtch Shâder Fìles";
       case MENU_LABEL_VALUE_CORE_ASSETS_DIRECTORY:
          return "Ðownloads Dir";
       case MENU_LABEL_VALUE_ASSETS_DIRECTORY:
@@ -1028,6 +1040,8 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Mønitor Ïñdêx";
       case MENU_LABEL_VALUE_VIDEO_FRAME_DELAY:
          return "Frámê Delay";
+      case MENU_LABEL_VALUE_VIDEO_FRAME_PACING:
+         return "Frámê Pâcing";
       case MENU_LABEL_VALUE_INPUT_DUTY_CYCLE:
          return "Duty Cycle";
       case MENU_LABEL_VALUE_INPUT_TURBO_PERIOD:
@@ -1084,6 +1098,8 @@ const char *menu_hash_to_str_us(uint32_t hash)
          return "Loåd Çónfìgúratiøñ";
       case MENU_LABEL_VALUE_REWIND_GRANULARITY:
          return "Rewind Granúlarity";
+      case MENU_LABEL_VALUE_RUN_AHEAD_FRAMES:
+         return "Rüñ-Âhead Frámês";
       case MENU_LABEL_VALUE_REMAP_FILE_LOAD:
          return "Lòad Remap Filê";
       case MENU_LABEL_VALUE_REMAP_FILE_SAVE_AS:
@@ -2233,6 +2249,23 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                "pøssiblë còst öf latëncý and møre video \n"
                "stuttering.");
          break;
+      case MENU_LABEL_VIDEO_FRAME_DUPE_DETECT:
+         snprintf(s, len,
+               "Detéct frámes ìdentical tø the prévious oñe.\n"
+               " \n"
+               "Skîps filtêring, téxture upløad and \n"
+               "ré-encòding while thè core kéeps \n"
+               "résending a státic scrèen.");
+         break;
+      case MENU_LABEL_VIDEO_SHADER_WATCH_FILES:
+         snprintf(s, len,
+               "Rèloads thé shader in ùse whenever \n"
+               "its prêset, pàss sources ør LUTs \n"
+               "åre savéd.\n"
+               " \n"
+               "Onlÿ the passes thát chânged are \n"
+               "recømpiled.");
+         break;
       case MENU_LABEL_VIDEO_VSYNC:
          snprintf(s, len,
                "Vidéo V-Sÿñc.\n");
@@ -2254,6 +2287,17 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                "at â tîme, iñcrèâsing the rewînding \n"
                "speéd.");
          break;
+      case MENU_LABEL_RUN_AHEAD_FRAMES:
+         snprintf(s, len,
+               "Rüñs the core thís mâñy frames ahêad \n"
+               "añd rølls it båck every frámê.\n"
+               " \n"
+               "Hìdes thât many fråmes of the gamê's \n"
+               "øwn inpüt lag. Nêeds å core with \n"
+               "dëterministic sâvestates.\n"
+               " \n"
+               "Maxîmum ïs 6.");
+         break;
       case MENU_LABEL_SCREENSHOT:
          snprintf(s, len,
                "Täkê scréeñshöt.");
@@ -2268,6 +2312,14 @@ int menu_hash_get_help_us(uint32_t hash, char *s, size_t len)
                " \n"
                "Maxîmum ïs 15.");
          break;
+      case MENU_LABEL_VIDEO_FRAME_PACING:
+         snprintf(s, len,
+               "Stårts thë core as låte as it cåñ\n"
+               "whílê still mâkiñg thé next frame.\n"
+               " \n"
+               "Mêasures whêñ frames are prêsented\n"
+               "iñstead of usìng a fixed Frámê Delay.");
+         break;
       case MENU_LABEL_VIDEO_HARD_SYNC_FRAMES:
          snprintf(s, len,
                "Sets how manÿ frames ÇPU câñ \n"
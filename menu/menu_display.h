@@ -177,8 +177,6 @@ void menu_display_texture_unload(uintptr_t *id);
 
 void menu_display_handle_wallpaper_upload(void *task_data, void *user_data, const char *err);
 
-void menu_display_handle_boxart_upload(void *task_data, void *user_data, const char *err);
-
 const float *menu_display_get_tex_coords(void);
 
 extern menu_display_ctx_driver_t menu_display_ctx_gl;
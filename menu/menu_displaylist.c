@@ -45,6 +45,10 @@
 #include "../performance.h"
 #include "../core_info.h"
 
+#ifdef HAVE_NETPLAY
+#include "../netplay/netplay.h"
+#endif
+
 #ifdef HAVE_CHEEVOS
 #include "../cheevos.h"
 #endif
@@ -166,7 +170,7 @@ static int menu_displaylist_parse_core_info(menu_displaylist_info_t *info)
    
    runloop_ctl(RUNLOOP_CTL_CURRENT_CORE_GET, &core_info);
 
-   if (!core_info || !core_info->config_data)
+   if (!core_info || !core_info->has_info)
    {
       menu_entries_push(info->list,
             menu_hash_to_str(MENU_LABEL_VALUE_NO_CORE_INFORMATION_AVAILABLE),
@@ -895,6 +899,68 @@ static int menu_displaylist_parse_system_info(menu_displaylist_info_t *info)
    menu_entries_push(info->list, feat_str, "",
          MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
 
+#ifdef HAVE_NETPLAY
+   {
+      netplay_stats_t stats;
+
+      if (netplay_driver_ctl(RARCH_NETPLAY_CTL_GET_STATS, &stats))
+      {
+         if (stats.spectate)
+         {
+            snprintf(tmp, sizeof(tmp), "%s: %u",
+                  menu_hash_to_str(MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_SPECTATORS),
+                  stats.spectators);
+            menu_entries_push(info->list, tmp, "",
+                  MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+         }
+         else
+         {
+            snprintf(tmp, sizeof(tmp), "%s: %.2f",
+                  menu_hash_to_str(MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_INPUT_LAG),
+                  stats.input_lag);
+            menu_entries_push(info->list, tmp, "",
+                  MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+
+            snprintf(tmp, sizeof(tmp), "%s: %.2f",
+                  menu_hash_to_str(MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_JITTER),
+                  stats.jitter);
+            menu_entries_push(info->list, tmp, "",
+                  MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+
+            snprintf(tmp, sizeof(tmp), "%s: %u",
+                  menu_hash_to_str(MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_LOST_FRAMES),
+                  stats.lost_frames);
+            menu_entries_push(info->list, tmp, "",
+                  MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+
+            snprintf(tmp, sizeof(tmp), "%s: %u",
+                  menu_hash_to_str(MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_STALLS),
+                  stats.stalls);
+            menu_entries_push(info->list, tmp, "",
+                  MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+
+            snprintf(tmp, sizeof(tmp), "%s: %.1f",
+                  menu_hash_to_str(MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_RTT),
+                  stats.rtt);
+            menu_entries_push(info->list, tmp, "",
+                  MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+
+            snprintf(tmp, sizeof(tmp), "%s: %.1f",
+                  menu_hash_to_str(MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_RTT_JITTER),
+                  stats.rtt_jitter);
+            menu_entries_push(info->list, tmp, "",
+                  MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+
+            snprintf(tmp, sizeof(tmp), "%s: %.2f",
+                  menu_hash_to_str(MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_REDUNDANCY),
+                  stats.redundancy);
+            menu_entries_push(info->list, tmp, "",
+                  MENU_SETTINGS_CORE_INFO_NONE, 0, 0);
+         }
+      }
+   }
+#endif
+
    return 0;
 }
 
@@ -3250,7 +3316,10 @@ void menu_displaylist_push_list_process(menu_displaylist_info_t *info)
       return;
 
    if (info->need_sort)
+   {
       file_list_sort_on_alt(info->list);
+      menu_entries_ctl(MENU_ENTRIES_CTL_INVALIDATE_ROWS, NULL);
+   }
 
    if (info->need_refresh)
       menu_entries_refresh(info->list);
@@ -25,6 +25,7 @@
 #include "menu_navigation.h"
 #include "menu_hash.h"
 #include "menu_shader.h"
+#include "menu_thumbnail.h"
 
 #include "../general.h"
 #include "../system.h"
@@ -532,6 +533,7 @@ static void menu_free(menu_handle_t *menu)
    menu_driver_free(menu);
    menu_driver_ctl(RARCH_MENU_CTL_SYSTEM_INFO_DEINIT, NULL);
    menu_display_free();
+   menu_thumbnail_free();
    menu_entries_ctl(MENU_ENTRIES_CTL_DEINIT, NULL);
 
    event_command(EVENT_CMD_HISTORY_DEINIT);
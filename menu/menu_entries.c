@@ -34,6 +34,123 @@ struct menu_list
    size_t selection_buf_size;
 };
 
+/* A formatted row of a large list. Strings are stored
+ * compactly instead of as PATH_MAX_LENGTH buffers. */
+typedef struct menu_entries_row
+{
+   const file_list_t *list;
+   size_t idx;
+   unsigned generation;
+   bool valid;
+   char *path;
+   char *label;
+   char *value;
+   size_t entry_idx;
+   unsigned type;
+   unsigned spacing;
+} menu_entries_row_t;
+
+/* Rows are direct-mapped by index, so any window of up to
+ * MENU_ENTRIES_ROW_CACHE_SIZE consecutive rows fits. */
+static menu_entries_row_t *menu_entries_rows;
+static unsigned menu_entries_rows_generation;
+
+static void menu_entries_rows_free(void)
+{
+   unsigned i;
+
+   if (!menu_entries_rows)
+      return;
+
+   for (i = 0; i < MENU_ENTRIES_ROW_CACHE_SIZE; i++)
+   {
+      free(menu_entries_rows[i].path);
+      free(menu_entries_rows[i].label);
+      free(menu_entries_rows[i].value);
+   }
+
+   free(menu_entries_rows);
+   menu_entries_rows = NULL;
+}
+
+static void menu_entries_rows_invalidate(void)
+{
+   menu_entries_rows_generation++;
+}
+
+static char *menu_entries_row_strdup(char *old, const char *s)
+{
+   size_t len = strlen(s) + 1;
+   char *str  = (char*)realloc(old, len);
+
+   if (str)
+      memcpy(str, s, len);
+   return str;
+}
+
+/**
+ * menu_entries_get_row:
+ * @entry                    : Entry to fill in.
+ * @list                     : File list handle.
+ * @i                        : Index of the entry.
+ *
+ * Same as menu_entry_get() with use_representation set.
+ * For lists with at least MENU_ENTRIES_ROW_CACHE_MIN entries
+ * (file browsers, playlists) the formatted row is kept until
+ * the menu changes, so only rows scrolling into view are
+ * formatted.
+ **/
+void menu_entries_get_row(menu_entry_t *entry, file_list_t *list, size_t i)
+{
+   menu_entries_row_t *row = NULL;
+
+   entry->path[0] = entry->label[0] = entry->value[0] = '\0';
+
+   if (!list || list->size < MENU_ENTRIES_ROW_CACHE_MIN)
+   {
+      menu_entry_get(entry, 0, i, list, true);
+      return;
+   }
+
+   if (!menu_entries_rows)
+      menu_entries_rows = (menu_entries_row_t*)
+         calloc(MENU_ENTRIES_ROW_CACHE_SIZE, sizeof(*menu_entries_rows));
+
+   if (!menu_entries_rows)
+   {
+      menu_entry_get(entry, 0, i, list, true);
+      return;
+   }
+
+   row = &menu_entries_rows[i % MENU_ENTRIES_ROW_CACHE_SIZE];
+
+   if (!row->valid || row->list != list || row->idx != i
+         || row->generation != menu_entries_rows_generation)
+   {
+      menu_entry_get(entry, 0, i, list, true);
+
+      row->path       = menu_entries_row_strdup(row->path,  entry->path);
+      row->label      = menu_entries_row_strdup(row->label, entry->label);
+      row->value      = menu_entries_row_strdup(row->value, entry->value);
+      row->list       = list;
+      row->idx        = i;
+      row->generation = menu_entries_rows_generation;
+      row->entry_idx  = entry->entry_idx;
+      row->type       = entry->type;
+      row->spacing    = entry->spacing;
+      row->valid      = row->path && row->label && row->value;
+      return;
+   }
+
+   strlcpy(entry->path,  row->path,  sizeof(entry->path));
+   strlcpy(entry->label, row->label, sizeof(entry->label));
+   strlcpy(entry->value, row->value, sizeof(entry->value));
+   entry->entry_idx = row->entry_idx;
+   entry->idx       = i;
+   entry->type      = row->type;
+   entry->spacing   = row->spacing;
+}
+
 static void menu_list_free_list(file_list_t *list)
 {
    unsigned i;
@@ -215,6 +332,7 @@ void menu_entries_clear(file_list_t *list)
    unsigned i;
 
    menu_driver_ctl(RARCH_MENU_CTL_LIST_CLEAR, list);
+   menu_entries_rows_invalidate();
 
    for (i = 0; i < list->size; i++)
       file_list_free_actiondata(list, i);
@@ -227,6 +345,7 @@ void menu_entries_set_alt_at_offset(file_list_t *list, size_t idx,
       const char *alt)
 {
    file_list_set_alt_at_offset(list, idx, alt);
+   menu_entries_rows_invalidate();
 }
 
 /**
@@ -480,6 +599,7 @@ void menu_entries_push(file_list_t *list, const char *path, const char *label,
       return;
 
    file_list_push(list, path, label, type, directory_ptr, entry_idx);
+   menu_entries_rows_invalidate();
 
    idx = list->size - 1;
 
@@ -637,6 +757,7 @@ bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data)
          menu_entries_need_refresh        = NULL;
          menu_entries_nonblocking_refresh = NULL;
          menu_entries_begin               = 0;
+         menu_entries_rows_free();
          return true;
       case MENU_ENTRIES_CTL_NEEDS_REFRESH:
          if (menu_entries_nonblocking_refresh)
@@ -689,6 +810,7 @@ bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data)
             else
                menu_entries_need_refresh        = true;
          }
+         menu_entries_rows_invalidate();
          return true;
       case MENU_ENTRIES_CTL_UNSET_REFRESH:
          {
@@ -717,6 +839,9 @@ bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data)
          return true;
       case MENU_ENTRIES_CTL_INIT:
          return menu_entries_init();
+      case MENU_ENTRIES_CTL_INVALIDATE_ROWS:
+         menu_entries_rows_invalidate();
+         return true;
       case MENU_ENTRIES_CTL_SHOW_BACK:
          /* Returns true if a Back button should be shown 
           * (i.e. we are at least
@@ -29,6 +29,12 @@
 extern "C" {
 #endif
 
+/* Lists this long get their formatted rows cached. */
+#define MENU_ENTRIES_ROW_CACHE_MIN  256
+
+/* Number of formatted rows kept around the viewport. */
+#define MENU_ENTRIES_ROW_CACHE_SIZE 128
+
 typedef enum
 {
    MENU_LIST_PLAIN = 0,
@@ -119,7 +125,9 @@ enum menu_entries_ctl_state
    MENU_ENTRIES_CTL_SET_START,
    /* Returns the starting index of the menu entry list. */
    MENU_ENTRIES_CTL_START_GET,
-   MENU_ENTRIES_CTL_SHOW_BACK
+   MENU_ENTRIES_CTL_SHOW_BACK,
+   /* Drops formatted rows cached by menu_entries_get_row(). */
+   MENU_ENTRIES_CTL_INVALIDATE_ROWS
 };
 
 typedef struct menu_list menu_list_t;
@@ -128,6 +136,8 @@ size_t menu_entries_get_end(void);
 
 void menu_entries_get(size_t i, menu_entry_t *entry);
 
+void menu_entries_get_row(menu_entry_t *entry, file_list_t *list, size_t i);
+
 int menu_entries_get_title(char *title, size_t title_len);
 
 int menu_entries_get_core_title(char *title_msg, size_t title_msg_len);
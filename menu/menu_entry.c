@@ -356,6 +356,9 @@ int menu_entry_action(menu_entry_t *entry, unsigned i, enum menu_action action)
    file_list_t *selection_buf = menu_entries_get_selection_buf_ptr(0);
    menu_file_list_cbs_t *cbs  = menu_entries_get_actiondata_at_offset(selection_buf, i);
 
+   /* Any action may change what the rows display. */
+   menu_entries_ctl(MENU_ENTRIES_CTL_INVALIDATE_ROWS, NULL);
+
    switch (action)
    {
       case MENU_ACTION_UP:
@@ -324,9 +324,13 @@ extern "C" {
 #define MENU_LABEL_VALUE_VIDEO_HARD_SYNC_FRAMES                                0x1edcab0bU
 #define MENU_LABEL_VIDEO_FRAME_DELAY                                           0xd4aa9df4U
 #define MENU_LABEL_VALUE_VIDEO_FRAME_DELAY                                     0x990d36bfU
+#define MENU_LABEL_VIDEO_FRAME_PACING                                          0x85af1397U
+#define MENU_LABEL_VALUE_VIDEO_FRAME_PACING                                    0xd664c5c2U
 #define MENU_LABEL_SCREENSHOT                                                  0x9a37f083U
 #define MENU_LABEL_REWIND_GRANULARITY                                          0xe859cbdfU
 #define MENU_LABEL_VALUE_REWIND_GRANULARITY                                    0x6e1ae4c0U
+#define MENU_LABEL_RUN_AHEAD_FRAMES                                            0xfcf2c309U
+#define MENU_LABEL_VALUE_RUN_AHEAD_FRAMES                                      0x9b1877f8U
 #define MENU_LABEL_VALUE_VIDEO_ROTATION                                        0x9efcecf5U
 #define MENU_LABEL_THREADED_DATA_RUNLOOP_ENABLE                                0xdf5c6d33U
 #define MENU_LABEL_VALUE_THREADED_DATA_RUNLOOP_ENABLE                          0x04d8c10fU
@@ -957,6 +961,10 @@ extern "C" {
 
 #define MENU_LABEL_VIDEO_POST_FILTER_RECORD                                    0xa7b6e724U
 #define MENU_LABEL_VALUE_VIDEO_POST_FILTER_RECORD                              0x1362eaf7U
+#define MENU_LABEL_VIDEO_FRAME_DUPE_DETECT                                     0xe4cf238bU
+#define MENU_LABEL_VALUE_VIDEO_FRAME_DUPE_DETECT                               0x932354caU
+#define MENU_LABEL_VIDEO_SHADER_WATCH_FILES                                    0x82765d1aU
+#define MENU_LABEL_VALUE_VIDEO_SHADER_WATCH_FILES                              0x79d20e86U
 
 #define MENU_LABEL_RECORD_ENABLE                                               0x1654e22aU
 #define MENU_LABEL_VALUE_RECORD_ENABLE                                         0xee39aa6bU
@@ -998,6 +1006,14 @@ extern "C" {
 #define MENU_LABEL_VALUE_SYSTEM_INFO_NETWORK_COMMAND_IFACE_SUPPORT             0x9c9c8e3eU
 #define MENU_LABEL_VALUE_SYSTEM_INFO_NETWORK_REMOTE_SUPPORT                    0x1a817f5bU
 #define MENU_LABEL_VALUE_SYSTEM_INFO_COCOA_SUPPORT                             0x89849204U
+#define MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_INPUT_LAG                         0x27786e82U
+#define MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_JITTER                            0xf45e56b1U
+#define MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_LOST_FRAMES                       0x017ea05eU
+#define MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_STALLS                            0x0a194592U
+#define MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_RTT                               0xe62b8d59U
+#define MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_RTT_JITTER                        0x8fc0b48aU
+#define MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_REDUNDANCY                        0xff820aecU
+#define MENU_LABEL_VALUE_SYSTEM_INFO_NETPLAY_SPECTATORS                        0x95622207U
 #define MENU_LABEL_VALUE_SYSTEM_INFO_RPNG_SUPPORT                              0xe1dcea36U
 #define MENU_LABEL_VALUE_SYSTEM_INFO_SDL_SUPPORT                               0xf9bc2a42U
 #define MENU_LABEL_VALUE_SYSTEM_INFO_SDL2_SUPPORT                              0x3c2d6134U
@@ -52,6 +52,8 @@
 #include "../config.def.h"
 #include "../file_ext.h"
 #include "../performance.h"
+#include "../runahead.h"
+#include "../msg_hash.h"
 
 
 struct rarch_setting_info
@@ -2829,6 +2831,9 @@ void general_write_handler(void *data)
       case MENU_LABEL_AUDIO_MAX_TIMING_SKEW:
          settings->audio.max_timing_skew = *setting->value.fraction;
          break;
+      case MENU_LABEL_USER_LANGUAGE:
+         msg_hash_set_language(*setting->value.unsigned_integer);
+         break;
       case MENU_LABEL_AUDIO_RATE_CONTROL_DELTA:
          if (*setting->value.fraction < 0.0005)
          {
@@ -4102,6 +4107,20 @@ static bool setting_append_list_rewind_options(
    menu_settings_list_current_add_range(list, list_info, 1, 32768, 1, true, false);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_UINT(
+         list, list_info,
+         &settings->run_ahead_frames,
+         menu_hash_to_str(MENU_LABEL_RUN_AHEAD_FRAMES),
+         menu_hash_to_str(MENU_LABEL_VALUE_RUN_AHEAD_FRAMES),
+         run_ahead_frames,
+         &group_info,
+         &subgroup_info,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   menu_settings_list_current_add_range(list, list_info, 0, RUNAHEAD_MAX_FRAMES, 1, true, true);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
    END_SUB_GROUP(list, list_info, parent_group);
    END_GROUP(list, list_info, parent_group);
 
@@ -4679,6 +4698,21 @@ static bool setting_append_list_video_options(
    menu_settings_list_current_add_range(list, list_info, 0, 15, 1, true, true);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+   CONFIG_BOOL(
+         list, list_info,
+         &settings->video.frame_pacing,
+         menu_hash_to_str(MENU_LABEL_VIDEO_FRAME_PACING),
+         menu_hash_to_str(MENU_LABEL_VALUE_VIDEO_FRAME_PACING),
+         frame_pacing,
+         menu_hash_to_str(MENU_VALUE_OFF),
+         menu_hash_to_str(MENU_VALUE_ON),
+         &group_info,
+         &subgroup_info,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
 #if !defined(RARCH_MOBILE)
    CONFIG_BOOL(
          list, list_info,
@@ -4764,6 +4798,39 @@ static bool setting_append_list_video_options(
    menu_settings_list_current_add_cmd(list, list_info, EVENT_CMD_REINIT);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_ALLOW_EMPTY);
 
+   CONFIG_BOOL(
+         list, list_info,
+         &settings->video.frame_dupe_detect,
+         menu_hash_to_str(MENU_LABEL_VIDEO_FRAME_DUPE_DETECT),
+         menu_hash_to_str(MENU_LABEL_VALUE_VIDEO_FRAME_DUPE_DETECT),
+         frame_dupe_detect,
+         menu_hash_to_str(MENU_VALUE_OFF),
+         menu_hash_to_str(MENU_VALUE_ON),
+         &group_info,
+         &subgroup_info,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
+#ifdef __linux__
+   CONFIG_BOOL(
+         list, list_info,
+         &settings->video.shader_watch_files,
+         menu_hash_to_str(MENU_LABEL_VIDEO_SHADER_WATCH_FILES),
+         menu_hash_to_str(MENU_LABEL_VALUE_VIDEO_SHADER_WATCH_FILES),
+         shader_watch_files,
+         menu_hash_to_str(MENU_VALUE_OFF),
+         menu_hash_to_str(MENU_VALUE_ON),
+         &group_info,
+         &subgroup_info,
+         parent_group,
+         general_write_handler,
+         general_read_handler);
+   menu_settings_list_current_add_cmd(list, list_info, EVENT_CMD_SHADER_WATCH_TOGGLE);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO|SD_FLAG_ADVANCED);
+#endif
+
    END_SUB_GROUP(list, list_info, parent_group);
    END_GROUP(list, list_info, parent_group);
 
@@ -0,0 +1,492 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2016 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <formats/image.h>
+#include <retro_miscellaneous.h>
+
+#include "menu_thumbnail.h"
+#include "menu_driver.h"
+#include "menu_entry.h"
+
+#include "../configuration.h"
+#include "../msg_hash.h"
+#include "../performance.h"
+#include "../verbosity.h"
+#include "../tasks/tasks.h"
+
+/* A decoded thumbnail, or a path known not to exist. */
+typedef struct menu_thumbnail_entry
+{
+   char *path;
+   uint32_t hash;
+   bool missing;
+   /* Missing entries are dropped after this time, so
+    * thumbnails added while browsing still show up. */
+   retro_time_t expires;
+   unsigned last_used;
+   struct texture_image image;
+} menu_thumbnail_entry_t;
+
+/* An image load in flight. Owned by the task until its
+ * callback runs, even after the cache has been freed. */
+typedef struct menu_thumbnail_load
+{
+   char path[PATH_MAX_LENGTH];
+   uint32_t hash;
+   bool prefetch;
+   bool cancelled;
+   bool orphaned;
+   struct menu_thumbnail_load *next;
+} menu_thumbnail_load_t;
+
+typedef struct menu_thumbnail_state
+{
+   menu_thumbnail_entry_t entries[MENU_THUMBNAIL_CACHE_ENTRIES];
+   menu_thumbnail_load_t *loads;
+   char wanted[PATH_MAX_LENGTH];
+   uint32_t wanted_hash;
+   size_t selection;
+   unsigned tick;
+   menu_thumbnail_stats_t stats;
+} menu_thumbnail_state_t;
+
+static menu_thumbnail_state_t menu_thumbnail_st;
+
+static size_t menu_thumbnail_entry_size(const menu_thumbnail_entry_t *entry)
+{
+   return entry->image.width * entry->image.height * sizeof(uint32_t);
+}
+
+static void menu_thumbnail_entry_free(menu_thumbnail_entry_t *entry)
+{
+   if (!entry->path)
+      return;
+
+   menu_thumbnail_st.stats.bytes -= menu_thumbnail_entry_size(entry);
+   menu_thumbnail_st.stats.entries--;
+
+   texture_image_free(&entry->image);
+   free(entry->path);
+   memset(entry, 0, sizeof(*entry));
+}
+
+static menu_thumbnail_entry_t *menu_thumbnail_find(
+      const char *path, uint32_t hash)
+{
+   unsigned i;
+
+   for (i = 0; i < MENU_THUMBNAIL_CACHE_ENTRIES; i++)
+   {
+      menu_thumbnail_entry_t *entry = &menu_thumbnail_st.entries[i];
+
+      if (entry->path && entry->hash == hash && !strcmp(entry->path, path))
+      {
+         if (entry->missing && retro_get_time_usec() >= entry->expires)
+         {
+            menu_thumbnail_entry_free(entry);
+            return NULL;
+         }
+
+         entry->last_used = ++menu_thumbnail_st.tick;
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+/* Returns a free slot if there is one and @used_only is
+ * false, otherwise the least recently used entry. */
+static menu_thumbnail_entry_t *menu_thumbnail_lru(bool used_only)
+{
+   unsigned i;
+   menu_thumbnail_entry_t *lru = NULL;
+
+   for (i = 0; i < MENU_THUMBNAIL_CACHE_ENTRIES; i++)
+   {
+      menu_thumbnail_entry_t *entry = &menu_thumbnail_st.entries[i];
+
+      if (!entry->path)
+      {
+         if (used_only)
+            continue;
+         return entry;
+      }
+
+      if (!lru || entry->last_used < lru->last_used)
+         lru = entry;
+   }
+
+   return lru;
+}
+
+static void menu_thumbnail_evict(menu_thumbnail_entry_t *entry)
+{
+   if (!entry || !entry->path)
+      return;
+
+   menu_thumbnail_entry_free(entry);
+   menu_thumbnail_st.stats.evictions++;
+}
+
+/* Takes ownership of the pixels in @img, if any. */
+static menu_thumbnail_entry_t *menu_thumbnail_insert(const char *path,
+      uint32_t hash, struct texture_image *img)
+{
+   menu_thumbnail_entry_t *entry = NULL;
+   size_t size = img ? img->width * img->height * sizeof(uint32_t) : 0;
+
+   if (size > MENU_THUMBNAIL_CACHE_BYTES)
+      return NULL;
+
+   while (menu_thumbnail_st.stats.bytes + size > MENU_THUMBNAIL_CACHE_BYTES)
+      menu_thumbnail_evict(menu_thumbnail_lru(true));
+
+   entry = menu_thumbnail_lru(false);
+   menu_thumbnail_evict(entry);
+
+   entry->path      = strdup(path);
+   entry->hash      = hash;
+   entry->last_used = ++menu_thumbnail_st.tick;
+   entry->missing   = !img;
+
+   if (img)
+      entry->image  = *img;
+   else
+      entry->expires = retro_get_time_usec() + MENU_THUMBNAIL_MISSING_USEC;
+
+   menu_thumbnail_st.stats.entries++;
+   menu_thumbnail_st.stats.bytes += size;
+
+   return entry;
+}
+
+static void menu_thumbnail_deliver(menu_thumbnail_entry_t *entry)
+{
+   menu_driver_load_image(&entry->image, MENU_IMAGE_BOXART);
+}
+
+static menu_thumbnail_load_t *menu_thumbnail_find_load(
+      const char *path, uint32_t hash)
+{
+   menu_thumbnail_load_t *load = NULL;
+
+   for (load = menu_thumbnail_st.loads; load; load = load->next)
+      if (!load->cancelled && load->hash == hash && !strcmp(load->path, path))
+         return load;
+
+   return NULL;
+}
+
+static size_t menu_thumbnail_num_loads(void)
+{
+   size_t num                  = 0;
+   menu_thumbnail_load_t *load = NULL;
+
+   for (load = menu_thumbnail_st.loads; load; load = load->next)
+      num += !load->cancelled;
+
+   return num;
+}
+
+static void menu_thumbnail_unlink_load(menu_thumbnail_load_t *load)
+{
+   menu_thumbnail_load_t **prev = &menu_thumbnail_st.loads;
+
+   for (; *prev; prev = &(*prev)->next)
+   {
+      if (*prev == load)
+      {
+         *prev = load->next;
+         break;
+      }
+   }
+}
+
+static void menu_thumbnail_handle_load(void *task_data,
+      void *user_data, const char *err)
+{
+   menu_thumbnail_entry_t *entry = NULL;
+   struct texture_image *img     = (struct texture_image*)task_data;
+   menu_thumbnail_load_t *load   = (menu_thumbnail_load_t*)user_data;
+
+   if (!load)
+      goto end;
+
+   if (load->cancelled)
+      menu_thumbnail_st.stats.cancelled++;
+
+   if (load->orphaned)
+      goto end;
+
+   menu_thumbnail_unlink_load(load);
+
+   /* Cancelled loads that made it to the end are still worth
+    * keeping, the user may well scroll back to them. */
+   if (!img || !img->pixels)
+      goto end;
+
+   entry = menu_thumbnail_insert(load->path, load->hash, img);
+   if (!entry)
+      goto end;
+
+   free(img);
+   img = NULL;
+
+   if (!entry->missing && entry->hash == menu_thumbnail_st.wanted_hash
+         && !strcmp(entry->path, menu_thumbnail_st.wanted))
+      menu_thumbnail_deliver(entry);
+
+end:
+   if (img)
+   {
+      texture_image_free(img);
+      free(img);
+   }
+   free(load);
+}
+
+static bool menu_thumbnail_cancel_finder(rarch_task_t *task, void *user_data)
+{
+   menu_thumbnail_load_t *load = (menu_thumbnail_load_t*)task->user_data;
+
+   if (task->callback == menu_thumbnail_handle_load
+         && load && load->cancelled)
+      task->cancelled = true;
+
+   /* Keep iterating over all tasks. */
+   return false;
+}
+
+/* Cancels loads for thumbnails that are no longer wanted.
+ * Prefetches are left alone so neighbouring entries still
+ * land in the cache. */
+static void menu_thumbnail_cancel_stale(void)
+{
+   bool cancelled              = false;
+   menu_thumbnail_load_t *load = NULL;
+
+   for (load = menu_thumbnail_st.loads; load; load = load->next)
+   {
+      if (load->prefetch || load->cancelled)
+         continue;
+      if (load->hash == menu_thumbnail_st.wanted_hash
+            && !strcmp(load->path, menu_thumbnail_st.wanted))
+         continue;
+
+      load->cancelled = true;
+      cancelled       = true;
+   }
+
+   if (cancelled)
+      rarch_task_find(menu_thumbnail_cancel_finder, NULL);
+}
+
+static bool menu_thumbnail_push_load(const char *path,
+      uint32_t hash, bool prefetch)
+{
+   menu_thumbnail_load_t *load = (menu_thumbnail_load_t*)
+      calloc(1, sizeof(*load));
+
+   if (!load)
+      return false;
+
+   strlcpy(load->path, path, sizeof(load->path));
+   load->hash     = hash;
+   load->prefetch = prefetch;
+
+   if (!rarch_task_push_image_load(path, "cb_menu_boxart",
+            menu_thumbnail_handle_load, load))
+   {
+      free(load);
+      return false;
+   }
+
+   load->next               = menu_thumbnail_st.loads;
+   menu_thumbnail_st.loads  = load;
+
+   return true;
+}
+
+bool menu_thumbnail_request(const char *path)
+{
+   uint32_t hash;
+   menu_thumbnail_load_t *load   = NULL;
+   menu_thumbnail_entry_t *entry = NULL;
+
+   if (!path || !*path)
+      return false;
+
+   hash = msg_hash_calculate(path);
+
+   strlcpy(menu_thumbnail_st.wanted, path, sizeof(menu_thumbnail_st.wanted));
+   menu_thumbnail_st.wanted_hash = hash;
+
+   menu_thumbnail_cancel_stale();
+
+   entry = menu_thumbnail_find(path, hash);
+
+   if (entry)
+   {
+      menu_thumbnail_st.stats.hits++;
+
+      if (entry->missing)
+         return false;
+
+      menu_thumbnail_deliver(entry);
+      return true;
+   }
+
+   menu_thumbnail_st.stats.misses++;
+
+   /* A prefetch for this path is already underway,
+    * it will be delivered once decoded. */
+   if ((load = menu_thumbnail_find_load(path, hash)))
+   {
+      load->prefetch = false;
+      return true;
+   }
+
+   if (!path_file_exists(path))
+   {
+      menu_thumbnail_insert(path, hash, NULL);
+      return false;
+   }
+
+   return menu_thumbnail_push_load(path, hash, false);
+}
+
+void menu_thumbnail_prefetch(const char *path)
+{
+   uint32_t hash;
+
+   if (!path || !*path)
+      return;
+
+   if (menu_thumbnail_num_loads() >= MENU_THUMBNAIL_MAX_PENDING)
+      return;
+
+   hash = msg_hash_calculate(path);
+
+   if (menu_thumbnail_find(path, hash) || menu_thumbnail_find_load(path, hash))
+      return;
+
+   if (!path_file_exists(path))
+   {
+      menu_thumbnail_insert(path, hash, NULL);
+      return;
+   }
+
+   if (menu_thumbnail_push_load(path, hash, true))
+      menu_thumbnail_st.stats.prefetches++;
+}
+
+void menu_thumbnail_get_path(const char *system, unsigned i,
+      char *s, size_t len)
+{
+   menu_entry_t entry;
+   settings_t *settings = config_get_ptr();
+
+   menu_entry_get(&entry, 0, i, NULL, true);
+
+   fill_pathname_join(s, settings->boxarts_directory, system, len);
+   fill_pathname_join(s, s, "Named_Snaps", len);
+   fill_pathname_join(s, s, entry.path, len);
+
+   strlcat(s, ".png", len);
+}
+
+bool menu_thumbnail_get_system(char *s, size_t len)
+{
+   unsigned menu_type  = 0;
+   menu_handle_t *menu = menu_driver_get_ptr();
+
+   menu_entries_get_last_stack(NULL, NULL, &menu_type, NULL);
+
+   if (!menu || menu_type != MENU_FILE_PLAYLIST_COLLECTION
+         || !*menu->db_playlist_file)
+      return false;
+
+   strlcpy(s, path_basename(menu->db_playlist_file), len);
+   path_remove_extension(s);
+
+   return true;
+}
+
+bool menu_thumbnail_select(const char *system,
+      size_t selection, size_t end)
+{
+   unsigned i;
+   bool ret;
+   char path[PATH_MAX_LENGTH] = {0};
+   int dir = selection < menu_thumbnail_st.selection ? -1 : 1;
+
+   menu_thumbnail_st.selection = selection;
+
+   menu_thumbnail_get_path(system, selection, path, sizeof(path));
+
+   ret = menu_thumbnail_request(path);
+
+   /* Warm the cache for the entries the user
+    * is scrolling towards. */
+   for (i = 1; i <= MENU_THUMBNAIL_PREFETCH; i++)
+   {
+      int64_t idx = (int64_t)selection + dir * (int64_t)i;
+
+      if (idx < 0 || idx >= (int64_t)end)
+         break;
+
+      menu_thumbnail_get_path(system, (unsigned)idx, path, sizeof(path));
+      menu_thumbnail_prefetch(path);
+   }
+
+   return ret;
+}
+
+void menu_thumbnail_get_stats(menu_thumbnail_stats_t *stats)
+{
+   if (stats)
+      *stats = menu_thumbnail_st.stats;
+}
+
+void menu_thumbnail_free(void)
+{
+   unsigned i;
+   menu_thumbnail_load_t *load = NULL;
+   menu_thumbnail_stats_t *stats = &menu_thumbnail_st.stats;
+
+   if (stats->hits || stats->misses)
+      RARCH_LOG("[Thumbnails]: %u hits, %u misses, %u prefetched, "
+            "%u cancelled, %u evicted.\n",
+            stats->hits, stats->misses, stats->prefetches,
+            stats->cancelled, stats->evictions);
+
+   /* In-flight loads free themselves once their task ends. */
+   for (load = menu_thumbnail_st.loads; load; load = load->next)
+   {
+      load->cancelled = true;
+      load->orphaned  = true;
+   }
+   rarch_task_find(menu_thumbnail_cancel_finder, NULL);
+
+   for (i = 0; i < MENU_THUMBNAIL_CACHE_ENTRIES; i++)
+      menu_thumbnail_entry_free(&menu_thumbnail_st.entries[i]);
+
+   memset(&menu_thumbnail_st, 0, sizeof(menu_thumbnail_st));
+}
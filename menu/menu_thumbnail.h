@@ -0,0 +1,124 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2016 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MENU_THUMBNAIL_H__
+#define __MENU_THUMBNAIL_H__
+
+#include <stddef.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of decoded thumbnails kept in memory. */
+#define MENU_THUMBNAIL_CACHE_ENTRIES 32
+
+/* Upper bound for the decoded pixel data kept in memory. */
+#define MENU_THUMBNAIL_CACHE_BYTES   (48 * 1024 * 1024)
+
+/* Maximum number of image loads in flight, prefetches included. */
+#define MENU_THUMBNAIL_MAX_PENDING   4
+
+/* Number of entries prefetched in the scroll direction. */
+#define MENU_THUMBNAIL_PREFETCH      2
+
+/* How long a missing thumbnail is remembered before the
+ * file is looked for again, in microseconds. */
+#define MENU_THUMBNAIL_MISSING_USEC  (10 * 1000000)
+
+typedef struct menu_thumbnail_stats
+{
+   unsigned hits;
+   unsigned misses;
+   unsigned prefetches;
+   unsigned cancelled;
+   unsigned evictions;
+   size_t   entries;
+   size_t   bytes;
+} menu_thumbnail_stats_t;
+
+/**
+ * menu_thumbnail_request:
+ * @path                : Path of the thumbnail image.
+ *
+ * Makes @path the thumbnail the menu is waiting for. Decoded
+ * images are handed to the menu driver through
+ * menu_driver_load_image(MENU_IMAGE_BOXART), immediately when
+ * cached and otherwise once the background load finishes. Loads
+ * for thumbnails requested earlier are cancelled unless they
+ * were prefetched.
+ *
+ * Returns: false if the image does not exist, otherwise true.
+ **/
+bool menu_thumbnail_request(const char *path);
+
+/**
+ * menu_thumbnail_prefetch:
+ * @path                : Path of the thumbnail image.
+ *
+ * Decodes @path into the cache in the background without
+ * handing it to the menu driver.
+ **/
+void menu_thumbnail_prefetch(const char *path);
+
+/**
+ * menu_thumbnail_get_path:
+ * @system              : Playlist the entry belongs to.
+ * @i                   : Index of the entry in the current list.
+ * @s                   : Output path.
+ * @len                 : Size of @s.
+ *
+ * Builds the path of the thumbnail for entry @i.
+ **/
+void menu_thumbnail_get_path(const char *system, unsigned i,
+      char *s, size_t len);
+
+/**
+ * menu_thumbnail_get_system:
+ * @s                   : Output system name.
+ * @len                 : Size of @s.
+ *
+ * Gets the name thumbnails of the current list are filed
+ * under, for menu drivers that browse playlists as plain lists.
+ *
+ * Returns: false if the current list is not a playlist.
+ **/
+bool menu_thumbnail_get_system(char *s, size_t len);
+
+/**
+ * menu_thumbnail_select:
+ * @system              : Playlist the entries belong to.
+ * @selection           : Selected entry.
+ * @end                 : Number of entries in the current list.
+ *
+ * Requests the thumbnail for @selection and prefetches the
+ * next MENU_THUMBNAIL_PREFETCH entries in the direction the
+ * selection last moved.
+ *
+ * Returns: false if the image does not exist, otherwise true.
+ **/
+bool menu_thumbnail_select(const char *system,
+      size_t selection, size_t end);
+
+void menu_thumbnail_get_stats(menu_thumbnail_stats_t *stats);
+
+void menu_thumbnail_free(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,25 +18,79 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#include <io.h>
+#elif !defined(RARCH_CONSOLE)
+#include <unistd.h>
+#endif
+
 #include <rhash.h>
 #include <retro_endianness.h>
 
 #include "movie.h"
+#include "command_event.h"
 #include "general.h"
+#include "libretro_version_1.h"
 #include "msg_hash.h"
 #include "verbosity.h"
+#include "gfx/video_driver.h"
+
+/* BSV2 movies are a header followed by chunks, each a tag,
+ * the frame it starts at and its payload size:
+ *
+ * KEYF: a savestate taken right before that frame ran.
+ *       There is always one at frame 0, then one every
+ *       BSV_KEYFRAME_INTERVAL frames.
+ * INPT: input for a run of frames. Per-frame input counts,
+ *       then the input itself, both run-length coded.
+ * INDX: tag, frame and offset of every chunk above.
+ * END:  marks the end of the chunks.
+ *
+ * Chunks are flushed as they are written, so a movie that
+ * was never finished still plays, its chunks are scanned for
+ * instead of read from the index. Everything is little-endian
+ * apart from the magic, as with BSV1. */
+#define BSV_CHUNK_KEYFRAME      0x4659454bU /* "KEYF" */
+#define BSV_CHUNK_INPUT         0x54504e49U /* "INPT" */
+#define BSV_CHUNK_INDEX         0x58444e49U /* "INDX" */
+#define BSV_CHUNK_END           0x20444e45U /* "END " */
+
+#define BSV_CHUNK_FRAMES        256
+#define BSV_KEYFRAME_INTERVAL   (60 * 60 * 2)
+
+struct bsv_chunk
+{
+   uint32_t tag;
+   uint32_t frame;
+   uint32_t offset;
+};
 
 struct bsv_movie
 {
    FILE *file;
+   unsigned version;
+
+   /* The whole input stream. Recordings are kept around
+    * so rewinding can reach past what was written out. */
+   int16_t *input;
+   size_t input_count;
+   size_t input_cap;
+   size_t input_ptr;
 
-   /* A ring buffer keeping track of positions
-    * in the file for each frame. */
+   /* Where each frame starts in the input stream. */
    size_t *frame_pos;
-   size_t frame_mask;
+   size_t frame_cap;
    size_t frame_ptr;
+   size_t frame_count;
 
-   size_t min_file_pos;
+   /* Chunks in file order, BSV2 only. */
+   struct bsv_chunk *chunks;
+   size_t chunk_count;
+   size_t chunk_cap;
+
+   /* Recording: frames written out, and the last keyframe. */
+   size_t flushed_frames;
+   size_t last_keyframe;
 
    size_t state_size;
    uint8_t *state;
@@ -63,8 +117,507 @@ struct bsv_state
 
 struct bsv_state bsv_movie_state;
 
+static bool bsv_movie_read_words(FILE *file, uint32_t *words, size_t count)
+{
+   size_t i;
+
+   if (fread(words, sizeof(uint32_t), count, file) != count)
+      return false;
+
+   for (i = 0; i < count; i++)
+      words[i] = swap_if_big32(words[i]);
+
+   return true;
+}
+
+static bool bsv_movie_write_words(FILE *file,
+      const uint32_t *words, size_t count)
+{
+   size_t i;
+
+   for (i = 0; i < count; i++)
+   {
+      uint32_t word = swap_if_big32(words[i]);
+      if (fwrite(&word, sizeof(word), 1, file) != 1)
+         return false;
+   }
+
+   return true;
+}
+
+/* Codes @count words as (run, value) pairs. @out must have
+ * room for 2 * @count words. Returns the number written. */
+static size_t bsv_rle_encode(const uint16_t *in, size_t count, uint16_t *out)
+{
+   size_t i   = 0;
+   size_t len = 0;
+
+   while (i < count)
+   {
+      size_t run = 1;
+
+      while (i + run < count && run < 0xffff && in[i + run] == in[i])
+         run++;
+
+      out[len++] = swap_if_big16((uint16_t)run);
+      out[len++] = swap_if_big16(in[i]);
+      i         += run;
+   }
+
+   return len;
+}
+
+static bool bsv_rle_decode(const uint16_t *in, size_t len,
+      uint16_t *out, size_t count)
+{
+   size_t i;
+   size_t pos = 0;
+
+   for (i = 0; i + 1 < len; i += 2)
+   {
+      uint16_t run   = swap_if_big16(in[i]);
+      uint16_t value = swap_if_big16(in[i + 1]);
+
+      if (run > count - pos)
+         return false;
+
+      while (run--)
+         out[pos++] = value;
+   }
+
+   return pos == count;
+}
+
+static bool bsv_movie_reserve_input(bsv_movie_t *handle, size_t count)
+{
+   int16_t *input = NULL;
+   size_t cap     = handle->input_cap ? handle->input_cap : 4096;
+
+   if (count <= handle->input_cap)
+      return true;
+
+   while (cap < count)
+      cap *= 2;
+
+   if (!(input = (int16_t*)realloc(handle->input, cap * sizeof(*input))))
+      return false;
+
+   handle->input     = input;
+   handle->input_cap = cap;
+   return true;
+}
+
+/* Makes frame_pos[@frame] valid. */
+static bool bsv_movie_reserve_frame(bsv_movie_t *handle, size_t frame)
+{
+   size_t *frame_pos = NULL;
+   size_t cap        = handle->frame_cap ? handle->frame_cap : 4096;
+
+   if (frame < handle->frame_cap)
+      return true;
+
+   while (cap <= frame)
+      cap *= 2;
+
+   if (!(frame_pos = (size_t*)realloc(handle->frame_pos,
+               cap * sizeof(*frame_pos))))
+      return false;
+
+   handle->frame_pos = frame_pos;
+   handle->frame_cap = cap;
+   return true;
+}
+
+static bool bsv_movie_add_chunk(bsv_movie_t *handle,
+      uint32_t tag, uint32_t frame, uint32_t offset)
+{
+   struct bsv_chunk *chunk = NULL;
+
+   if (handle->chunk_count == handle->chunk_cap)
+   {
+      size_t cap = handle->chunk_cap ? handle->chunk_cap * 2 : 64;
+      struct bsv_chunk *chunks = (struct bsv_chunk*)
+         realloc(handle->chunks, cap * sizeof(*chunks));
+
+      if (!chunks)
+         return false;
+
+      handle->chunks    = chunks;
+      handle->chunk_cap = cap;
+   }
+
+   chunk         = &handle->chunks[handle->chunk_count++];
+   chunk->tag    = tag;
+   chunk->frame  = frame;
+   chunk->offset = offset;
+   return true;
+}
+
+static bool bsv_movie_write_keyframe(bsv_movie_t *handle)
+{
+   uint32_t chunk[3];
+
+   if (!handle->state_size)
+      return true;
+
+   chunk[0] = BSV_CHUNK_KEYFRAME;
+   chunk[1] = handle->frame_ptr;
+   chunk[2] = handle->state_size;
+
+   if (!bsv_movie_add_chunk(handle, chunk[0], chunk[1], ftell(handle->file)))
+      return false;
+
+   core.retro_serialize(handle->state, handle->state_size);
+
+   if (!bsv_movie_write_words(handle->file, chunk, 3)
+         || fwrite(handle->state, 1, handle->state_size, handle->file)
+         != handle->state_size)
+      return false;
+
+   fflush(handle->file);
+   handle->last_keyframe = handle->frame_ptr;
+   return true;
+}
+
+/* Writes out the input of all frames before @end. */
+static bool bsv_movie_write_input(bsv_movie_t *handle, size_t end)
+{
+   size_t i;
+   uint32_t chunk[6];
+   size_t count_words, value_words;
+   bool ret          = false;
+   size_t start      = handle->flushed_frames;
+   size_t frames     = end - start;
+   size_t first      = handle->frame_pos[start];
+   size_t values     = handle->frame_pos[end] - first;
+   uint16_t *counts  = NULL;
+   uint16_t *out     = NULL;
+
+   if (end <= start)
+      return true;
+
+   counts = (uint16_t*)malloc(frames * sizeof(*counts));
+   out    = (uint16_t*)malloc(2 * (frames + values) * sizeof(*out));
+
+   if (!counts || !out)
+      goto end;
+
+   for (i = 0; i < frames; i++)
+   {
+      size_t count = handle->frame_pos[start + i + 1]
+         - handle->frame_pos[start + i];
+
+      if (count > 0xffff)
+      {
+         RARCH_ERR("Too much input in one frame for a BSV movie.\n");
+         goto end;
+      }
+
+      counts[i] = count;
+   }
+
+   count_words = bsv_rle_encode(counts, frames, out);
+   value_words = bsv_rle_encode((const uint16_t*)handle->input + first,
+         values, out + count_words);
+
+   chunk[0] = BSV_CHUNK_INPUT;
+   chunk[1] = start;
+   chunk[2] = 3 * sizeof(uint32_t)
+      + (count_words + value_words) * sizeof(uint16_t);
+   chunk[3] = frames;
+   chunk[4] = values;
+   chunk[5] = count_words;
+
+   if (!bsv_movie_add_chunk(handle, chunk[0], chunk[1], ftell(handle->file)))
+      goto end;
+
+   if (!bsv_movie_write_words(handle->file, chunk, 6)
+         || fwrite(out, sizeof(*out), count_words + value_words, handle->file)
+         != count_words + value_words)
+      goto end;
+
+   fflush(handle->file);
+   handle->flushed_frames = end;
+   ret = true;
+
+end:
+   free(counts);
+   free(out);
+   return ret;
+}
+
+static bool bsv_movie_write_index(bsv_movie_t *handle)
+{
+   size_t i;
+   uint32_t header[3];
+   uint32_t offset;
+
+   if (!bsv_movie_write_input(handle, handle->frame_ptr))
+      return false;
+
+   offset    = ftell(handle->file);
+   header[0] = BSV_CHUNK_INDEX;
+   header[1] = 0;
+   header[2] = sizeof(uint32_t) * (1 + 3 * handle->chunk_count);
+
+   if (!bsv_movie_write_words(handle->file, header, 3))
+      return false;
+
+   header[0] = handle->chunk_count;
+   if (!bsv_movie_write_words(handle->file, header, 1))
+      return false;
+
+   for (i = 0; i < handle->chunk_count; i++)
+   {
+      header[0] = handle->chunks[i].tag;
+      header[1] = handle->chunks[i].frame;
+      header[2] = handle->chunks[i].offset;
+
+      if (!bsv_movie_write_words(handle->file, header, 3))
+         return false;
+   }
+
+   header[0] = BSV_CHUNK_END;
+   header[1] = handle->frame_ptr;
+   header[2] = 0;
+
+   if (!bsv_movie_write_words(handle->file, header, 3))
+      return false;
+
+   header[0] = offset;
+
+   fseek(handle->file, INDEX_OFFSET_INDEX * sizeof(uint32_t), SEEK_SET);
+   return bsv_movie_write_words(handle->file, header, 1);
+}
+
+static bool bsv_movie_read_index(bsv_movie_t *handle, uint32_t offset)
+{
+   size_t i;
+   uint32_t chunk[3];
+   uint32_t count;
+
+   if (fseek(handle->file, offset, SEEK_SET) != 0
+         || !bsv_movie_read_words(handle->file, chunk, 3)
+         || chunk[0] != BSV_CHUNK_INDEX
+         || !bsv_movie_read_words(handle->file, &count, 1))
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      if (!bsv_movie_read_words(handle->file, chunk, 3)
+            || !bsv_movie_add_chunk(handle, chunk[0], chunk[1], chunk[2]))
+         return false;
+
+      /* Seeking does a binary search over the frames. */
+      if (i && chunk[1] < handle->chunks[i - 1].frame)
+      {
+         RARCH_WARN("Movie index is out of frame order.\n");
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/* For movies that were never finished. */
+static bool bsv_movie_scan_chunks(bsv_movie_t *handle)
+{
+   uint32_t chunk[3];
+   long offset = BSV2_HEADER_SIZE * sizeof(uint32_t);
+
+   handle->chunk_count = 0;
+
+   while (fseek(handle->file, offset, SEEK_SET) == 0
+         && bsv_movie_read_words(handle->file, chunk, 3)
+         && chunk[0] != BSV_CHUNK_END)
+   {
+      if (chunk[0] == BSV_CHUNK_KEYFRAME || chunk[0] == BSV_CHUNK_INPUT)
+      {
+         if (!bsv_movie_add_chunk(handle, chunk[0], chunk[1], offset))
+            return false;
+      }
+
+      offset += 3 * sizeof(uint32_t) + chunk[2];
+   }
+
+   return true;
+}
+
+static bool bsv_movie_read_input(bsv_movie_t *handle,
+      const struct bsv_chunk *chunk)
+{
+   size_t i;
+   uint32_t header[6];
+   size_t words;
+   size_t total      = 0;
+   bool ret          = false;
+   uint16_t *counts  = NULL;
+   uint16_t *in      = NULL;
+
+   if (fseek(handle->file, chunk->offset, SEEK_SET) != 0
+         || !bsv_movie_read_words(handle->file, header, 6))
+      return false;
+
+   /* Input chunks cover the movie back to back. */
+   if (header[1] != handle->frame_count
+         || header[2] < 3 * sizeof(uint32_t))
+      return false;
+
+   words  = (header[2] - 3 * sizeof(uint32_t)) / sizeof(uint16_t);
+   counts = (uint16_t*)malloc((header[3] + 1) * sizeof(*counts));
+   in     = (uint16_t*)malloc((words + 1) * sizeof(*in));
+
+   if (!counts || !in || header[5] > words
+         || fread(in, sizeof(*in), words, handle->file) != words)
+      goto end;
+
+   if (!bsv_movie_reserve_input(handle, handle->input_count + header[4])
+         || !bsv_movie_reserve_frame(handle, handle->frame_count + header[3]))
+      goto end;
+
+   if (!bsv_rle_decode(in, header[5], counts, header[3])
+         || !bsv_rle_decode(in + header[5], words - header[5],
+            (uint16_t*)handle->input + handle->input_count, header[4]))
+      goto end;
+
+   for (i = 0; i < header[3]; i++)
+      total += counts[i];
+
+   if (total != header[4])
+      goto end;
+
+   for (i = 0; i < header[3]; i++)
+   {
+      handle->frame_pos[handle->frame_count++] = handle->input_count;
+      handle->input_count                     += counts[i];
+   }
+
+   handle->frame_pos[handle->frame_count] = handle->input_count;
+   ret = true;
+
+end:
+   free(counts);
+   free(in);
+   return ret;
+}
+
+static bool bsv_movie_load_keyframe(bsv_movie_t *handle,
+      const struct bsv_chunk *chunk)
+{
+   uint32_t header[3];
+
+   if (fseek(handle->file, chunk->offset, SEEK_SET) != 0
+         || !bsv_movie_read_words(handle->file, header, 3)
+         || header[2] != handle->state_size
+         || fread(handle->state, 1, handle->state_size, handle->file)
+         != handle->state_size)
+   {
+      RARCH_ERR("Couldn't read state from movie.\n");
+      return false;
+   }
+
+   if (core.retro_serialize_size() == handle->state_size)
+      core.retro_unserialize(handle->state, handle->state_size);
+   else
+      RARCH_WARN("Movie format seems to have a different serializer version. Will most likely fail.\n");
+
+   return true;
+}
+
+static bool init_playback_bsv2(bsv_movie_t *handle)
+{
+   size_t i;
+   uint32_t header[BSV2_HEADER_SIZE - 4];
+
+   if (!bsv_movie_read_words(handle->file, header, BSV2_HEADER_SIZE - 4))
+   {
+      RARCH_ERR("Couldn't read movie header.\n");
+      return false;
+   }
+
+   handle->version = 2;
+
+   if (!header[INDEX_OFFSET_INDEX - 4]
+         || !bsv_movie_read_index(handle, header[INDEX_OFFSET_INDEX - 4]))
+   {
+      RARCH_WARN("Movie has no index, it was probably not finished.\n");
+      if (!bsv_movie_scan_chunks(handle))
+         return false;
+   }
+
+   for (i = 0; i < handle->chunk_count; i++)
+   {
+      if (handle->chunks[i].tag != BSV_CHUNK_INPUT)
+         continue;
+
+      if (!bsv_movie_read_input(handle, &handle->chunks[i]))
+      {
+         RARCH_WARN("Movie is truncated after frame %u.\n",
+               (unsigned)handle->frame_count);
+         break;
+      }
+   }
+
+   if (handle->state_size)
+   {
+      if (!handle->chunk_count
+            || handle->chunks[0].tag != BSV_CHUNK_KEYFRAME
+            || handle->chunks[0].frame != 0)
+      {
+         RARCH_ERR("Couldn't read state from movie.\n");
+         return false;
+      }
+
+      return bsv_movie_load_keyframe(handle, &handle->chunks[0]);
+   }
+
+   return true;
+}
+
+/* BSV1 is a flat input stream, read it all in. */
+static bool init_playback_bsv1(bsv_movie_t *handle)
+{
+   size_t i;
+   long start, end;
+
+   if (handle->state_size)
+   {
+      if (fread(handle->state, 1, handle->state_size, handle->file)
+            != handle->state_size)
+      {
+         RARCH_ERR("Couldn't read state from movie.\n");
+         return false;
+      }
+
+      if (core.retro_serialize_size() == handle->state_size)
+         core.retro_unserialize(handle->state, handle->state_size);
+      else
+         RARCH_WARN("Movie format seems to have a different serializer version. Will most likely fail.\n");
+   }
+
+   handle->version = 1;
+
+   start = ftell(handle->file);
+   fseek(handle->file, 0, SEEK_END);
+   end   = ftell(handle->file);
+   fseek(handle->file, start, SEEK_SET);
+
+   handle->input_count = (end - start) / sizeof(int16_t);
+
+   if (!bsv_movie_reserve_input(handle, handle->input_count + 1)
+         || fread(handle->input, sizeof(int16_t), handle->input_count,
+            handle->file) != handle->input_count)
+      return false;
+
+   for (i = 0; i < handle->input_count; i++)
+      handle->input[i] = swap_if_big16(handle->input[i]);
+
+   return true;
+}
+
 static bool init_playback(bsv_movie_t *handle, const char *path)
 {
+   uint32_t magic;
    uint32_t state_size;
    uint32_t header[4] = {0};
    global_t *global   = global_get_ptr();
@@ -84,9 +637,11 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
       return false;
    }
 
+   magic = swap_if_little32(header[MAGIC_INDEX]);
+
    /* Compatibility with old implementation that
     * used incorrect documentation. */
-   if (swap_if_little32(header[MAGIC_INDEX]) != BSV_MAGIC
+   if (magic != BSV_MAGIC && magic != BSV2_MAGIC
          && swap_if_big32(header[MAGIC_INDEX]) != BSV_MAGIC)
    {
       RARCH_ERR("Movie file is not a valid BSV1 file.\n");
@@ -104,28 +659,16 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
       handle->state_size = state_size;
       if (!handle->state)
          return false;
-
-      if (fread(handle->state, 1, state_size, handle->file) != state_size)
-      {
-         RARCH_ERR("Couldn't read state from movie.\n");
-         return false;
-      }
-
-      if (core.retro_serialize_size() == state_size)
-         core.retro_unserialize(handle->state, state_size);
-      else
-         RARCH_WARN("Movie format seems to have a different serializer version. Will most likely fail.\n");
    }
 
-   handle->min_file_pos = sizeof(header) + state_size;
-
-   return true;
+   if (magic == BSV2_MAGIC)
+      return init_playback_bsv2(handle);
+   return init_playback_bsv1(handle);
 }
 
 static bool init_record(bsv_movie_t *handle, const char *path)
 {
-   uint32_t state_size;
-   uint32_t header[4] = {0};
+   uint32_t header[BSV2_HEADER_SIZE] = {0};
    global_t *global   = global_get_ptr();
 
    handle->file       = fopen(path, "wb");
@@ -135,29 +678,27 @@ static bool init_record(bsv_movie_t *handle, const char *path)
       return false;
    }
 
-   /* This value is supposed to show up as
-    * BSV1 in a HEX editor, big-endian. */
-   header[MAGIC_INDEX]      = swap_if_little32(BSV_MAGIC);
-   header[CRC_INDEX]        = swap_if_big32(global->content_crc);
-   state_size               = core.retro_serialize_size();
-   header[STATE_SIZE_INDEX] = swap_if_big32(state_size);
+   handle->version          = 2;
+   handle->state_size       = core.retro_serialize_size();
 
-   fwrite(header, 4, sizeof(uint32_t), handle->file);
+   /* The magic is supposed to show up as BSV2
+    * in a HEX editor, big-endian. */
+   header[MAGIC_INDEX]      = swap_if_little32(BSV2_MAGIC);
+   header[CRC_INDEX]        = swap_if_big32(global->content_crc);
+   header[STATE_SIZE_INDEX] = swap_if_big32(handle->state_size);
 
-   handle->min_file_pos     = sizeof(header) + state_size;
-   handle->state_size       = state_size;
+   if (fwrite(header, sizeof(uint32_t), BSV2_HEADER_SIZE, handle->file)
+         != BSV2_HEADER_SIZE)
+      return false;
 
-   if (state_size)
+   if (handle->state_size)
    {
-      handle->state = (uint8_t*)malloc(state_size);
+      handle->state = (uint8_t*)malloc(handle->state_size);
       if (!handle->state)
          return false;
-
-      core.retro_serialize(handle->state, state_size);
-      fwrite(handle->state, 1, state_size, handle->file);
    }
 
-   return true;
+   return bsv_movie_write_keyframe(handle);
 }
 
 void bsv_movie_free(bsv_movie_t *handle)
@@ -166,7 +707,14 @@ void bsv_movie_free(bsv_movie_t *handle)
       return;
 
    if (handle->file)
+   {
+      if (!handle->playback && !bsv_movie_write_index(handle))
+         RARCH_ERR("Couldn't finish writing movie.\n");
       fclose(handle->file);
+   }
+
+   free(handle->input);
+   free(handle->chunks);
    free(handle->state);
    free(handle->frame_pos);
    free(handle);
@@ -175,10 +723,11 @@ void bsv_movie_free(bsv_movie_t *handle)
 bool bsv_movie_get_input(int16_t *input)
 {
    bsv_movie_t *handle = bsv_movie_state.movie;
-   if (fread(input, sizeof(int16_t), 1, handle->file) != 1)
+
+   if (handle->input_ptr >= handle->input_count)
       return false;
 
-   *input = swap_if_big16(*input);
+   *input = handle->input[handle->input_ptr++];
    return true;
 }
 
@@ -186,8 +735,11 @@ void bsv_movie_set_input(int16_t input)
 {
    bsv_movie_t *handle = bsv_movie_state.movie;
 
-   input = swap_if_big16(input);
-   fwrite(&input, sizeof(int16_t), 1, handle->file);
+   if (!bsv_movie_reserve_input(handle, handle->input_ptr + 1))
+      return;
+
+   handle->input[handle->input_ptr++] = input;
+   handle->input_count                = handle->input_ptr;
 }
 
 bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
@@ -196,6 +748,10 @@ bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
    if (!handle)
       return NULL;
 
+   if (!bsv_movie_reserve_frame(handle, handle->frame_count))
+      goto error;
+   handle->frame_pos[0] = 0;
+
    if (type == RARCH_MOVIE_PLAYBACK)
    {
       if (!init_playback(handle, path))
@@ -204,14 +760,6 @@ bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
    else if (!init_record(handle, path))
       goto error;
 
-   /* Just pick something really large 
-    * ~1 million frames rewind should do the trick. */
-   if (!(handle->frame_pos = (size_t*)calloc((1 << 20), sizeof(size_t))))
-      goto error; 
-
-   handle->frame_pos[0]    = handle->min_file_pos;
-   handle->frame_mask      = (1 << 20) - 1;
-
    return handle;
 
 error:
@@ -223,7 +771,16 @@ void bsv_movie_set_frame_start(bsv_movie_t *handle)
 {
    if (!handle)
       return;
-   handle->frame_pos[handle->frame_ptr] = ftell(handle->file);
+
+   if (!handle->playback
+         && handle->frame_ptr >= handle->last_keyframe + BSV_KEYFRAME_INTERVAL)
+   {
+      if (!bsv_movie_write_input(handle, handle->frame_ptr)
+            || !bsv_movie_write_keyframe(handle))
+         RARCH_ERR("Couldn't write to movie.\n");
+   }
+
+   handle->frame_pos[handle->frame_ptr] = handle->input_ptr;
 }
 
 void bsv_movie_set_frame_end(bsv_movie_t *handle)
@@ -231,50 +788,199 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle)
    if (!handle)
       return;
 
-   handle->frame_ptr    = (handle->frame_ptr + 1) & handle->frame_mask;
+   if (!bsv_movie_reserve_frame(handle, handle->frame_ptr + 1))
+      return;
+
+   handle->frame_ptr++;
+   handle->frame_pos[handle->frame_ptr] = handle->input_ptr;
+
+   if (!handle->playback && handle->frame_ptr
+         >= handle->flushed_frames + BSV_CHUNK_FRAMES)
+   {
+      if (!bsv_movie_write_input(handle, handle->frame_ptr))
+         RARCH_ERR("Couldn't write to movie.\n");
+   }
 
    handle->first_rewind = !handle->did_rewind;
    handle->did_rewind   = false;
 }
 
+/* Cuts the file at @offset and carries on writing there, so
+ * that stale chunks past it don't get scanned in should the
+ * movie not be finished. */
+static void bsv_movie_truncate_file(bsv_movie_t *handle, long offset)
+{
+   fflush(handle->file);
+#if defined(_WIN32)
+   _chsize(_fileno(handle->file), offset);
+#elif !defined(RARCH_CONSOLE)
+   if (ftruncate(fileno(handle->file), offset) != 0)
+      RARCH_WARN("Couldn't truncate movie.\n");
+#endif
+   fseek(handle->file, offset, SEEK_SET);
+}
+
+/* Drops everything written from the input chunk holding
+ * frame_ptr onwards, it is about to be recorded over. */
+static void bsv_movie_truncate(bsv_movie_t *handle)
+{
+   size_t i;
+
+   if (handle->frame_ptr >= handle->flushed_frames)
+      return;
+
+   for (i = handle->chunk_count; i-- > 0; )
+   {
+      const struct bsv_chunk *chunk = &handle->chunks[i];
+
+      if (chunk->tag == BSV_CHUNK_INPUT && chunk->frame <= handle->frame_ptr)
+         break;
+   }
+
+   if (i >= handle->chunk_count)
+      return;
+
+   bsv_movie_truncate_file(handle, handle->chunks[i].offset);
+   handle->flushed_frames = handle->chunks[i].frame;
+   handle->chunk_count    = i;
+   handle->last_keyframe  = 0;
+
+   for (i = 0; i < handle->chunk_count; i++)
+      if (handle->chunks[i].tag == BSV_CHUNK_KEYFRAME)
+         handle->last_keyframe = handle->chunks[i].frame;
+}
+
 void bsv_movie_frame_rewind(bsv_movie_t *handle)
 {
    handle->did_rewind = true;
 
-   if ((handle->frame_ptr <= 1) && (handle->frame_pos[0] == handle->min_file_pos))
+   if (handle->frame_ptr <= 1)
    {
       /* If we're at the beginning... */
       handle->frame_ptr = 0;
-      fseek(handle->file, handle->min_file_pos, SEEK_SET);
    }
    else
    {
       /* First time rewind is performed, the old frame is simply replayed.
        * However, playing back that frame caused us to read data, and push
-       * data to the ring buffer.
+       * data to the frame positions.
        *
        * Sucessively rewinding frames, we need to rewind past the read data,
        * plus another. */
-      handle->frame_ptr = (handle->frame_ptr -
-            (handle->first_rewind ? 1 : 2)) & handle->frame_mask;
-      fseek(handle->file, handle->frame_pos[handle->frame_ptr], SEEK_SET);
+      handle->frame_ptr -= handle->first_rewind ? 1 : 2;
+   }
+
+   handle->input_ptr = handle->frame_pos[handle->frame_ptr];
+
+   if (handle->playback)
+      return;
+
+   if (handle->frame_ptr == 0)
+   {
+      /* We rewound past the beginning. If recording,
+       * we simply reset the starting point. Nice and easy. */
+      bsv_movie_truncate_file(handle, BSV2_HEADER_SIZE * sizeof(uint32_t));
+      handle->chunk_count    = 0;
+      handle->flushed_frames = 0;
+      handle->input_count    = 0;
+
+      if (!bsv_movie_write_keyframe(handle))
+         RARCH_ERR("Couldn't write to movie.\n");
    }
+   else
+      bsv_movie_truncate(handle);
+}
 
-   if (ftell(handle->file) <= (long)handle->min_file_pos)
+static void bsv_movie_video_null(const void *data,
+      unsigned width, unsigned height, size_t pitch)
+{
+   (void)data;
+   (void)width;
+   (void)height;
+   (void)pitch;
+}
+
+static void bsv_movie_audio_sample_null(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
+
+static size_t bsv_movie_audio_sample_batch_null(
+      const int16_t *data, size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+/**
+ * bsv_movie_seek:
+ * @handle               : movie being played back.
+ * @frame                : frame to seek to.
+ *
+ * Loads the last keyframe at or before @frame, found with a
+ * binary search, then runs the core up to @frame without
+ * presenting, playing or recording the frames in between.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool bsv_movie_seek(bsv_movie_t *handle, size_t frame)
+{
+   size_t lo, hi;
+   const struct bsv_chunk *key = NULL;
+   retro_video_refresh_t video_refresh = retro_get_video_refresh();
+
+   if (!handle || !handle->playback || handle->version < 2
+         || !handle->state_size || frame > handle->frame_count)
+      return false;
+
+   /* Chunks are in frame order. Find the last one at or
+    * before @frame, then the keyframe leading it. */
+   lo = 0;
+   hi = handle->chunk_count;
+
+   while (lo < hi)
    {
-      /* We rewound past the beginning. */
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (handle->chunks[mid].frame <= frame)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
 
-      if (!handle->playback)
+   while (lo-- > 0)
+   {
+      if (handle->chunks[lo].tag == BSV_CHUNK_KEYFRAME)
       {
-         /* If recording, we simply reset
-          * the starting point. Nice and easy. */
-         fseek(handle->file, 4 * sizeof(uint32_t), SEEK_SET);
-         core.retro_serialize(handle->state, handle->state_size);
-         fwrite(handle->state, 1, handle->state_size, handle->file);
+         key = &handle->chunks[lo];
+         break;
       }
-      else
-         fseek(handle->file, handle->min_file_pos, SEEK_SET);
    }
+
+   if (!key || !bsv_movie_load_keyframe(handle, key))
+      return false;
+
+   handle->frame_ptr  = key->frame;
+   handle->input_ptr  = handle->frame_pos[key->frame];
+   handle->did_rewind = false;
+
+   core.retro_set_video_refresh(bsv_movie_video_null);
+   core.retro_set_audio_sample(bsv_movie_audio_sample_null);
+   core.retro_set_audio_sample_batch(bsv_movie_audio_sample_batch_null);
+
+   while (handle->frame_ptr < frame)
+   {
+      bsv_movie_set_frame_start(handle);
+      core.retro_run();
+      bsv_movie_set_frame_end(handle);
+   }
+
+   core.retro_set_video_refresh(video_refresh
+         ? video_refresh : video_driver_frame);
+   retro_set_rewind_callbacks();
+
+   return true;
 }
 
 static void bsv_movie_init_state(void)
@@ -380,6 +1086,19 @@ bool bsv_movie_ctl(enum bsv_ctl_state state, void *data)
       case BSV_MOVIE_CTL_FRAME_REWIND:
          bsv_movie_frame_rewind(bsv_movie_state.movie);
          break;
+      case BSV_MOVIE_CTL_SEEK:
+         {
+            unsigned *frame = (unsigned*)data;
+            if (!frame || !bsv_movie_state.movie_playback
+                  || !bsv_movie_seek(bsv_movie_state.movie, *frame))
+               return false;
+
+            /* What was rewound or played to the end is gone. */
+            bsv_movie_state.movie_end = false;
+            event_command(EVENT_CMD_REWIND_DEINIT);
+            event_command(EVENT_CMD_REWIND_INIT);
+         }
+         break;
       default:
          return false;
    }
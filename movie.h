@@ -26,11 +26,16 @@ extern "C" {
 #include <boolean.h>
 
 #define BSV_MAGIC 0x42535631
+#define BSV2_MAGIC 0x42535632
 
 #define MAGIC_INDEX 0
 #define SERIALIZER_INDEX 1
 #define CRC_INDEX 2
 #define STATE_SIZE_INDEX 3
+/* BSV2 only. */
+#define INDEX_OFFSET_INDEX 4
+
+#define BSV2_HEADER_SIZE 5
 
 typedef struct bsv_movie bsv_movie_t;
 
@@ -55,6 +60,7 @@ enum bsv_ctl_state
    BSV_MOVIE_CTL_SET_FRAME_START,
    BSV_MOVIE_CTL_SET_FRAME_END,
    BSV_MOVIE_CTL_FRAME_REWIND,
+   BSV_MOVIE_CTL_SEEK,
    BSV_MOVIE_CTL_DEINIT,
    BSV_MOVIE_CTL_INIT,
    BSV_MOVIE_CTL_END_EOF,
@@ -85,6 +91,8 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle);
 
 void bsv_movie_frame_rewind(bsv_movie_t *handle);
 
+bool bsv_movie_seek(bsv_movie_t *handle, size_t frame);
+
 void bsv_movie_free(bsv_movie_t *handle);
 
 bool bsv_movie_ctl(enum bsv_ctl_state state, void *data);
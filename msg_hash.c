@@ -17,20 +17,34 @@
 #include <string.h>
 
 #include <rhash.h>
+#include <boolean.h>
+#include <retro_miscellaneous.h>
 
 #include "msg_hash.h"
 
-#include "configuration.h"
+#include "libretro.h"
 
-const char *msg_hash_to_str(uint32_t hash)
+#include "intl/msg_hash_lut.h"
+
+#define MSG_HASH_LUT_SIZE (1 << MSG_HASH_LUT_BITS)
+
+#define MSG_HASH_LUT_INDEX(hash) \
+   ((uint32_t)((hash) * MSG_HASH_LUT_MULT) >> (32 - MSG_HASH_LUT_BITS))
+
+typedef struct msg_hash_lut_entry
 {
-   const char *ret = NULL;
-   settings_t *settings = config_get_ptr();
+   uint32_t hash;
+   const char *str;
+} msg_hash_lut_entry_t;
 
-   if (!settings)
-      goto end;
+static msg_hash_lut_entry_t msg_hash_lut[MSG_HASH_LUT_SIZE];
+static bool msg_hash_lut_inited;
 
-   switch (settings->user_language)
+static const char *msg_hash_to_str_lang(unsigned language, uint32_t hash)
+{
+   const char *ret = NULL;
+
+   switch (language)
    {
       case RETRO_LANGUAGE_FRENCH:
          ret = msg_hash_to_str_fr(hash);
@@ -63,7 +77,46 @@ const char *msg_hash_to_str(uint32_t hash)
    if (ret && strcmp(ret, "null") != 0)
       return ret;
 
-end:
+   return msg_hash_to_str_us(hash);
+}
+
+/**
+ * msg_hash_set_language:
+ * @language            : RETRO_LANGUAGE_* value.
+ *
+ * Resolves every translated message for @language up front,
+ * falling back to English for missing translations, so that
+ * msg_hash_to_str() becomes a single table lookup.
+ **/
+void msg_hash_set_language(unsigned language)
+{
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(msg_hash_lut_keys); i++)
+   {
+      uint32_t hash              = msg_hash_lut_keys[i];
+      msg_hash_lut_entry_t *entry = &msg_hash_lut[MSG_HASH_LUT_INDEX(hash)];
+
+      entry->str  = msg_hash_to_str_lang(language, hash);
+      entry->hash = hash;
+   }
+
+   msg_hash_lut_inited = true;
+}
+
+const char *msg_hash_to_str(uint32_t hash)
+{
+   const msg_hash_lut_entry_t *entry = NULL;
+
+   if (!msg_hash_lut_inited)
+      msg_hash_set_language(RETRO_LANGUAGE_ENGLISH);
+
+   entry = &msg_hash_lut[MSG_HASH_LUT_INDEX(hash)];
+
+   if (entry->hash == hash && entry->str)
+      return entry->str;
+
+   /* Not in any translation, msg_hash_lut.h may be out of date. */
    return msg_hash_to_str_us(hash);
 }
 
@@ -84,6 +84,7 @@
 #define MSG_SLOW_MOTION_REWIND                        0x385adb27U
 #define MSG_SLOW_MOTION                               0x744c437fU
 #define MSG_REWIND_REACHED_END                        0x4f1aab8fU
+#define MSG_RUNAHEAD_FAILED_TO_LOAD_STATE             0x0bfe25d2U
 #define MSG_FAILED_TO_START_MOVIE_RECORD              0x61221776U
 
 #define MSG_STATE_SLOT                                0x27b67f67U
@@ -93,6 +94,8 @@
 #define MSG_FAILED_TO_APPLY_SHADER                    0x2094eb67U
 #define MSG_APPLYING_SHADER                           0x35599b7fU
 #define MSG_SHADER                                    0x1bb1211cU
+#define MSG_SHADER_RELOADED                           0x72e37fbbU
+#define MSG_SHADER_FAILED_TO_RELOAD                   0xbf699c58U
 
 #define MSG_REDIRECTING_SAVESTATE_TO                  0x8d98f7a6U
 #define MSG_REDIRECTING_SAVEFILE_TO                   0x868c54a5U
@@ -155,6 +158,8 @@
 #define MSG_DOWNLOADING                               0x465305dbU
 #define MSG_EXTRACTING                                0x25a4c19eU
 
+void msg_hash_set_language(unsigned language);
+
 const char *msg_hash_to_str(uint32_t hash);
 
 const char *msg_hash_to_str_fr(uint32_t hash);
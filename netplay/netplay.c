@@ -26,6 +26,7 @@
 #include <retro_endianness.h>
 
 #include "netplay_private.h"
+#include "../performance.h"
 
 enum
 {
@@ -43,7 +44,7 @@ void *netplay_data;
  *
  * Warns that netplay has disconnected.
  **/
-static void warn_hangup(void)
+void warn_hangup(void)
 {
    RARCH_WARN("Netplay has disconnected. Will continue without connection ...\n");
    runloop_msg_queue_push("Netplay has disconnected. Will continue without connection.", 0, 480, false);
@@ -89,6 +90,17 @@ static bool netplay_can_poll(netplay_t *netplay)
    return netplay->can_poll;
 }
 
+/* Only frames the peer has not acknowledged yet are sent,
+ * so redundancy follows the actual loss and round trip. */
+static unsigned netplay_packet_frames(netplay_t *netplay)
+{
+   uint32_t unacked = netplay->frame_count + 1 - netplay->peer_ack;
+
+   if (netplay->peer_ack > netplay->frame_count)
+      return 1;
+   return min(max(unacked, 1), UDP_FRAME_PACKETS);
+}
+
 static bool send_chunk(netplay_t *netplay)
 {
    const struct sockaddr *addr = NULL;
@@ -101,18 +113,30 @@ static bool send_chunk(netplay_t *netplay)
    if (addr)
    {
       ssize_t bytes_sent;
+      uint32_t packet[1 + UDP_FRAME_PACKETS * 2];
+      unsigned frames = netplay_packet_frames(netplay);
+      size_t size     = (1 + frames * 2) * sizeof(uint32_t);
+
+      /* Next frame we need from the peer, then our newest frames. */
+      packet[0] = htonl(netplay->read_frame_count);
+      memcpy(packet + 1,
+            netplay->packet_buffer + (UDP_FRAME_PACKETS - frames) * 2,
+            frames * 2 * sizeof(uint32_t));
+
+      netplay->frames_sent += frames;
+      netplay->packets_sent++;
 
 #ifdef HAVE_IPV6
-      bytes_sent = (sendto(netplay->udp_fd, (const char*)netplay->packet_buffer,
-               sizeof(netplay->packet_buffer), 0, addr,
+      bytes_sent = (sendto(netplay->udp_fd, (const char*)packet,
+               size, 0, addr,
                sizeof(struct sockaddr_in6)));
 #else
-      bytes_sent = (sendto(netplay->udp_fd, (const char*)netplay->packet_buffer,
-               sizeof(netplay->packet_buffer), 0, addr,
+      bytes_sent = (sendto(netplay->udp_fd, (const char*)packet,
+               size, 0, addr,
                sizeof(struct sockaddr_in)));
 #endif
 
-      if (bytes_sent != sizeof(netplay->packet_buffer))
+      if (bytes_sent != (ssize_t)size)
       {
          warn_hangup();
          netplay->has_connection = false;
@@ -164,6 +188,8 @@ static bool get_self_input_state(netplay_t *netplay)
          sizeof (netplay->packet_buffer) - 2 * sizeof(uint32_t));
    netplay->packet_buffer[(UDP_FRAME_PACKETS - 1) * 2] = htonl(netplay->frame_count); 
    netplay->packet_buffer[(UDP_FRAME_PACKETS - 1) * 2 + 1] = htonl(state);
+   netplay->send_time[netplay->frame_count % UDP_FRAME_PACKETS] =
+      retro_get_time_usec();
 
    if (!send_chunk(netplay))
    {
@@ -251,9 +277,29 @@ static bool netplay_get_cmd(netplay_t *netplay)
          warn_hangup();
          return netplay_cmd_ack(netplay);
 
+      case NETPLAY_CMD_CRC:
+         {
+            uint32_t args[2];
+
+            /* Sent without waiting for a response, so none is given. */
+            if (cmd_size != sizeof(args) ||
+                  !socket_receive_all_blocking(netplay->fd, args, sizeof(args)))
+            {
+               RARCH_ERR("Failed to receive CMD_CRC arguments.\n");
+               return false;
+            }
+
+            netplay_net_recv_crc(netplay, ntohl(args[0]), ntohl(args[1]));
+         }
+         return true;
+
       case NETPLAY_CMD_LOAD_SAVESTATE:
-         RARCH_ERR("NETPLAY_CMD_LOAD_SAVESTATE unimplemented.\n");
-         return netplay_cmd_nak(netplay);
+         if (cmd_size != 2 * sizeof(uint32_t) || np_is_server(netplay))
+         {
+            RARCH_ERR("CMD_LOAD_SAVESTATE received unexpectedly.\n");
+            return false;
+         }
+         return netplay_net_recv_savestate(netplay);
 
       case NETPLAY_CMD_PAUSE:
          event_command(EVENT_CMD_PAUSE);
@@ -273,6 +319,9 @@ static bool netplay_get_cmd(netplay_t *netplay)
 #define MAX_RETRIES 16
 #define RETRY_MS 500
 
+/* Runs on the emulation thread, unlike spectator traffic.
+ * Blocking here is lockstep waiting for the peer's input, a
+ * network thread would have to be waited on all the same. */
 static int poll_input(netplay_t *netplay, bool block)
 {
    int max_fd        = (netplay->fd > netplay->udp_fd ? netplay->fd : netplay->udp_fd) + 1;
@@ -315,6 +364,7 @@ static int poll_input(netplay_t *netplay, bool block)
          return -1;
       }
 
+      netplay->stalls++;
       RARCH_LOG("Network is stalling, resending packet... Count %u of %d ...\n",
             netplay->timeout_cnt, MAX_RETRIES);
    } while ((netplay->timeout_cnt < MAX_RETRIES) && block);
@@ -324,26 +374,56 @@ static int poll_input(netplay_t *netplay, bool block)
    return 0;
 }
 
-static bool receive_data(netplay_t *netplay, uint32_t *buffer, size_t size)
+/* Returns the number of frames in the packet, or -1 on error. */
+static int receive_data(netplay_t *netplay, uint32_t *buffer, size_t size)
 {
    socklen_t addrlen = sizeof(netplay->their_addr);
+   ssize_t len       = recvfrom(netplay->udp_fd, (char*)buffer, size, 0,
+            (struct sockaddr*)&netplay->their_addr, &addrlen);
 
-   if (recvfrom(netplay->udp_fd, (char*)buffer, size, 0,
-            (struct sockaddr*)&netplay->their_addr, &addrlen) != (ssize_t)size)
-      return false;
+   if (len < (ssize_t)(3 * sizeof(uint32_t))
+         || (len - sizeof(uint32_t)) % (2 * sizeof(uint32_t)))
+      return -1;
 
    netplay->has_client_addr = true;
 
-   return true;
+   return (len - sizeof(uint32_t)) / (2 * sizeof(uint32_t));
+}
+
+/* Samples the round trip of the newest frame the peer
+ * acknowledged, as long as we still know when it was sent. */
+static void netplay_update_ack(netplay_t *netplay, uint32_t ack)
+{
+   int64_t rtt, diff;
+   uint32_t frame = ack - 1;
+
+   if (ack <= netplay->peer_ack)
+      return;
+
+   netplay->peer_ack = ack;
+
+   if (netplay->frame_count - frame >= UDP_FRAME_PACKETS)
+      return;
+
+   rtt  = retro_get_time_usec()
+      - netplay->send_time[frame % UDP_FRAME_PACKETS];
+   diff = rtt - netplay->rtt_avg;
+
+   netplay->rtt_avg    += diff / 8;
+   netplay->rtt_jitter += ((diff < 0 ? -diff : diff) - netplay->rtt_jitter) / 8;
 }
 
 static void parse_packet(netplay_t *netplay, uint32_t *buffer, unsigned size)
 {
    unsigned i;
+   unsigned received = 0;
 
-   for (i = 0; i < size * 2; i++)
+   for (i = 0; i < 1 + size * 2; i++)
       buffer[i] = ntohl(buffer[i]);
 
+   netplay_update_ack(netplay, buffer[0]);
+   buffer++;
+
    for (i = 0; i < size && netplay->read_frame_count <= netplay->frame_count; i++)
    {
       uint32_t frame = buffer[2 * i + 0];
@@ -357,7 +437,24 @@ static void parse_packet(netplay_t *netplay, uint32_t *buffer, unsigned size)
       netplay->read_ptr = NEXT_PTR(netplay->read_ptr);
       netplay->read_frame_count++;
       netplay->timeout_cnt = 0;
+      received++;
    }
+
+   /* Frames the peer had to send again, because we did not
+    * acknowledge them in time or their packet was lost. */
+   if (received > 1)
+      netplay->lost_frames += received - 1;
+}
+
+/* Tracks how far behind remote input arrives, as running
+ * averages with 4 bits of fraction. */
+static void netplay_update_lag(netplay_t *netplay)
+{
+   int lag  = (int)(netplay->frame_count - netplay->read_frame_count) << 4;
+   int diff = lag - netplay->lag_avg;
+
+   netplay->lag_avg    += diff / 8;
+   netplay->lag_jitter += ((diff < 0 ? -diff : diff) - netplay->lag_jitter) / 8;
 }
 
 /* TODO: Somewhat better prediction. :P */
@@ -372,6 +469,14 @@ static void simulate_input(netplay_t *netplay)
    netplay->buffer[ptr].used_real = false;
 }
 
+/* True once we ran delay_frames past the last frame with
+ * confirmed input, where we have to block for the peer. */
+static bool netplay_buffer_full(netplay_t *netplay)
+{
+   return netplay->frame_count - netplay->other_frame_count
+      >= netplay->delay_frames;
+}
+
 /**
  * netplay_poll:
  * @netplay              : pointer to netplay object
@@ -408,7 +513,7 @@ static bool netplay_poll(netplay_t *netplay)
 
    /* We might have reached the end of the buffer, where we 
     * simply have to block. */
-   res = poll_input(netplay, netplay->other_ptr == netplay->self_ptr);
+   res = poll_input(netplay, netplay_buffer_full(netplay));
    if (res == -1)
    {
       netplay->has_connection = false;
@@ -421,29 +526,32 @@ static bool netplay_poll(netplay_t *netplay)
       uint32_t first_read = netplay->read_frame_count;
       do 
       {
-         uint32_t buffer[UDP_FRAME_PACKETS * 2];
-         if (!receive_data(netplay, buffer, sizeof(buffer)))
+         uint32_t buffer[1 + UDP_FRAME_PACKETS * 2];
+         int frames = receive_data(netplay, buffer, sizeof(buffer));
+         if (frames < 0)
          {
             warn_hangup();
             netplay->has_connection = false;
             return false;
          }
-         parse_packet(netplay, buffer, UDP_FRAME_PACKETS);
+         parse_packet(netplay, buffer, frames);
 
       } while ((netplay->read_frame_count <= netplay->frame_count) && 
-            poll_input(netplay, (netplay->other_ptr == netplay->self_ptr) && 
+            poll_input(netplay, netplay_buffer_full(netplay) && 
                (first_read == netplay->read_frame_count)) == 1);
    }
    else
    {
       /* Cannot allow this. Should not happen though. */
-      if (netplay->self_ptr == netplay->other_ptr)
+      if (netplay_buffer_full(netplay))
       {
          warn_hangup();
          return false;
       }
    }
 
+   netplay_update_lag(netplay);
+
    if (netplay->read_ptr != netplay->self_ptr)
       simulate_input(netplay);
    else
@@ -946,6 +1054,18 @@ void netplay_free(netplay_t *netplay)
 {
    unsigned i;
 
+   if (netplay->rollback_count)
+      RARCH_LOG("Netplay: %u rollbacks, %u frames replayed "
+            "(max depth %u), %u redundant serializes skipped.\n",
+            netplay->rollback_count, netplay->rollback_frames,
+            netplay->rollback_max_depth, netplay->serialize_skipped);
+   if (netplay->check.resyncs)
+      RARCH_LOG("Netplay: recovered from %u desyncs.\n",
+            netplay->check.resyncs);
+
+   if (netplay->spectate.enabled)
+      netplay_spectate_deinit(netplay);
+
    socket_close(netplay->fd);
 
    if (netplay->spectate.enabled)
@@ -963,6 +1083,8 @@ void netplay_free(netplay_t *netplay)
       for (i = 0; i < netplay->buffer_size; i++)
          free(netplay->buffer[i].state);
 
+      netplay_net_free_check(netplay);
+
       free(netplay->buffer);
    }
 
@@ -1106,6 +1228,29 @@ bool init_netplay(void)
    return false;
 }
 
+static void netplay_get_stats(netplay_t *netplay, netplay_stats_t *stats)
+{
+   memset(stats, 0, sizeof(*stats));
+
+   stats->spectate = netplay->spectate.enabled;
+
+   if (netplay->spectate.enabled)
+   {
+      if (np_is_server(netplay))
+         stats->spectators = netplay_spectate_count(netplay);
+      return;
+   }
+
+   stats->input_lag   = netplay->lag_avg / 16.0f;
+   stats->jitter      = netplay->lag_jitter / 16.0f;
+   stats->lost_frames = netplay->lost_frames;
+   stats->stalls      = netplay->stalls;
+   stats->rtt         = netplay->rtt_avg / 1000.0f;
+   stats->rtt_jitter  = netplay->rtt_jitter / 1000.0f;
+   if (netplay->packets_sent)
+      stats->redundancy = (float)netplay->frames_sent / netplay->packets_sent;
+}
+
 bool netplay_driver_ctl(enum rarch_netplay_ctl_state state, void *data)
 {
    if (!netplay_data)
@@ -1115,6 +1260,9 @@ bool netplay_driver_ctl(enum rarch_netplay_ctl_state state, void *data)
    {
       case RARCH_NETPLAY_CTL_IS_DATA_INITED:
          return true;
+      case RARCH_NETPLAY_CTL_GET_STATS:
+         netplay_get_stats((netplay_t*)netplay_data, (netplay_stats_t*)data);
+         return true;
       case RARCH_NETPLAY_CTL_POST_FRAME:
          netplay_post_frame((netplay_t*)netplay_data);
          break;
@@ -35,9 +35,28 @@ enum rarch_netplay_ctl_state
    RARCH_NETPLAY_CTL_FULLSCREEN_TOGGLE,
    RARCH_NETPLAY_CTL_POST_FRAME,
    RARCH_NETPLAY_CTL_PRE_FRAME,
-   RARCH_NETPLAY_CTL_IS_DATA_INITED
+   RARCH_NETPLAY_CTL_IS_DATA_INITED,
+   RARCH_NETPLAY_CTL_GET_STATS
 };
 
+typedef struct netplay_stats
+{
+   /* Frames the remote input arrives behind local input. */
+   float input_lag;
+   float jitter;
+   /* Frames only received through redundant packet data. */
+   unsigned lost_frames;
+   /* Times the network stalled and input was resent. */
+   unsigned stalls;
+   /* Milliseconds until our input is acknowledged. */
+   float rtt;
+   float rtt_jitter;
+   /* Average frames of input per packet sent. */
+   float redundancy;
+   unsigned spectators;
+   bool spectate;
+} netplay_stats_t;
+
 /* TODO: most of this, actually */
 /* /!\ WARNING: A command identifier cannot exceed 16 bytes in length. */
 enum netplay_cmd
@@ -57,6 +76,8 @@ enum netplay_cmd
                                              each one individually.                    */
 
 /* loading and synchronization */
+   NETPLAY_CMD_CRC            = 0x0010, /**< Checksum of the state at a frame both
+                                             peers have confirmed input for.           */
    NETPLAY_CMD_LOAD_SAVESTATE = 0x0012, /** Send a savestate for the client to load    */
    NETPLAY_CMD_CHEATS         = 0x0013, /** Sends over cheats enabled on client.       */
 /* controlling game playback */
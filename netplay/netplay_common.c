@@ -15,7 +15,7 @@
  */
 
 #include "netplay_private.h"
-bool np_get_nickname(netplay_t *netplay, int fd)
+bool np_get_nickname(int fd, char *nick, size_t size)
 {
    uint8_t nick_size;
 
@@ -25,18 +25,20 @@ bool np_get_nickname(netplay_t *netplay, int fd)
       return false;
    }
 
-   if (nick_size >= sizeof(netplay->other_nick))
+   if (nick_size >= size)
    {
       RARCH_ERR("Invalid nick size.\n");
       return false;
    }
 
-   if (!socket_receive_all_blocking(fd, netplay->other_nick, nick_size))
+   if (!socket_receive_all_blocking(fd, nick, nick_size))
    {
       RARCH_ERR("Failed to receive nick.\n");
       return false;
    }
 
+   nick[nick_size] = '\0';
+
    return true;
 }
 bool np_send_nickname(netplay_t *netplay, int fd)
@@ -165,6 +167,8 @@ uint32_t np_impl_magic(void)
    for (i = 0; i < len; i++)
       res ^= ver[i] << ((i & 0xf) + 16);
 
+   res ^= NETPLAY_PROTOCOL_VERSION << 24;
+
    return res;
 }
 
@@ -199,7 +203,8 @@ bool np_send_info(netplay_t *netplay)
       return false;
    }
 
-   if (!np_get_nickname(netplay, netplay->fd))
+   if (!np_get_nickname(netplay->fd,
+            netplay->other_nick, sizeof(netplay->other_nick)))
    {
       RARCH_ERR("Failed to receive nick from host.\n");
       return false;
@@ -243,7 +248,8 @@ bool np_get_info(netplay_t *netplay)
       return false;
    }
 
-   if (!np_get_nickname(netplay, netplay->fd))
+   if (!np_get_nickname(netplay->fd,
+            netplay->other_nick, sizeof(netplay->other_nick)))
    {
       RARCH_ERR("Failed to get nickname from client.\n");
       return false;
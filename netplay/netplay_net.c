@@ -14,7 +14,240 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
+#include <file/file_extract.h>
+#include <retro_miscellaneous.h>
+
 #include "netplay_private.h"
+#include "../performance.h"
+#include "../rewind.h"
+
+/* Peers periodically exchange a checksum of the state at a frame
+ * both have confirmed input for. On a mismatch the host sends its
+ * state as a delta against the last state both agreed on, encoded
+ * with the rewind delta compressor, and the client replays from it. */
+
+static void netplay_net_check_compare(netplay_t *netplay)
+{
+   void *tmp;
+
+   if (!netplay->check.done || !netplay->check.has_remote)
+      return;
+
+   /* A check only one side made, drop the older one. */
+   if (netplay->check.remote_frame != netplay->check.frame)
+   {
+      if (netplay->check.remote_frame < netplay->check.frame)
+         netplay->check.has_remote = false;
+      else
+         netplay->check.done       = false;
+      return;
+   }
+
+   netplay->check.done       = false;
+   netplay->check.has_remote = false;
+
+   if (netplay->check.remote_crc == netplay->check.crc)
+   {
+      tmp                   = netplay->check.agreed;
+      netplay->check.agreed = netplay->check.local;
+      netplay->check.local  = tmp;
+      return;
+   }
+
+   RARCH_WARN("Netplay desync detected at frame %u.\n",
+         (unsigned)netplay->check.frame);
+
+   if (np_is_server(netplay))
+   {
+      /* Our state at other_ptr has all input confirmed. */
+      uint32_t cmd, args[2];
+      size_t patch_len;
+
+      memcpy(netplay->check.resync,
+            netplay->buffer[netplay->other_ptr].state, netplay->state_size);
+      /* The patch carries the first state's words, so applying
+       * it to the agreed state on the client yields ours. */
+      patch_len = state_manager_raw_compress(netplay->check.resync,
+            netplay->check.agreed, netplay->state_size, netplay->check.patch);
+
+      cmd     = htonl((NETPLAY_CMD_LOAD_SAVESTATE << 16) | sizeof(args));
+      args[0] = htonl(netplay->other_frame_count);
+      args[1] = htonl(patch_len);
+
+      RARCH_LOG("Netplay: sending %u byte state delta for frame %u.\n",
+            (unsigned)patch_len, (unsigned)netplay->other_frame_count);
+
+      if (!socket_send_all_blocking(netplay->fd, &cmd, sizeof(cmd)) ||
+            !socket_send_all_blocking(netplay->fd, args, sizeof(args)) ||
+            !socket_send_all_blocking(netplay->fd,
+               netplay->check.patch, patch_len))
+      {
+         warn_hangup();
+         netplay->has_connection = false;
+         return;
+      }
+
+      netplay->check.resyncs++;
+   }
+}
+
+void netplay_net_recv_crc(netplay_t *netplay, uint32_t frame, uint32_t crc)
+{
+   if (!netplay->check.agreed)
+      return;
+
+   netplay->check.remote_frame = frame;
+   netplay->check.remote_crc   = crc;
+   netplay->check.has_remote   = true;
+
+   netplay_net_check_compare(netplay);
+}
+
+bool netplay_net_recv_savestate(netplay_t *netplay)
+{
+   uint32_t args[2];
+   size_t patch_len;
+
+   if (!socket_receive_all_blocking(netplay->fd, args, sizeof(args)))
+      return false;
+
+   patch_len = ntohl(args[1]);
+
+   if (!netplay->check.agreed || patch_len > netplay->check.patch_size)
+   {
+      RARCH_ERR("Invalid netplay state delta.\n");
+      return false;
+   }
+
+   if (!socket_receive_all_blocking(netplay->fd,
+            netplay->check.patch, patch_len))
+      return false;
+
+   memcpy(netplay->check.resync, netplay->check.agreed, netplay->state_size);
+   if (!state_manager_raw_decompress_checked(netplay->check.patch, patch_len,
+            netplay->check.resync, netplay->state_size))
+   {
+      RARCH_ERR("Invalid netplay state delta.\n");
+      return false;
+   }
+
+   /* Loaded at the end of the frame, see netplay_net_apply_resync(). */
+   netplay->check.resync_frame   = ntohl(args[0]);
+   netplay->check.resync_pending = true;
+
+   return true;
+}
+
+/* Puts the host's state in place of ours and rewinds to it,
+ * once we have its input, so the next replay runs from there. */
+static void netplay_net_apply_resync(netplay_t *netplay)
+{
+   uint32_t frame = netplay->check.resync_frame;
+   uint32_t delta = netplay->frame_count - frame;
+
+   if (!netplay->check.resync_pending)
+      return;
+
+   if (frame > netplay->read_frame_count)
+      return;
+
+   netplay->check.resync_pending = false;
+
+   if (frame > netplay->frame_count || delta >= netplay->buffer_size)
+   {
+      RARCH_WARN("Netplay state delta for frame %u arrived too late.\n",
+            (unsigned)frame);
+      return;
+   }
+
+   netplay->other_ptr = (netplay->self_ptr + netplay->buffer_size - delta)
+      % netplay->buffer_size;
+   netplay->other_frame_count = frame;
+   memcpy(netplay->buffer[netplay->other_ptr].state,
+         netplay->check.resync, netplay->state_size);
+
+   /* Drop a check that was made on top of the desynced state. */
+   netplay->check.pending  = false;
+   netplay->check.done     = false;
+   netplay->force_replay   = true;
+   netplay->check.resyncs++;
+
+   runloop_msg_queue_push("Netplay desync, resynchronized with host.",
+         1, 180, false);
+}
+
+static void netplay_net_check_pre_frame(netplay_t *netplay)
+{
+   if (!netplay->check.agreed || netplay->check.pending || netplay->check.done)
+      return;
+
+   if (!netplay->frame_count || netplay->frame_count % NETPLAY_CHECK_FRAMES)
+      return;
+
+   netplay->check.frame   = netplay->frame_count;
+   netplay->check.ptr     = netplay->self_ptr;
+   netplay->check.pending = true;
+}
+
+static void netplay_net_check_post_frame(netplay_t *netplay)
+{
+   uint32_t cmd, args[2];
+
+   if (!netplay->check.pending
+         || netplay->other_frame_count < netplay->check.frame)
+      return;
+
+   /* Input before the check frame is confirmed, and any replay
+    * through it serialized the slot again, so the state is final. */
+   memcpy(netplay->check.local, netplay->buffer[netplay->check.ptr].state,
+         netplay->state_size);
+   netplay->check.crc     = zlib_crc32_calculate(
+         (const uint8_t*)netplay->check.local, netplay->state_size);
+   netplay->check.pending = false;
+   netplay->check.done    = true;
+
+   cmd     = htonl((NETPLAY_CMD_CRC << 16) | sizeof(args));
+   args[0] = htonl(netplay->check.frame);
+   args[1] = htonl(netplay->check.crc);
+
+   if (!socket_send_all_blocking(netplay->fd, &cmd, sizeof(cmd)) ||
+         !socket_send_all_blocking(netplay->fd, args, sizeof(args)))
+   {
+      warn_hangup();
+      netplay->has_connection = false;
+      return;
+   }
+
+   netplay_net_check_compare(netplay);
+}
+
+void netplay_net_free_check(netplay_t *netplay)
+{
+   free(netplay->check.agreed);
+   free(netplay->check.local);
+   free(netplay->check.resync);
+   free(netplay->check.patch);
+   memset(&netplay->check, 0, sizeof(netplay->check));
+}
+
+static void netplay_net_init_check(netplay_t *netplay)
+{
+   netplay->check.agreed = state_manager_raw_alloc(netplay->state_size, 0);
+   netplay->check.local  = state_manager_raw_alloc(netplay->state_size, 1);
+   netplay->check.resync = state_manager_raw_alloc(netplay->state_size, 2);
+   netplay->check.patch_size = state_manager_raw_maxsize(netplay->state_size);
+   netplay->check.patch  = malloc(netplay->check.patch_size);
+
+   if (!netplay->check.agreed || !netplay->check.local
+         || !netplay->check.resync || !netplay->check.patch)
+   {
+      RARCH_WARN("Netplay desync recovery disabled, out of memory.\n");
+      netplay_net_free_check(netplay);
+   }
+}
+
 /**
  * pre_frame:   
  * @netplay              : pointer to netplay object
@@ -23,8 +256,16 @@
  **/
 static void netplay_net_pre_frame(netplay_t *netplay)
 {
+   static struct retro_perf_counter netplay_serialize = {0};
+
+   rarch_perf_init(&netplay_serialize, "netplay_serialize");
+   retro_perf_start(&netplay_serialize);
    core.retro_serialize(netplay->buffer[netplay->self_ptr].state,
          netplay->state_size);
+   retro_perf_stop(&netplay_serialize);
+
+   netplay_net_check_pre_frame(netplay);
+
    netplay->can_poll = true;
 
    input_poll_net();
@@ -41,13 +282,20 @@ static void netplay_net_post_frame(netplay_t *netplay)
 {
    netplay->frame_count++;
 
+   netplay_net_apply_resync(netplay);
+
    /* Nothing to do... */
-   if (netplay->other_frame_count == netplay->read_frame_count)
+   if (netplay->other_frame_count == netplay->read_frame_count
+         && !netplay->force_replay)
+   {
+      netplay_net_check_post_frame(netplay);
       return;
+   }
 
    /* Skip ahead if we predicted correctly.
     * Skip until our simulation failed. */
-   while (netplay->other_frame_count < netplay->read_frame_count)
+   while (!netplay->force_replay
+         && netplay->other_frame_count < netplay->read_frame_count)
    {
       const struct delta_frame *ptr = &netplay->buffer[netplay->other_ptr];
 
@@ -58,11 +306,20 @@ static void netplay_net_post_frame(netplay_t *netplay)
       netplay->other_frame_count++;
    }
 
-   if (netplay->other_frame_count < netplay->read_frame_count)
+   if (netplay->force_replay
+         || netplay->other_frame_count < netplay->read_frame_count)
    {
-      bool first = true;
+      static struct retro_perf_counter netplay_rollback     = {0};
+      static struct retro_perf_counter netplay_replay_frame = {0};
+      bool first     = true;
+      unsigned depth = netplay->frame_count - netplay->other_frame_count;
 
-      /* Replay frames. */
+      rarch_perf_init(&netplay_rollback, "netplay_rollback");
+      rarch_perf_init(&netplay_replay_frame, "netplay_replay_frame");
+      retro_perf_start(&netplay_rollback);
+
+      /* Replay frames. Video and audio are dropped by
+       * video_frame_net() and friends while is_replay is set. */
       netplay->is_replay = true;
       netplay->tmp_ptr = netplay->other_ptr;
       netplay->tmp_frame_count = netplay->other_frame_count;
@@ -70,26 +327,48 @@ static void netplay_net_post_frame(netplay_t *netplay)
       core.retro_unserialize(netplay->buffer[netplay->other_ptr].state,
             netplay->state_size);
 
-      while (first || (netplay->tmp_ptr != netplay->self_ptr))
-      {
-         core.retro_serialize(netplay->buffer[netplay->tmp_ptr].state,
-               netplay->state_size);
 #if defined(HAVE_THREADS) && !defined(RARCH_CONSOLE)
-         lock_autosave();
+      lock_autosave();
 #endif
+      while (first || (netplay->tmp_ptr != netplay->self_ptr))
+      {
+         /* Frames up to read_frame_count now run on real input
+          * and can never be rolled back to again, only the
+          * ones still running on predicted input need a state. */
+         if (netplay->tmp_frame_count >= netplay->read_frame_count
+               || (netplay->check.pending
+                  && netplay->tmp_frame_count == netplay->check.frame
+                  && !first))
+            core.retro_serialize(netplay->buffer[netplay->tmp_ptr].state,
+                  netplay->state_size);
+         else
+            netplay->serialize_skipped++;
+
+         retro_perf_start(&netplay_replay_frame);
          core.retro_run();
-#if defined(HAVE_THREADS) && !defined(RARCH_CONSOLE)
-         unlock_autosave();
-#endif
+         retro_perf_stop(&netplay_replay_frame);
+
          netplay->tmp_ptr = NEXT_PTR(netplay->tmp_ptr);
          netplay->tmp_frame_count++;
          first = false;
       }
+#if defined(HAVE_THREADS) && !defined(RARCH_CONSOLE)
+      unlock_autosave();
+#endif
 
       netplay->other_ptr = netplay->read_ptr;
       netplay->other_frame_count = netplay->read_frame_count;
       netplay->is_replay = false;
+      netplay->force_replay = false;
+
+      retro_perf_stop(&netplay_rollback);
+
+      netplay->rollback_count++;
+      netplay->rollback_frames += depth;
+      netplay->rollback_max_depth = max(netplay->rollback_max_depth, depth);
    }
+
+   netplay_net_check_post_frame(netplay);
 }
 static bool netplay_net_init_buffers(netplay_t *netplay)
 {
@@ -116,6 +395,9 @@ static bool netplay_net_init_buffers(netplay_t *netplay)
       netplay->buffer[i].is_simulated = true;
    }
 
+   if (netplay->state_size)
+      netplay_net_init_check(netplay);
+
    return true;
 }
 
@@ -132,7 +414,12 @@ static bool netplay_net_info_cb(netplay_t* netplay, unsigned frames)
          return false;
    }
 
-   netplay->buffer_size = frames + 1;
+   /* The host's state delta is for a frame up to a full delay
+    * window behind its own, and we may be a window ahead of it,
+    * plus the frames it spent in flight. Keep that many states
+    * so it always lands in the buffer, even with no delay. */
+   netplay->delay_frames = frames;
+   netplay->buffer_size  = 2 * (frames + 1) + NETPLAY_RESYNC_FRAMES;
 
    if (!netplay_net_init_buffers(netplay))
       return false;
@@ -33,8 +33,17 @@
 #define HAVE_IPV6
 #endif
 
+/* Bump whenever packets or commands change, so builds that
+ * disagree fail the handshake instead of misparsing each other. */
+#define NETPLAY_PROTOCOL_VERSION 2
+
 #define UDP_FRAME_PACKETS 16
+/* Frames between state checksums exchanged by the peers. */
+#define NETPLAY_CHECK_FRAMES 120
+/* Frames a state delta may spend in flight and still be applied. */
+#define NETPLAY_RESYNC_FRAMES UDP_FRAME_PACKETS
 #define MAX_SPECTATORS 16
+#define NETPLAY_NICK_LEN 32
 #define RARCH_DEFAULT_PORT 55435
 
 #define PREV_PTR(x) ((x) == 0 ? netplay->buffer_size - 1 : (x) - 1)
@@ -60,8 +69,8 @@ struct netplay_callbacks {
 
 struct netplay
 {
-   char nick[32];
-   char other_nick[32];
+   char nick[NETPLAY_NICK_LEN];
+   char other_nick[NETPLAY_NICK_LEN];
    struct sockaddr_storage other_addr;
 
    struct retro_callbacks cbs;
@@ -75,6 +84,9 @@ struct netplay
 
    struct delta_frame *buffer;
    size_t buffer_size;
+   /* Frames we may run ahead of confirmed input before blocking.
+    * The buffer is larger, see netplay_net_info_cb(). */
+   unsigned delay_frames;
 
    /* Pointer where we are now. */
    size_t self_ptr; 
@@ -94,7 +106,7 @@ struct netplay
    bool can_poll;
 
    /* To compat UDP packet loss we also send 
-    * old data along with the packets. */
+    * old data along with the packets, see send_chunk(). */
    uint32_t packet_buffer[UDP_FRAME_PACKETS * 2];
    uint32_t frame_count;
    uint32_t read_frame_count;
@@ -106,6 +118,53 @@ struct netplay
 
    unsigned timeout_cnt;
 
+   /* Link statistics, see netplay_get_stats(). */
+   int lag_avg;          /* Frames, fixed point 4 bits. */
+   int lag_jitter;       /* Frames, fixed point 4 bits. */
+   unsigned lost_frames;
+   unsigned stalls;
+
+   /* Next frame the peer needs from us, from its last packet. */
+   uint32_t peer_ack;
+   retro_time_t send_time[UDP_FRAME_PACKETS];
+   int64_t rtt_avg;      /* Microseconds. */
+   int64_t rtt_jitter;   /* Microseconds. */
+   uint64_t frames_sent;
+   uint64_t packets_sent;
+
+   /* Desync detection, see netplay_net.c. States are allocated
+    * with state_manager_raw_alloc() so they can be delta encoded. */
+   struct
+   {
+      uint32_t frame;
+      size_t ptr;
+      uint32_t crc;
+      bool pending;  /* Waiting for input up to frame to be confirmed. */
+      bool done;     /* crc is final, waiting for the peer's. */
+
+      uint32_t remote_frame;
+      uint32_t remote_crc;
+      bool has_remote;
+
+      /* Last state both peers agreed on, the delta base. */
+      void *agreed;
+      void *local;
+      void *resync;
+      void *patch;
+      size_t patch_size;
+
+      uint32_t resync_frame;
+      bool resync_pending;
+      unsigned resyncs;
+   } check;
+   bool force_replay;
+
+   /* Rollback statistics, logged when netplay ends. */
+   unsigned rollback_count;
+   unsigned rollback_frames;
+   unsigned rollback_max_depth;
+   unsigned serialize_skipped;
+
    /* Spectating. */
    struct {
       bool enabled;
@@ -113,6 +172,10 @@ struct netplay
       uint16_t *input;
       size_t input_ptr;
       size_t input_sz;
+#ifdef HAVE_THREADS
+      /* Serves spectators when hosting, see netplay_spectate.c. */
+      struct netplay_spectate_thread *thread;
+#endif
    } spectate;
    bool is_server;
    /* User flipping
@@ -138,7 +201,7 @@ struct netplay_callbacks* netplay_get_cbs_spectate(void);
 void np_log_connection(const struct sockaddr_storage *their_addr,
       unsigned slot, const char *nick);
 
-bool np_get_nickname(netplay_t *netplay, int fd);
+bool np_get_nickname(int fd, char *nick, size_t size);
 bool np_send_nickname(netplay_t *netplay, int fd);
 bool np_send_info(netplay_t *netplay);
 uint32_t *np_bsv_header_generate(size_t *size, uint32_t magic);
@@ -148,4 +211,10 @@ bool np_send_info(netplay_t *netplay);
 bool np_get_info(netplay_t *netplay);
 bool np_is_server(netplay_t* netplay);
 bool np_is_spectate(netplay_t* netplay);
+void netplay_spectate_deinit(netplay_t *netplay);
+void warn_hangup(void);
+void netplay_net_free_check(netplay_t *netplay);
+void netplay_net_recv_crc(netplay_t *netplay, uint32_t frame, uint32_t crc);
+bool netplay_net_recv_savestate(netplay_t *netplay);
+unsigned netplay_spectate_count(netplay_t *netplay);
 #endif
@@ -20,9 +20,522 @@
 
 #include <net/net_compat.h>
 #include <retro_endianness.h>
+#include <retro_miscellaneous.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <queues/fifo_buffer.h>
+#endif
 
 #include "netplay_private.h"
 
+#ifdef HAVE_THREADS
+/* Spectators are served by their own thread so that a slow or
+ * stalled spectator can never block emulation. The main thread
+ * only serializes headers and queues input, under the lock.
+ * Spectator sockets are non-blocking, so one slow spectator
+ * cannot hold up the others either. */
+
+/* Input queued per spectator on top of the BSV header. */
+#define SPECTATE_FIFO_SIZE (256 * 1024)
+#define SPECTATE_POLL_MS   5
+
+enum netplay_spectator_state
+{
+   SPECTATOR_FREE = 0,
+   SPECTATOR_HANDSHAKE,
+   SPECTATOR_WAIT_HEADER,
+   SPECTATOR_ACTIVE,
+   SPECTATOR_DROP
+};
+
+struct netplay_spectator
+{
+   int fd;
+   enum netplay_spectator_state state;
+   fifo_buffer_t *out;
+   struct sockaddr_storage addr;
+
+   /* Size byte followed by the nickname, as received so far. */
+   uint8_t nick_buf[1 + NETPLAY_NICK_LEN];
+   size_t nick_received;
+   char nick[NETPLAY_NICK_LEN];
+
+   /* Data taken off the fifo that the socket has not accepted
+    * yet. Only touched by the spectator thread. */
+   uint8_t pending[4096];
+   size_t pending_pos;
+   size_t pending_size;
+};
+
+struct netplay_spectate_thread
+{
+   netplay_t *netplay;
+   sthread_t *thread;
+   slock_t *lock;
+   bool quit;
+   size_t header_size;
+   struct netplay_spectator clients[MAX_SPECTATORS];
+};
+
+/* Call with the lock held. */
+static void netplay_spectator_close(struct netplay_spectate_thread *st,
+      unsigned i)
+{
+   struct netplay_spectator *client = &st->clients[i];
+
+   if (client->fd >= 0)
+      socket_close(client->fd);
+   if (client->out)
+      fifo_free(client->out);
+
+   client->fd            = -1;
+   client->out           = NULL;
+   client->state         = SPECTATOR_FREE;
+   client->nick_received = 0;
+   client->nick[0]       = '\0';
+   client->pending_pos   = 0;
+   client->pending_size  = 0;
+}
+
+static void netplay_spectator_disconnected(unsigned i)
+{
+   char msg[128];
+
+   RARCH_LOG("Client (#%u) disconnected ...\n", i);
+
+   snprintf(msg, sizeof(msg), "Client (#%u) disconnected.", i);
+   runloop_msg_queue_push(msg, 1, 180, false);
+}
+
+static void netplay_spectator_drop(struct netplay_spectate_thread *st,
+      unsigned i)
+{
+   slock_lock(st->lock);
+   netplay_spectator_close(st, i);
+   slock_unlock(st->lock);
+
+   netplay_spectator_disconnected(i);
+}
+
+static void netplay_spectate_accept(struct netplay_spectate_thread *st)
+{
+   unsigned i;
+   int new_fd, bufsize;
+   int idx                  = -1;
+   netplay_t *netplay       = st->netplay;
+   struct sockaddr_storage their_addr;
+   socklen_t addr_size      = sizeof(their_addr);
+   fifo_buffer_t *out       = NULL;
+
+   new_fd = accept(netplay->fd, (struct sockaddr*)&their_addr, &addr_size);
+   if (new_fd < 0)
+   {
+      RARCH_ERR("Failed to accept incoming spectator.\n");
+      return;
+   }
+
+   if (!socket_nonblock(new_fd))
+   {
+      socket_close(new_fd);
+      return;
+   }
+
+   bufsize = st->header_size;
+   setsockopt(new_fd, SOL_SOCKET, SO_SNDBUF, (const char*)&bufsize,
+         sizeof(int));
+
+   out = fifo_new(st->header_size + SPECTATE_FIFO_SIZE);
+   if (!out)
+   {
+      socket_close(new_fd);
+      return;
+   }
+
+   slock_lock(st->lock);
+   for (i = 0; i < MAX_SPECTATORS; i++)
+   {
+      if (st->clients[i].state == SPECTATOR_FREE)
+      {
+         idx                    = i;
+         st->clients[i].fd      = new_fd;
+         st->clients[i].out     = out;
+         st->clients[i].addr    = their_addr;
+         st->clients[i].state   = SPECTATOR_HANDSHAKE;
+         break;
+      }
+   }
+   slock_unlock(st->lock);
+
+   /* No vacant client streams :( */
+   if (idx == -1)
+   {
+      fifo_free(out);
+      socket_close(new_fd);
+   }
+}
+
+/* Reads the spectator's nickname as it arrives, then queues
+ * ours ahead of the BSV header. */
+static void netplay_spectate_handshake(struct netplay_spectate_thread *st,
+      unsigned i)
+{
+   ssize_t ret;
+   size_t wanted;
+   uint8_t nick_size;
+   netplay_t *netplay               = st->netplay;
+   struct netplay_spectator *client = &st->clients[i];
+
+   slock_lock(st->lock);
+
+   wanted = client->nick_received ? 1 + client->nick_buf[0] : 1;
+   ret    = recv(client->fd, (char*)client->nick_buf + client->nick_received,
+         wanted - client->nick_received, 0);
+
+   if (ret <= 0)
+   {
+      if (isagain(ret))
+      {
+         slock_unlock(st->lock);
+         return;
+      }
+      goto error;
+   }
+
+   client->nick_received += ret;
+
+   if (client->nick_buf[0] >= sizeof(client->nick))
+   {
+      RARCH_ERR("Invalid nick size.\n");
+      goto error;
+   }
+
+   if (client->nick_received < 1 + (size_t)client->nick_buf[0])
+   {
+      slock_unlock(st->lock);
+      return;
+   }
+
+   nick_size = client->nick_buf[0];
+   memcpy(client->nick, client->nick_buf + 1, nick_size);
+   client->nick[nick_size] = '\0';
+
+   nick_size = strlen(netplay->nick);
+   fifo_write(client->out, &nick_size, sizeof(nick_size));
+   fifo_write(client->out, netplay->nick, nick_size);
+
+   client->state = SPECTATOR_WAIT_HEADER;
+   slock_unlock(st->lock);
+   return;
+
+error:
+   RARCH_ERR("Failed to get nickname from client.\n");
+   netplay_spectator_close(st, i);
+   slock_unlock(st->lock);
+}
+
+/* Sends as much of what the main thread queued for spectator @i
+ * as its socket takes without blocking. */
+static void netplay_spectate_flush(struct netplay_spectate_thread *st,
+      unsigned i)
+{
+   struct netplay_spectator *client = &st->clients[i];
+
+   for (;;)
+   {
+      ssize_t ret;
+
+      if (client->pending_pos == client->pending_size)
+      {
+         size_t avail = 0;
+
+         slock_lock(st->lock);
+
+         if (client->state == SPECTATOR_DROP)
+         {
+            netplay_spectator_close(st, i);
+            slock_unlock(st->lock);
+            netplay_spectator_disconnected(i);
+            return;
+         }
+
+         if (client->state == SPECTATOR_FREE
+               || client->state == SPECTATOR_HANDSHAKE
+               || !(avail = fifo_read_avail(client->out)))
+         {
+            slock_unlock(st->lock);
+            return;
+         }
+
+         avail = min(avail, sizeof(client->pending));
+         fifo_read(client->out, client->pending, avail);
+         slock_unlock(st->lock);
+
+         client->pending_pos  = 0;
+         client->pending_size = avail;
+      }
+
+      ret = send(client->fd,
+            (const char*)client->pending + client->pending_pos,
+            client->pending_size - client->pending_pos, MSG_NOSIGNAL);
+
+      if (ret <= 0)
+      {
+         if (!isagain(ret))
+            netplay_spectator_drop(st, i);
+         return;
+      }
+
+      client->pending_pos += ret;
+   }
+}
+
+static void netplay_spectate_thread(void *data)
+{
+   struct netplay_spectate_thread *st = 
+      (struct netplay_spectate_thread*)data;
+   netplay_t *netplay = st->netplay;
+
+   for (;;)
+   {
+      unsigned i;
+      fd_set read_fds, write_fds;
+      bool quit;
+      enum netplay_spectator_state states[MAX_SPECTATORS];
+      int max_fd        = netplay->fd;
+      struct timeval tv = {0};
+
+      FD_ZERO(&read_fds);
+      FD_ZERO(&write_fds);
+      FD_SET(netplay->fd, &read_fds);
+
+      slock_lock(st->lock);
+      quit = st->quit;
+
+      for (i = 0; i < MAX_SPECTATORS; i++)
+      {
+         struct netplay_spectator *client = &st->clients[i];
+
+         states[i] = client->state;
+
+         if (client->state == SPECTATOR_HANDSHAKE)
+            FD_SET(client->fd, &read_fds);
+         else if ((client->state == SPECTATOR_WAIT_HEADER
+                  || client->state == SPECTATOR_ACTIVE)
+               && (client->pending_pos < client->pending_size
+                  || fifo_read_avail(client->out)))
+            FD_SET(client->fd, &write_fds);
+         else
+            continue;
+
+         max_fd = max(max_fd, client->fd);
+      }
+      slock_unlock(st->lock);
+
+      if (quit)
+         break;
+
+      tv.tv_usec = SPECTATE_POLL_MS * 1000;
+
+      if (socket_select(max_fd + 1, &read_fds, &write_fds, NULL, &tv) < 0)
+         continue;
+
+      if (FD_ISSET(netplay->fd, &read_fds))
+         netplay_spectate_accept(st);
+
+      for (i = 0; i < MAX_SPECTATORS; i++)
+      {
+         int fd = st->clients[i].fd;
+
+         switch (states[i])
+         {
+            case SPECTATOR_HANDSHAKE:
+               if (FD_ISSET(fd, &read_fds))
+                  netplay_spectate_handshake(st, i);
+               break;
+            case SPECTATOR_WAIT_HEADER:
+            case SPECTATOR_ACTIVE:
+               if (FD_ISSET(fd, &write_fds))
+                  netplay_spectate_flush(st, i);
+               break;
+            case SPECTATOR_DROP:
+               netplay_spectate_flush(st, i);
+               break;
+            default:
+               break;
+         }
+      }
+   }
+}
+
+static bool netplay_spectate_thread_init(netplay_t *netplay)
+{
+   unsigned i;
+   struct netplay_spectate_thread *st = 
+      (struct netplay_spectate_thread*)calloc(1, sizeof(*st));
+
+   if (!st)
+      return false;
+
+   for (i = 0; i < MAX_SPECTATORS; i++)
+      st->clients[i].fd = -1;
+
+   st->netplay     = netplay;
+   st->header_size = 4 * sizeof(uint32_t) + core.retro_serialize_size();
+   st->lock        = slock_new();
+
+   if (!st->lock)
+      goto error;
+
+   netplay->spectate.thread = st;
+
+   st->thread = sthread_create(netplay_spectate_thread, st);
+   if (!st->thread)
+      goto error;
+
+   return true;
+
+error:
+   if (st->lock)
+      slock_free(st->lock);
+   free(st);
+   netplay->spectate.thread = NULL;
+   return false;
+}
+
+void netplay_spectate_deinit(netplay_t *netplay)
+{
+   unsigned i;
+   struct netplay_spectate_thread *st = netplay->spectate.thread;
+
+   if (!st)
+      return;
+
+   slock_lock(st->lock);
+   st->quit = true;
+   slock_unlock(st->lock);
+
+   sthread_join(st->thread);
+
+   for (i = 0; i < MAX_SPECTATORS; i++)
+      netplay_spectator_close(st, i);
+
+   slock_free(st->lock);
+   free(st);
+   netplay->spectate.thread = NULL;
+}
+
+/**
+ * netplay_spectate_thread_pre_frame:
+ * @netplay              : pointer to netplay object
+ *
+ * Queues a BSV header for every spectator that finished its
+ * handshake. The savestate has to be taken on this thread, at
+ * a frame boundary, so the input stream picks up right after.
+ **/
+static void netplay_spectate_thread_pre_frame(netplay_t *netplay)
+{
+   unsigned i;
+   struct netplay_spectate_thread *st = netplay->spectate.thread;
+
+   slock_lock(st->lock);
+
+   for (i = 0; i < MAX_SPECTATORS; i++)
+   {
+      size_t header_size;
+      uint32_t *header                 = NULL;
+      struct netplay_spectator *client = &st->clients[i];
+
+      if (client->state != SPECTATOR_WAIT_HEADER)
+         continue;
+
+      header = np_bsv_header_generate(&header_size, np_impl_magic());
+
+      if (!header || header_size > fifo_write_avail(client->out))
+      {
+         RARCH_ERR("Failed to generate BSV header.\n");
+         client->state = SPECTATOR_DROP;
+         free(header);
+         continue;
+      }
+
+      fifo_write(client->out, header, header_size);
+      free(header);
+
+      client->state = SPECTATOR_ACTIVE;
+
+#ifndef HAVE_SOCKET_LEGACY
+      np_log_connection(&client->addr, i, client->nick);
+#endif
+   }
+
+   slock_unlock(st->lock);
+}
+
+static void netplay_spectate_thread_post_frame(netplay_t *netplay)
+{
+   unsigned i;
+   struct netplay_spectate_thread *st = netplay->spectate.thread;
+   size_t size = netplay->spectate.input_ptr * sizeof(int16_t);
+
+   slock_lock(st->lock);
+
+   for (i = 0; i < MAX_SPECTATORS; i++)
+   {
+      struct netplay_spectator *client = &st->clients[i];
+
+      if (client->state != SPECTATOR_ACTIVE)
+         continue;
+
+      /* A spectator that fell this far behind would desync. */
+      if (size > fifo_write_avail(client->out))
+      {
+         client->state = SPECTATOR_DROP;
+         continue;
+      }
+
+      fifo_write(client->out, netplay->spectate.input, size);
+   }
+
+   slock_unlock(st->lock);
+
+   netplay->spectate.input_ptr = 0;
+}
+
+unsigned netplay_spectate_count(netplay_t *netplay)
+{
+   unsigned i, count                  = 0;
+   struct netplay_spectate_thread *st = netplay->spectate.thread;
+
+   if (!st)
+   {
+      for (i = 0; i < MAX_SPECTATORS; i++)
+         count += netplay->spectate.fds[i] >= 0;
+      return count;
+   }
+
+   slock_lock(st->lock);
+   for (i = 0; i < MAX_SPECTATORS; i++)
+      count += st->clients[i].state == SPECTATOR_ACTIVE;
+   slock_unlock(st->lock);
+
+   return count;
+}
+#else
+void netplay_spectate_deinit(netplay_t *netplay)
+{
+}
+
+unsigned netplay_spectate_count(netplay_t *netplay)
+{
+   unsigned i, count = 0;
+
+   for (i = 0; i < MAX_SPECTATORS; i++)
+      count += netplay->spectate.fds[i] >= 0;
+   return count;
+}
+#endif
+
 /**
  * netplay_pre_frame_spectate:   
  * @netplay              : pointer to netplay object
@@ -35,6 +548,7 @@ static void netplay_spectate_pre_frame(netplay_t *netplay)
    uint32_t *header;
    int new_fd, idx, bufsize;
    size_t header_size;
+   char nick[NETPLAY_NICK_LEN];
    struct sockaddr_storage their_addr;
    socklen_t addr_size;
    fd_set fds;
@@ -43,6 +557,14 @@ static void netplay_spectate_pre_frame(netplay_t *netplay)
    if (!np_is_server(netplay))
       return;
 
+#ifdef HAVE_THREADS
+   if (netplay->spectate.thread)
+   {
+      netplay_spectate_thread_pre_frame(netplay);
+      return;
+   }
+#endif
+
    FD_ZERO(&fds);
    FD_SET(netplay->fd, &fds);
 
@@ -77,7 +599,7 @@ static void netplay_spectate_pre_frame(netplay_t *netplay)
       return;
    }
 
-   if (!np_get_nickname(netplay, new_fd))
+   if (!np_get_nickname(new_fd, nick, sizeof(nick)))
    {
       RARCH_ERR("Failed to get nickname from client.\n");
       socket_close(new_fd);
@@ -117,7 +639,7 @@ static void netplay_spectate_pre_frame(netplay_t *netplay)
    netplay->spectate.fds[idx] = new_fd;
 
 #ifndef HAVE_SOCKET_LEGACY
-   np_log_connection(&their_addr, idx, netplay->other_nick);
+   np_log_connection(&their_addr, idx, nick);
 #endif
 }
 
@@ -135,6 +657,14 @@ static void netplay_spectate_post_frame(netplay_t *netplay)
    if (!np_is_server(netplay))
       return;
 
+#ifdef HAVE_THREADS
+   if (netplay->spectate.thread)
+   {
+      netplay_spectate_thread_post_frame(netplay);
+      return;
+   }
+#endif
+
    for (i = 0; i < MAX_SPECTATORS; i++)
    {
       char msg[128];
@@ -171,6 +701,12 @@ static bool netplay_spectate_info_cb(netplay_t *netplay, unsigned frames)
 
    for (i = 0; i < MAX_SPECTATORS; i++)
       netplay->spectate.fds[i] = -1;
+
+#ifdef HAVE_THREADS
+   /* Falls back to serving spectators from the main thread. */
+   if (np_is_server(netplay) && !netplay_spectate_thread_init(netplay))
+      RARCH_WARN("Failed to start netplay spectator thread.\n");
+#endif
    return true;
 }
 
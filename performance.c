@@ -23,8 +23,10 @@
 
 #ifdef _WIN32
 #define PERF_LOG_FMT "[PERF]: Avg (%s): %I64u ticks, %I64u runs.\n"
+#define PERF_HIST_LOG_FMT "[PERF]:     p50 %I64u, p95 %I64u, p99 %I64u, max %I64u ticks.\n"
 #else
 #define PERF_LOG_FMT "[PERF]: Avg (%s): %llu ticks, %llu runs.\n"
+#define PERF_HIST_LOG_FMT "[PERF]:     p50 %llu, p95 %llu, p99 %llu, max %llu ticks.\n"
 #endif
 
 #if !defined(_WIN32) && !defined(RARCH_CONSOLE)
@@ -109,11 +111,179 @@ static int clock_gettime(int clk_ik, struct timespec *t)
 #include "frontend/drivers/platform_linux.h"
 #endif
 
+/* Latency histograms. retro_perf_counter is part of the libretro
+ * API and can't grow, so they are kept on the side, keyed by the
+ * counter's address. Buckets are log2 with PERF_HIST_SUB_BITS of
+ * mantissa, so each one is at most 25% wide. */
+#define PERF_HIST_SUB_BITS 2
+#define PERF_HIST_BUCKETS  128
+#define PERF_HIST_SLOTS    (2 * MAX_COUNTERS)
+
+/* Counters get stopped on the video, audio and core threads
+ * alike, so samples are added atomically. Targets without
+ * 64-bit atomics can at worst lose a racing sample. */
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+#define PERF_ATOMIC_INC32(ptr)          __sync_fetch_and_add((ptr), 1)
+#define PERF_ATOMIC_INC64(ptr)          __sync_fetch_and_add((ptr), 1)
+#define PERF_ATOMIC_CAS64(ptr, old, val) __sync_bool_compare_and_swap((ptr), (old), (val))
+#elif defined(_MSC_VER) && !defined(_XBOX)
+#define PERF_ATOMIC_INC32(ptr)          InterlockedIncrement((volatile LONG*)(ptr))
+#define PERF_ATOMIC_INC64(ptr)          InterlockedIncrement64((volatile LONGLONG*)(ptr))
+#define PERF_ATOMIC_CAS64(ptr, old, val) (InterlockedCompareExchange64( \
+      (volatile LONGLONG*)(ptr), (LONGLONG)(val), (LONGLONG)(old)) == (LONGLONG)(old))
+#else
+#define PERF_ATOMIC_INC32(ptr)          ((*(ptr))++)
+#define PERF_ATOMIC_INC64(ptr)          ((*(ptr))++)
+#define PERF_ATOMIC_CAS64(ptr, old, val) (*(ptr) = (val), true)
+#endif
+
+struct perf_histogram
+{
+   const struct retro_perf_counter *perf;
+   uint64_t samples;
+   uint64_t max;
+   uint32_t buckets[PERF_HIST_BUCKETS];
+};
+
 static struct retro_perf_counter *perf_counters_rarch[MAX_COUNTERS];
 static struct retro_perf_counter *perf_counters_libretro[MAX_COUNTERS];
 static unsigned perf_ptr_rarch;
 static unsigned perf_ptr_libretro;
 
+static struct perf_histogram perf_histograms[PERF_HIST_SLOTS];
+/* Whole frames, in microseconds. */
+static struct perf_histogram perf_frame_histogram;
+static retro_time_t perf_frame_last;
+
+static unsigned perf_histogram_slot(const struct retro_perf_counter *perf)
+{
+   uintptr_t key = (uintptr_t)perf;
+   return (unsigned)((key >> 4) ^ (key >> 12)) % PERF_HIST_SLOTS;
+}
+
+static struct perf_histogram *perf_histogram_find(
+      const struct retro_perf_counter *perf)
+{
+   unsigned i;
+   unsigned slot = perf_histogram_slot(perf);
+
+   for (i = 0; i < PERF_HIST_SLOTS; i++)
+   {
+      struct perf_histogram *hist =
+         &perf_histograms[(slot + i) % PERF_HIST_SLOTS];
+
+      if (hist->perf == perf)
+         return hist;
+      if (!hist->perf)
+         return NULL;
+   }
+
+   return NULL;
+}
+
+static void perf_histogram_add(const struct retro_perf_counter *perf)
+{
+   unsigned i;
+   unsigned slot = perf_histogram_slot(perf);
+
+   for (i = 0; i < PERF_HIST_SLOTS; i++)
+   {
+      struct perf_histogram *hist =
+         &perf_histograms[(slot + i) % PERF_HIST_SLOTS];
+
+      if (hist->perf == perf)
+         return;
+
+      if (!hist->perf)
+      {
+         memset(hist, 0, sizeof(*hist));
+         hist->perf = perf;
+         return;
+      }
+   }
+}
+
+static unsigned perf_histogram_bucket(uint64_t value)
+{
+   unsigned msb = 0;
+   unsigned bucket;
+
+   if (value < (2 << PERF_HIST_SUB_BITS))
+      return (unsigned)value;
+
+   while (value >> (msb + 1))
+      msb++;
+
+   bucket = ((msb - PERF_HIST_SUB_BITS + 1) << PERF_HIST_SUB_BITS)
+      | (unsigned)((value >> (msb - PERF_HIST_SUB_BITS))
+            & ((1 << PERF_HIST_SUB_BITS) - 1));
+
+   return bucket < PERF_HIST_BUCKETS ? bucket : PERF_HIST_BUCKETS - 1;
+}
+
+/* Largest value that lands in @bucket. */
+static uint64_t perf_histogram_bucket_max(unsigned bucket)
+{
+   unsigned shift;
+   uint64_t mantissa;
+
+   if (bucket < (2 << PERF_HIST_SUB_BITS))
+      return bucket;
+
+   shift    = (bucket >> PERF_HIST_SUB_BITS) - 1;
+   mantissa = (1 << PERF_HIST_SUB_BITS)
+      | (bucket & ((1 << PERF_HIST_SUB_BITS) - 1));
+
+   return ((mantissa + 1) << shift) - 1;
+}
+
+static void perf_histogram_sample(struct perf_histogram *hist, uint64_t value)
+{
+   uint64_t max;
+
+   PERF_ATOMIC_INC32(&hist->buckets[perf_histogram_bucket(value)]);
+   PERF_ATOMIC_INC64(&hist->samples);
+
+   do
+   {
+      max = hist->max;
+   } while (value > max && !PERF_ATOMIC_CAS64(&hist->max, max, value));
+}
+
+static uint64_t perf_histogram_percentile(const struct perf_histogram *hist,
+      unsigned percent)
+{
+   unsigned i;
+   uint64_t seen   = 0;
+   uint64_t target = (hist->samples * percent + 99) / 100;
+
+   for (i = 0; i < PERF_HIST_BUCKETS; i++)
+   {
+      seen += hist->buckets[i];
+      if (seen >= target)
+      {
+         uint64_t value = perf_histogram_bucket_max(i);
+         return value < hist->max ? value : hist->max;
+      }
+   }
+
+   return hist->max;
+}
+
+static bool perf_histogram_get_stats(const struct perf_histogram *hist,
+      struct retro_perf_stats *stats)
+{
+   if (!hist || !hist->samples)
+      return false;
+
+   stats->samples = hist->samples;
+   stats->p50     = perf_histogram_percentile(hist, 50);
+   stats->p95     = perf_histogram_percentile(hist, 95);
+   stats->p99     = perf_histogram_percentile(hist, 99);
+   stats->max     = hist->max;
+   return true;
+}
+
 struct retro_perf_counter **retro_get_perf_counter_rarch(void)
 {
    return perf_counters_rarch;
@@ -145,6 +315,7 @@ void rarch_perf_register(struct retro_perf_counter *perf)
 
    perf_counters_rarch[perf_ptr_rarch++] = perf;
    perf->registered = true;
+   perf_histogram_add(perf);
 }
 
 void retro_perf_register(struct retro_perf_counter *perf)
@@ -154,12 +325,21 @@ void retro_perf_register(struct retro_perf_counter *perf)
 
    perf_counters_libretro[perf_ptr_libretro++] = perf;
    perf->registered = true;
+   perf_histogram_add(perf);
 }
 
 void retro_perf_clear(void)
 {
+   unsigned i;
+
    perf_ptr_libretro = 0;
    memset(perf_counters_libretro, 0, sizeof(perf_counters_libretro));
+
+   /* The core's counters are gone, rebuild the
+    * histogram table with the frontend's only. */
+   memset(perf_histograms, 0, sizeof(perf_histograms));
+   for (i = 0; i < perf_ptr_rarch; i++)
+      perf_histogram_add(perf_counters_rarch[i]);
 }
 
 static void log_counters(struct retro_perf_counter **counters, unsigned num)
@@ -167,14 +347,23 @@ static void log_counters(struct retro_perf_counter **counters, unsigned num)
    unsigned i;
    for (i = 0; i < num; i++)
    {
-      if (counters[i]->call_cnt)
-      {
-         RARCH_LOG(PERF_LOG_FMT,
-               counters[i]->ident,
-               (unsigned long long)counters[i]->total /
-               (unsigned long long)counters[i]->call_cnt,
-               (unsigned long long)counters[i]->call_cnt);
-      }
+      struct retro_perf_stats stats;
+
+      if (!counters[i]->call_cnt)
+         continue;
+
+      RARCH_LOG(PERF_LOG_FMT,
+            counters[i]->ident,
+            (unsigned long long)counters[i]->total /
+            (unsigned long long)counters[i]->call_cnt,
+            (unsigned long long)counters[i]->call_cnt);
+
+      if (retro_perf_get_stats(counters[i], &stats))
+         RARCH_LOG(PERF_HIST_LOG_FMT,
+               (unsigned long long)stats.p50,
+               (unsigned long long)stats.p95,
+               (unsigned long long)stats.p99,
+               (unsigned long long)stats.max);
    }
 }
 
@@ -193,6 +382,104 @@ void retro_perf_log(void)
    log_counters(perf_counters_libretro, perf_ptr_libretro);
 }
 
+/**
+ * rarch_perf_dump:
+ *
+ * Logs every counter, with latency percentiles,
+ * and the whole frame time while running.
+ **/
+void rarch_perf_dump(void)
+{
+   struct retro_perf_stats stats;
+
+   if (!runloop_ctl(RUNLOOP_CTL_IS_PERFCNT_ENABLE, NULL))
+   {
+      RARCH_WARN("[PERF]: Performance counters are disabled.\n");
+      return;
+   }
+
+   if (rarch_perf_get_frame_stats(&stats))
+      RARCH_LOG("[PERF]: Frame: p50 %.2f, p95 %.2f, p99 %.2f, max %.2f ms.\n",
+            stats.p50 / 1000.0, stats.p95 / 1000.0,
+            stats.p99 / 1000.0, stats.max / 1000.0);
+
+   rarch_perf_log();
+   retro_perf_log();
+}
+
+/**
+ * retro_perf_get_stats:
+ * @perf               : pointer to performance counter
+ * @stats              : filled with latency percentiles, in ticks.
+ *
+ * Returns: true (1) if @perf has been sampled, otherwise false (0).
+ **/
+bool retro_perf_get_stats(const struct retro_perf_counter *perf,
+      struct retro_perf_stats *stats)
+{
+   return perf_histogram_get_stats(perf_histogram_find(perf), stats);
+}
+
+/**
+ * retro_perf_reset:
+ * @perf               : pointer to performance counter
+ *
+ * Clears a counter's totals and its histogram.
+ **/
+void retro_perf_reset(struct retro_perf_counter *perf)
+{
+   struct perf_histogram *hist = perf_histogram_find(perf);
+
+   perf->total    = 0;
+   perf->call_cnt = 0;
+
+   if (hist)
+   {
+      hist->samples = 0;
+      hist->max     = 0;
+      memset(hist->buckets, 0, sizeof(hist->buckets));
+   }
+}
+
+/**
+ * rarch_perf_frame:
+ *
+ * Samples the time since the last call into the frame
+ * histogram. Called once per frame by the runloop.
+ **/
+void rarch_perf_frame(void)
+{
+   retro_time_t now;
+
+   if (!runloop_ctl(RUNLOOP_CTL_IS_PERFCNT_ENABLE, NULL))
+   {
+      perf_frame_last = 0;
+      return;
+   }
+
+   now = retro_get_time_usec();
+   if (perf_frame_last)
+      perf_histogram_sample(&perf_frame_histogram, now - perf_frame_last);
+   perf_frame_last = now;
+}
+
+/**
+ * rarch_perf_frame_skip:
+ *
+ * Called by the runloop on iterations where the core does
+ * not run (menu, pause), so that the time spent there is
+ * not sampled as one long frame.
+ **/
+void rarch_perf_frame_skip(void)
+{
+   perf_frame_last = 0;
+}
+
+bool rarch_perf_get_frame_stats(struct retro_perf_stats *stats)
+{
+   return perf_histogram_get_stats(&perf_frame_histogram, stats);
+}
+
 /**
  * retro_get_perf_counter:
  *
@@ -529,7 +816,9 @@ uint64_t retro_get_cpu_features(void)
          && ((xgetbv_x86(0) & 0x6) == 0x6))
       cpu |= RETRO_SIMD_AVX;
 
-   if (max_flag >= 7)
+   /* AVX2 uses the same YMM state, which the OS
+    * must have enabled as checked for AVX above. */
+   if ((cpu & RETRO_SIMD_AVX) && max_flag >= 7)
    {
       x86_cpuid(7, flags);
       if (flags[1] & (1 << 5))
@@ -618,8 +907,15 @@ void retro_perf_start(struct retro_perf_counter *perf)
 
 void retro_perf_stop(struct retro_perf_counter *perf)
 {
+   struct perf_histogram *hist = NULL;
+   retro_perf_tick_t elapsed;
+
    if (!runloop_ctl(RUNLOOP_CTL_IS_PERFCNT_ENABLE, NULL) || !perf)
       return;
 
-   perf->total += retro_get_perf_counter() - perf->start;
+   elapsed      = retro_get_perf_counter() - perf->start;
+   perf->total += elapsed;
+
+   if ((hist = perf_histogram_find(perf)))
+      perf_histogram_sample(hist, elapsed);
 }
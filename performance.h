@@ -18,6 +18,7 @@
 #define _RARCH_PERF_H
 
 #include <stdint.h>
+#include <boolean.h>
 
 #include "libretro.h"
 
@@ -29,6 +30,16 @@ extern "C" {
 #define MAX_COUNTERS 64
 #endif
 
+/* Latency percentiles of a counter, from its histogram. */
+struct retro_perf_stats
+{
+   uint64_t samples;
+   uint64_t p50;
+   uint64_t p95;
+   uint64_t p99;
+   uint64_t max;
+};
+
 struct retro_perf_counter **retro_get_perf_counter_rarch(void);
 
 struct retro_perf_counter **retro_get_perf_counter_libretro(void);
@@ -67,6 +78,19 @@ void rarch_perf_log(void);
 
 int rarch_perf_init(struct retro_perf_counter *perf, const char *name);
 
+void rarch_perf_dump(void);
+
+bool retro_perf_get_stats(const struct retro_perf_counter *perf,
+      struct retro_perf_stats *stats);
+
+void retro_perf_reset(struct retro_perf_counter *perf);
+
+void rarch_perf_frame(void);
+
+void rarch_perf_frame_skip(void);
+
+bool rarch_perf_get_frame_stats(struct retro_perf_stats *stats);
+
 /**
  * retro_perf_start:
  * @perf               : pointer to performance counter
@@ -369,6 +369,7 @@ else
    echo "Notice: X11, Xext or xf86vm not present. Skipping X11 code paths."
    HAVE_X11='no'
    HAVE_XVIDEO='no'
+   HAVE_XSHM='no'
 fi
 
 if [ "$HAVE_UDEV" != "no" ]; then
@@ -68,5 +68,5 @@ HAVE_IMAGEVIEWER=yes    # Built-in image viewer support.
 C89_IMAGEVIEWER=no      # stb_image hates C89
 HAVE_MMAP=auto          # MMAP support
 HAVE_QT=no              # QT companion support
-HAVE_XSHM=no            # XShm video driver support (disabled because it's just a dummied out stub)
+HAVE_XSHM=auto          # XShm video driver support
 HAVE_CHEEVOS=yes        # Disable Retro Achievements
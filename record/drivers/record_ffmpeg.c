@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <assert.h>
 
@@ -54,12 +55,15 @@ extern "C" {
 #include <compat/msvc.h>
 
 #include <boolean.h>
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
 #include <queues/fifo_buffer.h>
 #include <rthreads/rthreads.h>
 #include <gfx/scaler/scaler.h>
 #include <file/config_file.h>
 
 #include "../../general.h"
+#include "../../performance.h"
 #include "../../verbosity.h"
 #include "../../audio/audio_resampler_driver.h"
 #include "../../audio/audio_utils.h"
@@ -90,13 +94,35 @@ extern "C" {
 #define av_frame_free avcodec_free_frame
 #endif
 
+/* Raw frames queued by the core before they are converted. */
+#define MAX_FRAMES 32
+
+/* Converted frames queued for the encoder. */
+#define MAX_CONV_FRAMES 4
+
+/* A raw frame as queued in attr_fifo. */
+struct ff_video_frame
+{
+   struct ffemu_video_data vid;
+   /* Frames dropped since the previous queued frame. */
+   unsigned dropped;
+};
+
+/* A frame in the output format, ready to be encoded. */
+struct ff_conv_frame
+{
+   AVFrame *frame;
+   uint8_t *buf;
+};
+
 struct ff_video_info
 {
    AVCodecContext *codec;
    AVCodec *encoder;
 
-   AVFrame *conv_frame;
-   uint8_t *conv_frame_buf;
+   struct ff_conv_frame conv[MAX_CONV_FRAMES];
+   size_t conv_size;
+   /* Next pts to hand out, owned by the scale thread. */
    int64_t frame_cnt;
 
    uint8_t *outbuf;
@@ -166,6 +192,42 @@ struct ff_muxer_info
    AVStream *vstream;
 };
 
+/* Hard cap on replay buffer memory, whatever the window. */
+#define REPLAY_MAX_BYTES (512 * 1024 * 1024)
+
+/* An encoded packet held by the replay buffer. Dumps take
+ * references, so trimming never frees a packet in use. */
+struct ff_replay_packet
+{
+   AVPacket pkt;
+   unsigned refs;
+   struct ff_replay_packet *next;
+};
+
+/* Encoded packets for the last replay_seconds, starting on a
+ * video keyframe. Timestamps are in the muxer stream time
+ * bases, though no file is ever opened for that muxer. */
+struct ff_replay_info
+{
+   slock_t *lock;
+   struct ff_replay_packet *head;
+   struct ff_replay_packet *tail;
+   /* First video keyframe after head, where the next trim cuts. */
+   struct ff_replay_packet *key;
+   size_t packets;
+   size_t bytes;
+
+   /* Encoder settings to give the streams of a dump. */
+   AVCodecContext *vcodec;
+   AVCodecContext *acodec;
+
+   sthread_t *thread;
+   volatile bool dumping;
+   char path[PATH_MAX_LENGTH];
+   struct ff_replay_packet **dump;
+   size_t dump_count;
+};
+
 struct ff_config_param
 {
    config_file_t *conf;
@@ -174,9 +236,15 @@ struct ff_config_param
    char format[64];
    enum PixelFormat out_pix_fmt;
    unsigned threads;
+   /* Drop video frames instead of stalling the core
+    * when the encoder can't keep up. */
+   bool drop_frames;
    unsigned frame_drop_ratio;
    unsigned sample_rate;
    unsigned scale_factor;
+   /* Keep only this many seconds in memory, written out
+    * on request instead of streamed to the output file. */
+   unsigned replay_seconds;
 
    bool audio_enable;
    /* Keep same naming conventions as libavcodec. */
@@ -191,25 +259,56 @@ struct ff_config_param
    AVDictionary *audio_opts;
 };
 
+struct ff_pipeline_stats
+{
+   unsigned frames;
+   unsigned dropped;
+   unsigned stalls;
+   retro_time_t stall_time;
+   unsigned max_queued;
+};
+
+/* Video goes through two stages: the scale thread converts
+ * raw frames from attr_fifo/video_fifo into the conv ring,
+ * the encoder thread encodes those along with audio and
+ * does all the muxing. Everything is guarded by lock. */
 typedef struct ffmpeg
 {
    struct ff_video_info video;
    struct ff_audio_info audio;
    struct ff_muxer_info muxer;
+   struct ff_replay_info replay;
    struct ff_config_param config;
    
    struct ffemu_params params;
 
-   scond_t *cond;
-   slock_t *cond_lock;
    slock_t *lock;
+   /* Raw video queued, or shutting down. */
+   scond_t *cond;
+   /* Room in the input fifos. */
+   scond_t *space_cond;
+   /* Converted video or audio queued, or scaling is done. */
+   scond_t *conv_cond;
+   /* Room in the conv ring. */
+   scond_t *conv_space_cond;
+
    fifo_buffer_t *audio_fifo;
    fifo_buffer_t *video_fifo;
    fifo_buffer_t *attr_fifo;
+   unsigned queued;
+
+   unsigned conv_read;
+   unsigned conv_count;
+
+   sthread_t *scale_thread;
    sthread_t *thread;
 
-   volatile bool alive;
-   volatile bool can_sleep;
+   bool alive;
+   bool scale_done;
+
+   /* Frames dropped but not yet accounted for in the queue. */
+   unsigned dropped;
+   struct ff_pipeline_stats stats;
 } ffmpeg_t;
 
 static bool ffmpeg_codec_has_sample_format(enum AVSampleFormat fmt,
@@ -384,7 +483,7 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
 
 static bool ffmpeg_init_video(ffmpeg_t *handle)
 {
-   size_t size;
+   unsigned i;
    struct ff_config_param *params = &handle->config;
    struct ff_video_info *video    = &handle->video;
    struct ffemu_params *param     = &handle->params;
@@ -465,6 +564,13 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
          return false;
    }
 
+   /* Scaling runs on the encoder thread, next to the codec's own
+    * threads. Only fan out over the cores the codec leaves free,
+    * with threads = 0 libavcodec already takes all of them. */
+   video->scaler.threads = 1;
+   if (params->threads && params->threads < retro_get_cpu_cores())
+      video->scaler.threads = retro_get_cpu_cores() - params->threads;
+
    video->codec = avcodec_alloc_context3(codec);
 
    /* Useful to set scale_factor to 2 for chroma subsampled formats to
@@ -482,7 +588,10 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
          param->aspect_ratio * param->out_height / param->out_width, 255);
    video->codec->pix_fmt             = video->pix_fmt;
 
+   /* Frame threading keeps several frames in flight inside
+    * the encoder, on top of our own conversion stage. */
    video->codec->thread_count = params->threads;
+   video->codec->thread_type  = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
    if (params->video_qscale)
    {
@@ -506,12 +615,21 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
 
    video->frame_drop_ratio = params->frame_drop_ratio;
 
-   size = avpicture_get_size(video->pix_fmt, param->out_width,
+   video->conv_size = avpicture_get_size(video->pix_fmt, param->out_width,
          param->out_height);
-   video->conv_frame_buf = (uint8_t*)av_malloc(size);
-   video->conv_frame = av_frame_alloc();
-   avpicture_fill((AVPicture*)video->conv_frame, video->conv_frame_buf,
-         video->pix_fmt, param->out_width, param->out_height);
+
+   for (i = 0; i < MAX_CONV_FRAMES; i++)
+   {
+      struct ff_conv_frame *conv = &video->conv[i];
+
+      conv->buf   = (uint8_t*)av_malloc(video->conv_size);
+      conv->frame = av_frame_alloc();
+      if (!conv->buf || !conv->frame)
+         return false;
+
+      avpicture_fill((AVPicture*)conv->frame, conv->buf,
+            video->pix_fmt, param->out_width, param->out_height);
+   }
 
    return true;
 }
@@ -521,10 +639,12 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
 {
    struct config_file_entry entry;
    char pix_fmt[64] = {0};
+   char drop_policy[64] = {0};
 
    params->out_pix_fmt = PIX_FMT_NONE;
    params->scale_factor = 1;
-   params->threads = 1;
+   /* Let libavcodec pick a thread count. */
+   params->threads = 0;
    params->frame_drop_ratio = 1;
 
    if (!config)
@@ -553,8 +673,23 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
    if (!config_get_bool(params->conf, "audio_enable", &params->audio_enable))
       params->audio_enable = true;
 
+   /* "block" (default) stalls the core until the encoder catches
+    * up, "drop" throws away frames instead. */
+   if (config_get_array(params->conf, "drop_policy", drop_policy,
+            sizeof(drop_policy)))
+   {
+      if (!strcmp(drop_policy, "drop"))
+         params->drop_frames = true;
+      else if (strcmp(drop_policy, "block"))
+      {
+         RARCH_ERR("[FFmpeg]: Unknown drop_policy \"%s\".\n", drop_policy);
+         return false;
+      }
+   }
+
    config_get_uint(params->conf, "sample_rate", &params->sample_rate);
    config_get_uint(params->conf, "scale_factor", &params->scale_factor);
+   config_get_uint(params->conf, "replay_buffer", &params->replay_seconds);
 
    params->audio_qscale = config_get_int(params->conf, "audio_global_quality",
          &params->audio_global_quality);
@@ -607,7 +742,9 @@ static bool ffmpeg_init_muxer_pre(ffmpeg_t *handle)
    if (!ctx->oformat)
       return false;
 
-   if (avio_open(&ctx->pb, ctx->filename, AVIO_FLAG_WRITE) < 0)
+   /* The replay buffer opens its own files when dumped. */
+   if (!handle->config.replay_seconds
+         && avio_open(&ctx->pb, ctx->filename, AVIO_FLAG_WRITE) < 0)
    {
       av_free(ctx);
       return false;
@@ -638,52 +775,445 @@ static bool ffmpeg_init_muxer_post(ffmpeg_t *handle)
    av_dict_set(&handle->muxer.ctx->metadata, "title",
          "RetroArch video dump", 0); 
 
+   if (handle->config.replay_seconds)
+      return true;
+
    return avformat_write_header(handle->muxer.ctx, NULL) >= 0;
 }
 
-#define MAX_FRAMES 32
+static void ffmpeg_replay_unref(struct ff_replay_packet *node)
+{
+   if (--node->refs)
+      return;
+
+   av_free_packet(&node->pkt);
+   free(node);
+}
+
+static bool ffmpeg_replay_is_video(ffmpeg_t *handle, const AVPacket *pkt)
+{
+   return pkt->stream_index == handle->muxer.vstream->index;
+}
+
+static bool ffmpeg_replay_is_key(ffmpeg_t *handle, const AVPacket *pkt)
+{
+   return ffmpeg_replay_is_video(handle, pkt)
+      && (pkt->flags & AV_PKT_FLAG_KEY);
+}
+
+static double ffmpeg_replay_time(ffmpeg_t *handle, const AVPacket *pkt)
+{
+   AVStream *stream = ffmpeg_replay_is_video(handle, pkt) ?
+      handle->muxer.vstream : handle->muxer.astream;
+
+   return pkt->pts * av_q2d(stream->time_base);
+}
+
+/* Drops whole GOPs from the front for as long as what is left
+ * still covers the window, so the buffer always starts on a
+ * keyframe and can be muxed as is. Must hold replay.lock. */
+static void ffmpeg_replay_trim(ffmpeg_t *handle, double newest)
+{
+   struct ff_replay_info *replay = &handle->replay;
+
+   while (replay->key)
+   {
+      struct ff_replay_packet *node = NULL;
+
+      if (newest - ffmpeg_replay_time(handle, &replay->key->pkt)
+            < handle->config.replay_seconds
+            && replay->bytes <= REPLAY_MAX_BYTES)
+         return;
+
+      while (replay->head != replay->key)
+      {
+         node         = replay->head;
+         replay->head = node->next;
+
+         replay->packets--;
+         replay->bytes -= node->pkt.size;
+         ffmpeg_replay_unref(node);
+      }
+
+      /* Only the GOP we now start on is scanned, every packet
+       * is looked at once on its way through the buffer. */
+      for (node = replay->head->next; node; node = node->next)
+         if (ffmpeg_replay_is_key(handle, &node->pkt))
+            break;
+
+      replay->key = node;
+   }
+}
+
+static bool ffmpeg_replay_push(ffmpeg_t *handle, const AVPacket *pkt)
+{
+   struct ff_replay_info *replay = &handle->replay;
+   struct ff_replay_packet *node = (struct ff_replay_packet*)
+      calloc(1, sizeof(*node));
+
+   if (!node)
+      return false;
+
+   /* Encoder output lives in our outbuf, take a copy. */
+   if (av_new_packet(&node->pkt, pkt->size) < 0)
+   {
+      free(node);
+      return false;
+   }
+
+   memcpy(node->pkt.data, pkt->data, pkt->size);
+   node->pkt.pts          = pkt->pts;
+   node->pkt.dts          = pkt->dts;
+   node->pkt.duration     = pkt->duration;
+   node->pkt.flags        = pkt->flags;
+   node->pkt.stream_index = pkt->stream_index;
+   node->refs             = 1;
+
+   slock_lock(replay->lock);
+
+   if (replay->tail)
+      replay->tail->next = node;
+   else
+      replay->head       = node;
+   replay->tail          = node;
+
+   if (!replay->key && node != replay->head
+         && ffmpeg_replay_is_key(handle, pkt))
+      replay->key        = node;
+
+   replay->packets++;
+   replay->bytes += pkt->size;
+
+   if (ffmpeg_replay_is_video(handle, pkt))
+      ffmpeg_replay_trim(handle, ffmpeg_replay_time(handle, pkt));
+
+   slock_unlock(replay->lock);
+
+   return true;
+}
+
+static bool ffmpeg_write_packet(ffmpeg_t *handle, AVPacket *pkt)
+{
+   if (handle->config.replay_seconds)
+      return ffmpeg_replay_push(handle, pkt);
+
+   return av_interleaved_write_frame(handle->muxer.ctx, pkt) >= 0;
+}
+
+static AVStream *ffmpeg_replay_new_stream(AVFormatContext *ctx,
+      const AVCodecContext *codec)
+{
+   AVStream *stream = avformat_new_stream(ctx, codec->codec);
+
+   if (!stream || avcodec_copy_context(stream->codec, codec) < 0)
+      return NULL;
+
+   stream->sample_aspect_ratio = codec->sample_aspect_ratio;
+   return stream;
+}
+
+/* Muxes the packets referenced by replay.dump into replay.path,
+ * with timestamps shifted so the clip starts at zero. */
+static bool ffmpeg_replay_write(ffmpeg_t *handle, double *duration)
+{
+   size_t i;
+   AVStream *vstream             = NULL;
+   AVStream *astream             = NULL;
+   int64_t start                 = AV_NOPTS_VALUE;
+   int64_t end                   = AV_NOPTS_VALUE;
+   bool ret                      = false;
+   struct ff_replay_info *replay = &handle->replay;
+   AVFormatContext *ctx          = avformat_alloc_context();
+
+   if (!ctx)
+      return false;
+
+   ctx->oformat = handle->muxer.ctx->oformat;
+   av_strlcpy(ctx->filename, replay->path, sizeof(ctx->filename));
+   av_dict_set(&ctx->metadata, "title", "RetroArch replay", 0);
+
+   /* Same order as the recording muxer, so stream indices match. */
+   if (!(vstream = ffmpeg_replay_new_stream(ctx, replay->vcodec)))
+      goto end;
+
+   if (replay->acodec
+         && !(astream = ffmpeg_replay_new_stream(ctx, replay->acodec)))
+      goto end;
+
+   if (avio_open(&ctx->pb, ctx->filename, AVIO_FLAG_WRITE) < 0)
+      goto end;
+
+   if (avformat_write_header(ctx, NULL) < 0)
+      goto end;
+
+   for (i = 0; i < replay->dump_count; i++)
+   {
+      AVPacket pkt;
+      const AVPacket *held = &replay->dump[i]->pkt;
+      bool is_video        = ffmpeg_replay_is_video(handle, held);
+      AVRational src       = is_video ? handle->muxer.vstream->time_base
+         : handle->muxer.astream->time_base;
+      AVRational dst       = is_video ? vstream->time_base : astream->time_base;
+      int64_t pts          = av_rescale_q(held->pts, src, AV_TIME_BASE_Q);
+      int64_t offset;
+
+      /* Start on the first video keyframe, and drop audio from
+       * before it. */
+      if (start == AV_NOPTS_VALUE)
+      {
+         if (!ffmpeg_replay_is_key(handle, held))
+            continue;
+         start = pts;
+      }
+
+      if (pts < start)
+         continue;
+
+      if (is_video)
+         end = pts;
+
+      /* A new reference to the held data, which the muxer
+       * takes over and drops once written. */
+      if (av_copy_packet(&pkt, held) < 0)
+         goto end;
+
+      offset   = av_rescale_q(start, AV_TIME_BASE_Q, src);
+      pkt.pts  = av_rescale_q(pkt.pts - offset, src, dst);
+      if (pkt.dts != (int64_t)AV_NOPTS_VALUE)
+         pkt.dts = av_rescale_q(pkt.dts - offset, src, dst);
+
+      if (av_interleaved_write_frame(ctx, &pkt) < 0)
+         goto end;
+   }
+
+   ret = av_write_trailer(ctx) == 0;
+
+   if (start != AV_NOPTS_VALUE)
+      *duration = (end - start) / (double)AV_TIME_BASE;
+
+end:
+   if (ctx->pb)
+      avio_close(ctx->pb);
+   avformat_free_context(ctx);
+
+   return ret;
+}
+
+/* Drops the dump's references. */
+static void ffmpeg_replay_release(ffmpeg_t *handle)
+{
+   size_t i;
+   struct ff_replay_info *replay = &handle->replay;
+
+   slock_lock(replay->lock);
+   for (i = 0; i < replay->dump_count; i++)
+      ffmpeg_replay_unref(replay->dump[i]);
+   slock_unlock(replay->lock);
+
+   free(replay->dump);
+   replay->dump       = NULL;
+   replay->dump_count = 0;
+}
+
+static void ffmpeg_replay_thread(void *data)
+{
+   size_t i;
+   size_t bytes                  = 0;
+   double duration               = 0.0;
+   ffmpeg_t *handle              = (ffmpeg_t*)data;
+   struct ff_replay_info *replay = &handle->replay;
+   static struct retro_perf_counter ffmpeg_replay_dump = {0};
+
+   rarch_perf_init(&ffmpeg_replay_dump, "ffmpeg_replay_dump");
+   retro_perf_start(&ffmpeg_replay_dump);
+
+   for (i = 0; i < replay->dump_count; i++)
+      bytes += replay->dump[i]->pkt.size;
+
+   if (ffmpeg_replay_write(handle, &duration))
+      RARCH_LOG("[FFmpeg]: Saved %.1f s replay to \"%s\" "
+            "(%u packets, %.1f MB).\n", duration, replay->path,
+            (unsigned)replay->dump_count, bytes / (1024.0 * 1024.0));
+   else
+      RARCH_ERR("[FFmpeg]: Failed to save replay to \"%s\".\n",
+            replay->path);
+
+   retro_perf_stop(&ffmpeg_replay_dump);
+
+   ffmpeg_replay_release(handle);
+   replay->dumping = false;
+}
+
+static bool ffmpeg_dump_replay(void *data, const char *path)
+{
+   struct ff_replay_packet *node = NULL;
+   struct ff_replay_info *replay = NULL;
+   ffmpeg_t *handle              = (ffmpeg_t*)data;
+
+   if (!handle || !path || !*path)
+      return false;
+
+   if (!handle->config.replay_seconds)
+   {
+      RARCH_ERR("[FFmpeg]: Recording has no replay buffer, "
+            "set replay_buffer in the record config.\n");
+      return false;
+   }
+
+   replay = &handle->replay;
+
+   if (replay->dumping)
+   {
+      RARCH_WARN("[FFmpeg]: Still saving the previous replay.\n");
+      return false;
+   }
+
+   if (replay->thread)
+      sthread_join(replay->thread);
+   replay->thread = NULL;
+
+   /* Only references are taken here, the encoder keeps
+    * going while the dump thread muxes. */
+   slock_lock(replay->lock);
+
+   replay->dump = (struct ff_replay_packet**)
+      calloc(replay->packets, sizeof(*replay->dump));
+
+   if (replay->dump)
+   {
+      for (node = replay->head; node; node = node->next)
+      {
+         node->refs++;
+         replay->dump[replay->dump_count++] = node;
+      }
+   }
+
+   slock_unlock(replay->lock);
+
+   if (!replay->dump_count)
+   {
+      free(replay->dump);
+      replay->dump = NULL;
+      return false;
+   }
+
+   strlcpy(replay->path, path, sizeof(replay->path));
+
+   replay->dumping = true;
+   replay->thread  = sthread_create(ffmpeg_replay_thread, handle);
+
+   if (!replay->thread)
+   {
+      replay->dumping = false;
+      ffmpeg_replay_release(handle);
+      return false;
+   }
+
+   return true;
+}
+
+static bool ffmpeg_init_replay(ffmpeg_t *handle)
+{
+   struct ff_replay_info *replay = &handle->replay;
+
+   replay->lock   = slock_new();
+   replay->vcodec = avcodec_alloc_context3(NULL);
+
+   if (!replay->lock || !replay->vcodec
+         || avcodec_copy_context(replay->vcodec, handle->video.codec) < 0)
+      return false;
+
+   if (handle->config.audio_enable)
+   {
+      replay->acodec = avcodec_alloc_context3(NULL);
+      if (!replay->acodec
+            || avcodec_copy_context(replay->acodec, handle->audio.codec) < 0)
+         return false;
+   }
+
+   RARCH_LOG("[FFmpeg]: Keeping the last %u seconds in memory, "
+         "send SAVE_REPLAY to write them out.\n",
+         handle->config.replay_seconds);
+
+   return true;
+}
+
+static void ffmpeg_deinit_replay(ffmpeg_t *handle)
+{
+   struct ff_replay_info *replay = &handle->replay;
+
+   if (replay->thread)
+      sthread_join(replay->thread);
+
+   while (replay->head)
+   {
+      struct ff_replay_packet *node = replay->head;
+      replay->head = node->next;
+      ffmpeg_replay_unref(node);
+   }
+
+   if (replay->vcodec)
+      avcodec_free_context(&replay->vcodec);
+   if (replay->acodec)
+      avcodec_free_context(&replay->acodec);
+   if (replay->lock)
+      slock_free(replay->lock);
+
+   memset(replay, 0, sizeof(*replay));
+}
 
 static void ffmpeg_thread(void *data);
+static void ffmpeg_scale_thread(void *data);
 
 static bool init_thread(ffmpeg_t *handle)
 {
    handle->lock = slock_new();
-   handle->cond_lock = slock_new();
    handle->cond = scond_new();
+   handle->space_cond = scond_new();
+   handle->conv_cond = scond_new();
+   handle->conv_space_cond = scond_new();
    handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
          handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
+   handle->attr_fifo = fifo_new(sizeof(struct ff_video_frame) * MAX_FRAMES);
    handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
             handle->video.pix_size * MAX_FRAMES);
 
    handle->alive = true;
-   handle->can_sleep = true;
    handle->thread = sthread_create(ffmpeg_thread, handle);
+   handle->scale_thread = sthread_create(ffmpeg_scale_thread, handle);
 
-   assert(handle->lock && handle->cond_lock &&
-      handle->cond && handle->audio_fifo &&
-      handle->attr_fifo && handle->video_fifo && handle->thread);
+   assert(handle->lock && handle->cond && handle->space_cond &&
+      handle->conv_cond && handle->conv_space_cond && handle->audio_fifo &&
+      handle->attr_fifo && handle->video_fifo &&
+      handle->thread && handle->scale_thread);
 
    return true;
 }
 
+/* Both threads drain whatever is still queued before
+ * they exit, so nothing the core pushed is lost. */
 static void deinit_thread(ffmpeg_t *handle)
 {
    if (!handle->thread)
       return;
 
-   slock_lock(handle->cond_lock);
+   slock_lock(handle->lock);
    handle->alive = false;
-   handle->can_sleep = false;
-   slock_unlock(handle->cond_lock);
+   scond_broadcast(handle->cond);
+   scond_broadcast(handle->space_cond);
+   scond_broadcast(handle->conv_cond);
+   slock_unlock(handle->lock);
 
-   scond_signal(handle->cond);
+   sthread_join(handle->scale_thread);
    sthread_join(handle->thread);
 
    slock_free(handle->lock);
-   slock_free(handle->cond_lock);
    scond_free(handle->cond);
+   scond_free(handle->space_cond);
+   scond_free(handle->conv_cond);
+   scond_free(handle->conv_space_cond);
 
+   handle->scale_thread = NULL;
    handle->thread = NULL;
 }
 
@@ -710,12 +1240,14 @@ static void deinit_thread_buf(ffmpeg_t *handle)
 
 static void ffmpeg_free(void *data)
 {
+   unsigned i;
    ffmpeg_t *handle = (ffmpeg_t*)data;
    if (!handle)
       return;
 
    deinit_thread(handle);
    deinit_thread_buf(handle);
+   ffmpeg_deinit_replay(handle);
 
    if (handle->audio.codec)
    {
@@ -731,8 +1263,11 @@ static void ffmpeg_free(void *data)
       av_free(handle->video.codec);
    }
 
-   av_frame_free(&handle->video.conv_frame);
-   av_free(handle->video.conv_frame_buf);
+   for (i = 0; i < MAX_CONV_FRAMES; i++)
+   {
+      av_frame_free(&handle->video.conv[i].frame);
+      av_free(handle->video.conv[i].buf);
+   }
 
    scaler_ctx_gen_reset(&handle->video.scaler);
 
@@ -785,6 +1320,9 @@ static void *ffmpeg_new(const struct ffemu_params *params)
    if (!ffmpeg_init_muxer_post(handle))
       goto error;
 
+   if (handle->config.replay_seconds && !ffmpeg_init_replay(handle))
+      goto error;
+
    if (!init_thread(handle))
       goto error;
 
@@ -800,7 +1338,9 @@ static bool ffmpeg_push_video(void *data,
 {
    unsigned y;
    bool drop_frame;
-   struct ffemu_video_data attr_data;
+   size_t size;
+   struct ff_video_frame frame;
+   retro_time_t stall_start = 0;
    ffmpeg_t *handle = (ffmpeg_t*)data;
    int offset = 0;
 
@@ -815,52 +1355,67 @@ static bool ffmpeg_push_video(void *data,
    if (drop_frame)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->attr_fifo);
-      slock_unlock(handle->lock);
+   /* Tightly pack our frame to conserve memory.
+    * libretro tends to use a very large pitch.
+    */
+   frame.vid = *vid;
 
-      if (!handle->alive)
-         return false;
+   if (frame.vid.is_dupe)
+      frame.vid.width = frame.vid.height = frame.vid.pitch = 0;
+   else
+      frame.vid.pitch = frame.vid.width * handle->video.pix_size;
 
-      if (avail >= sizeof(*vid))
-         break;
+   size = frame.vid.height * frame.vid.pitch;
+
+   slock_lock(handle->lock);
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
+   while (handle->alive &&
+         (fifo_write_avail(handle->attr_fifo) < sizeof(frame)
+          || fifo_write_avail(handle->video_fifo) < size))
+   {
+      if (handle->config.drop_frames)
       {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
+         if (!handle->stats.dropped++)
+            RARCH_WARN("[FFmpeg]: Encoder can't keep up, dropping frames.\n");
+         handle->dropped++;
+         slock_unlock(handle->lock);
+         return true;
       }
-      else
-         scond_signal(handle->cond);
 
-      slock_unlock(handle->cond_lock);
+      if (!stall_start)
+      {
+         stall_start = retro_get_time_usec();
+         handle->stats.stalls++;
+      }
+
+      scond_wait(handle->space_cond, handle->lock);
    }
 
-   slock_lock(handle->lock);
+   if (stall_start)
+      handle->stats.stall_time += retro_get_time_usec() - stall_start;
 
-   /* Tightly pack our frame to conserve memory.
-    * libretro tends to use a very large pitch.
-    */
-   attr_data = *vid;
+   if (!handle->alive)
+   {
+      slock_unlock(handle->lock);
+      return false;
+   }
 
-   if (attr_data.is_dupe)
-      attr_data.width = attr_data.height = attr_data.pitch = 0;
-   else
-      attr_data.pitch = attr_data.width * handle->video.pix_size;
+   frame.dropped   = handle->dropped;
+   handle->dropped = 0;
 
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   fifo_write(handle->attr_fifo, &frame, sizeof(frame));
 
-   for (y = 0; y < attr_data.height; y++, offset += vid->pitch)
+   for (y = 0; y < frame.vid.height; y++, offset += vid->pitch)
       fifo_write(handle->video_fifo,
-            (const uint8_t*)vid->data + offset, attr_data.pitch);
+            (const uint8_t*)vid->data + offset, frame.vid.pitch);
+
+   handle->queued++;
+   handle->stats.frames++;
+   if (handle->queued > handle->stats.max_queued)
+      handle->stats.max_queued = handle->queued;
 
-   slock_unlock(handle->lock);
    scond_signal(handle->cond);
+   slock_unlock(handle->lock);
 
    return true;
 }
@@ -868,6 +1423,7 @@ static bool ffmpeg_push_video(void *data,
 static bool ffmpeg_push_audio(void *data,
       const struct ffemu_audio_data *audio_data)
 {
+   size_t size;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle || !audio_data)
@@ -876,51 +1432,44 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->audio_fifo);
-      slock_unlock(handle->lock);
+   size = audio_data->frames * handle->params.channels * sizeof(int16_t);
 
-      if (!handle->alive)
-         return false;
-
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
-         break;
+   /* Audio is never dropped, it would throw off A/V sync. */
+   slock_lock(handle->lock);
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
+   while (handle->alive && fifo_write_avail(handle->audio_fifo) < size)
+      scond_wait(handle->space_cond, handle->lock);
 
-      slock_unlock(handle->cond_lock);
+   if (!handle->alive)
+   {
+      slock_unlock(handle->lock);
+      return false;
    }
 
-   slock_lock(handle->lock);
-   fifo_write(handle->audio_fifo, audio_data->data,
-         audio_data->frames * handle->params.channels * sizeof(int16_t));
+   fifo_write(handle->audio_fifo, audio_data->data, size);
+
+   scond_signal(handle->conv_cond);
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
 
 static bool encode_video(ffmpeg_t *handle, AVPacket *pkt, AVFrame *frame)
 {
+   int ret;
    int got_packet = 0;
+   static struct retro_perf_counter ffmpeg_encode_video = {0};
 
    av_init_packet(pkt);
    pkt->data = handle->video.outbuf;
    pkt->size = handle->video.outbuf_size;
 
-   if (avcodec_encode_video2(handle->video.codec, pkt, frame, &got_packet) < 0)
+   rarch_perf_init(&ffmpeg_encode_video, "ffmpeg_encode_video");
+   retro_perf_start(&ffmpeg_encode_video);
+   ret = avcodec_encode_video2(handle->video.codec, pkt, frame, &got_packet);
+   retro_perf_stop(&ffmpeg_encode_video);
+
+   if (ret < 0)
       return false;
 
    if (!got_packet)
@@ -948,7 +1497,7 @@ static bool encode_video(ffmpeg_t *handle, AVPacket *pkt, AVFrame *frame)
 }
 
 static void ffmpeg_scale_input(ffmpeg_t *handle,
-      const struct ffemu_video_data *vid)
+      const struct ffemu_video_data *vid, AVFrame *out)
 {
    /* Attempt to preserve more information if we scale down. */
    bool shrunk = handle->params.out_width < vid->width
@@ -965,8 +1514,7 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
             shrunk ? SWS_BILINEAR : SWS_POINT, NULL, NULL, NULL);
 
       sws_scale(handle->video.sws, (const uint8_t* const*)&vid->data,
-            &linesize, 0, vid->height, handle->video.conv_frame->data,
-            handle->video.conv_frame->linesize);
+            &linesize, 0, vid->height, out->data, out->linesize);
    }
    else
    {
@@ -982,37 +1530,28 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
 
          handle->video.scaler.out_width  = handle->params.out_width;
          handle->video.scaler.out_height = handle->params.out_height;
-         handle->video.scaler.out_stride = 
-            handle->video.conv_frame->linesize[0];
+         handle->video.scaler.out_stride = out->linesize[0];
 
          scaler_ctx_gen_filter(&handle->video.scaler);
       }
 
-      scaler_ctx_scale(&handle->video.scaler,
-            handle->video.conv_frame->data[0], vid->data);
+      scaler_ctx_scale(&handle->video.scaler, out->data[0], vid->data);
    }
 }
 
-static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
-      const struct ffemu_video_data *vid)
+static bool ffmpeg_push_video_thread(ffmpeg_t *handle, AVFrame *frame)
 {
    AVPacket pkt;
 
-   if (!vid->is_dupe)
-      ffmpeg_scale_input(handle, vid);
-
-   handle->video.conv_frame->pts = handle->video.frame_cnt;
-
-   if (!encode_video(handle, &pkt, handle->video.conv_frame))
+   if (!encode_video(handle, &pkt, frame))
       return false;
 
    if (pkt.size)
    {
-      if (av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+      if (!ffmpeg_write_packet(handle, &pkt))
          return false;
    }
 
-   handle->video.frame_cnt++;
    return true;
 }
 
@@ -1067,8 +1606,10 @@ static void planarize_audio(ffmpeg_t *handle)
 static bool encode_audio(ffmpeg_t *handle, AVPacket *pkt, bool dry)
 {
    AVFrame *frame;
+   int ret;
    int samples_size;
    int got_packet = 0;
+   static struct retro_perf_counter ffmpeg_encode_audio = {0};
 
    av_init_packet(pkt);
    pkt->data = handle->audio.outbuf;
@@ -1096,8 +1637,13 @@ static bool encode_audio(ffmpeg_t *handle, AVPacket *pkt, bool dry)
          handle->audio.buffer,
          samples_size, 0);
 
-   if (avcodec_encode_audio2(handle->audio.codec,
-            pkt, dry ? NULL : frame, &got_packet) < 0)
+   rarch_perf_init(&ffmpeg_encode_audio, "ffmpeg_encode_audio");
+   retro_perf_start(&ffmpeg_encode_audio);
+   ret = avcodec_encode_audio2(handle->audio.codec,
+            pkt, dry ? NULL : frame, &got_packet);
+   retro_perf_stop(&ffmpeg_encode_audio);
+
+   if (ret < 0)
    {
       av_frame_free(&frame);
       return false;
@@ -1237,7 +1783,7 @@ static bool ffmpeg_push_audio_thread(ffmpeg_t *handle,
 
       if (pkt.size)
       {
-         if (av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+         if (!ffmpeg_write_packet(handle, &pkt))
             return false;
       }
    }
@@ -1266,7 +1812,7 @@ static void ffmpeg_flush_audio(ffmpeg_t *handle, void *audio_buf,
    {
       AVPacket pkt;
       if (!encode_audio(handle, &pkt, true) || !pkt.size ||
-            av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+            !ffmpeg_write_packet(handle, &pkt))
          break;
    }
 }
@@ -1277,71 +1823,51 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
    {
       AVPacket pkt;
       if (!encode_video(handle, &pkt, NULL) || !pkt.size ||
-            av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+            !ffmpeg_write_packet(handle, &pkt))
          break;
    }
 }
 
+/* The threads have drained the queues by now, all that's
+ * left is a partial audio block and the encoders' delay. */
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
-   bool did_work;
-   void *video_buf = av_malloc(2 * handle->params.fb_width * 
-         handle->params.fb_height * handle->video.pix_size);
    size_t audio_buf_size = handle->config.audio_enable ? 
       (handle->audio.codec->frame_size * 
        handle->params.channels * sizeof(int16_t)) : 0;
    void *audio_buf = NULL;
 
    if (audio_buf_size)
-      audio_buf = av_malloc(audio_buf_size);
-   /* Try pushing data in an interleaving pattern to 
-    * ease the work of the muxer a bit. */
-
-   do
    {
-      struct ffemu_video_data attr_buf;
-
-      did_work = false;
-
-      if (handle->config.audio_enable)
-      {
-         if (fifo_read_avail(handle->audio_fifo) >= audio_buf_size)
-         {
-            struct ffemu_audio_data aud = {0};
-
-            fifo_read(handle->audio_fifo, audio_buf, audio_buf_size);
-
-            aud.frames = handle->audio.codec->frame_size;
-            aud.data = audio_buf;
-
-            ffmpeg_push_audio_thread(handle, &aud, true);
-            did_work = true;
-         }
-      }
-
-      if (fifo_read_avail(handle->attr_fifo) >= sizeof(attr_buf))
-      {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf, 
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
-
-         did_work = true;
-      }
-   } while (did_work);
-
-   /* Flush out last audio. */
-   if (handle->config.audio_enable)
+      audio_buf = av_malloc(audio_buf_size);
       ffmpeg_flush_audio(handle, audio_buf, audio_buf_size);
+   }
 
-   /* Flush out last video. */
    ffmpeg_flush_video(handle);
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
+static void ffmpeg_log_stats(ffmpeg_t *handle)
+{
+   const struct ff_pipeline_stats *stats = &handle->stats;
+
+   if (stats->dropped || stats->stalls)
+      RARCH_WARN("[FFmpeg]: Encoder fell behind: %u of %u frames dropped, "
+            "core stalled %u times for %.1f ms, up to %u frames queued.\n",
+            stats->dropped, stats->frames + stats->dropped,
+            stats->stalls, stats->stall_time / 1000.0,
+            stats->max_queued);
+   else
+      RARCH_LOG("[FFmpeg]: Recorded %u frames, up to %u queued.\n",
+            stats->frames, stats->max_queued);
+
+   if (handle->config.replay_seconds)
+      RARCH_LOG("[FFmpeg]: Replay buffer held %u packets, %.1f MB.\n",
+            (unsigned)handle->replay.packets,
+            handle->replay.bytes / (1024.0 * 1024.0));
+}
+
 static bool ffmpeg_finalize(void *data)
 {
    ffmpeg_t *handle = (ffmpeg_t*)data;
@@ -1356,17 +1882,19 @@ static bool ffmpeg_finalize(void *data)
 
    deinit_thread_buf(handle);
 
+   ffmpeg_log_stats(handle);
+
    /* Write final data. */
-   av_write_trailer(handle->muxer.ctx);
+   if (!handle->config.replay_seconds)
+      av_write_trailer(handle->muxer.ctx);
 
    return true;
 }
 
-static void ffmpeg_thread(void *data)
+static void ffmpeg_scale_thread(void *data)
 {
-   size_t audio_buf_size;
-   void *audio_buf;
    ffmpeg_t *ff = (ffmpeg_t*)data;
+   struct ff_conv_frame *prev = NULL;
 
    /* For some reason, FFmpeg has a tendency to crash 
     * if we don't overallocate a bit. */
@@ -1374,63 +1902,119 @@ static void ffmpeg_thread(void *data)
          ff->params.fb_height * ff->video.pix_size);
    assert(video_buf);
 
+   for (;;)
+   {
+      struct ff_video_frame frame;
+      struct ff_conv_frame *conv = NULL;
+
+      slock_lock(ff->lock);
+
+      while (ff->alive && !ff->queued)
+         scond_wait(ff->cond, ff->lock);
+
+      if (!ff->queued)
+      {
+         slock_unlock(ff->lock);
+         break;
+      }
+
+      fifo_read(ff->attr_fifo, &frame, sizeof(frame));
+      fifo_read(ff->video_fifo, video_buf,
+            frame.vid.height * frame.vid.pitch);
+      ff->queued--;
+      scond_signal(ff->space_cond);
+
+      /* The encoder thread only exits after us, so this
+       * always frees up eventually. */
+      while (ff->conv_count == MAX_CONV_FRAMES)
+         scond_wait(ff->conv_space_cond, ff->lock);
+
+      conv = &ff->video.conv[
+         (ff->conv_read + ff->conv_count) % MAX_CONV_FRAMES];
+      slock_unlock(ff->lock);
+
+      frame.vid.data = video_buf;
+
+      if (!frame.vid.is_dupe)
+         ffmpeg_scale_input(ff, &frame.vid, conv->frame);
+      else if (prev)
+         memcpy(conv->buf, prev->buf, ff->video.conv_size);
+
+      /* Leave a gap in the timestamps for dropped frames
+       * so audio stays in sync. */
+      ff->video.frame_cnt += frame.dropped;
+      conv->frame->pts     = ff->video.frame_cnt++;
+      prev                 = conv;
+
+      slock_lock(ff->lock);
+      ff->conv_count++;
+      scond_signal(ff->conv_cond);
+      slock_unlock(ff->lock);
+   }
+
+   slock_lock(ff->lock);
+   ff->scale_done = true;
+   scond_signal(ff->conv_cond);
+   slock_unlock(ff->lock);
+
+   av_free(video_buf);
+}
+
+static void ffmpeg_thread(void *data)
+{
+   size_t audio_buf_size;
+   void *audio_buf;
+   ffmpeg_t *ff = (ffmpeg_t*)data;
+
    audio_buf_size = ff->config.audio_enable ? 
       (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
    audio_buf      = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
 
-   while (ff->alive)
+   for (;;)
    {
-      struct ffemu_video_data attr_buf;
-
       bool avail_video = false;
       bool avail_audio = false;
 
       slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
 
-      if (ff->config.audio_enable)
-         if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
-      slock_unlock(ff->lock);
-
-      if (!avail_video && !avail_audio)
+      for (;;)
       {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
-         {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
-         }
-         else
-            scond_signal(ff->cond);
+         avail_video = ff->conv_count > 0;
+         avail_audio = audio_buf_size &&
+            fifo_read_avail(ff->audio_fifo) >= audio_buf_size;
 
-         slock_unlock(ff->cond_lock);
+         if (avail_video || avail_audio || ff->scale_done)
+            break;
+
+         scond_wait(ff->conv_cond, ff->lock);
       }
 
+      if (avail_audio)
+      {
+         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
+         scond_signal(ff->space_cond);
+      }
+
+      slock_unlock(ff->lock);
+
+      if (!avail_video && !avail_audio)
+         break;
+
       if (avail_video)
       {
+         ffmpeg_push_video_thread(ff, ff->video.conv[ff->conv_read].frame);
+
          slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
+         ff->conv_read = (ff->conv_read + 1) % MAX_CONV_FRAMES;
+         ff->conv_count--;
+         scond_signal(ff->conv_space_cond);
          slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
       }
 
       if (avail_audio)
       {
          struct ffemu_audio_data aud = {0};
 
-         slock_lock(ff->lock);
-         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
          aud.frames = ff->audio.codec->frame_size;
          aud.data = audio_buf;
 
@@ -1438,7 +2022,6 @@ static void ffmpeg_thread(void *data)
       }
    }
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
@@ -1448,5 +2031,6 @@ const record_driver_t ffemu_ffmpeg = {
    ffmpeg_push_video,
    ffmpeg_push_audio,
    ffmpeg_finalize,
+   ffmpeg_dump_replay,
    "ffmpeg",
 };
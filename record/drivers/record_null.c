@@ -53,11 +53,17 @@ static bool record_null_finalize(void *data)
    return false;
 }
 
+static bool record_null_dump_replay(void *data, const char *path)
+{
+   return false;
+}
+
 const record_driver_t ffemu_null = {
    record_null_new,
    record_null_free,
    record_null_push_video,
    record_null_push_audio,
    record_null_finalize,
+   record_null_dump_replay,
    "null",
 };
@@ -272,6 +272,15 @@ void recording_push_audio(const int16_t *data, size_t samples)
       recording_driver->push_audio(recording_data, &ffemu_data);
 }
 
+bool recording_dump_replay(const char *path)
+{
+   if (!recording_data || !recording_driver
+         || !recording_driver->dump_replay)
+      return false;
+
+   return recording_driver->dump_replay(recording_data, path);
+}
+
 /**
  * recording_init:
  *
@@ -87,6 +87,8 @@ typedef struct record_driver
    bool  (*push_video)(void *data,const struct ffemu_video_data *video_data);
    bool  (*push_audio)(void *data, const struct ffemu_audio_data *audio_data);
    bool  (*finalize)(void *data);
+   /* Writes out the replay buffer, if the driver keeps one. */
+   bool  (*dump_replay)(void *data, const char *path);
    const char *ident;
 } record_driver_t;
 
@@ -166,6 +168,18 @@ void recording_set_state(bool state);
 
 void recording_push_audio(const int16_t *data, size_t samples);
 
+/**
+ * recording_dump_replay:
+ * @path                : Path of the video file to write.
+ *
+ * Writes the recording driver's replay buffer to @path in the
+ * background. Only works if recording was started with a
+ * replay buffer configured.
+ *
+ * Returns: true (1) if saving was started, otherwise false (0).
+ **/
+bool recording_dump_replay(const char *path);
+
 void *recording_driver_get_data_ptr(void);
 
 void recording_driver_clear_data_ptr(void);
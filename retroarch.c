@@ -95,7 +95,9 @@ enum
    RA_OPT_VERSION,
    RA_OPT_EOF_EXIT,
    RA_OPT_LOG_FILE,
-   RA_OPT_MAX_FRAMES
+   RA_OPT_MAX_FRAMES,
+   RA_OPT_HEADLESS,
+   RA_OPT_BENCHMARK
 };
 
 static char current_savefile_dir[PATH_MAX_LENGTH];
@@ -103,6 +105,10 @@ static char current_savefile_dir[PATH_MAX_LENGTH];
 static char error_string[PATH_MAX_LENGTH];
 static jmp_buf error_sjlj_context;
 
+/* Whether this run's headless report went out already, see
+ * rarch_deinit_headless(). */
+static bool headless_reported;
+
 #define _PSUPP(var, name, desc) printf("  %s:\n\t\t%s: %s\n", name, desc, _##var##_supp ? "yes" : "no")
 
 static void print_features(void)
@@ -249,6 +255,12 @@ static void print_help(const char *arg0)
 
    puts("  -r, --record=FILE     Path to record video file.\n        Using .mkv extension is recommended.");
    puts("      --recordconfig    Path to settings used during recording.");
+   puts("      --headless        Render straight to the recording as fast as possible,\n"
+        "                        without display or audio output. The recording keeps\n"
+        "                        the core's audio. Exits at the end of the BSV movie.");
+   puts("      --benchmark=FILE  Runs the core headless as fast as possible and writes frames/s\n"
+        "                        and performance counters to FILE as JSON ('-' for stdout).\n"
+        "                        Use with --max-frames and/or --bsvplay.");
    puts("      --size=WIDTHxHEIGHT\n"
         "                        Overrides output video size when recording.");
    puts("  -U, --ups=FILE        Specifies path for UPS patch that will be applied to content.");
@@ -579,6 +591,8 @@ static void parse_input(int argc, char *argv[])
       { "fullscreen",   0, NULL, 'f' },
       { "record",       1, NULL, 'r' },
       { "recordconfig", 1, NULL, RA_OPT_RECORDCONFIG },
+      { "headless",     0, NULL, RA_OPT_HEADLESS },
+      { "benchmark",    1, NULL, RA_OPT_BENCHMARK },
       { "size",         1, NULL, RA_OPT_SIZE },
       { "verbose",      0, NULL, 'v' },
       { "config",       1, NULL, 'c' },
@@ -913,6 +927,17 @@ static void parse_input(int argc, char *argv[])
                   sizeof(global->record.config));
             break;
 
+         case RA_OPT_HEADLESS:
+            global->record.headless = true;
+            bsv_movie_ctl(BSV_MOVIE_CTL_SET_END_EOF, NULL);
+            break;
+
+         case RA_OPT_BENCHMARK:
+            strlcpy(global->benchmark, optarg, sizeof(global->benchmark));
+            global->record.headless = true;
+            bsv_movie_ctl(BSV_MOVIE_CTL_SET_END_EOF, NULL);
+            break;
+
          case RA_OPT_MAX_FRAMES:
             {
                unsigned max_frames = strtoul(optarg, NULL, 10);
@@ -1094,6 +1119,152 @@ void rarch_init_system_av_info(void)
    runloop_ctl(RUNLOOP_CTL_SET_FRAME_LIMIT, NULL);
 }
 
+/* Overrides the loaded config so nothing paces the core but the
+ * encoder: null video, audio and input drivers, no vsync and no
+ * frame limiter. BSV playback supplies the input.
+ *
+ * Audio still reaches the recording, which is pushed the core's
+ * samples before the audio driver is consulted; disabling audio
+ * only skips resampling for a device nobody listens to. */
+static void rarch_init_headless(void)
+{
+   settings_t *settings = config_get_ptr();
+   global_t   *global   = global_get_ptr();
+
+   if (*global->benchmark)
+   {
+      /* Keep audio going into the null driver, so
+       * resampling is part of what gets measured. */
+      runloop_ctl(RUNLOOP_CTL_SET_PERFCNT_ENABLE, NULL);
+
+      if (!runloop_ctl(RUNLOOP_CTL_HAS_MAX_FRAMES, NULL)
+            && !bsv_movie_ctl(BSV_MOVIE_CTL_START_PLAYBACK, NULL))
+         RARCH_WARN("Benchmarking without --max-frames or --bsvplay, it will never end.\n");
+   }
+   else
+   {
+      if (!*recording_is_enabled())
+         RARCH_WARN("Running headless without --record, nothing will be rendered.\n");
+
+      settings->audio.enable   = false;
+   }
+
+   strlcpy(settings->video.driver, "null", sizeof(settings->video.driver));
+   strlcpy(settings->audio.driver, "null", sizeof(settings->audio.driver));
+   strlcpy(settings->input.driver, "null", sizeof(settings->input.driver));
+   strlcpy(settings->input.joypad_driver, "null",
+         sizeof(settings->input.joypad_driver));
+
+   settings->video.vsync       = false;
+   settings->video.frame_delay = 0;
+   settings->video.gpu_record  = false;
+   settings->fastforward_ratio = 0.0f;
+   settings->pause_nonactive   = false;
+   settings->rewind_enable     = false;
+}
+
+static void rarch_write_benchmark_counters(FILE *file, const char *name,
+      struct retro_perf_counter **counters, unsigned num)
+{
+   unsigned i;
+   bool first = true;
+
+   fprintf(file, "  \"%s\": [", name);
+
+   for (i = 0; i < num; i++)
+   {
+      const char *ident = counters[i]->ident;
+
+      if (!counters[i]->call_cnt)
+         continue;
+
+      fprintf(file, "%s\n    { \"name\": \"", first ? "" : ",");
+      for (; ident && *ident; ident++)
+      {
+         if (*ident == '"' || *ident == '\\')
+            fputc('\\', file);
+         fputc(*ident, file);
+      }
+      fprintf(file, "\", \"calls\": %llu, \"ticks\": %llu, \"ticks_per_call\": %llu }",
+            (unsigned long long)counters[i]->call_cnt,
+            (unsigned long long)counters[i]->total,
+            (unsigned long long)(counters[i]->total / counters[i]->call_cnt));
+      first = false;
+   }
+
+   fprintf(file, "%s]", first ? "" : "\n  ");
+}
+
+/* Ticks come from retro_get_perf_counter(), so they are
+ * CPU cycles where the platform has a cycle counter. */
+static void rarch_write_benchmark(const char *path,
+      uint64_t frames, double elapsed, double fps)
+{
+   global_t *global = global_get_ptr();
+   FILE *file       = stdout;
+
+   if (strcmp(path, "-") != 0)
+      file = fopen(path, "w");
+
+   if (!file)
+   {
+      RARCH_ERR("Couldn't open benchmark report \"%s\".\n", path);
+      return;
+   }
+
+   fprintf(file, "{\n");
+   fprintf(file, "  \"content_crc\": %u,\n", global->content_crc);
+   fprintf(file, "  \"frames\": %llu,\n", (unsigned long long)frames);
+   fprintf(file, "  \"seconds\": %.6f,\n", elapsed);
+   fprintf(file, "  \"fps\": %.3f,\n",
+         elapsed > 0.0 ? frames / elapsed : 0.0);
+   fprintf(file, "  \"real_time\": %.3f,\n",
+         elapsed > 0.0 && fps > 0.0 ? frames / (elapsed * fps) : 0.0);
+   rarch_write_benchmark_counters(file, "frontend",
+         retro_get_perf_counter_rarch(), retro_get_perf_count_rarch());
+   fprintf(file, ",\n");
+   rarch_write_benchmark_counters(file, "core",
+         retro_get_perf_counter_libretro(), retro_get_perf_count_libretro());
+   fprintf(file, "\n}\n");
+
+   if (file != stdout)
+      fclose(file);
+}
+
+/* Reports how the headless run went. Fatal errors, failed
+ * init and the regular teardown all get here, only the
+ * first one reports. */
+static void rarch_deinit_headless(void)
+{
+   struct retro_system_av_info *av_info = video_viewport_get_system_av_info();
+   uint64_t *frame_count                = NULL;
+   uint64_t frames                      = 0;
+   double elapsed                       = 0.0;
+   global_t *global                     = global_get_ptr();
+
+   if (!global->record.headless || headless_reported)
+      return;
+
+   headless_reported = true;
+
+   if (video_driver_ctl(RARCH_DISPLAY_CTL_GET_FRAME_COUNT, &frame_count))
+      frames = *frame_count;
+   if (global->record.headless_start)
+      elapsed = (retro_get_time_usec()
+            - global->record.headless_start) / 1000000.0;
+
+   if (frames && elapsed > 0.0)
+      RARCH_LOG("Rendered %llu frames in %.1f s (%.1f fps, %.1fx real time).\n",
+            (unsigned long long)frames, elapsed,
+            frames / elapsed,
+            frames / (elapsed * av_info->timing.fps));
+
+   /* Written even if nothing ran, so a failed run shows up. */
+   if (*global->benchmark)
+      rarch_write_benchmark(global->benchmark, frames,
+            elapsed, av_info->timing.fps);
+}
+
 /**
  * rarch_main_init:
  * @argc                 : Count of (commandline) arguments.
@@ -1110,10 +1281,12 @@ int rarch_main_init(int argc, char *argv[])
    global_t *global  = global_get_ptr();
 
    init_state();
+   headless_reported = false;
 
    if ((sjlj_ret = setjmp(error_sjlj_context)) > 0)
    {
       RARCH_ERR("Fatal error received in: \"%s\"\n", error_string);
+      rarch_deinit_headless();
       return sjlj_ret;
    }
 
@@ -1142,6 +1315,9 @@ int rarch_main_init(int argc, char *argv[])
    config_load();
    rarch_task_init();
 
+   if (global->record.headless)
+      rarch_init_headless();
+
    {
       settings_t *settings = config_get_ptr();
 
@@ -1204,6 +1380,8 @@ int rarch_main_init(int argc, char *argv[])
 error:
    event_command(EVENT_CMD_CORE_DEINIT);
 
+   rarch_deinit_headless();
+
    global->inited.main  = false;
    return 1;
 }
@@ -1508,6 +1686,9 @@ void rarch_main_deinit(void)
       event_command(EVENT_CMD_AUTOSAVE_DEINIT);
 
    event_command(EVENT_CMD_RECORD_DEINIT);
+
+   rarch_deinit_headless();
+
    event_command(EVENT_CMD_SAVEFILES);
 
    event_command(EVENT_CMD_REWIND_DEINIT);
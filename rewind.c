@@ -372,6 +372,72 @@ void state_manager_raw_decompress(const void *patch,
    }
 }
 
+bool state_manager_raw_decompress_checked(const void *patch,
+      size_t patchlen, void *data, size_t datalen)
+{
+   uint16_t         *out16 = (uint16_t*)data;
+   const uint16_t *patch16 = (const uint16_t*)patch;
+   size_t         patch16s = patchlen / sizeof(uint16_t);
+   size_t           out16s = (datalen + sizeof(uint16_t) - 1)
+      / sizeof(uint16_t);
+
+   for (;;)
+   {
+      uint16_t numchanged;
+
+      if (patch16s < 1)
+         return false;
+
+      numchanged = *(patch16++);
+      patch16s--;
+
+      if (numchanged)
+      {
+         uint16_t i;
+         uint16_t skip;
+
+         if (patch16s < 1 + (size_t)numchanged)
+            return false;
+
+         skip = *(patch16++);
+         patch16s--;
+
+         if ((size_t)skip + numchanged > out16s)
+            return false;
+
+         out16  += skip;
+         out16s -= skip;
+
+         for (i = 0; i < numchanged; i++)
+            out16[i] = patch16[i];
+
+         patch16  += numchanged;
+         patch16s -= numchanged;
+         out16    += numchanged;
+         out16s   -= numchanged;
+      }
+      else
+      {
+         uint32_t numunchanged;
+
+         if (patch16s < 2)
+            return false;
+
+         numunchanged = patch16[0] | (patch16[1] << 16);
+
+         if (!numunchanged)
+            return true;
+         if (numunchanged > out16s)
+            return false;
+
+         patch16  += 2;
+         patch16s -= 2;
+         out16    += numunchanged;
+         out16s   -= numunchanged;
+      }
+   }
+}
+
 /* The start offsets point to 'nextstart' of any given compressed frame.
  * Each uint16 is stored native endian; anything that claims any other 
  * endianness refers to the endianness of this specific item.
@@ -68,6 +68,13 @@ size_t state_manager_raw_compress(const void *src, const void *dst, size_t len,
  */
 void state_manager_raw_decompress(const void *patch, size_t patchlen, void *data, size_t datalen);
 
+/*
+ * Like state_manager_raw_decompress, but checks every block against 'patchlen' and 'datalen',
+ * so it is safe on patches from untrusted sources such as the network.
+ * Returns false if the patch is malformed; 'data' may then be partially patched.
+ */
+bool state_manager_raw_decompress_checked(const void *patch, size_t patchlen, void *data, size_t datalen);
+
 bool state_manager_frame_is_reversed(void);
 
 void state_manager_set_frame_is_reversed(bool value);
@@ -0,0 +1,247 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "runahead.h"
+#include "dynamic.h"
+#include "libretro_version_1.h"
+#include "movie.h"
+#include "msg_hash.h"
+#include "performance.h"
+#include "rewind.h"
+#include "runloop.h"
+#include "verbosity.h"
+#include "gfx/video_driver.h"
+#include "input/input_driver.h"
+
+#ifdef HAVE_NETPLAY
+#include "netplay/netplay.h"
+#endif
+
+/* Why run-ahead is off, each logged once. */
+enum runahead_reason
+{
+   RUNAHEAD_REASON_NETPLAY = 0,
+   RUNAHEAD_REASON_MOVIE,
+   RUNAHEAD_REASON_NO_SAVESTATES,
+   RUNAHEAD_REASON_OUT_OF_MEMORY,
+   RUNAHEAD_REASON_SAVE_FAILED
+};
+
+static const char *runahead_reasons[] = {
+   "netplay is active",
+   "a movie is being recorded or played back",
+   "the core does not support savestates",
+   "out of memory",
+   "the core failed to save its state",
+};
+
+/* Run-ahead rolls the core back to a state saved in memory
+ * every frame, instead of driving a second core instance.
+ * A core is loaded once per process, so a second instance
+ * would share its globals with the first. */
+static struct
+{
+   void *state;
+   size_t capacity;
+   /* The core could not save this content, don't retry until
+    * it is unloaded. */
+   bool unsupported;
+   /* Bit per runahead_reason already logged. */
+   unsigned warned;
+} runahead;
+
+static void runahead_video_null(const void *data,
+      unsigned width, unsigned height, size_t pitch)
+{
+   (void)data;
+   (void)width;
+   (void)height;
+   (void)pitch;
+}
+
+static void runahead_audio_sample_null(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
+
+static size_t runahead_audio_sample_batch_null(
+      const int16_t *data, size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+static void runahead_input_poll_null(void)
+{
+}
+
+static void runahead_warn(enum runahead_reason reason)
+{
+   if (runahead.warned & (1 << reason))
+      return;
+
+   RARCH_WARN("Run-ahead disabled: %s.\n", runahead_reasons[reason]);
+   runahead.warned |= 1 << reason;
+}
+
+static bool runahead_available(void)
+{
+   if (runahead.unsupported)
+      return false;
+
+   /* Rewind replays frames the core already ran. */
+   if (state_manager_frame_is_reversed())
+      return false;
+
+#ifdef HAVE_NETPLAY
+   /* Netplay rolls the core back itself, and hooks the same
+    * callbacks. */
+   if (netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_DATA_INITED, NULL))
+   {
+      runahead_warn(RUNAHEAD_REASON_NETPLAY);
+      return false;
+   }
+#endif
+
+   /* Extra frames would record or play back extra input. */
+   if (bsv_movie_ctl(BSV_MOVIE_CTL_IS_INITED, NULL))
+   {
+      runahead_warn(RUNAHEAD_REASON_MOVIE);
+      return false;
+   }
+
+   return true;
+}
+
+static bool runahead_reserve(size_t size)
+{
+   void *state = NULL;
+
+   if (size <= runahead.capacity)
+      return true;
+
+   state = realloc(runahead.state, size);
+   if (!state)
+      return false;
+
+   runahead.state    = state;
+   runahead.capacity = size;
+   return true;
+}
+
+static void runahead_restore_callbacks(void)
+{
+   core.retro_set_video_refresh(video_driver_frame);
+   core.retro_set_input_poll(input_poll);
+   retro_set_rewind_callbacks();
+}
+
+bool runahead_run(unsigned frames)
+{
+   static struct retro_perf_counter runahead_serialize   = {0};
+   static struct retro_perf_counter runahead_frames      = {0};
+   static struct retro_perf_counter runahead_unserialize = {0};
+   unsigned i;
+   size_t size;
+   bool saved, loaded;
+
+   if (!frames || !runahead_available())
+      return false;
+
+   size = core.retro_serialize_size();
+   if (!size)
+   {
+      runahead.unsupported = true;
+      runahead_warn(RUNAHEAD_REASON_NO_SAVESTATES);
+      return false;
+   }
+
+   if (!runahead_reserve(size))
+   {
+      runahead_warn(RUNAHEAD_REASON_OUT_OF_MEMORY);
+      return false;
+   }
+
+   rarch_perf_init(&runahead_serialize,   "runahead_serialize");
+   rarch_perf_init(&runahead_frames,      "runahead_frames");
+   rarch_perf_init(&runahead_unserialize, "runahead_unserialize");
+
+   /* The real frame: input and audio, but the player sees
+    * a later one instead. */
+   core.retro_set_video_refresh(runahead_video_null);
+   core.retro_run();
+
+   retro_perf_start(&runahead_serialize);
+   saved = core.retro_serialize(runahead.state, size);
+   retro_perf_stop(&runahead_serialize);
+
+   if (!saved)
+   {
+      runahead_restore_callbacks();
+      runahead.unsupported = true;
+      runahead_warn(RUNAHEAD_REASON_SAVE_FAILED);
+
+      /* The real frame's video was dropped. */
+      video_driver_ctl(RARCH_DISPLAY_CTL_CACHED_FRAME_RENDER, NULL);
+      return true;
+   }
+
+   /* Speculative frames repeat this frame's input, so there
+    * is nothing new to poll, and their audio would play
+    * again for real later. */
+   core.retro_set_audio_sample(runahead_audio_sample_null);
+   core.retro_set_audio_sample_batch(runahead_audio_sample_batch_null);
+   core.retro_set_input_poll(runahead_input_poll_null);
+
+   retro_perf_start(&runahead_frames);
+   for (i = 1; i < frames; i++)
+      core.retro_run();
+
+   core.retro_set_video_refresh(video_driver_frame);
+   core.retro_run();
+   retro_perf_stop(&runahead_frames);
+
+   runahead_restore_callbacks();
+
+   retro_perf_start(&runahead_unserialize);
+   loaded = core.retro_unserialize(runahead.state, size);
+   retro_perf_stop(&runahead_unserialize);
+
+   /* The core is left the speculative frames ahead, which
+    * the player will notice. */
+   if (!loaded)
+   {
+      runahead.unsupported = true;
+      RARCH_ERR("Run-ahead: the core failed to load its state, "
+            "it is now %u frames ahead.\n", frames);
+      runloop_msg_queue_push_new(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE,
+            1, 180, true);
+   }
+
+   return true;
+}
+
+void runahead_deinit(void)
+{
+   free(runahead.state);
+   runahead.state       = NULL;
+   runahead.capacity    = 0;
+   runahead.unsupported = false;
+   runahead.warned      = 0;
+}
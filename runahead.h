@@ -0,0 +1,52 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_RUNAHEAD_H
+#define __RARCH_RUNAHEAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <boolean.h>
+
+/* Most frames run-ahead can be asked to hide. */
+#define RUNAHEAD_MAX_FRAMES 6
+
+/**
+ * runahead_run:
+ * @frames              : how many frames ahead of the real
+ *                        state the displayed frame should be.
+ *
+ * Runs the core for one real frame, with its audio but not
+ * its video. The state is then saved in memory, @frames more
+ * frames are run with only the last one displayed, and the
+ * state is loaded back.
+ *
+ * Returns: true if the core was run, false if run-ahead is
+ * not possible right now and the caller should run the core
+ * itself.
+ **/
+bool runahead_run(unsigned frames);
+
+/* Frees the state buffer. Call when the core is unloaded. */
+void runahead_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
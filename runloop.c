@@ -38,6 +38,8 @@
 #include "cheats.h"
 #include "configuration.h"
 #include "performance.h"
+#include "frame_pacing.h"
+#include "runahead.h"
 #include "movie.h"
 #include "retroarch.h"
 #include "runloop.h"
@@ -48,6 +50,7 @@
 #include "camera/camera_driver.h"
 #include "record/record_driver.h"
 #include "input/input_driver.h"
+#include "gfx/video_shader_watch.h"
 #include "ui/ui_companion_driver.h"
 #include "libretro_version_1.h"
 
@@ -765,6 +768,7 @@ bool runloop_ctl(enum runloop_ctl_state state, void *data)
             check_shader_dir(&runloop_shader_dir,
                   runloop_cmd_triggered(cmd, RARCH_SHADER_NEXT),
                   runloop_cmd_triggered(cmd, RARCH_SHADER_PREV));
+            video_shader_watch_check();
 
             if (runloop_cmd_triggered(cmd, RARCH_DISK_EJECT_TOGGLE))
                event_command(EVENT_CMD_DISK_EJECT_TOGGLE);
@@ -936,6 +940,8 @@ bool runloop_ctl(enum runloop_ctl_state state, void *data)
             runloop_max_frames = *ptr;
          }
          break;
+      case RUNLOOP_CTL_HAS_MAX_FRAMES:
+         return runloop_max_frames != 0;
       case RUNLOOP_CTL_IS_IDLE:
          return runloop_idle;
       case RUNLOOP_CTL_SET_IDLE:
@@ -1217,6 +1223,42 @@ static INLINE int runloop_iterate_time_to_exit(bool quit_key_pressed)
    return 0;
 }
 
+/**
+ * runloop_frame_pacing_period:
+ * @limit_period         : frame time enforced by the frame limiter.
+ *
+ * Returns: time between presents frame pacing should expect,
+ * or 0 if nothing paces them.
+ **/
+static retro_time_t runloop_frame_pacing_period(retro_time_t limit_period)
+{
+   settings_t *settings = config_get_ptr();
+
+   /* The threaded driver returns before presenting. */
+   if (video_driver_is_threaded())
+      return 0;
+
+   /* Without hard sync, the GPU driver queues up frames and
+    * returns from the swap long before they are shown, so
+    * there is no vblank to predict. */
+   if (settings->video.vsync && !settings->video.hard_sync)
+      return 0;
+
+   if (settings->video.vsync && settings->video.refresh_rate > 0.0f)
+   {
+      unsigned swaps = settings->video.swap_interval;
+      if (settings->video.black_frame_insertion)
+         swaps *= 2;
+      return (retro_time_t)roundf(1000000.0f * swaps
+            / settings->video.refresh_rate);
+   }
+
+   if (settings->fastforward_ratio)
+      return limit_period;
+
+   return 0;
+}
+
 /**
  * runloop_iterate:
  *
@@ -1235,10 +1277,13 @@ int runloop_iterate(unsigned *sleep_ms)
    static retro_time_t frame_limit_minimum_time = 0.0;
    static retro_time_t frame_limit_last_time    = 0.0;
    static retro_input_t last_input              = 0;
+   static struct retro_perf_counter core_run    = {0};
    settings_t *settings                         = config_get_ptr();
    global_t   *global                           = global_get_ptr();
    rarch_system_info_t *system                  = NULL;
 
+   rarch_perf_init(&core_run, "core_run");
+
    cmd.state[1]                                 = last_input;
    cmd.state[0]                                 = input_keys_pressed();
    last_input                                   = cmd.state[0];
@@ -1359,6 +1404,8 @@ int runloop_iterate(unsigned *sleep_ms)
       if (menu_driver_iterate((enum menu_action)menu_input_frame_retropad(cmd.state[0], cmd.state[2])) == -1)
          rarch_ctl(RARCH_CTL_MENU_RUNNING_FINISHED, NULL);
 
+      rarch_perf_frame_skip();
+
       if (focused || !is_idle)
          menu_driver_ctl(RARCH_MENU_CTL_RENDER, NULL);
 
@@ -1375,6 +1422,7 @@ int runloop_iterate(unsigned *sleep_ms)
    if (!runloop_ctl(RUNLOOP_CTL_CHECK_STATE, &cmd))
    {
       /* RetroArch has been paused. */
+      rarch_perf_frame_skip();
       retro_ctx.poll_cb();
       *sleep_ms = 10;
       return 1;
@@ -1406,12 +1454,32 @@ int runloop_iterate(unsigned *sleep_ms)
             settings->input.analog_dpad_mode[i]);
    }
 
-   if ((settings->video.frame_delay > 0) && 
-         !input_driver_ctl(RARCH_INPUT_CTL_IS_NONBLOCK_STATE, NULL))
-      retro_sleep(settings->video.frame_delay);
+   if (!input_driver_ctl(RARCH_INPUT_CTL_IS_NONBLOCK_STATE, NULL))
+   {
+      if (settings->video.frame_pacing)
+      {
+         /* Without vsync, the frame limiter sets the deadline. */
+         retro_time_t deadline = 0;
+         if (!settings->video.vsync && settings->fastforward_ratio)
+            deadline = frame_limit_last_time + frame_limit_minimum_time;
+
+         frame_pacing_set_period(runloop_frame_pacing_period(
+                  frame_limit_minimum_time));
+         frame_pacing_run_late(deadline);
+      }
+      else if (settings->video.frame_delay > 0)
+         retro_sleep(settings->video.frame_delay);
+   }
+
+   if (global->record.headless && !global->record.headless_start)
+      global->record.headless_start = retro_get_time_usec();
 
    /* Run libretro for one frame. */
-   core.retro_run();
+   retro_perf_start(&core_run);
+   if (!runahead_run(settings->run_ahead_frames))
+      core.retro_run();
+   retro_perf_stop(&core_run);
+   rarch_perf_frame();
 
 #ifdef HAVE_CHEEVOS
    /* Test the achievements. */
@@ -1448,6 +1516,20 @@ end:
    target                         = frame_limit_last_time + frame_limit_minimum_time;
    to_sleep_ms                    = (target - current) / 1000;
 
+   /* Waiting here instead of in the caller lets the wait
+    * end on the target, rather than on a millisecond tick. */
+   if (settings->video.frame_pacing)
+   {
+      if (target > current)
+      {
+         frame_pacing_wait_until(target);
+         frame_limit_last_time += frame_limit_minimum_time;
+      }
+      else
+         frame_limit_last_time = retro_get_time_usec();
+      return 0;
+   }
+
    if (to_sleep_ms > 0)
    {
       *sleep_ms = (unsigned)to_sleep_ms;
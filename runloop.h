@@ -55,6 +55,7 @@ enum runloop_ctl_state
    RUNLOOP_CTL_IS_PAUSED,
    RUNLOOP_CTL_SET_PAUSED,
    RUNLOOP_CTL_SET_MAX_FRAMES,
+   RUNLOOP_CTL_HAS_MAX_FRAMES,
    RUNLOOP_CTL_CLEAR_STATE,
    RUNLOOP_CTL_STATE_FREE,
    RUNLOOP_CTL_GLOBAL_FREE,
@@ -247,8 +248,17 @@ typedef struct global
       char output_dir[PATH_MAX_LENGTH];
       char config_dir[PATH_MAX_LENGTH];
       bool use_output_dir;
+      /* Render straight to the recording, without display,
+       * audio device or frame limiter. The recording still
+       * gets the core's audio. */
+      bool headless;
+      /* When the core first ran, so loading isn't timed. */
+      retro_time_t headless_start;
    } record;
 
+   /* --benchmark, where the JSON report is written. */
+   char benchmark[PATH_MAX_LENGTH];
+
    /* Settings and/or global state that is specific to 
     * a console-style implementation. */
    struct